@@ -0,0 +1,498 @@
+/**
+ * @brief Shellby benchmark suite: times the shell's hot paths and writes the results as JSON.
+ *
+ * It links against the shell's object files and calls the code directly.
+ * Covered: parsing (fresh and cached), prompt rendering and pipeline spawning.
+ * Also the echo, printf, test and cat builtins, functions and loops (next to
+ * bash, if installed), history I/O, seek, peek, warp -z lookups and procfs.
+ * Run it with 'make bench'; runs from two commits can be compared.
+ */
+#define _GNU_SOURCE
+#include "core/shell_state.h"
+#include "core/parser.h"
+#include "core/parse_cache.h"
+#include "core/executor.h"
+#include "core/signals.h"
+#include "core/dirdb.h"
+#include "core/procfs.h"
+#include "commands/peek.h"
+#include "commands/seek.h"
+#include "commands/proclore.h"
+#include "commands/activities.h"
+#include "commands/ping.h"
+#include "utils/que.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// The signal module expects this global, normally defined in main.c.
+ShellState* g_shell_state = NULL;
+
+#define BENCH_REPS 5
+#define BENCH_BG_JOBS 10
+#define BENCH_DIRDB_ENTRIES 30000
+#define BENCH_TREE_PROCS 50000
+
+/**
+ * @brief Sizes of the generated fixtures. '--quick' shrinks them for smoke runs.
+ */
+typedef struct {
+    long parse_iters;
+    long prompt_iters;
+    long spawn_iters;
+    long history_small;
+    long history_large;
+    int seek_depth;
+    int seek_fanout;
+    long peek_entries;
+    long procfs_iters;
+    long loop_iters;
+} BenchSizes;
+
+static const BenchSizes full_sizes = {200000, 20000, 200, 10000, 1000000, 4, 8, 100000, 5000, 1000000};
+static const BenchSizes quick_sizes = {20000, 2000, 20, 10000, 100000, 3, 6, 5000, 500, 100000};
+
+static BenchSizes sizes;
+static ShellState bench_state;
+static char work_dir[MAX_PATH_LEN];
+static FILE* json_out;
+static int num_results = 0;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Times 'fn(iters)' BENCH_REPS times and emits one JSON result.
+ * @param name Result name, e.g. "parser/pipeline_3".
+ * @param fn The function under test; it performs 'iters' operations.
+ * @param iters Operations per repetition.
+ * @param items_per_op Work items handled by one operation (entries, stages...).
+ */
+static void run_bench(const char* name, void (*fn)(long), long iters, long items_per_op) {
+    uint64_t samples[BENCH_REPS];
+    fprintf(stderr, "  %-28s", name);
+    for (int r = 0; r < BENCH_REPS; r++) {
+        uint64_t start = now_ns();
+        fn(iters);
+        fflush(stdout);
+        samples[r] = now_ns() - start;
+    }
+    qsort(samples, BENCH_REPS, sizeof(samples[0]), compare_u64);
+
+    double median_ns_per_op = (double)samples[BENCH_REPS / 2] / iters;
+    double min_ns_per_op = (double)samples[0] / iters;
+    fprintf(stderr, "%14.1f ns/op\n", median_ns_per_op);
+
+    fprintf(json_out,
+            "%s\n    {\"name\": \"%s\", \"iterations\": %ld, \"repetitions\": %d, \"items_per_op\": %ld, "
+            "\"median_ns_per_op\": %.1f, \"min_ns_per_op\": %.1f, \"ops_per_sec\": %.1f}",
+            num_results++ == 0 ? "" : ",", name, iters, BENCH_REPS, items_per_op,
+            median_ns_per_op, min_ns_per_op, median_ns_per_op > 0 ? 1e9 / median_ns_per_op : 0.0);
+}
+
+// --- Fixtures ---
+
+static void write_history_fixture(long entries) {
+    char path[MAX_PATH_LEN * 2];
+    snprintf(path, sizeof(path), "%s/%s", work_dir, HISTORY_FILENAME);
+    FILE* f = fopen(path, "w");
+    if (!f) { perror(path); exit(EXIT_FAILURE); }
+    for (long i = 0; i < entries; i++) {
+        fprintf(f, "grep -n pattern_%ld src/file_%ld.c | sort | uniq -c > out_%ld.txt\n", i, i % 97, i);
+    }
+    fclose(f);
+}
+
+static void make_tree(const char* path, int depth, int fanout) {
+    mkdir(path, 0755);
+    char child[MAX_PATH_LEN * 2];
+    for (int i = 0; i < fanout; i++) {
+        snprintf(child, sizeof(child), "%s/file_%d.txt", path, i);
+        int fd = open(child, O_WRONLY | O_CREAT, 0644);
+        if (fd >= 0) close(fd);
+        if (depth > 0) {
+            snprintf(child, sizeof(child), "%s/dir_%d", path, i);
+            make_tree(child, depth - 1, fanout);
+        }
+    }
+}
+
+static void make_flat_dir(const char* path, long entries) {
+    mkdir(path, 0755);
+    char child[MAX_PATH_LEN * 2];
+    for (long i = 0; i < entries; i++) {
+        snprintf(child, sizeof(child), "%s/entry_%07ld", path, i);
+        int fd = open(child, O_WRONLY | O_CREAT, 0644);
+        if (fd >= 0) close(fd);
+    }
+}
+
+static int remove_entry(const char* path, const struct stat* sb, int type, struct FTW* ftw) {
+    (void)sb; (void)type; (void)ftw;
+    remove(path);
+    return 0;
+}
+
+// --- Benchmarks ---
+
+static const char* parse_line;
+
+static void bench_parse(long iters) {
+    for (long i = 0; i < iters; i++) {
+        Node* tree;
+        if (parse_program(parse_line, &tree) == PARSE_OK) node_free(tree);
+    }
+}
+
+static void bench_parse_cached(long iters) {
+    for (long i = 0; i < iters; i++) {
+        Node* tree;
+        if (parse_cached(parse_line, &tree) == PARSE_OK) node_free(tree);
+    }
+}
+
+static void bench_prompt(long iters) {
+    for (long i = 0; i < iters; i++) {
+        display_shell_prompt(&bench_state);
+    }
+}
+
+static const char* spawn_line;
+
+static void bench_spawn(long iters) {
+    for (long i = 0; i < iters; i++) {
+        process_input_line(spawn_line, &bench_state);
+    }
+}
+
+static char loop_line[256];
+
+static void bench_loop(long iters) {
+    for (long i = 0; i < iters; i++) {
+        process_input_line(loop_line, &bench_state);
+    }
+}
+
+/**
+ * @brief Runs 'loop_line' with 'bash -c', for comparison.
+ * @return The exit status, or -1 if bash could not be started.
+ */
+static int run_bash_loop(void) {
+    char* argv[] = {"bash", "-c", loop_line, NULL};
+    pid_t pid;
+    if (posix_spawnp(&pid, "bash", NULL, NULL, argv, environ) != 0) return -1;
+    int status;
+    if (waitpid(pid, &status, 0) < 0) return -1;
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static void bench_loop_bash(long iters) {
+    for (long i = 0; i < iters; i++) run_bash_loop();
+}
+
+/**
+ * @brief A builtin command line and the same command run as a program.
+ */
+typedef struct {
+    const char* name;
+    const char* builtin;
+    const char* external;
+} BuiltinLine;
+
+static const BuiltinLine builtin_lines[] = {
+    {"echo", "echo hello world", "/bin/echo hello world"},
+    {"printf", "printf '%s=%d\\n' answer 42", "/usr/bin/printf '%s=%d\\n' answer 42"},
+    {"test", "[ -f cat_input.txt -a 3 -lt 10 ]", "/usr/bin/test -f cat_input.txt -a 3 -lt 10"},
+    {"cat_4k", "cat cat_input.txt", "/bin/cat cat_input.txt"},
+    {NULL, NULL, NULL}
+};
+
+static void write_cat_fixture(void) {
+    FILE* f = fopen("cat_input.txt", "w");
+    if (!f) { perror("cat_input.txt"); exit(EXIT_FAILURE); }
+    for (int i = 0; i < 64; i++) fprintf(f, "%063d\n", i);
+    fclose(f);
+}
+
+static void bench_history_load(long iters) {
+    for (long i = 0; i < iters; i++) {
+        Que q = initQue();
+        read_history_from_file(q, work_dir);
+        destroyQue(q);
+    }
+}
+
+static void bench_history_store(long iters) {
+    Que q = initQue();
+    read_history_from_file(q, work_dir);
+    for (long i = 0; i < iters; i++) {
+        write_history_to_file(q, work_dir);
+    }
+    destroyQue(q);
+}
+
+static char tree_dir[MAX_PATH_LEN * 2];
+
+static void bench_seek(long iters) {
+    for (long i = 0; i < iters; i++) {
+        seek_execute("file_3.txt", tree_dir, &bench_state, false, true, false);
+    }
+}
+
+static char flat_dir[MAX_PATH_LEN * 2];
+
+static void bench_peek_long(long iters) {
+    for (long i = 0; i < iters; i++) {
+        peek_execute(flat_dir, &bench_state, true, false);
+    }
+}
+
+static char* dirdb_query[2];
+
+static void fill_dirdb(long entries) {
+    char path[MAX_PATH_LEN];
+    for (long i = 0; i < entries; i++) {
+        snprintf(path, sizeof(path), "/home/bench/src/team%ld/service%05ld", i % 50, i);
+        dirdb_visit(path);
+    }
+}
+
+static void bench_dirdb_match(long iters) {
+    char best[MAX_PATH_LEN];
+    int num_fragments = dirdb_query[1] ? 2 : 1;
+    for (long i = 0; i < iters; i++) {
+        dirdb_best(dirdb_query, num_fragments, NULL, best, sizeof(best));
+    }
+}
+
+static void bench_dirdb_visit(long iters) {
+    for (long i = 0; i < iters; i++) {
+        dirdb_visit("/home/bench/src/team42/service00042");
+    }
+}
+
+static void bench_proclore(long iters) {
+    for (long i = 0; i < iters; i++) {
+        proclore_execute(getpid(), work_dir, false, 0);
+    }
+}
+
+static void bench_activities(long iters) {
+    for (long i = 0; i < iters; i++) {
+        activities_execute(&bench_state);
+    }
+}
+
+static JobMonitor bench_monitor;
+
+static void bench_activities_frame(long iters) {
+    StrBuf frame;
+    strbuf_init(&frame);
+    for (long i = 0; i < iters; i++) {
+        strbuf_reset(&frame);
+        job_monitor_frame(&bench_monitor, &bench_state, &frame);
+    }
+    strbuf_free(&frame);
+}
+
+static ProcTable bench_procs;
+
+static void bench_proc_table(long iters) {
+    for (long i = 0; i < iters; i++) {
+        proc_table_load(&bench_procs);
+    }
+}
+
+static ProcTable bench_tree_procs;
+
+/**
+ * @brief A synthetic snapshot of BENCH_TREE_PROCS processes, each the child of a pseudo-random earlier one.
+ */
+static void make_tree_procs(void) {
+    bench_tree_procs.procs = calloc(BENCH_TREE_PROCS, sizeof(ProcInfo));
+    if (!bench_tree_procs.procs) return;
+    bench_tree_procs.count = bench_tree_procs.capacity = BENCH_TREE_PROCS;
+    for (int i = 0; i < BENCH_TREE_PROCS; i++) {
+        ProcInfo* proc = &bench_tree_procs.procs[i];
+        proc->pid = i + 1;
+        proc->ppid = i ? (pid_t)(1 + (unsigned)i * 2654435761u % (unsigned)i) : 0;
+        proc->pgid = proc->pid;
+        proc->state = 'S';
+        snprintf(proc->comm, sizeof(proc->comm), "proc%d", i % 100);
+    }
+}
+
+static void bench_proc_tree(long iters) {
+    for (long i = 0; i < iters; i++) {
+        ProcTree tree;
+        proc_tree_build(&tree, &bench_tree_procs);
+        proc_tree_free(&tree);
+    }
+}
+
+static void bench_ping_pattern(long iters) {
+    char* argv[] = {"ping", "sleep", "0", NULL};
+    for (long i = 0; i < iters; i++) {
+        ping_execute(3, argv, &bench_state);
+    }
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr, "Usage: %s [--quick] [--commit <id>] [-o <file>]\n", prog);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char* argv[]) {
+    const char* out_path = NULL;
+    const char* commit = "unknown";
+    sizes = full_sizes;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) sizes = quick_sizes;
+        else if (strcmp(argv[i], "--commit") == 0 && i + 1 < argc) commit = argv[++i];
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) out_path = argv[++i];
+        else usage(argv[0]);
+    }
+
+    // JSON goes to the requested file or the original stdout; the shell code's own
+    // output is sent to /dev/null so terminal speed does not skew the numbers.
+    json_out = out_path ? fopen(out_path, "w") : fdopen(dup(STDOUT_FILENO), "w");
+    if (!json_out) { perror(out_path ? out_path : "stdout"); return EXIT_FAILURE; }
+    int devnull = open("/dev/null", O_RDWR);
+    if (devnull < 0) { perror("/dev/null"); return EXIT_FAILURE; }
+    dup2(devnull, STDIN_FILENO); // No terminal: job-control calls become no-ops
+    dup2(devnull, STDOUT_FILENO);
+    close(devnull);
+
+    snprintf(work_dir, sizeof(work_dir), "/tmp/shellby_bench.XXXXXX");
+    if (!mkdtemp(work_dir) || chdir(work_dir) != 0) { perror("mkdtemp"); return EXIT_FAILURE; }
+    if (!shell_state_init(&bench_state)) return EXIT_FAILURE;
+    g_shell_state = &bench_state;
+    setup_signal_handlers(); // Foreground waits sleep in the event loop, as in the shell
+
+    char hostname[256] = "unknown";
+    gethostname(hostname, sizeof(hostname) - 1);
+    fprintf(json_out, "{\n  \"suite\": \"shellby\",\n  \"commit\": \"%s\",\n  \"host\": \"%s\",\n"
+                      "  \"timestamp\": %ld,\n  \"results\": [", commit, hostname, (long)time(NULL));
+
+    fprintf(stderr, "Running benchmarks in %s\n", work_dir);
+
+    parse_line = "ls -la /usr/include";
+    run_bench("parser/simple", bench_parse, sizes.parse_iters, 1);
+    parse_line = "cat < input.txt | grep -v error | sort -r | uniq -c | head -n 20 >> out.txt &";
+    run_bench("parser/pipeline_5", bench_parse, sizes.parse_iters, 5);
+    run_bench("parser/pipeline_5_cached", bench_parse_cached, sizes.parse_iters, 5);
+
+    run_bench("prompt/render", bench_prompt, sizes.prompt_iters, 1);
+
+    // Full paths, so these start programs rather than the builtins of the same name.
+    spawn_line = "/bin/true";
+    run_bench("spawn/pipeline_1", bench_spawn, sizes.spawn_iters, 1);
+    spawn_line = "/bin/true | /bin/true | /bin/true";
+    run_bench("spawn/pipeline_3", bench_spawn, sizes.spawn_iters, 3);
+    spawn_line = "/bin/true | /bin/true | /bin/true | /bin/true | /bin/true | /bin/true | /bin/true | /bin/true | /bin/true | /bin/true";
+    run_bench("spawn/pipeline_10", bench_spawn, sizes.spawn_iters, 10);
+    spawn_line = "BENCH_A=1 BENCH_B=2 /bin/true";
+    run_bench("spawn/env_override", bench_spawn, sizes.spawn_iters, 1);
+    spawn_line = "BENCH_OUT=$(/bin/echo captured)";
+    run_bench("spawn/command_substitution", bench_spawn, sizes.spawn_iters, 1);
+
+    // Each builtin next to the program it replaces.
+    write_cat_fixture();
+    for (int i = 0; builtin_lines[i].name; i++) {
+        char name[64];
+        spawn_line = builtin_lines[i].builtin;
+        snprintf(name, sizeof(name), "builtin/%s", builtin_lines[i].name);
+        run_bench(name, bench_spawn, sizes.parse_iters, 1);
+        spawn_line = builtin_lines[i].external;
+        snprintf(name, sizeof(name), "builtin/%s_external", builtin_lines[i].name);
+        run_bench(name, bench_spawn, sizes.spawn_iters, 1);
+    }
+
+    process_input_line("bench_fn() { BENCH_ARG=$1; }", &bench_state);
+    spawn_line = "bench_fn value";
+    run_bench("exec/function_call", bench_spawn, sizes.parse_iters, 1);
+
+    snprintf(loop_line, sizeof(loop_line), "for i in $(seq %ld); do BENCH_X=$i; done", sizes.loop_iters);
+    bool full_loop = sizes.loop_iters == 1000000;
+    run_bench(full_loop ? "loop/for_1m" : "loop/for_large", bench_loop, 1, sizes.loop_iters);
+    if (run_bash_loop() == 0) {
+        run_bench(full_loop ? "loop/for_1m_bash" : "loop/for_large_bash", bench_loop_bash, 1, sizes.loop_iters);
+    } else {
+        fprintf(stderr, "  (bash not found: skipping the bash loop)\n");
+    }
+
+    write_history_fixture(sizes.history_small);
+    run_bench("history/load_10k", bench_history_load, 1, sizes.history_small);
+    run_bench("history/store_10k", bench_history_store, 1, sizes.history_small);
+    write_history_fixture(sizes.history_large);
+    run_bench(sizes.history_large >= 1000000 ? "history/load_1m" : "history/load_large",
+              bench_history_load, 1, sizes.history_large);
+    run_bench(sizes.history_large >= 1000000 ? "history/store_1m" : "history/store_large",
+              bench_history_store, 1, sizes.history_large);
+
+    fprintf(stderr, "  (generating fixtures)\n");
+    snprintf(tree_dir, sizeof(tree_dir), "%s/tree", work_dir);
+    make_tree(tree_dir, sizes.seek_depth, sizes.seek_fanout);
+    run_bench("seek/tree", bench_seek, 1, 1);
+
+    snprintf(flat_dir, sizeof(flat_dir), "%s/flat", work_dir);
+    make_flat_dir(flat_dir, sizes.peek_entries);
+    run_bench("peek/long_flat_dir", bench_peek_long, 1, sizes.peek_entries);
+
+    // The shell opened its directory database in work_dir.
+    fill_dirdb(BENCH_DIRDB_ENTRIES);
+    dirdb_query[0] = "team23";
+    dirdb_query[1] = "service00123";
+    run_bench("dirdb/match_30k", bench_dirdb_match, sizes.procfs_iters, BENCH_DIRDB_ENTRIES);
+    dirdb_query[0] = "team7"; // 600 matches
+    dirdb_query[1] = NULL;
+    run_bench("dirdb/match_broad_30k", bench_dirdb_match, sizes.procfs_iters, BENCH_DIRDB_ENTRIES);
+    run_bench("dirdb/visit", bench_dirdb_visit, sizes.parse_iters, 1);
+
+    run_bench("procfs/proclore_self", bench_proclore, sizes.procfs_iters, 1);
+    for (int i = 0; i < BENCH_BG_JOBS; i++) {
+        process_input_line("sleep 600 &", &bench_state);
+    }
+    run_bench("procfs/activities_10_jobs", bench_activities, sizes.procfs_iters, BENCH_BG_JOBS);
+    job_monitor_init(&bench_monitor);
+    run_bench("procfs/activities_watch_frame_10_jobs", bench_activities_frame, sizes.procfs_iters, BENCH_BG_JOBS);
+    job_monitor_free(&bench_monitor);
+    proc_table_load(&bench_procs);
+    run_bench("procfs/table_load", bench_proc_table, sizes.procfs_iters, bench_procs.count);
+    proc_table_free(&bench_procs);
+    make_tree_procs();
+    run_bench("procfs/tree_build_50k", bench_proc_tree, sizes.procfs_iters / 10, BENCH_TREE_PROCS);
+    proc_table_free(&bench_tree_procs);
+    run_bench("ping/pattern_10_jobs", bench_ping_pattern, sizes.procfs_iters, BENCH_BG_JOBS);
+    for (int i = 0; i < bench_state.jobs.count; i++) {
+        kill(-bench_state.jobs.jobs[i]->pgid, SIGKILL);
+    }
+
+    fprintf(json_out, "\n  ]\n}\n");
+    fclose(json_out);
+
+    shell_state_destroy(&bench_state);
+    if (chdir("/") == 0) {
+        nftw(work_dir, remove_entry, 64, FTW_DEPTH | FTW_PHYS);
+    }
+    return EXIT_SUCCESS;
+}
@@ -2,16 +2,70 @@
 #define ACTIVITIES_H_
 
 #include "core/shell_state.h"
+#include "core/procfs.h"
+#include "utils/strbuf.h"
+
+#define ACTIVITIES_WATCH_INTERVAL 1.0 ///< Seconds between 'activities -w' refreshes
+
+/**
+ * @brief A job member being sampled by the monitor.
+ */
+typedef struct {
+    ProcHandle handle;
+    unsigned long long ticks; ///< utime + stime at the previous sample
+    bool seen;                ///< Already counted in the current frame
+} MemberSample;
+
+/**
+ * @brief The state 'activities -w' keeps between frames: an open stat file for
+ *        every live process of a job, so sampling one costs a single pread() and
+ *        CPU usage is the difference from the previous frame.
+ *
+ * A job's processes are its members and whatever they started: those in its
+ * cgroup when 'limit' gave it one, otherwise those in its process group, found
+ * in one snapshot of /proc per frame.
+ */
+typedef struct {
+    MemberSample* samples; ///< Sorted by PID
+    int count;
+    int capacity;
+    ProcTable table;       ///< The latest snapshot, reused from frame to frame
+    long long sampled_ms;  ///< When the previous frame was sampled, 0 before the first
+} JobMonitor;
 
 /**
  * @brief Executes the 'activities' command.
  *
- * Scans the /proc directory to find and list all processes that were
- * spawned by the current shell session. It displays their PID, command name,
- * and current state (Running/Stopped).
+ * Lists the background and stopped jobs of the current shell session. It
+ * displays their PGID, command name, and current state (Running/Stopped).
  *
  * @param state A read-only pointer to the current shell state.
+ * @return Always 0.
+ */
+int activities_execute(const ShellState* state);
+
+void job_monitor_init(JobMonitor* monitor);
+
+/**
+ * @brief Samples every job and appends one frame of the table to 'out'.
+ */
+void job_monitor_frame(JobMonitor* monitor, const ShellState* state, StrBuf* out);
+
+void job_monitor_free(JobMonitor* monitor);
+
+/**
+ * @brief 'activities -w': a table of the jobs with per-job CPU usage, resident
+ *        memory, elapsed time and state summed over their members, refreshed
+ *        in place every 'interval' seconds until 'q', Ctrl+C, or no job is left.
+ * @return 0, or 1 if the output could not be written.
+ */
+int activities_watch(const ShellState* state, double interval);
+
+/**
+ * @brief 'activities -t': each job followed by the process trees under its
+ *        live members, all from a single snapshot of /proc.
+ * @return 0, or 1 if /proc could not be read.
  */
-void activities_execute(const ShellState* state);
+int activities_tree(const ShellState* state);
 
-#endif // ACTIVITIES_H_
\ No newline at end of file
+#endif // ACTIVITIES_H_
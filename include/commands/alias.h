@@ -0,0 +1,26 @@
+#ifndef ALIAS_H_
+#define ALIAS_H_
+
+#include "core/shell_state.h"
+
+/**
+ * @brief Executes the 'alias' command.
+ *
+ *   alias                 - list all aliases, sorted, in a form that can be read back
+ *   alias <name>          - print one alias
+ *   alias <name>=<value>  - define an alias
+ *
+ * An alias is replaced by its text when it is the first word of a command.
+ * A definition takes effect from the next line.
+ *
+ * @return 0 on success, 1 if a name is not an alias or not valid.
+ */
+int alias_execute(int argc, char* argv[], ShellState* state);
+
+/**
+ * @brief Executes the 'unalias' command: 'unalias <name>...' or 'unalias -a' (remove all).
+ * @return 0 on success, 1 if a name is not an alias.
+ */
+int unalias_execute(int argc, char* argv[], ShellState* state);
+
+#endif // ALIAS_H_
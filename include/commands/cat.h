@@ -0,0 +1,24 @@
+#ifndef CAT_H_
+#define CAT_H_
+
+#include "core/shell_state.h"
+
+/**
+ * @brief Executes the 'cat' builtin: cat [-benstuvAET] [file ...]
+ *
+ * Copies the files (or standard input, for none or '-') to standard output.
+ * Without options the data is copied in the kernel where it can be: with
+ * copy_file_range() between regular files (unless appending) and splice()
+ * from anything but a regular file into a pipe, falling back to
+ * read()/write() otherwise. The options number lines (-n, or
+ * -b for non-blank ones), squeeze blank lines (-s), mark line ends (-E), show
+ * tabs (-T) and show other control characters (-v; -A is -vET, -e is -vE,
+ * -t is -vT). -u is accepted and ignored. Reading a terminal or pipe can be
+ * stopped with Ctrl+C.
+ *
+ * @return 0 on success, 1 if a file could not be read or the output written,
+ *         130 if interrupted.
+ */
+int cat_execute(int argc, char* argv[], ShellState* state);
+
+#endif // CAT_H_
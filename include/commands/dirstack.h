@@ -0,0 +1,40 @@
+#ifndef DIRSTACK_H_
+#define DIRSTACK_H_
+
+#include "core/shell_state.h"
+
+/**
+ * @brief Executes 'pushd': pushd [dir | +N | -N]
+ *
+ * With a directory, saves the current one on the stack and warps there.
+ * Without arguments, swaps the current directory with the top of the stack.
+ * +N (counting from the left of 'dirs', from zero) or -N (from the right)
+ * rotates the stack so that entry becomes the current directory.
+ * Prints the stack afterwards, as 'dirs' does.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+int pushd_execute(int argc, char* argv[], ShellState* state);
+
+/**
+ * @brief Executes 'popd': popd [+N | -N]
+ *
+ * Removes the top of the stack and warps to it, or with +N / -N removes
+ * that entry without changing directory. Prints the stack afterwards.
+ *
+ * @return 0 on success, 1 if the stack is empty or the index is out of range.
+ */
+int popd_execute(int argc, char* argv[], ShellState* state);
+
+/**
+ * @brief Executes 'dirs': dirs [-clpv]
+ *
+ * Prints the current directory followed by the stack, top first, with the
+ * home directory shown as '~' (-l prints full paths). -p prints one entry
+ * per line, -v numbers them, and -c clears the stack.
+ *
+ * @return 0 on success, 1 for an unknown option.
+ */
+int dirs_execute(int argc, char* argv[], ShellState* state);
+
+#endif // DIRSTACK_H_
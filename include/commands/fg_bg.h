@@ -8,14 +8,16 @@
  * @brief Brings a background job to the foreground.
  * @param pid The PID of any process within the job to bring to the foreground.
  * @param state A pointer to the current shell state.
+ * @return The job's exit status, or 1 if it could not be resumed.
  */
-void fg_execute(pid_t pid, ShellState* state);
+int fg_execute(pid_t pid, ShellState* state);
 
 /**
  * @brief Resumes a stopped background job, keeping it in the background.
  * @param pid The PID of any process within the stopped job to resume.
  * @param state A pointer to the current shell state.
+ * @return 0 on success, 1 if the job could not be resumed.
  */
-void bg_execute(pid_t pid, ShellState* state);
+int bg_execute(pid_t pid, ShellState* state);
 
 #endif // FG_BG_H_
\ No newline at end of file
@@ -1,14 +1,21 @@
 #ifndef IMAN_H_
 #define IMAN_H_
 
+#include <stdbool.h>
+
 /**
  * @brief Executes the 'iman' command.
  *
- * Fetches the man page for a given command from an online source (man.he.net)
- * and displays it to the user.
+ * By default renders the locally installed man page (gzip'd roff found under
+ * MANPATH) and caches the rendered text, memory-mapped on repeat lookups.
+ * With use_remote, fetches the page over HTTP from man.he.net instead, or from
+ * the server named by IMAN_SERVER=host[:port].
  *
  * @param command_name The name of the command to look up (e.g., "ls", "grep").
+ * @param section The manual section to search (e.g., "3"), or NULL for all.
+ * @param use_remote True to use the HTTP backend instead of local pages.
+ * @return 0 if a page was shown, 1 otherwise.
  */
-void iman_execute(const char* command_name);
+int iman_execute(const char* command_name, const char* section, bool use_remote);
 
 #endif // IMAN_H_
\ No newline at end of file
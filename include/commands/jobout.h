@@ -0,0 +1,26 @@
+#ifndef JOBOUT_H_
+#define JOBOUT_H_
+
+#include "core/shell_state.h"
+
+/**
+ * @brief Executes the 'jobout' command: shows the output captured from a
+ *        background job started with 'set -o jobcapture' (see core/job_output.h).
+ *
+ *   jobout [<pid>]     - print what the job has written so far
+ *   jobout -f [<pid>]  - print it, then keep printing new output until the job
+ *                        closes its output or Ctrl+C is pressed
+ *   jobout -l          - list the jobs with captured output
+ *
+ * <pid> is the job's PGID or the PID of any of its processes; without it, the
+ * most recent job with captured output is used. Jobs that have ended stay
+ * available until JOB_OUTPUT_KEEP newer ones have.
+ *
+ * @param argc The number of arguments (including "jobout").
+ * @param argv The argument vector.
+ * @param state A pointer to the current shell state.
+ * @return 0 on success, 1 on usage errors or if there is no such job.
+ */
+int jobout_execute(int argc, char* argv[], ShellState* state);
+
+#endif // JOBOUT_H_
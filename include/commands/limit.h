@@ -0,0 +1,27 @@
+#ifndef LIMIT_H_
+#define LIMIT_H_
+
+#include "core/cgroup.h"
+#include "core/jobs.h"
+#include "core/shell_state.h"
+
+/**
+ * @brief Parses and removes the prefix of 'limit [-m <size>] [-c <percent>] [-p <count>] [--] command...'.
+ *
+ * 'limit' is not a builtin: the executor strips it from the first stage of a
+ * pipeline, and the whole job then runs in a cgroup of its own with these
+ * limits (see core/cgroup.h). The size takes a K, M, G or T suffix; the CPU
+ * share is a percentage of one CPU, so '-c 150%' allows one and a half.
+ *
+ * @param cmd The expanded first stage; args[0] is "limit". On success it holds the command.
+ * @return False on a usage error (already reported).
+ */
+bool limit_parse(SimpleCommand* cmd, CgroupLimits* limits);
+
+/**
+ * @brief Prints to stderr what a finished job that ran in its own cgroup used:
+ *        CPU time, peak memory, and processes killed for exceeding the limit.
+ */
+void limit_report(const Job* job);
+
+#endif // LIMIT_H_
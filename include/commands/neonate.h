@@ -8,7 +8,8 @@
  * until the 'x' key is pressed.
  *
  * @param time_arg The interval in seconds between printing the PID.
+ * @return 0 on success, 1 if the terminal could not be set up.
  */
-void neonate_execute(int time_arg);
+int neonate_execute(int time_arg);
 
 #endif // NEONATE_H_
\ No newline at end of file
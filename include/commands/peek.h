@@ -1,6 +1,8 @@
 #ifndef PEEK_H_
 #define PEEK_H_
 
+#include "core/shell_state.h"
+
 #include <sys/stat.h> // For mode_t
 #include <stdbool.h>
 
@@ -16,10 +18,12 @@ void print_file_permissions(mode_t perms);
  * This function consolidates the logic for peek, peek -l, peek -a, peek -la.
  *
  * @param dir_arg The directory to peek into. If NULL or empty, peeks current directory.
- * @param home_dir The user's home directory (for ~ expansion).
+ * @param state The shell state: the home directory (for ~ expansion) and the
+ *              directory descriptor relative paths are opened from.
  * @param list_long Format similar to 'ls -l'.
  * @param show_hidden Show hidden files (starting with '.').
+ * @return 0 on success, 1 if the directory could not be listed.
  */
-void peek_execute(const char* dir_arg, const char* home_dir, bool list_long, bool show_hidden);
+int peek_execute(const char* dir_arg, const ShellState* state, bool list_long, bool show_hidden);
 
 #endif // PEEK_H_
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef PIN_H_
+#define PIN_H_
+
+#include "core/placement.h"
+#include "core/shell_state.h"
+
+/**
+ * @brief Parses and removes the prefix of 'pin [--reset] [-c <cpus>] [-n <nice>] [--io <class>] [--] [command...]'.
+ *
+ * Like 'limit', 'pin' is not a builtin: the executor strips it from the first
+ * stage of a pipeline, and every process of the job starts with the placement
+ * (see core/placement.h), on top of the defaults set by 'pin' alone.
+ *
+ * @param cmd The expanded first stage; args[0] is "pin". On success it holds
+ *        the command, or nothing (argc 0) if only options were given.
+ * @param reset Set if '--reset' was given: the defaults are dropped before 'placement' applies.
+ * @return False on a usage error (already reported).
+ */
+bool pin_parse(SimpleCommand* cmd, Placement* placement, bool* reset);
+
+/**
+ * @brief 'pin' without a command: adds 'placement' to the defaults every job
+ *        starts with (clearing them first with 'reset'), then prints them.
+ * @return The exit status.
+ */
+int pin_set_defaults(ShellState* state, const Placement* placement, bool reset);
+
+#endif // PIN_H_
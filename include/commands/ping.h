@@ -1,14 +1,20 @@
 #ifndef PING_H_
 #define PING_H_
 
-#include <sys/types.h> // For pid_t
+#include "core/shell_state.h"
 
 /**
- * @brief Executes the 'ping' command to send a signal to a process.
+ * @brief Executes 'ping <target>... <signal>': sends a signal to processes.
  *
- * @param pid The Process ID of the target process.
- * @param signal_number The signal number to send.
+ * The signal is a number, wrapped into 0-31 (so -1 is 31), or a name ("TERM",
+ * "SIGKILL"). A target is a PID, '-PGID' for a process group, '+PID' for a
+ * process and all its descendants, '%job' for a job of this shell, or a
+ * pattern matched against process names (as in 'ping "worker*" TERM'). Targets are resolved against one snapshot of
+ * /proc and signalled through pidfds, so a PID reused in the meantime is never
+ * hit. One line is printed per target.
+ *
+ * @return 0 if every target was signalled, 1 otherwise.
  */
-void ping_execute(pid_t pid, int signal_number);
+int ping_execute(int argc, char* argv[], ShellState* state);
 
-#endif // PING_H_
\ No newline at end of file
+#endif // PING_H_
@@ -0,0 +1,32 @@
+#ifndef PRINT_H_
+#define PRINT_H_
+
+#include "core/shell_state.h"
+
+/**
+ * @brief Executes the 'echo' builtin: echo [-neE] [arg ...]
+ *
+ * Prints the arguments separated by spaces, followed by a newline unless -n is
+ * given. With -e, backslash escapes are interpreted (\n, \t, \0nnn, \xHH,
+ * and \c, which ends the output); -E turns that off again. An argument that
+ * is not made only of these option letters ends the options, as in bash.
+ *
+ * @return 0 on success, 1 if the output could not be written.
+ */
+int echo_execute(int argc, char* argv[], ShellState* state);
+
+/**
+ * @brief Executes the 'printf' builtin: printf format [arg ...]
+ *
+ * Supports the C conversions %s %c %d %i %o %u %x %X %e %E %f %F %g %G %a %A,
+ * with flags, width and precision ('*' takes them from the arguments), plus %b
+ * (an argument with echo -e escapes) and %%. Backslash escapes in the format
+ * are interpreted. The format is reused until the arguments are used up.
+ * A numeric argument may be a character constant such as "'A".
+ *
+ * @return 0 on success, 1 if an argument was not a valid number or the output
+ *         could not be written, 2 on usage errors.
+ */
+int printf_execute(int argc, char* argv[], ShellState* state);
+
+#endif // PRINT_H_
@@ -1,15 +1,43 @@
 #ifndef PROCLORE_H_
 #define PROCLORE_H_
 
+#include <stdbool.h>
+
+#define PROCLORE_SAMPLE_INTERVAL 0.25 ///< Seconds over which 'proclore -x' measures CPU usage
+#define PROCLORE_WATCH_INTERVAL 1.0   ///< Seconds between 'proclore -w' refreshes
+
 /**
  * @brief Displays information about a process.
  *
  * Information includes PID, process state, process group, virtual memory size,
- * and executable path (relative to home_dir if applicable).
+ * and executable path (relative to home_dir if applicable). With 'extended'
+ * ('proclore -x') it adds resident memory (RSS and PSS), threads, open file
+ * descriptors, the command line, and CPU usage sampled over 'interval' seconds.
  *
  * @param pid The Process ID to get information for.
  * @param home_dir The user's home directory path (for path relativization).
+ * @param extended Add the extended fields.
+ * @param interval Seconds between the two CPU samples (extended only).
+ * @return 0 on success, 1 if the process could not be inspected.
+ */
+int proclore_execute(int pid, const char* home_dir, bool extended, double interval);
+
+/**
+ * @brief 'proclore -w': the extended display, refreshed in place every 'interval'
+ *        seconds until Ctrl+C, 'q', or the process exits.
+ *
+ * The process's procfs files stay open and are re-read with pread(), so each
+ * refresh costs a handful of system calls.
+ *
+ * @return 0, or 1 if the process could not be inspected.
+ */
+int proclore_watch(int pid, const char* home_dir, double interval);
+
+/**
+ * @brief 'proclore -t': the process and all its descendants as a tree,
+ *        from a single snapshot of /proc.
+ * @return 0, or 1 if the process does not exist.
  */
-void proclore_execute(int pid, const char* home_dir);
+int proclore_tree(int pid);
 
-#endif // PROCLORE_H_
\ No newline at end of file
+#endif // PROCLORE_H_
@@ -0,0 +1,23 @@
+#ifndef SET_H_
+#define SET_H_
+
+#include "core/shell_state.h"
+
+/**
+ * @brief Executes the 'set' command.
+ *
+ * Toggles shell options:
+ *   set -o            - list all options and their values
+ *   set -o <option>   - enable an option
+ *   set +o <option>   - disable an option
+ *
+ * Options: pipefail, noclobber, jobcapture.
+ *
+ * @param argc The number of arguments (including "set").
+ * @param argv The argument vector.
+ * @param state A pointer to the current shell state.
+ * @return 0 on success, 1 on usage errors or unknown options.
+ */
+int set_execute(int argc, char* argv[], ShellState* state);
+
+#endif // SET_H_
@@ -0,0 +1,19 @@
+#ifndef SHELLSTAT_H_
+#define SHELLSTAT_H_
+
+/**
+ * @brief Executes the 'shellstat' command.
+ *
+ * Controls and reports the shell's internal tracing:
+ *   shellstat               - print per-phase latency histograms
+ *   shellstat on|off        - enable or disable tracing
+ *   shellstat reset         - discard all recorded spans
+ *   shellstat export <file> - write recorded spans as Chrome trace JSON
+ *
+ * @param argc The number of arguments (including "shellstat").
+ * @param argv The argument vector.
+ * @return 0 on success, 1 on usage or export errors.
+ */
+int shellstat_execute(int argc, char* argv[]);
+
+#endif // SHELLSTAT_H_
@@ -0,0 +1,23 @@
+#ifndef TEST_H_
+#define TEST_H_
+
+#include "core/shell_state.h"
+
+/**
+ * @brief Executes the 'test' builtin, also run as '[' (which needs a closing ']').
+ *
+ * Evaluates an expression built from:
+ *   -n s, -z s, s1 = s2, s1 == s2, s1 != s2, s1 < s2, s1 > s2   - strings
+ *   n1 -eq n2, -ne, -lt, -le, -gt, -ge                          - integers
+ *   -e, -f, -d, -b, -c, -p, -S, -L (or -h), -s, -r, -w, -x,
+ *   -u, -g, -k, -O, -G file; -t fd                              - files
+ *   f1 -nt f2, f1 -ot f2, f1 -ef f2                             - file comparisons
+ *   ! expr, expr -a expr, expr -o expr, ( expr )
+ * With one to four arguments the POSIX rules decide how they are read, so
+ * 'test -n' and 'test ! = x' mean what POSIX says they mean.
+ *
+ * @return 0 if the expression is true, 1 if false, 2 on a syntax error.
+ */
+int test_execute(int argc, char* argv[], ShellState* state);
+
+#endif // TEST_H_
@@ -0,0 +1,23 @@
+#ifndef TIMEOUT_H_
+#define TIMEOUT_H_
+
+#include "core/job_timer.h"
+#include "core/shell_state.h"
+
+/**
+ * @brief Parses and removes the prefix of 'timeout [-s <signal>] [-k <grace>] <duration> command...'.
+ *
+ * Like 'limit', 'timeout' is not a builtin: the executor strips it from the
+ * first stage of a pipeline and the whole job gets a deadline (see
+ * core/job_timer.h). When it passes, the job's process group is sent the
+ * signal (SIGTERM by default), then SIGKILL after the grace period if one is
+ * given; the job's status is TIMEOUT_STATUS, or 128 + SIGKILL if it had to be
+ * killed. Durations are seconds, with an optional s, m, h or d suffix and
+ * fractions allowed ("0.5", "2m"); a duration of 0 sets no deadline.
+ *
+ * @param cmd The expanded first stage; args[0] is "timeout". On success it holds the command.
+ * @return False on a usage error (already reported).
+ */
+bool timeout_parse(SimpleCommand* cmd, TimeoutSpec* spec);
+
+#endif // TIMEOUT_H_
@@ -1,20 +1,40 @@
 #ifndef WARP_H_
 #define WARP_H_
 
+#include "core/shell_state.h"
+
 /**
- * @brief Changes the current working directory.
+ * @brief Changes the current working directory and prints the new one.
  *
  * Supports ".", "..", "-", "~", "~/path", and absolute/relative paths.
- * Updates prev_dir_warp with the directory before the change if successful.
+ * The shell's logical directory (PWD) and previous directory (OLDPWD) are
+ * updated on success (see core/cwd.h), and the new directory is recorded in
+ * the frecency database (core/dirdb.h).
  *
  * @param dir_arg The target directory argument string.
- * @param home_dir The user's home directory path.
- * @param prev_dir_warp A buffer storing the previous working directory. This function
- *                      will return the CWD *before* a successful warp.
- * @return A dynamically allocated string containing the path of the directory *before*
- *         a successful warp. The caller must free this string. Returns an empty,
- *         dynamically allocated string on failure or if OLDPWD was not set for "warp -".
+ * @param state The shell state.
+ * @return True on success, false on failure or if OLDPWD was not set for "warp -".
+ */
+bool warp(const char* dir_arg, ShellState* state);
+
+/**
+ * @brief As warp(), without printing the new directory (for pushd and popd).
+ */
+bool warp_quiet(const char* dir_arg, ShellState* state);
+
+/**
+ * @brief 'warp -z': changes to the most frecent visited directory matching the fragments.
+ *
+ * Directories that no longer exist are dropped from the database on the way.
+ *
+ * @return True on success, false if nothing matched.
+ */
+bool warp_frecent(char* const fragments[], int num_fragments, ShellState* state);
+
+/**
+ * @brief 'warp -z -l': prints the matching directories with their scores, best first.
+ * @return 0 if any matched, 1 otherwise.
  */
-char* warp(const char* dir_arg, const char* home_dir, const char* prev_dir_warp);
+int warp_list_frecent(char* const fragments[], int num_fragments);
 
-#endif // WARP_H_
\ No newline at end of file
+#endif // WARP_H_
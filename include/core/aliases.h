@@ -0,0 +1,46 @@
+#ifndef ALIASES_H_
+#define ALIASES_H_
+
+#include "utils/strmap.h"
+
+#include <stdbool.h>
+
+/**
+ * @brief The shell's aliases. They are expanded by the parser, which has no
+ *        access to the shell state, so the table lives in this module.
+ */
+
+/**
+ * @brief The text an alias stands for, or NULL if 'name' is not an alias.
+ */
+const char* alias_get(const char* name);
+
+/**
+ * @brief Defines or redefines an alias. 'value' is copied.
+ * @return True on success, false if memory could not be allocated (already reported).
+ */
+bool alias_set(const char* name, const char* value);
+
+/**
+ * @brief Removes an alias.
+ * @return True if it was defined.
+ */
+bool alias_remove(const char* name);
+
+/**
+ * @brief Removes every alias.
+ */
+void alias_clear(void);
+
+/**
+ * @brief The table, for listing. Values are the alias texts (char*).
+ */
+const StrMap* alias_table(void);
+
+/**
+ * @brief A counter bumped on every change, so a command parsed with older
+ *        definitions can be recognized (see parse_cached()).
+ */
+unsigned alias_generation(void);
+
+#endif // ALIASES_H_
@@ -0,0 +1,153 @@
+#ifndef AST_H_
+#define AST_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief A piece of a word: literal text, or a parameter to expand later.
+ *
+ * The lexer records expansions as separate parts, so expanding a word never
+ * has to re-scan its text and the same tree can be executed many times.
+ */
+typedef enum {
+    PART_LITERAL,     ///< Text taken as-is (quotes and escapes already removed)
+    PART_PARAM,       ///< $name, ${name} or a special parameter such as $?
+    PART_COMMAND,     ///< $(command): replaced by the command's output
+    PART_PROCESS_IN,  ///< <(command): a /dev/fd path to read the command's output from
+    PART_PROCESS_OUT  ///< >(command): a /dev/fd path whose contents become the command's input
+} WordPartType;
+
+struct Node;
+
+typedef struct {
+    WordPartType type;
+    char* text;    ///< The literal text, the parameter name, or the command's source
+    bool quoted;   ///< For parameters and $(...): appeared inside double quotes
+    struct Node* command; ///< For substitutions: the command, parsed once by the lexer (NULL if empty)
+} WordPart;
+
+typedef struct {
+    WordPart* parts;
+    int num_parts;
+    int parts_capacity;
+    bool has_quotes; ///< Any part of the word was quoted or escaped
+    size_t assign_len; ///< For a NAME=value word: the length of "NAME=" (0 otherwise)
+} Word;
+
+typedef enum {
+    REDIR_INPUT,      ///< < file
+    REDIR_OUTPUT,     ///< > file
+    REDIR_CLOBBER,    ///< >| file (overwrites even with noclobber set)
+    REDIR_APPEND,     ///< >> file
+    REDIR_READ_WRITE, ///< <> file
+    REDIR_DUP_INPUT,  ///< <& n, or <&- to close
+    REDIR_DUP_OUTPUT, ///< >& n, or >&- to close
+    REDIR_OUTPUT_ALL, ///< &> file (stdout and stderr)
+    REDIR_APPEND_ALL, ///< &>> file
+    REDIR_HEREDOC,    ///< << delimiter; the target is the body
+    REDIR_HERESTRING  ///< <<< word
+} RedirectType;
+
+typedef struct {
+    RedirectType type;
+    int fd;       ///< The descriptor written before the operator (2 in 2>), or -1 for the default
+    Word target;
+} Redirect;
+
+typedef enum {
+    NODE_COMMAND,    ///< A simple command: words and redirections
+    NODE_PIPELINE,   ///< Two or more stages connected by '|'
+    NODE_AND,        ///< left && right
+    NODE_OR,         ///< left || right
+    NODE_SEQUENCE,   ///< left ; right
+    NODE_BACKGROUND, ///< left &
+    NODE_GROUP,      ///< { left; }
+    NODE_FUNCTION,   ///< name() left: words[0] is the name, left the body
+    NODE_IF,         ///< if left; then right; else alternate; fi (an elif is a nested IF)
+    NODE_WHILE,      ///< while left; do right; done
+    NODE_UNTIL,      ///< until left; do right; done
+    NODE_FOR         ///< for words[0] in words[1..]; do right; done
+} NodeType;
+
+/**
+ * @brief A node of the command tree built by the parser.
+ */
+typedef struct Node {
+    NodeType type;
+    int refs;            ///< Owners of this node; node_free() releases one (see node_retain())
+
+    struct Node* left;   ///< AND/OR/SEQUENCE: first operand; BACKGROUND/GROUP: the body; IF/WHILE/UNTIL: the condition
+    struct Node* right;  ///< AND/OR/SEQUENCE: second operand; IF: the 'then' part; WHILE/UNTIL/FOR: the body
+    struct Node* alternate; ///< IF: the 'elif' or 'else' part (NULL if there is none)
+
+    struct Node** stages; ///< PIPELINE: the stages, in order
+    int num_stages;
+    int stages_capacity;
+
+    Word* words;          ///< COMMAND: the command name and arguments; FOR: the variable, then the list
+    int num_words;
+    int words_capacity;
+    Redirect* redirects;  ///< COMMAND and compound commands: redirections, in source order
+    int num_redirects;
+    int redirects_capacity;
+} Node;
+
+/**
+ * @brief Allocates a zeroed node of the given type.
+ * @return The node, or NULL if memory could not be allocated.
+ */
+Node* node_new(NodeType type);
+
+/**
+ * @brief Releases one reference to a node; the last one frees it and everything
+ *        below it. Accepts NULL.
+ */
+void node_free(Node* node);
+
+/**
+ * @brief Adds a reference to a node, so it outlives the tree it was parsed in
+ *        (a function body, or a tree kept in the parse cache).
+ * @return The node.
+ */
+Node* node_retain(Node* node);
+
+/**
+ * @brief Appends a stage to a pipeline node, taking ownership of it.
+ */
+bool node_add_stage(Node* pipeline, Node* stage);
+
+/**
+ * @brief Appends a word to a command node, taking ownership of its parts.
+ */
+bool node_add_word(Node* command, Word* word);
+
+/**
+ * @brief Appends a redirection to a command or compound command node, taking ownership of the target.
+ * @param fd The descriptor to redirect, or -1 for the operator's default.
+ */
+bool node_add_redirect(Node* command, RedirectType type, int fd, Word* target);
+
+/**
+ * @brief Appends a part to a word. 'text' is copied.
+ */
+bool word_add_part(Word* word, WordPartType type, const char* text, bool quoted);
+
+/**
+ * @brief Appends a substitution part to a word, taking ownership of 'command'.
+ *        'text' (the command's source) is copied.
+ */
+bool word_add_command_part(Word* word, WordPartType type, const char* text, struct Node* command, bool quoted);
+
+/**
+ * @brief Frees the parts of a word and resets it to empty.
+ */
+void word_clear(Word* word);
+
+/**
+ * @brief True if the word is exactly 'text' with no quoting or expansions,
+ *        as reserved words like '{' and '}' must be.
+ */
+bool word_is_bare(const Word* word, const char* text);
+
+#endif // AST_H_
@@ -0,0 +1,26 @@
+#ifndef BUILTINS_H_
+#define BUILTINS_H_
+
+#include "core/shell_state.h"
+
+/**
+ * @brief A builtin command's entry point.
+ * @param argc The number of arguments (including the command name).
+ * @param argv The NULL-terminated argument vector.
+ * @param state The current shell state.
+ * @return The command's exit status (0 for success).
+ */
+typedef int (*BuiltinFunc)(int argc, char* argv[], ShellState* state);
+
+typedef struct {
+    const char* name;
+    BuiltinFunc func;
+} Builtin;
+
+/**
+ * @brief Looks up a builtin command by name.
+ * @return The builtin, or NULL if 'name' is not a builtin.
+ */
+const Builtin* builtin_lookup(const char* name);
+
+#endif // BUILTINS_H_
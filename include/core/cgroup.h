@@ -0,0 +1,90 @@
+#ifndef CGROUP_H_
+#define CGROUP_H_
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+/**
+ * @brief Per-job cgroup v2 leaves, for 'limit'.
+ *
+ * A job started with limits gets a cgroup of its own, created next to the
+ * shell before anything is forked. Each process of the job is created
+ * directly inside it with clone3(CLONE_INTO_CGROUP); on kernels without it,
+ * the forked child moves itself in before it execs. Children the job starts
+ * stay in the cgroup, so its counters cover the whole pipeline.
+ *
+ * The parent is $SHELLBY_CGROUP if set (a delegated cgroup directory),
+ * otherwise the shell's own cgroup on the cgroup2 mount. Without a usable
+ * cgroup v2 hierarchy the job simply runs without limits.
+ */
+
+/**
+ * @brief Limits for a job's cgroup; a zero field is not limited.
+ */
+typedef struct {
+    long long memory_max; ///< memory.max, in bytes
+    int cpu_percent;      ///< cpu.max as a share of one CPU (150 = one and a half CPUs)
+    int pids_max;         ///< pids.max
+} CgroupLimits;
+
+/**
+ * @brief A cgroup created for one job.
+ */
+typedef struct {
+    int dir_fd;  ///< The cgroup's directory, for CLONE_INTO_CGROUP and reading its files
+    char* path;  ///< Absolute path of the directory
+} Cgroup;
+
+/**
+ * @brief What the processes of a cgroup used, read back when the job is done.
+ */
+typedef struct {
+    long long usage_usec;  ///< CPU time, user and system
+    long long user_usec;
+    long long system_usec;
+    long long memory_peak; ///< Bytes, or -1 without the memory controller
+    long long oom_kills;   ///< Processes killed for exceeding memory.max, or -1 if unknown
+} CgroupUsage;
+
+/**
+ * @brief Creates a cgroup for a job and applies 'limits' to it.
+ *
+ * A limit whose controller is not available is skipped with a warning; the
+ * job still gets the cgroup, for accounting.
+ *
+ * @param parent_dir The delegated cgroup directory to create it in ($SHELLBY_CGROUP),
+ *        or NULL for the shell's own cgroup.
+ * @return The cgroup, or NULL if none could be created (the reason is
+ *         reported, and the job should run without one).
+ */
+Cgroup* cgroup_create(const char* parent_dir, const CgroupLimits* limits);
+
+/**
+ * @brief fork(), with the child starting inside 'cgroup'.
+ * @return As fork(): the child's PID in the parent, 0 in the child, -1 on failure.
+ */
+pid_t cgroup_fork(const Cgroup* cgroup);
+
+/**
+ * @brief Reads the cgroup's cpu.stat, memory.peak and memory.events.
+ * @return False if cpu.stat could not be read.
+ */
+bool cgroup_read_usage(const Cgroup* cgroup, CgroupUsage* usage);
+
+/**
+ * @brief Closes the cgroup and removes its directory, unless processes that
+ *        outlived the job are still in it. NULL is ignored.
+ */
+void cgroup_destroy(Cgroup* cgroup);
+
+/**
+ * @brief Moves the shell back into the cgroup it left to enable controllers
+ *        for its jobs, and removes its "shellby-<pid>" leaf; for shell exit.
+ *
+ * The controllers the shell enabled are disabled again first, unless other
+ * cgroups below the parent remain. The leaf stays while jobs started in it
+ * are still running. Does nothing if the shell never moved.
+ */
+void cgroup_leave_leaf(void);
+
+#endif // CGROUP_H_
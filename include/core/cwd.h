@@ -0,0 +1,48 @@
+#ifndef CWD_H_
+#define CWD_H_
+
+#include "core/shell_state.h"
+
+/**
+ * @brief The shell's logical working directory.
+ *
+ * The shell keeps the directory it is in as text (state->cwd, exported as
+ * PWD) together with an O_PATH descriptor for it (state->cwd_fd), and only
+ * the directory-changing builtins update them. The prompt, 'pwd' and the
+ * builtins that take paths use these instead of asking the kernel with
+ * getcwd(), which walks up the tree on every call. The path is logical: after
+ * 'warp link/..' through a symbolic link it reads as the user typed it,
+ * as with 'cd -L' in other shells.
+ */
+
+/**
+ * @brief Sets up the logical directory at startup: $PWD if it names the
+ *        current directory, otherwise what getcwd() says. Exports PWD.
+ * @return False if the current directory cannot be determined (already reported).
+ */
+bool cwd_init(ShellState* state);
+
+/**
+ * @brief Closes the directory descriptor.
+ */
+void cwd_destroy(ShellState* state);
+
+/**
+ * @brief Changes to 'path', absolute or relative to the logical directory.
+ *
+ * '.' and '..' are resolved in the text, as 'cd -L' does; if that names no
+ * directory (a '..' after a symbolic link to a place whose parent differs),
+ * the path is followed physically instead. On success the old directory
+ * becomes state->prev_dir, and PWD and OLDPWD are exported.
+ *
+ * @return False with errno set if the directory could not be entered; nothing changes then.
+ */
+bool cwd_change(ShellState* state, const char* path);
+
+/**
+ * @brief Makes 'path' absolute against the logical directory, resolving '.' and '..' in the text.
+ * @return False if the result does not fit in 'size' bytes.
+ */
+bool cwd_absolute(const ShellState* state, const char* path, char* out, size_t size);
+
+#endif // CWD_H_
@@ -0,0 +1,74 @@
+#ifndef DIRDB_H_
+#define DIRDB_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief The frecency database of visited directories, used by 'warp -z'.
+ *
+ * Every directory the shell changes into is recorded in a memory-mapped file
+ * (DIRDB_FILENAME in the home directory) shared by all running shells, which
+ * take an flock() around each access. Entries are packed records holding the
+ * path, a visit rank, the time of the last visit and hashed signatures of the
+ * character pairs in the path. Each shell indexes the signatures as bitmaps,
+ * so a query rejects nearly all entries a 64-entry word at a time before
+ * comparing any text. When the ranks add up to more than a limit, all of them
+ * are scaled down and entries falling below one visit are dropped, so the file
+ * stays small without any per-entry bookkeeping.
+ *
+ * Every function is a no-op (or finds nothing) if the file could not be opened.
+ */
+
+/**
+ * @brief A directory matched by dirdb_list().
+ */
+typedef struct {
+    char* path;
+    double score; ///< Rank weighted by how recently the directory was visited
+} DirMatch;
+
+/**
+ * @brief Opens (creating if needed) the database at 'path'.
+ * @return False if it could not be opened (already reported); the shell runs on without it.
+ */
+bool dirdb_open(const char* path);
+
+/**
+ * @brief Unmaps and closes the database.
+ */
+void dirdb_close(void);
+
+/**
+ * @brief Records a visit to the absolute directory 'path'.
+ */
+void dirdb_visit(const char* path);
+
+/**
+ * @brief Forgets 'path', e.g. because the directory no longer exists.
+ */
+void dirdb_remove(const char* path);
+
+/**
+ * @brief Finds the highest-scoring directory matching the fragments.
+ *
+ * A directory matches if every fragment occurs in its path, case-insensitively
+ * and in order, with the last fragment in the final component (unless that
+ * fragment contains a '/').
+ *
+ * @param exclude A path that never matches (the current directory), or NULL.
+ * @param out Receives the path.
+ * @return True if a directory matched.
+ */
+bool dirdb_best(char* const fragments[], int num_fragments, const char* exclude, char* out, size_t out_size);
+
+/**
+ * @brief Lists the directories matching the fragments (all of them for none), best first.
+ * @param out Set to an array to release with dirdb_free_matches().
+ * @return The number of matches, or -1 on allocation failure (already reported).
+ */
+int dirdb_list(char* const fragments[], int num_fragments, DirMatch** out);
+
+void dirdb_free_matches(DirMatch* matches, int count);
+
+#endif // DIRDB_H_
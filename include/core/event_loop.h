@@ -0,0 +1,50 @@
+#ifndef EVENT_LOOP_H_
+#define EVENT_LOOP_H_
+
+#include "core/signals.h"
+
+#define EVENT_LOOP_MAX_WATCHERS 64
+
+/**
+ * Set in the result of event_loop_run_once() when 'wait_fd' became ready.
+ * The other bits are SIGNAL_EVENT_* values from core/signals.h.
+ */
+#define EVENT_FD_READY 0x100
+
+/**
+ * @brief Callback for a watched file descriptor.
+ * @param fd The descriptor that became ready.
+ * @param revents The poll(2) revents for it.
+ * @param data The pointer given to event_loop_add().
+ */
+typedef void (*EventHandler)(int fd, short revents, void* data);
+
+/**
+ * @brief Registers a descriptor to be watched by every event_loop_run_once() call.
+ * @param fd The descriptor.
+ * @param events poll(2) events to wait for (e.g., POLLIN).
+ * @param handler Called from the main loop when the descriptor is ready.
+ * @param data Passed through to the handler.
+ * @return 0 on success, -1 if the watcher table is full.
+ */
+int event_loop_add(int fd, short events, EventHandler handler, void* data);
+
+/**
+ * @brief Stops watching a descriptor. Safe to call from inside a handler.
+ */
+void event_loop_remove(int fd);
+
+/**
+ * @brief Waits once for signals, registered descriptors and, optionally, one
+ *        more descriptor the caller is interested in (e.g., the terminal).
+ *
+ * Signals are dispatched through signals_dispatch() and watcher callbacks are
+ * run before returning, all on the calling thread.
+ *
+ * @param wait_fd An extra descriptor to wait for readability on, or -1.
+ * @param timeout_ms Timeout in milliseconds, or -1 to wait indefinitely.
+ * @return A mask of EVENT_FD_READY and SIGNAL_EVENT_* bits (0 on timeout).
+ */
+int event_loop_run_once(int wait_fd, int timeout_ms);
+
+#endif // EVENT_LOOP_H_
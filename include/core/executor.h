@@ -1,17 +1,100 @@
 #ifndef EXECUTOR_H_
 #define EXECUTOR_H_
 
+#include "core/ast.h"
+#include "core/parser.h"
 #include "core/shell_state.h"
+#include "utils/strbuf.h"
 
 /**
- * @brief Processes a raw line of input from the user.
+ * @brief Parses and runs a line (or several lines) of input.
  *
- * This is the main entry point after receiving input. It handles splitting by ';',
- * deals with 'pastevents execute', and then calls the parser and executor for each command.
+ * This is the main entry point after receiving input. It substitutes
+ * 'pastevents execute', parses the text into a command tree and evaluates it:
+ * '&&' and '||' short-circuit, ';' and newlines sequence, '{ ...; }' groups.
+ * The status of the last command is left in state->last_exit_status ($?).
  *
- * @param input_line The raw string from the user.
+ * @param input_line The text to run. It is not modified.
  * @param state The current state of the shell.
+ * @return False if the command is not finished yet (e.g., the text ends with
+ *         '&&' or inside quotes): nothing was run, and the caller should append
+ *         the next line and call again. True otherwise.
  */
-void process_input_line(char* input_line, ShellState* state);
+bool process_input_line(const char* input_line, ShellState* state);
+
+/**
+ * @brief A command being read a line at a time, from a script or at the "> " prompt.
+ */
+typedef struct {
+    StrBuf text;          ///< The lines read so far
+    HeredocEnd* heredocs; ///< Here-document bodies the text ends inside of (see parse_program_open())
+    int num_heredocs;
+    int heredoc;          ///< The body that the next line belongs to
+} PendingCommand;
+
+void pending_command_init(PendingCommand* pending);
+
+/**
+ * @brief Adds a line to the command and runs it with process_input_line() once it is complete.
+ *
+ * While the text ends inside here-document bodies, a line is only compared
+ * with the delimiter, and the text is parsed again after the last one.
+ *
+ * @param line The line, without its '\n'.
+ * @return True if the command ran (or failed) and the text was cleared; false
+ *         if it needs more lines.
+ */
+bool pending_command_add(PendingCommand* pending, const char* line, size_t len, ShellState* state);
+
+/**
+ * @brief Drops the unfinished command (Ctrl+C at "> ", or the end of input).
+ */
+void pending_command_reset(PendingCommand* pending);
+
+void pending_command_free(PendingCommand* pending);
+
+/**
+ * @brief Runs a command tree with its output going into a pipe, and collects that output ($(...)).
+ *
+ * The commands are spawned like any pipeline, but stay in the shell's process
+ * group. The output is read into memory; nothing touches the filesystem.
+ *
+ * @param tree The parsed command (NULL for an empty "$()").
+ * @param state The current state of the shell.
+ * @param status Receives the command's exit status.
+ * @return The output without trailing newlines (caller frees), or NULL on failure.
+ */
+char* capture_command_output(const Node* tree, ShellState* state, int* status);
+
+/**
+ * @brief Starts a command tree connected to a pipe for <(...) or >(...).
+ *
+ * The command runs concurrently and is reaped along with background jobs.
+ *
+ * @param tree The parsed command (NULL for an empty substitution).
+ * @param output False for <(cmd) (the shell's end reads cmd's output), true
+ *        for >(cmd) (writes to the shell's end become cmd's input).
+ * @param state The current state of the shell.
+ * @return The shell's end of the pipe, close-on-exec (usable as /dev/fd/N), or -1 on failure.
+ */
+int open_process_substitution(const Node* tree, bool output, ShellState* state);
+
+/**
+ * @brief Closes the shell's end of a pipe from open_process_substitution().
+ *        Forked shell code closes every such pipe but its own command's. -1 is ignored.
+ */
+void close_process_substitution(int fd);
+
+/**
+ * @brief Reaps background jobs that have terminated and reports them.
+ *
+ * Non-blocking; called before each command and whenever SIGCHLD arrives while
+ * the user is editing a line. Finished process substitutions are reaped too,
+ * without a notice.
+ *
+ * @param state The current state of the shell.
+ * @return The number of jobs that were reported as terminated.
+ */
+int reap_background_jobs(ShellState* state);
 
 #endif // EXECUTOR_H_
\ No newline at end of file
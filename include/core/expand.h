@@ -0,0 +1,62 @@
+#ifndef EXPAND_H_
+#define EXPAND_H_
+
+#include "core/ast.h"
+#include "core/shell_state.h"
+
+/**
+ * @brief Expands a word to a single string, without field splitting.
+ *
+ * Literal parts are copied; parameters are replaced by their values: $? is the
+ * status of the last command, $$ the shell's PID, $! the last background job,
+ * $0-$9 and $# the positional parameters, $@ and $* all of them joined with
+ * spaces, and names are looked up in the shell's variables (unset names expand
+ * to nothing). $(command) runs the command and is replaced by its output.
+ * Process substitutions are not allowed here.
+ *
+ * @return A newly allocated string, or NULL if memory could not be allocated.
+ */
+char* expand_word(const Word* word, ShellState* state);
+
+/**
+ * @brief Expands a command node into an argument vector, assignments and redirections.
+ *
+ * Words before the command name that look like NAME=value become assignments.
+ * The result of an unquoted expansion is split into fields at IFS characters
+ * (space, tab and newline by default), so one that expands to nothing adds no
+ * argument; "$@" gives one argument per positional parameter. <(cmd) and
+ * >(cmd) start 'cmd' and expand to a /dev/fd path; the pipes are owned by 'out'
+ * and closed by simple_command_clear().
+ *
+ * @param command A NODE_COMMAND node.
+ * @param state The current shell state.
+ * @param out Receives the expanded command. Release it with simple_command_clear().
+ * @return True on success, false on error (already reported). 'out' is cleared on failure.
+ */
+bool expand_command(const Node* command, ShellState* state, SimpleCommand* out);
+
+/**
+ * @brief Expands only the redirections of a command or group node into out->redirects.
+ *
+ * 'N>&M' and 'N<&M' need a descriptor number or '-' (close); with no N,
+ * '>&file' is taken as '&>file'. '&>' sends stdout to the file and stderr
+ * along with it. Here-document text is kept as-is, to be opened when the
+ * command starts (see redirects_prepare()).
+ *
+ * @return True on success, false on error (already reported).
+ */
+bool expand_redirects(const Node* node, ShellState* state, SimpleCommand* out);
+
+/**
+ * @brief Expands a list of words into out->args, split into fields as a
+ *        command's arguments are but with no assignments (used for a 'for' list).
+ * @return True on success, false on error (already reported). 'out' is cleared on failure.
+ */
+bool expand_word_list(const Word* words, int num_words, ShellState* state, SimpleCommand* out);
+
+/**
+ * @brief Frees everything a SimpleCommand owns and zeroes it.
+ */
+void simple_command_clear(SimpleCommand* cmd);
+
+#endif // EXPAND_H_
@@ -0,0 +1,21 @@
+#ifndef HEREDOC_H_
+#define HEREDOC_H_
+
+#include <stddef.h>
+
+/**
+ * @brief Makes a readable descriptor holding 'data', to become a command's stdin.
+ *
+ * A body that fits in a pipe's buffer is written into a pipe right away (the
+ * write cannot block, so the shell never waits on the reader). A larger body
+ * goes into a sealed memfd instead, so it cannot deadlock either. Nothing is
+ * written to the filesystem.
+ *
+ * @param data The here-document or here-string text.
+ * @param len Its length in bytes.
+ * @return A close-on-exec descriptor positioned at the start of the data, or -1
+ *         on failure (already reported).
+ */
+int heredoc_open(const char* data, size_t len);
+
+#endif // HEREDOC_H_
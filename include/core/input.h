@@ -3,13 +3,25 @@
 
 #include "core/shell_state.h"
 
+#include <stddef.h>
+
+#define LINE_INTERRUPTED (-2) ///< Ctrl+C while continuing a multi-line command
+
 /**
  * @brief Reads a line of input with history navigation enabled.
- * @param buffer The buffer to store the input line.
- * @param size The size of the buffer.
- * @param state The current shell state (for history and prompt redrawing).
- * @return 0 on success (Enter pressed), -1 on EOF (Ctrl+D).
+ *
+ * Works like getline(3): *buffer is (re)allocated as needed to hold the whole
+ * line, so input is never truncated. The caller owns *buffer and must free it.
+ *
+ * @param buffer Pointer to a heap buffer (may point to NULL initially).
+ * @param capacity Pointer to the allocated size of *buffer (0 if NULL).
+ * While waiting for input the shell's event loop runs: Ctrl+C abandons the
+ * line and redraws the prompt, and finished background jobs are reported.
+ *
+ * @param state The current shell state (for history, prompt redrawing and jobs).
+ * @return The length of the line on success (Enter pressed), -1 on EOF (Ctrl+D)
+ *         or allocation failure, LINE_INTERRUPTED on Ctrl+C at a "> " continuation prompt.
  */
-int get_line_with_history(char* buffer, int size, const ShellState* state);
+long get_line_with_history(char** buffer, size_t* capacity, ShellState* state);
 
 #endif // INPUT_H_
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef JOB_OUTPUT_H_
+#define JOB_OUTPUT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define JOB_OUTPUT_SIZE (64 * 1024) ///< Bytes of output kept per job
+#define JOB_OUTPUT_KEEP 8           ///< Finished jobs whose output is kept for 'jobout'
+
+/**
+ * @brief The captured stdout and stderr of a background job ('set -o jobcapture').
+ *
+ * Every stage of the job writes into one pipe. The shell watches its read end
+ * in the event loop and reads straight into a fixed-size ring, so a chatty job
+ * costs at most JOB_OUTPUT_SIZE bytes and never blocks on a full pipe: once the
+ * ring is full, the oldest bytes are overwritten. Nothing touches the disk.
+ */
+typedef struct {
+    int fd;                   ///< Read end of the pipe (non-blocking), or -1 after EOF
+    char* data;               ///< The ring, 'size' bytes
+    size_t size;
+    unsigned long long total; ///< Bytes received so far; the ring holds the last 'size' of them
+    bool echo;                ///< Also copy new bytes to stdout as they arrive (the job is in the foreground)
+} JobOutput;
+
+/**
+ * @brief Creates the ring and its pipe, and starts draining it in the event loop.
+ * @param write_fd Set to the pipe's write end (close-on-exec), for the job's
+ *        stdout and stderr; the caller closes it once the job is started.
+ * @return The output, or NULL if it could not be set up (reported).
+ */
+JobOutput* job_output_open(int* write_fd);
+
+/**
+ * @brief Reads what is waiting in the pipe into the ring, without blocking.
+ *
+ * Called from the event loop; also before the ring is read, so nothing already
+ * written is missed. At EOF the pipe is closed.
+ */
+void job_output_drain(JobOutput* output);
+
+/**
+ * @brief The offset of the oldest byte still in the ring.
+ */
+unsigned long long job_output_oldest(const JobOutput* output);
+
+/**
+ * @brief Writes the bytes from offset 'from' (or the oldest kept, if later) up to the end.
+ * @return The offset written up to, for the next call.
+ */
+unsigned long long job_output_write(const JobOutput* output, unsigned long long from, int fd);
+
+/**
+ * @brief Stops draining and closes the pipe, keeping what was captured.
+ */
+void job_output_close(JobOutput* output);
+
+/**
+ * @brief Stops draining, closes the pipe and frees the ring. NULL is ignored.
+ */
+void job_output_free(JobOutput* output);
+
+#endif // JOB_OUTPUT_H_
@@ -0,0 +1,59 @@
+#ifndef JOB_TIMER_H_
+#define JOB_TIMER_H_
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+#define TIMEOUT_STATUS 124 ///< Exit status of a job that ran out of time, as with coreutils timeout
+
+/**
+ * @brief How long a job may run, for 'timeout'.
+ */
+typedef struct {
+    double seconds;    ///< Time from its start until it is signalled
+    int signal;        ///< Sent when the time is up (SIGTERM by default)
+    double kill_after; ///< Seconds after that until SIGKILL, if it still runs; 0 for never
+} TimeoutSpec;
+
+/**
+ * @brief The deadline of a running job.
+ *
+ * A timerfd watched by the event loop fires at the deadline, so nothing polls
+ * on a clock: the job is signalled from whichever loop is waiting at the time,
+ * a foreground wait or the prompt. The job's processes are held as pidfds,
+ * which wake a wait as soon as they exit, even without the signalfd (in a
+ * subshell), and tell the timer whether anything of the job is left to signal.
+ * A job without a process group of its own (in a script or subshell) shares the
+ * shell's, so there each process is signalled along with its descendants, found
+ * in a snapshot of /proc taken when the time is up.
+ */
+typedef struct {
+    TimeoutSpec spec;
+    int timer_fd;   ///< -1 once closed
+    pid_t pgid;
+    bool own_group; ///< Signal the process group; otherwise each process and everything below it
+    pid_t* pids;    ///< The job's processes, each held by the pidfd at the same index
+    int* pidfds;
+    int num_pidfds;
+    bool expired;   ///< The signal was sent
+    bool killed;    ///< So was SIGKILL, after the grace period
+} JobTimer;
+
+/**
+ * @brief Starts the clock for a job that has just been spawned.
+ * @param pids The job's processes; pids[0] leads the group 'pgid'.
+ * @return The timer, or NULL if it could not be set up (reported).
+ */
+JobTimer* job_timer_start(const TimeoutSpec* spec, pid_t pgid, bool own_group, const pid_t* pids, int num_pids);
+
+/**
+ * @brief Stops watching the timer and the pidfds and closes them; it will not fire.
+ */
+void job_timer_close(JobTimer* timer);
+
+/**
+ * @brief Closes the timer and frees it. NULL is ignored.
+ */
+void job_timer_free(JobTimer* timer);
+
+#endif // JOB_TIMER_H_
@@ -0,0 +1,126 @@
+#ifndef JOBS_H_
+#define JOBS_H_
+
+#include "core/cgroup.h"
+#include "core/job_output.h"
+#include "core/job_timer.h"
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+#define MAX_JOBS 100
+
+typedef enum {
+    JOB_RUNNING,
+    JOB_STOPPED,
+    JOB_DONE
+} JobState;
+
+/**
+ * @brief One process of a job (a pipeline stage).
+ */
+typedef struct {
+    pid_t pid;
+    JobState state;
+    int status; ///< Exit code, or 128 + signal number, once JOB_DONE
+} JobMember;
+
+/**
+ * @brief A pipeline running in its own process group.
+ *
+ * Every member is tracked individually: the job is only done once all of its
+ * members have been reaped, however they end and in whatever order.
+ */
+typedef struct {
+    pid_t pgid;
+    char* name;          ///< Display name (the first command)
+    JobMember* members;
+    int num_members;
+    bool own_group;      ///< False in a subshell without job control: members share the shell's group
+    Cgroup* cgroup;      ///< The job's own cgroup when started by 'limit', or NULL
+    JobOutput* output;   ///< Its captured stdout and stderr ('set -o jobcapture'), or NULL
+    JobTimer* timer;     ///< Its deadline when started by 'timeout', or NULL
+} Job;
+
+/**
+ * @brief The shell's background and stopped jobs.
+ */
+typedef struct {
+    Job* jobs[MAX_JOBS];
+    int count;
+} JobTable;
+
+/**
+ * @brief Creates a job for processes that have already been forked.
+ * @param name Display name (copied).
+ * @param pids The member PIDs; pids[0] is the process group leader.
+ * @param num_pids Number of members.
+ * @param own_group True if the members were put in a process group of their own.
+ * @return The new job, or NULL if memory could not be allocated.
+ */
+Job* job_create(const char* name, const pid_t* pids, int num_pids, bool own_group);
+
+/**
+ * @brief Frees a job, its captured output, timer and cgroup, if any. Its processes are not touched.
+ */
+void job_free(Job* job);
+
+/**
+ * @brief The overall state: done once every member is done, running while any
+ *        member still runs, stopped otherwise.
+ */
+JobState job_state(const Job* job);
+
+/**
+ * @brief Collects all pending state changes of the job's members without blocking.
+ */
+void job_poll(Job* job);
+
+/**
+ * @brief Waits until the job is no longer running (all members done, or stopped).
+ *
+ * Sleeps in the event loop between checks, so signals are still dispatched and
+ * watched descriptors serviced while a foreground job runs. A job with a timer
+ * is waited for in the loop even without the signalfd: its pidfds wake it.
+ *
+ * @return The job's state afterwards (JOB_DONE or JOB_STOPPED).
+ */
+JobState job_wait(Job* job);
+
+/**
+ * @brief Marks every unfinished member as running, e.g. after sending SIGCONT.
+ */
+void job_mark_running(Job* job);
+
+/**
+ * @brief The job's exit status, shell style.
+ * @param pipefail If true, the status of the rightmost failing member wins;
+ *        otherwise the last member's status is used.
+ * @return The status; 128 + SIGTSTP if the job is stopped; TIMEOUT_STATUS (or
+ *         128 + SIGKILL, if it had to be killed) if it ran out of time.
+ */
+int job_exit_status(const Job* job, bool pipefail);
+
+/**
+ * @brief Whether a member of the job was ended by SIGINT from the user's Ctrl+C,
+ *        rather than by 'timeout -s INT'.
+ */
+bool job_interrupted(const Job* job);
+
+/**
+ * @brief Adds a job to the table.
+ * @return False if the table is full.
+ */
+bool job_table_add(JobTable* table, Job* job);
+
+/**
+ * @brief Finds a job by its process group ID, or NULL.
+ */
+Job* job_table_find(const JobTable* table, pid_t pgid);
+
+/**
+ * @brief Removes a job from the table (without freeing it), keeping the order.
+ */
+void job_table_remove(JobTable* table, Job* job);
+
+#endif // JOBS_H_
@@ -0,0 +1,89 @@
+#ifndef LEXER_H_
+#define LEXER_H_
+
+#include "core/ast.h"
+
+#include <stddef.h>
+
+typedef enum {
+    TOK_WORD,
+    TOK_AND_IF,   ///< &&
+    TOK_OR_IF,    ///< ||
+    TOK_PIPE,     ///< |
+    TOK_AMP,      ///< &
+    TOK_SEMI,     ///< ;
+    TOK_LESS,     ///< <
+    TOK_GREAT,    ///< >
+    TOK_DGREAT,   ///< >>
+    TOK_DLESS,    ///< << (here-document)
+    TOK_DLESSDASH,///< <<- (here-document, leading tabs stripped)
+    TOK_TLESS,    ///< <<< (here-string)
+    TOK_LESSAND,  ///< <&
+    TOK_GREATAND, ///< >&
+    TOK_LESSGREAT,///< <>
+    TOK_CLOBBER,  ///< >|
+    TOK_AND_GREAT,///< &>
+    TOK_AND_DGREAT,///< &>>
+    TOK_LPAREN,   ///< ( (only in function definitions)
+    TOK_RPAREN,   ///< )
+    TOK_NEWLINE,
+    TOK_EOF
+} TokenType;
+
+typedef enum {
+    LEX_OK,
+    LEX_INCOMPLETE, ///< Input ended inside quotes or after a trailing backslash
+    LEX_ERROR       ///< Out of memory, or a syntax error inside a substitution (already reported)
+} LexStatus;
+
+typedef struct {
+    TokenType type;
+    Word word;      ///< For TOK_WORD; owned by the token until moved into a node
+    int io_number;  ///< For redirection operators: the descriptor written right before it, or -1
+} Token;
+
+typedef struct {
+    const char* input;
+    size_t pos;
+} Lexer;
+
+/**
+ * @brief Starts tokenizing 'input', which must outlive the lexer.
+ */
+void lexer_init(Lexer* lexer, const char* input);
+
+/**
+ * @brief Reads the next token.
+ *
+ * Operators need no surrounding spaces. Single quotes, double quotes and
+ * backslashes are removed from words; '$' expansions are recorded as
+ * PART_PARAM parts, and $(...), <(...) and >(...) as parsed substitution
+ * parts. A '#' at the start of a word begins a comment. A word that
+ * starts with an unquoted NAME= has its assign_len set. Digits written
+ * directly before '<' or '>' (as in 2>&1) are the operator's io_number.
+ *
+ * @param lexer The lexer.
+ * @param token Receives the token. For TOK_WORD the caller owns token->word.
+ * @return LEX_OK, LEX_INCOMPLETE if more input is needed, or LEX_ERROR.
+ */
+LexStatus lexer_next(Lexer* lexer, Token* token);
+
+/**
+ * @brief Turns the body of an unquoted here-document into a word.
+ *
+ * Quotes are ordinary characters in a here-document; '$' expansions are
+ * recorded (as if double-quoted) and a backslash only escapes '$', '`', '\\'
+ * and a line break.
+ *
+ * @param body The body text.
+ * @param word Receives the word (the caller owns it).
+ * @return LEX_OK, or LEX_ERROR (a substitution inside is incomplete or invalid, or out of memory).
+ */
+LexStatus lexer_scan_heredoc(const char* body, Word* word);
+
+/**
+ * @brief A printable name for a token type, for error messages.
+ */
+const char* token_name(TokenType type);
+
+#endif // LEXER_H_
@@ -0,0 +1,26 @@
+#ifndef PARSE_CACHE_H_
+#define PARSE_CACHE_H_
+
+#include "core/parser.h"
+
+/**
+ * @brief Parses a command line, reusing the tree from an earlier parse of the same text.
+ *
+ * Recently parsed lines are memoized by a hash of their text in a small
+ * direct-mapped cache, so re-running a line (typed again, recalled with
+ * 'pastevents execute', or read again by a script) skips lexing and parsing.
+ * Only complete, valid lines are kept, and an entry made before an alias
+ * changed is not reused, since aliases are expanded while parsing.
+ *
+ * @param input The text to parse.
+ * @param tree_out Set to the tree (NULL for empty input or on failure). Release it with node_free().
+ * @return As for parse_program().
+ */
+ParseStatus parse_cached(const char* input, Node** tree_out);
+
+/**
+ * @brief Drops every cached tree (used at exit, so leak checkers stay quiet).
+ */
+void parse_cache_clear(void);
+
+#endif // PARSE_CACHE_H_
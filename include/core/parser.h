@@ -1,27 +1,74 @@
 #ifndef PARSER_H_
 #define PARSER_H_
 
-#include "core/shell_state.h"
+#include "core/ast.h"
+
+typedef enum {
+    PARSE_OK,
+    PARSE_INCOMPLETE, ///< The input stops where more is required (e.g., after '&&' or inside quotes)
+    PARSE_ERROR       ///< A syntax error; a message has already been printed
+} ParseStatus;
 
 /**
- * @brief Parses a pipeline string into an array of SimpleCommand structs.
+ * @brief Parses a command line (or several lines of a script) into a command tree.
+ *
+ * Grammar, loosely:
+ *   list     := and_or (( ';' | '&' | newline ) and_or)*
+ *   and_or   := pipeline (( '&&' | '||' ) pipeline)*
+ *   pipeline := command ( '|' command )*
+ *   command  := compound redirection* | name '(' ')' '{' list '}' | ( word | redirection )+
+ *   compound := '{' list '}'
+ *             | 'if' list 'then' list ( 'elif' list 'then' list )* [ 'else' list ] 'fi'
+ *             | ( 'while' | 'until' ) list 'do' list 'done'
+ *             | 'for' name [ 'in' word* ( ';' | newline ) ] 'do' list 'done'
  *
- * This function takes a single command string (which may contain pipes and
- * redirections) and populates an array of SimpleCommand structs.
+ * Operators do not need surrounding spaces, and a line break is allowed after
+ * '&&', '||' and '|', and the lists of compound commands may span lines.
+ * Reserved words such as 'then' and 'done' are only recognized where a
+ * command could start, so 'echo done' prints "done". There is no limit on the number of stages or arguments
+ * other than available memory. The body of a here-document ('<<' or '<<-')
+ * is read from the lines that follow the one holding the operator. An alias
+ * in command position is replaced by its text before the command is parsed.
  *
- * @param command_str The string for the pipeline (e.g., "cat < in.txt | grep 'a' > out.txt").
- * @param commands Array of SimpleCommand structs to be populated.
- * @param max_commands The maximum size of the commands array.
- * @param is_background Pointer to a boolean that will be set to true if the command ends with '&'.
- * @return The number of simple commands parsed from the pipeline, or -1 on syntax error.
+ * @param input The text to parse. It is not modified.
+ * @param tree_out Set to the tree (NULL for empty input or on failure). Release it with node_free().
+ * @return PARSE_OK, PARSE_INCOMPLETE if the caller should read another line and
+ *         parse the combined text again, or PARSE_ERROR.
+ */
+ParseStatus parse_program(const char* input, Node** tree_out);
+
+/**
+ * @brief The line that ends a here-document body.
+ */
+typedef struct {
+    char* delimiter;
+    bool strip_tabs; ///< '<<-': leading tabs are ignored on each line
+} HeredocEnd;
+
+/**
+ * @brief As parse_program(), and if the input ends inside here-document
+ *        bodies, also says which ones.
+ *
+ * Lines that follow are then part of those bodies until each delimiter line
+ * has been seen, and cannot change how the text parses until then. A caller
+ * reading line by line can compare each line with heredoc_end_matches()
+ * instead of parsing all the text again, so a long body is read in linear time.
+ *
+ * @param open If not NULL, set to the open bodies' ends, in the order the
+ *        bodies follow (release with heredoc_ends_free()); NULL with 0 if the
+ *        input is complete or needs more lines for another reason.
+ * @param num_open Set to the number of them.
+ */
+ParseStatus parse_program_open(const char* input, Node** tree_out, HeredocEnd** open, int* num_open);
+
+/**
+ * @brief Whether 'line' (its 'len' characters, without the newline) ends a here-document body.
  */
-int parse_pipeline(char* command_str, SimpleCommand commands[], int max_commands, bool* is_background);
+bool heredoc_end_matches(const HeredocEnd* end, const char* line, size_t len);
 
 /**
- * @brief Frees the memory allocated within an array of SimpleCommand structs.
- * @param commands Array of SimpleCommand structs.
- * @param num_commands The number of valid commands in the array.
+ * @brief Frees the ends returned by parse_program_open(). NULL is ignored.
  */
-void free_simple_commands(SimpleCommand commands[], int num_commands);
+void heredoc_ends_free(HeredocEnd* ends, int count);
 
-#endif // PARSER_H_
\ No newline at end of file
+#endif // PARSER_H_
@@ -0,0 +1,78 @@
+#ifndef PLACEMENT_H_
+#define PLACEMENT_H_
+
+#include "utils/strbuf.h"
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+#define PLACEMENT_MAX_CPUS 1024 ///< CPU_SETSIZE
+#define PLACEMENT_CPU_WORDS (PLACEMENT_MAX_CPUS / (8 * sizeof(unsigned long)))
+
+/**
+ * @brief Where and how eagerly a job's processes run: the CPUs they may use,
+ *        their nice value and their I/O scheduling class, for 'pin'.
+ *
+ * posix_spawn has no attributes for any of these, so a job with a placement
+ * is forked and each child applies it to itself before exec; everything the
+ * job starts inherits it. Fields that are not set leave the shell's own.
+ */
+typedef struct {
+    bool has_cpus;
+    unsigned long cpus[PLACEMENT_CPU_WORDS]; ///< Bit n set: CPU n may be used
+    bool has_nice;
+    int nice;       ///< -20 (most favoured) to 19
+    bool has_io;
+    int io_class;   ///< IOPRIO_CLASS_RT, IOPRIO_CLASS_BE or IOPRIO_CLASS_IDLE
+    int io_level;   ///< 0 (highest) to 7, within RT and BE
+} Placement;
+
+bool placement_is_set(const Placement* placement);
+
+/**
+ * @brief Parses a CPU list such as "4-7" or "0,2,8-11" into placement->cpus.
+ * @return False if it is malformed or names no CPU this process may use
+ *         (the reason is reported).
+ */
+bool placement_parse_cpus(const char* list, Placement* placement);
+
+/**
+ * @brief Parses an I/O class: "idle", or "be" / "best-effort" and "rt" /
+ *        "realtime", with an optional ":<level>" (4 by default).
+ * @return False if it is malformed (reported).
+ */
+bool placement_parse_io(const char* text, Placement* placement);
+
+/**
+ * @brief Copies the fields set in 'over' into 'into'.
+ */
+void placement_merge(Placement* into, const Placement* over);
+
+/**
+ * @brief Applies the placement to the calling process; for a child before exec.
+ * @return False if part of it could not be applied (reported).
+ */
+bool placement_apply(const Placement* placement);
+
+/**
+ * @brief Reads the effective placement of a process: every field is set.
+ * @return False if the process cannot be inspected.
+ */
+bool placement_read(pid_t pid, Placement* placement);
+
+/**
+ * @brief Appends the CPU list, compressed to ranges ("0-3,8").
+ */
+void placement_format_cpus(const Placement* placement, StrBuf* out);
+
+/**
+ * @brief Appends the I/O class as ionice shows it ("idle", "best-effort: prio 4").
+ */
+void placement_format_io(const Placement* placement, StrBuf* out);
+
+/**
+ * @brief Appends the fields that are set ("cpus 4-7, nice 10, io idle").
+ */
+void placement_format(const Placement* placement, StrBuf* out);
+
+#endif // PLACEMENT_H_
@@ -0,0 +1,141 @@
+#ifndef PROCFS_H_
+#define PROCFS_H_
+
+#include "utils/strbuf.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+/**
+ * @brief A snapshot of the processes in /proc, taken in one pass.
+ *
+ * Each process costs one openat()/read()/close() of its 'stat' file relative
+ * to a descriptor of /proc, so the kernel never walks a path from the root.
+ * Entries come out of /proc in ascending PID order, so lookups are binary
+ * searches.
+ */
+
+#define PROC_COMM_LEN 16 ///< The kernel's TASK_COMM_LEN, including the NUL
+
+/**
+ * @brief The fields of /proc/<pid>/stat the shell uses.
+ */
+typedef struct {
+    pid_t pid;
+    pid_t ppid;
+    pid_t pgid;
+    pid_t sid;
+    char state;                    ///< R, S, D, T, Z, ...
+    char comm[PROC_COMM_LEN];      ///< Executable name, as the kernel truncates it
+    unsigned long long utime;      ///< User time, in clock ticks
+    unsigned long long stime;      ///< System time, in clock ticks
+    unsigned long long start_time; ///< Clock ticks after boot; with the PID, identifies the process
+    long num_threads;
+    unsigned long long vsize;      ///< Virtual memory, in bytes
+    long long rss;                 ///< Resident set, in pages
+} ProcInfo;
+
+/**
+ * @brief A process's /proc directory and stat file, kept open so that sampling
+ *        it again costs a single pread(). Once the process is gone, reads fail
+ *        instead of reaching whatever process gets the PID next.
+ */
+typedef struct {
+    pid_t pid;
+    int dir_fd;  ///< /proc/<pid>, for opening its other files with openat()
+    int stat_fd; ///< /proc/<pid>/stat
+} ProcHandle;
+
+typedef struct {
+    ProcInfo* procs; ///< Sorted by PID
+    int count;
+    int capacity;
+} ProcTable;
+
+/**
+ * @brief Parent and child links over a ProcTable, by index into its entries.
+ *
+ * Built in one pass over the snapshot: children are stored contiguously per
+ * parent (children[child_start[i] .. child_start[i + 1]) are those of entry
+ * i, in PID order), so walking a subtree never searches the table.
+ */
+typedef struct {
+    const ProcTable* table;
+    int* parent;      ///< Index of each entry's parent, or -1 if it is not in the snapshot
+    int* child_start; ///< table->count + 1 offsets into 'children'
+    int* children;
+} ProcTree;
+
+/**
+ * @brief Parses the text of a /proc/<pid>/stat file.
+ * @return False if it is malformed.
+ */
+bool procfs_parse_stat(const char* text, size_t len, ProcInfo* out);
+
+/**
+ * @brief Reads /proc/<pid>/stat.
+ * @return False if the process does not exist (any more) or cannot be read.
+ */
+bool procfs_read_stat(pid_t pid, ProcInfo* out);
+
+/**
+ * @brief Opens a handle on 'pid'.
+ * @return False (with errno set) if the process does not exist or cannot be inspected.
+ */
+bool proc_handle_open(ProcHandle* handle, pid_t pid);
+
+/**
+ * @brief Samples the process's stat file.
+ * @return False once the process has exited.
+ */
+bool proc_handle_read_stat(const ProcHandle* handle, ProcInfo* out);
+
+/**
+ * @brief Reads a whole file opened on a handle (from offset 0) into 'buffer', NUL-terminated.
+ * @return The number of bytes read, or -1.
+ */
+ssize_t procfs_pread_file(int fd, char* buffer, size_t size);
+
+void proc_handle_close(ProcHandle* handle);
+
+/**
+ * @brief Signals a process through a pidfd, which keeps referring to that
+ *        process even if it exits and its PID is handed to another one.
+ * @param start_time Its start time in a snapshot, to tell a PID reused since
+ *        apart; 0 for a PID taken as given.
+ * @return 0, or the errno of the failure (ESRCH if it is gone).
+ */
+int procfs_signal(pid_t pid, unsigned long long start_time, int signal_number);
+
+/**
+ * @brief Fills 'table' (which may hold an earlier snapshot) with every process now running.
+ * @return False if /proc could not be read or memory allocated (already reported).
+ */
+bool proc_table_load(ProcTable* table);
+
+/**
+ * @brief Releases the table's memory. It can be loaded again afterwards.
+ */
+void proc_table_free(ProcTable* table);
+
+/**
+ * @brief The entry for 'pid', or NULL if it was not running at the snapshot.
+ */
+const ProcInfo* proc_table_find(const ProcTable* table, pid_t pid);
+
+/**
+ * @brief Links the entries of 'table', which must outlive the tree.
+ * @return False if memory could not be allocated (already reported).
+ */
+bool proc_tree_build(ProcTree* tree, const ProcTable* table);
+
+void proc_tree_free(ProcTree* tree);
+
+/**
+ * @brief Appends the subtree under entry 'root' as indented lines ("PID name [state]"),
+ *        each starting with 'prefix'.
+ */
+void proc_tree_format(const ProcTree* tree, int root, const char* prefix, StrBuf* out);
+
+#endif // PROCFS_H_
@@ -0,0 +1,98 @@
+#ifndef REDIRECT_H_
+#define REDIRECT_H_
+
+#include <spawn.h>
+#include <stdbool.h>
+
+/**
+ * @brief What one redirection does to the descriptor table.
+ */
+typedef enum {
+    FD_ACTION_OPEN,  ///< Open 'text' (a path) with 'flags' as fd
+    FD_ACTION_DUP,   ///< Make fd a copy of 'source'
+    FD_ACTION_CLOSE, ///< Close fd
+    FD_ACTION_DATA   ///< Make 'text' readable on fd (a here-document); see redirects_prepare()
+} FdActionType;
+
+/**
+ * @brief One expanded redirection.
+ *
+ * The actions of a command are applied in order, so '> log 2>&1' sends both
+ * streams to the file while '2>&1 > log' leaves stderr where stdout was.
+ */
+typedef struct {
+    FdActionType type;
+    int fd;       ///< The descriptor redirected
+    int source;   ///< DUP: the descriptor copied; DATA: the prepared descriptor (-1 until then)
+    int flags;    ///< OPEN: open() flags. O_EXCL marks a '>' made under noclobber.
+    char* text;   ///< OPEN: the path; DATA: the text
+} FdAction;
+
+/**
+ * @brief The redirections of one command, in source order.
+ */
+typedef struct {
+    FdAction* actions;
+    int count;
+    int capacity;
+} RedirectList;
+
+/**
+ * @brief Descriptors a builtin's redirections replaced, kept to be put back.
+ */
+typedef struct {
+    int* fds;     ///< The descriptors changed
+    int* saved;   ///< Their originals (close-on-exec copies), or -1 if they were closed
+    int count;
+} SavedFds;
+
+/**
+ * @brief Appends an action. Ownership of 'text' (which may be NULL) is taken, even on failure.
+ * @return True on success, false if memory could not be allocated (already reported).
+ */
+bool redirects_add(RedirectList* list, FdActionType type, int fd, int source, int flags, char* text);
+
+/**
+ * @brief Opens the descriptors for here-documents. Called in the shell before
+ *        the command is started, since a spawned process cannot create them.
+ * @return True on success, false on error (already reported).
+ */
+bool redirects_prepare(RedirectList* list);
+
+/**
+ * @brief Applies every action in one pass. Used in a forked child, before exec.
+ * @return True on success, false on the first failure (already reported).
+ */
+bool redirects_apply(const RedirectList* list);
+
+/**
+ * @brief Applies the actions in the shell itself, saving each descriptor first
+ *        so redirects_restore() can undo them (used for builtins and groups).
+ *        Buffered output is flushed first, so it goes where it was written.
+ * @return True on success. On failure (already reported) nothing is left changed.
+ */
+bool redirects_apply_saved(const RedirectList* list, SavedFds* saved);
+
+/**
+ * @brief Flushes output and puts back the descriptors saved by redirects_apply_saved().
+ */
+void redirects_restore(SavedFds* saved);
+
+/**
+ * @brief Translates the actions into posix_spawn file actions, in the same order.
+ *
+ * A noclobber '>' is translated as an exclusive create; if the target exists
+ * the spawn fails and the caller falls back to fork, where
+ * redirects_apply() makes the full check. So does an action on one of the
+ * shell's own descriptors (see utils/fd.h), which gives EBADF.
+ *
+ * @return 0 on success, or an errno value.
+ */
+int redirects_add_file_actions(const RedirectList* list, posix_spawn_file_actions_t* file_actions);
+
+/**
+ * @brief Frees the actions and closes prepared here-document descriptors.
+ */
+void redirects_clear(RedirectList* list);
+
+#endif // REDIRECT_H_
@@ -1,19 +1,23 @@
 #ifndef SHELL_STATE_H_
 #define SHELL_STATE_H_
 
+#include "core/jobs.h"
+#include "core/placement.h"
+#include "core/redirect.h"
+#include "core/vars.h"
 #include "utils/que.h"
+#include "utils/strmap.h"
 #include "utils/colors.h" // <-- ADD THIS
 #include <stdbool.h>
 #include <sys/types.h>
 
-// Common buffer sizes and limits
+// Common buffer sizes and limits. Input lines and argument vectors are
+// heap-allocated and grow as needed; exec is bounded only by ARG_MAX.
 #define MAX_PATH_LEN 4096
-#define MAX_INPUT_LEN 4096
-#define MAX_COMMAND_LEN 4096
-#define MAX_ARGS 64
-#define MAX_BG_PROCS 100
+#define MAX_COMMAND_LEN 4096 // Display name of the last command (prompt only)
 #define HISTORY_SIZE 15
 #define HISTORY_FILENAME ".shellby_history.txt"
+#define DIRDB_FILENAME ".shellby_dirs" // Frecency database of visited directories (warp -z)
 
 /*
  * REMOVE the old color code definitions from here.
@@ -24,25 +28,56 @@
  * @brief Represents a single command with its arguments and I/O redirection info.
  */
 typedef struct {
-    char* args[MAX_ARGS];
-    char* input_file;
-    char* output_file;
-    bool append_mode;
+    char** args;          ///< NULL-terminated argument vector.
+    int argc;             ///< Number of arguments, excluding the NULL terminator.
+    int args_capacity;    ///< Allocated slots in args.
+    RedirectList redirects; ///< Expanded redirections, applied in order
+    char** assigns;       ///< "NAME=value" assignments that precede the command name
+    int num_assigns;
+    int assigns_capacity;
+    int* subst_fds;       ///< Shell ends of <(...) and >(...) pipes, closed with the command
+    int num_subst_fds;
+    int subst_fds_capacity;
+    int subst_status;     ///< Status of the last $(...) expanded for this command
 } SimpleCommand;
 
+/**
+ * @brief Options toggled with the 'set' builtin.
+ */
+typedef struct {
+    bool pipefail; ///< A pipeline's status is that of its rightmost failing stage
+    bool noclobber; ///< '>' refuses to overwrite an existing regular file (use '>|')
+    bool jobcapture; ///< Background jobs write into a ring per job, read with 'jobout', not to the terminal
+} ShellOptions;
+
+/**
+ * @brief A 'break', 'continue' or 'return' that is cutting command lists short.
+ */
+typedef enum {
+    FLOW_NORMAL,
+    FLOW_BREAK,    ///< Leave 'flow_count' enclosing loops
+    FLOW_CONTINUE, ///< Leave 'flow_count' - 1 loops, then go on with the next iteration of the one after
+    FLOW_RETURN    ///< Leave the function being run
+} FlowControl;
+
 /**
  * @brief Holds all persistent state for the shell instance.
  */
 typedef struct {
     char home_dir[MAX_PATH_LEN];
-    char prev_dir[MAX_PATH_LEN];
+    char cwd[MAX_PATH_LEN];   ///< Logical working directory ($PWD), kept by core/cwd.h
+    int cwd_fd;               ///< O_PATH descriptor for it, for openat() and friends
+    char prev_dir[MAX_PATH_LEN]; ///< $OLDPWD
+    char** dir_stack;     ///< pushd's directories, the most recent last (the current one is not kept)
+    int dir_stack_count;
+    int dir_stack_capacity;
     Que history_queue;
     bool is_running;
 
-    // Background process tracking
-    int background_pids[MAX_BG_PROCS];
-    char background_process_names[MAX_BG_PROCS][MAX_PATH_LEN];
-    int num_bg_processes;
+    // Background and stopped jobs
+    JobTable jobs;
+    JobTable substitutions; ///< Running process substitutions, reaped quietly
+    JobTable finished;      ///< Ended background jobs kept for their captured output, oldest first
 
     // For prompt display
     char last_command_name[MAX_COMMAND_LEN];
@@ -51,6 +86,26 @@ typedef struct {
     // for keyboard interrupts
     pid_t foreground_pgid;
 
+    ShellOptions options;
+    int last_exit_status; ///< Status of the last command ($?)
+    pid_t last_background_pid; ///< PID of the last job started with '&' ($!)
+
+    VarStore vars;        ///< Shell variables; the exported ones form the environment
+    char** positional;    ///< $0, $1, ...: the script name and its arguments
+    int num_positional;   ///< Including $0
+    StrMap functions;     ///< Function name -> body (a retained Node*), parsed once when defined
+    int function_depth;   ///< Function calls in progress
+    int loop_depth;       ///< Loops in progress in the current function (or at top level)
+    FlowControl flow;     ///< Set by break, continue and return; consumed by the loop or function
+    int flow_count;       ///< For FLOW_BREAK and FLOW_CONTINUE: loops still to leave
+    bool interrupted;     ///< Ctrl+C stopped a command: the rest of the line is abandoned
+
+    Placement job_placement; ///< 'pin' defaults: the CPUs, nice value and I/O class of every job started
+
+    bool job_control;     ///< Jobs get their own process groups and the terminal (off in subshells)
+    bool interactive;     ///< Reading from a terminal: keep history, show prompts
+    bool in_continuation; ///< The current command needs more lines; prompt with "> "
+
 } ShellState;
 
 /**
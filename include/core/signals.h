@@ -1,13 +1,77 @@
 #ifndef SIGNALS_H_
 #define SIGNALS_H_
 
+#include <signal.h>
+#include <stdbool.h>
+
+/**
+ * Events produced by signals_dispatch(), as a bit mask.
+ */
+#define SIGNAL_EVENT_INTERRUPT 0x1 ///< Ctrl+C with no foreground job: abandon the current line
+#define SIGNAL_EVENT_CHILD     0x2 ///< A child changed state (SIGCHLD)
+#define SIGNAL_EVENT_RESIZE    0x4 ///< The terminal was resized (SIGWINCH)
+
+/**
+ * @brief Sets up signal handling for the shell.
+ *
+ * This function should be called once at shell startup. SIGINT, SIGTSTP,
+ * SIGCHLD and SIGWINCH are blocked and delivered through a signalfd instead,
+ * so no code ever runs in signal context; the event loop reads the descriptor
+ * and calls signals_dispatch() from the main thread. Signals related to
+ * terminal control (SIGTTIN, SIGTTOU) are ignored, which is crucial for job
+ * management. SIGPIPE is ignored so that a builtin writing to a closed pipe
+ * gets EPIPE instead of killing the shell.
+ *
+ * @return 0 on success, -1 if the signalfd could not be created.
+ */
+int setup_signal_handlers();
+
+/**
+ * @brief The signalfd set up by setup_signal_handlers(), or -1.
+ */
+int signals_get_fd();
+
+/**
+ * @brief Drains the signalfd and acts on what it finds.
+ *
+ * Ctrl+C and Ctrl+Z are forwarded to the foreground process group, if any.
+ *
+ * @return A mask of SIGNAL_EVENT_* bits for the caller to handle.
+ */
+int signals_dispatch();
+
+/**
+ * @brief Checks, without blocking, for a Ctrl+C that arrived while the shell
+ *        itself was busy (a loop of builtins has no foreground job to stop).
+ *
+ * Costs one sigpending() call when nothing is pending. If SIGINT is, every
+ * pending signal is dispatched as signals_dispatch() would.
+ *
+ * @return True if Ctrl+C was pressed.
+ */
+bool signals_interrupt_pending();
+
+/**
+ * @brief Looks up a signal by name, with or without "SIG", in any case ("TERM", "sigkill").
+ * @return The signal, or -1 if there is none by that name.
+ */
+int signals_from_name(const char* name);
+
 /**
- * @brief Sets up the main signal handlers for the shell.
+ * @brief Restores the signal mask and default dispositions in a forked child.
  *
- * This function should be called once at shell startup. It configures handlers
- * for SIGINT (Ctrl+C) and SIGTSTP (Ctrl+Z) and tells the shell to ignore
- * signals related to terminal control, which is crucial for job management.
+ * Must be called in every child before exec: blocked signals and SIG_IGN
+ * dispositions are otherwise inherited by the new program. The signalfd is
+ * closed too, so a child that keeps running shell code waits with waitid.
+ */
+void signals_reset_for_child();
+
+/**
+ * @brief The signal setup signals_reset_for_child() gives a child, for a
+ *        process started with posix_spawn instead of fork.
+ * @param defaults Receives the signals to reset to SIG_DFL.
+ * @param mask Receives the signal mask the new program should start with.
  */
-void setup_signal_handlers();
+void signals_child_defaults(sigset_t* defaults, sigset_t* mask);
 
-#endif // SIGNALS_H_
\ No newline at end of file
+#endif // SIGNALS_H_
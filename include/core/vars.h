@@ -0,0 +1,116 @@
+#ifndef VARS_H_
+#define VARS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief One shell variable.
+ *
+ * Names are interned: a name's string is allocated once, the first time it is
+ * seen, and its slot is kept (with value NULL) when the variable is unset, so
+ * the table never needs tombstones.
+ */
+typedef struct {
+    const char* name;  ///< Interned name; NULL for an empty slot
+    uint32_t hash;
+    char* value;       ///< NULL if unset
+    char* env_entry;   ///< "NAME=value", kept while the variable is exported and set
+    bool exported;
+} Var;
+
+/**
+ * @brief The shell's variables, in an open-addressing (linear probing) hash table.
+ *
+ * Exported variables are also available as an envp array. The array is cached
+ * and only rebuilt after an exported variable changes, so spawning a command
+ * does not copy the environment.
+ */
+typedef struct {
+    Var* slots;
+    size_t capacity;    ///< A power of two
+    size_t used;        ///< Slots holding a name
+    char** envp;        ///< Cached environment; NULL-terminated
+    size_t envp_count;
+    size_t envp_bytes;  ///< Bytes the environment takes in a new process image (for ARG_MAX)
+    bool envp_dirty;
+    char** original_environ;
+} VarStore;
+
+/**
+ * @brief Initializes the store with every entry of 'env' as an exported variable.
+ * @return True on success, false if memory could not be allocated.
+ */
+bool vars_init(VarStore* store, char** env);
+
+/**
+ * @brief Frees the store. If environ points at the cached array, it is restored first.
+ */
+void vars_destroy(VarStore* store);
+
+/**
+ * @brief True if 'name' (the first 'len' bytes) is a valid variable name.
+ */
+bool vars_valid_name(const char* name, size_t len);
+
+/**
+ * @brief Looks up a variable.
+ * @return The variable's slot, or NULL if the name was never seen.
+ */
+const Var* vars_find(const VarStore* store, const char* name);
+
+/**
+ * @brief The value of a variable, or NULL if it is unset.
+ */
+const char* vars_get(const VarStore* store, const char* name);
+
+/**
+ * @brief Sets a variable. Its export flag is kept, or set if 'export' is true.
+ * @return True on success, false if memory could not be allocated.
+ */
+bool vars_set(VarStore* store, const char* name, const char* value, bool export);
+
+/**
+ * @brief Sets a variable from "NAME=value" text.
+ */
+bool vars_assign(VarStore* store, const char* assignment, bool export);
+
+/**
+ * @brief Unsets a variable (and clears its export flag).
+ */
+void vars_unset(VarStore* store, const char* name);
+
+/**
+ * @brief Sets or clears a variable's export flag. An unset variable that is
+ *        exported enters the environment once it gets a value.
+ * @return True on success, false if memory could not be allocated.
+ */
+bool vars_export(VarStore* store, const char* name, bool export);
+
+/**
+ * @brief The environment for new processes, rebuilt first if an exported variable changed.
+ * @return The NULL-terminated array, or NULL if it could not be rebuilt.
+ */
+char** vars_envp(VarStore* store);
+
+/**
+ * @brief Points environ at the cached environment, so the shell's own getenv()
+ *        calls and exec see the current exported variables.
+ */
+void vars_apply_environ(VarStore* store);
+
+/**
+ * @brief Builds an environment with per-command assignments layered over the cache.
+ *
+ * Only the pointer array is allocated: the cached "NAME=value" strings are
+ * shared, and entries whose name is overridden are left out.
+ *
+ * @param store The store (its cache must be current, see vars_envp()).
+ * @param assigns "NAME=value" strings that take precedence; of several for one name, the last.
+ * @param num_assigns Number of assignments.
+ * @return The NULL-terminated array (free only the array), or NULL on allocation failure.
+ */
+char** vars_layer_envp(const VarStore* store, char* const* assigns, int num_assigns);
+
+#endif // VARS_H_
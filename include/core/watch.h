@@ -0,0 +1,48 @@
+#ifndef WATCH_H_
+#define WATCH_H_
+
+#include "utils/strbuf.h"
+
+#include <stdbool.h>
+#include <termios.h>
+
+/**
+ * @brief A display redrawn in place at a fixed rate, for 'proclore -w' and
+ *        'activities -w'.
+ *
+ * Each frame is composed in memory and written with a single write(). On a
+ * terminal the new frame overwrites the previous one; otherwise frames follow
+ * each other. Waiting between frames goes through the event loop, so Ctrl+C
+ * (or 'q' typed at the terminal) ends the display.
+ */
+typedef struct {
+    bool redraw;           ///< stdout is a terminal: move back over the last frame
+    bool keys;             ///< stdin is a terminal switched to unbuffered input
+    struct termios saved;  ///< The terminal settings to restore
+    int lines;             ///< Height of the last frame
+    StrBuf out;
+} WatchScreen;
+
+/**
+ * @brief Prepares the terminal. Pair with watch_end().
+ */
+void watch_begin(WatchScreen* screen);
+
+/**
+ * @brief Replaces the previous frame with 'frame' (lines ending in '\n').
+ * @return False if the output could not be written.
+ */
+bool watch_draw(WatchScreen* screen, const char* frame, size_t len);
+
+/**
+ * @brief Waits 'seconds' before the next frame.
+ * @return False if the user asked to stop.
+ */
+bool watch_sleep(WatchScreen* screen, double seconds);
+
+/**
+ * @brief Restores the terminal and frees the screen's buffer.
+ */
+void watch_end(WatchScreen* screen);
+
+#endif // WATCH_H_
@@ -7,6 +7,8 @@
 #define _BLUE_    "\x1b[34m"
 #define _MAGENTA_ "\x1b[35m"
 #define _CYAN_    "\x1b[36m"
+#define _BOLD_    "\x1b[1m"
+#define _UNDERLINE_ "\x1b[4m"
 #define _RESET_   "\x1b[0m"
 
 #endif // COLORS_H_
\ No newline at end of file
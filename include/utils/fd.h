@@ -0,0 +1,31 @@
+#ifndef FD_H_
+#define FD_H_
+
+#include <stdbool.h>
+
+#define SHELL_FD_MIN 10 ///< The shell's own long-lived descriptors go at or above this; 0-9 are the user's
+
+/**
+ * @brief Moves a descriptor the shell keeps open (the script, the directory
+ *        database, the signalfd...) out of the user's range, close-on-exec,
+ *        and records it as the shell's own.
+ *
+ * A command's redirections are refused for recorded descriptors, so 'N>&-'
+ * or '>&N' can neither close nor write over one, as bash does for its own.
+ *
+ * @return The new descriptor, or 'fd' itself (still recorded) if it could not
+ *         be moved; -1 for -1.
+ */
+int fd_keep(int fd);
+
+/**
+ * @brief Forgets a descriptor recorded by fd_keep() and closes it. -1 is ignored.
+ */
+void fd_close(int fd);
+
+/**
+ * @brief Whether 'fd' is one of the shell's own descriptors.
+ */
+bool fd_is_internal(int fd);
+
+#endif // FD_H_
@@ -0,0 +1,61 @@
+#ifndef HTML_TEXT_H_
+#define HTML_TEXT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define HTML_TAG_NAME_LEN 16
+#define HTML_ENTITY_LEN 10
+
+/**
+ * @brief Incremental HTML-to-text converter for man pages served as HTML.
+ *
+ * Input is fed chunk by chunk (e.g., straight from recv()); the state below is
+ * all that is kept between chunks, so memory use does not depend on the page
+ * size. An optional HTTP response header is skipped. Output starts at the
+ * "NAME" heading and stops at the closing </pre> tag. <strong>/<b> text is
+ * printed bold and link text blue.
+ */
+typedef struct {
+    int state;
+    size_t header_match;
+
+    bool started;    ///< The "NAME" heading has been seen and output is live
+    bool finished;   ///< The closing </pre> has been seen
+    bool not_found;  ///< The page is the server's "Search Again" page
+    size_t start_match;
+    size_t not_found_match;
+
+    char tag[HTML_TAG_NAME_LEN];
+    size_t tag_len;
+    bool tag_name_done;
+    char tag_quote;
+
+    char entity[HTML_ENTITY_LEN];
+    size_t entity_len;
+
+    int bold_depth;
+    bool in_link;
+    bool style_open;  ///< Escape codes are active on the output
+    bool style_dirty; ///< The style changed since it was last written
+} HtmlText;
+
+/**
+ * @brief Initializes a converter.
+ * @param skip_http_header True if the input begins with an HTTP response header.
+ */
+void html_text_init(HtmlText* h, bool skip_http_header);
+
+/**
+ * @brief Consumes a chunk of input, writing formatted text to 'out' as it goes.
+ * @return False once the end of the page has been reached (further input is ignored).
+ */
+bool html_text_feed(HtmlText* h, const char* data, size_t len, FILE* out);
+
+/**
+ * @brief Closes any open style and flushes 'out'.
+ */
+void html_text_finish(HtmlText* h, FILE* out);
+
+#endif // HTML_TEXT_H_
@@ -0,0 +1,21 @@
+#ifndef ROFF_H_
+#define ROFF_H_
+
+#include "utils/strbuf.h"
+#include <stdbool.h>
+
+/**
+ * @brief Renders a man page written in roff (man macros) to terminal text.
+ *
+ * The source is streamed line by line through zlib, so both gzip-compressed
+ * and plain pages are accepted. '.so' includes are followed relative to the
+ * man tree root. Bold text is rendered with _BOLD_, italics with _UNDERLINE_.
+ *
+ * @param path Path to the page (e.g., "/usr/share/man/man1/ls.1.gz").
+ * @param width Output width in columns.
+ * @param out Buffer the rendered text is appended to.
+ * @return True on success, false if the page could not be read.
+ */
+bool roff_render_file(const char* path, int width, StrBuf* out);
+
+#endif // ROFF_H_
@@ -0,0 +1,65 @@
+#ifndef STRBUF_H_
+#define STRBUF_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief A growable, always NUL-terminated byte buffer.
+ *
+ * Initialize with strbuf_init() (or zero it); release with strbuf_free().
+ */
+typedef struct {
+    char* data;   ///< Buffer contents (NULL until the first append).
+    size_t len;   ///< Number of bytes in use, excluding the NUL terminator.
+    size_t cap;   ///< Allocated size of data.
+} StrBuf;
+
+/**
+ * @brief Initializes an empty buffer without allocating.
+ */
+void strbuf_init(StrBuf* sb);
+
+/**
+ * @brief Makes room for at least 'extra' more bytes plus the terminator.
+ * @return True on success, false if memory could not be allocated.
+ */
+bool strbuf_reserve(StrBuf* sb, size_t extra);
+
+/**
+ * @brief Appends 'len' bytes from 'data'.
+ */
+bool strbuf_append(StrBuf* sb, const char* data, size_t len);
+
+/**
+ * @brief Appends a NUL-terminated string.
+ */
+bool strbuf_append_str(StrBuf* sb, const char* str);
+
+/**
+ * @brief Appends a single character.
+ */
+bool strbuf_putc(StrBuf* sb, char c);
+
+/**
+ * @brief Appends printf-style formatted text.
+ */
+bool strbuf_appendf(StrBuf* sb, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief Empties the buffer but keeps its allocation for reuse.
+ */
+void strbuf_reset(StrBuf* sb);
+
+/**
+ * @brief Hands the contents to the caller and leaves the buffer empty.
+ * @return A heap string the caller must free (never NULL unless allocation fails).
+ */
+char* strbuf_detach(StrBuf* sb);
+
+/**
+ * @brief Frees the buffer's memory.
+ */
+void strbuf_free(StrBuf* sb);
+
+#endif // STRBUF_H_
@@ -0,0 +1,60 @@
+#ifndef STRMAP_H_
+#define STRMAP_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief One slot of a StrMap.
+ */
+typedef struct {
+    char* key;     ///< Owned copy of the key; NULL for an empty slot
+    uint32_t hash;
+    void* value;
+} StrMapEntry;
+
+/**
+ * @brief A map from strings to pointers, in an open-addressing (linear probing) hash table.
+ *
+ * Removal shifts the following entries back instead of leaving tombstones, so
+ * lookups stay short however often names are defined and removed. Iterate by
+ * visiting every slot whose key is not NULL.
+ */
+typedef struct {
+    StrMapEntry* slots;
+    size_t capacity; ///< A power of two (0 until the first insertion)
+    size_t count;
+} StrMap;
+
+/**
+ * @brief Initializes an empty map without allocating.
+ */
+void strmap_init(StrMap* map);
+
+/**
+ * @brief The value stored for 'key', or NULL if there is none.
+ */
+void* strmap_get(const StrMap* map, const char* key);
+
+/**
+ * @brief Stores 'value' for 'key', which is copied if new.
+ * @param old_value If not NULL, receives the value replaced (NULL if the key was new),
+ *                  for the caller to release.
+ * @return True on success, false if memory could not be allocated (already reported).
+ */
+bool strmap_put(StrMap* map, const char* key, void* value, void** old_value);
+
+/**
+ * @brief Removes 'key'.
+ * @return The value that was stored, for the caller to release, or NULL.
+ */
+void* strmap_remove(StrMap* map, const char* key);
+
+/**
+ * @brief Removes every entry, passing each value to 'free_value' (if not NULL),
+ *        and releases the table.
+ */
+void strmap_clear(StrMap* map, void (*free_value)(void*));
+
+#endif // STRMAP_H_
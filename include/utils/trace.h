@@ -0,0 +1,90 @@
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief The shell phases that can be traced.
+ *
+ * Each phase gets its own latency histogram. Keep trace_phase_name() in
+ * trace.c in sync when adding entries.
+ */
+typedef enum {
+    TRACE_PROMPT,    ///< display_shell_prompt
+    TRACE_INPUT,     ///< process_input_line (a whole input line)
+    TRACE_PARSE,     ///< parse_program
+    TRACE_EXECUTE,   ///< execute_pipeline (spawn + wait)
+    TRACE_FORK,      ///< fork() or posix_spawn() as seen by the parent
+    TRACE_EXEC,      ///< fork() return until the child's execvp succeeded
+    TRACE_WAIT,      ///< waiting on a foreground job
+    TRACE_HISTORY,   ///< history queue operations and history file I/O
+    TRACE_NUM_PHASES
+} TracePhase;
+
+/**
+ * @brief Global on/off switch. Read by the TRACE_* macros on the hot path.
+ */
+extern bool g_trace_enabled;
+
+/**
+ * @brief Returns a monotonic timestamp in nanoseconds.
+ */
+uint64_t trace_now_ns(void);
+
+/**
+ * @brief Records a completed span into the calling thread's ring buffer
+ *        and updates that phase's histogram.
+ * @param phase The phase the span belongs to.
+ * @param start_ns Start timestamp from trace_now_ns().
+ * @param end_ns End timestamp from trace_now_ns().
+ */
+void trace_record(TracePhase phase, uint64_t start_ns, uint64_t end_ns);
+
+/**
+ * @brief Returns the short display name of a phase (e.g., "parse").
+ */
+const char* trace_phase_name(TracePhase phase);
+
+/**
+ * @brief Enables or disables tracing. Recorded data is kept.
+ */
+void trace_set_enabled(bool enabled);
+
+/**
+ * @brief Clears the calling thread's ring buffer and histograms.
+ */
+void trace_reset(void);
+
+/**
+ * @brief Prints per-phase latency statistics and log2 histograms.
+ * @param out The stream to print to.
+ */
+void trace_print_histograms(FILE* out);
+
+/**
+ * @brief Writes the spans currently held in the ring buffer as Chrome trace
+ *        JSON (loadable in chrome://tracing or Perfetto).
+ * @param path The output file path.
+ * @return 0 on success, -1 on failure (errno is set).
+ */
+int trace_export_chrome_json(const char* path);
+
+/*
+ * Span macros. With tracing off, TRACE_BEGIN costs one well-predicted branch
+ * and TRACE_END tests a local that is known to be zero.
+ *
+ *     TRACE_BEGIN(t);
+ *     ... work ...
+ *     TRACE_END(TRACE_PARSE, t);
+ */
+#define TRACE_BEGIN(var) \
+    uint64_t var = __builtin_expect(g_trace_enabled, 0) ? trace_now_ns() : 0
+
+#define TRACE_END(phase, var) \
+    do { \
+        if (__builtin_expect((var) != 0, 0)) trace_record((phase), (var), trace_now_ns()); \
+    } while (0)
+
+#endif // TRACE_H_
@@ -1,53 +1,277 @@
 #include "commands/activities.h"
-#include "utils/error.h"
+#include "core/watch.h"
 
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
-bool is_process_stopped(pid_t pid) {
-    char path[MAX_PATH_LEN];
-    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
-    FILE* f = fopen(path, "r");
-    if (!f) {
-        return false; // Process likely doesn't exist anymore
+#define NEW_SAMPLE ((unsigned long long)-1) ///< 'ticks' of a member not sampled yet
+
+int activities_execute(const ShellState* state) {
+    if (state->jobs.count == 0) {
+        printf("No background activities.\n");
+        return 0;
     }
 
-    char state_char;
-    // The state is the 3rd field in /proc/[pid]/stat
-    // We use %*s to discard the fields we don't need.
-    if (fscanf(f, "%*d %*s %c", &state_char) != 1) {
-        fclose(f);
-        return false; // Failed to read state
+    printf("Background Activities:\n");
+
+    // The source of truth is our shell's internal state.
+    // We iterate through the list of background jobs we are tracking.
+    for (int i = 0; i < state->jobs.count; i++) {
+        const Job* job = state->jobs.jobs[i];
+        // A job's state is derived from the tracked state of all of its members:
+        // it only counts as stopped once no member is still running.
+        const char* display_state = (job_state(job) == JOB_STOPPED) ? "Stopped" : "Running";
+
+        // Print the information for the job. We use the PGID as the job identifier.
+        printf("%d: %s - %s\n", job->pgid, job->name, display_state);
     }
-    fclose(f);
+    return 0;
+}
 
-    return (state_char == 'T');
+static long long clock_ms(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
 }
 
-void activities_execute(const ShellState* state) {
-    if (state->num_bg_processes == 0) {
-        printf("No background activities.\n");
+void job_monitor_init(JobMonitor* monitor) {
+    memset(monitor, 0, sizeof(*monitor));
+}
+
+void job_monitor_free(JobMonitor* monitor) {
+    for (int i = 0; i < monitor->count; i++) proc_handle_close(&monitor->samples[i].handle);
+    free(monitor->samples);
+    proc_table_free(&monitor->table);
+    job_monitor_init(monitor);
+}
+
+/**
+ * @brief The sample for 'pid', opening its stat file the first time it is seen.
+ * @return NULL if the process cannot be opened (it has just exited).
+ */
+static MemberSample* find_sample(JobMonitor* monitor, pid_t pid) {
+    int lo = 0, hi = monitor->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (monitor->samples[mid].handle.pid < pid) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo < monitor->count && monitor->samples[lo].handle.pid == pid) return &monitor->samples[lo];
+
+    if (monitor->count == monitor->capacity) {
+        int capacity = monitor->capacity ? monitor->capacity * 2 : 32;
+        MemberSample* samples = realloc(monitor->samples, capacity * sizeof(MemberSample));
+        if (!samples) return NULL;
+        monitor->samples = samples;
+        monitor->capacity = capacity;
+    }
+    MemberSample sample = { .ticks = NEW_SAMPLE };
+    if (!proc_handle_open(&sample.handle, pid)) return NULL;
+    memmove(monitor->samples + lo + 1, monitor->samples + lo, (monitor->count - lo) * sizeof(MemberSample));
+    monitor->samples[lo] = sample;
+    monitor->count++;
+    return &monitor->samples[lo];
+}
+
+/**
+ * @brief Closes the samples of members that have gone since the previous frame.
+ */
+static void drop_unseen(JobMonitor* monitor) {
+    int kept = 0;
+    for (int i = 0; i < monitor->count; i++) {
+        MemberSample* sample = &monitor->samples[i];
+        if (!sample->seen) {
+            proc_handle_close(&sample->handle);
+            continue;
+        }
+        sample->seen = false;
+        monitor->samples[kept++] = *sample;
+    }
+    monitor->count = kept;
+}
+
+/**
+ * @brief What the live processes of one job used, summed over a frame.
+ */
+typedef struct {
+    unsigned long long ticks;      ///< CPU ticks since the previous frame
+    unsigned long long start_time; ///< Of the oldest process
+    long long rss_kb;
+    int procs;
+} JobUsage;
+
+/**
+ * @brief Adds process 'pid' to 'usage', unless it was already counted in this frame.
+ */
+static void sample_process(JobMonitor* monitor, pid_t pid, long long page_kb, JobUsage* usage) {
+    MemberSample* sample = find_sample(monitor, pid);
+    ProcInfo info;
+    if (!sample || sample->seen || !proc_handle_read_stat(&sample->handle, &info) || info.state == 'Z') return;
+    unsigned long long total = info.utime + info.stime;
+    if (sample->ticks != NEW_SAMPLE) usage->ticks += total - sample->ticks;
+    sample->ticks = total;
+    sample->seen = true;
+    usage->rss_kb += info.rss * page_kb;
+    if (usage->procs++ == 0 || info.start_time < usage->start_time) usage->start_time = info.start_time;
+}
+
+/**
+ * @brief Adds every process in the job's cgroup, however it was started, to 'usage'.
+ */
+static void sample_cgroup(JobMonitor* monitor, const Cgroup* cgroup, long long page_kb, JobUsage* usage) {
+    int fd = openat(cgroup->dir_fd, "cgroup.procs", O_RDONLY | O_CLOEXEC);
+    FILE* procs = fd >= 0 ? fdopen(fd, "r") : NULL;
+    if (!procs) {
+        if (fd >= 0) close(fd);
         return;
     }
+    long pid;
+    while (fscanf(procs, "%ld", &pid) == 1) sample_process(monitor, (pid_t)pid, page_kb, usage);
+    fclose(procs);
+}
 
-    printf("Background Activities:\n");
+static void format_size(long long kb, char* out, size_t size) {
+    if (kb < 1024) snprintf(out, size, "%lldK", kb);
+    else if (kb < 1024 * 1024) snprintf(out, size, "%.1fM", kb / 1024.0);
+    else snprintf(out, size, "%.1fG", kb / (1024.0 * 1024.0));
+}
 
-    // The source of truth is our shell's internal state.
-    // We iterate through the list of background jobs we are tracking.
-    for (int i = 0; i < state->num_bg_processes; i++) {
-        pid_t job_pgid = state->background_pids[i];
-        const char* job_name = state->background_process_names[i];
-        const char* display_state;
-
-        // A job's state is determined by the state of its leader process (pgid).
-        if (is_process_stopped(job_pgid)) {
-            display_state = "Stopped";
-        } else {
-            display_state = "Running";
+/**
+ * @brief Elapsed time as ps shows it: [[D-]HH:]MM:SS.
+ */
+static void format_elapsed(long long seconds, char* out, size_t size) {
+    long long days = seconds / 86400, hours = seconds / 3600 % 24, minutes = seconds / 60 % 60;
+    if (days > 0) snprintf(out, size, "%lld-%02lld:%02lld:%02lld", days, hours, minutes, seconds % 60);
+    else if (hours > 0) snprintf(out, size, "%02lld:%02lld:%02lld", hours, minutes, seconds % 60);
+    else snprintf(out, size, "%02lld:%02lld", minutes, seconds % 60);
+}
+
+void job_monitor_frame(JobMonitor* monitor, const ShellState* state, StrBuf* out) {
+    long long now = clock_ms(CLOCK_MONOTONIC);
+    double seconds = monitor->sampled_ms ? (now - monitor->sampled_ms) / 1000.0 : 0;
+    double ticks_per_second = (double)sysconf(_SC_CLK_TCK);
+    long long page_kb = sysconf(_SC_PAGESIZE) / 1024;
+    double uptime = clock_ms(CLOCK_BOOTTIME) / 1000.0;
+
+    strbuf_appendf(out, "Background Activities: %d job%s\n", state->jobs.count, state->jobs.count == 1 ? "" : "s");
+    strbuf_appendf(out, "%8s  %-8s %6s %8s %11s %5s  %s\n", "PGID", "STATE", "CPU%", "RSS", "ELAPSED", "PROCS", "COMMAND");
+    bool snapshot = false; // Taken once a job without a cgroup needs its process group
+    for (int i = 0; i < state->jobs.count; i++) {
+        Job* job = state->jobs.jobs[i];
+        job_poll(job); // Members that ended are reaped here; the job is reported at the next prompt
+        JobUsage usage = {0};
+        for (int m = 0; m < job->num_members; m++) {
+            if (job->members[m].state != JOB_DONE) sample_process(monitor, job->members[m].pid, page_kb, &usage);
+        }
+        // The processes the members started count too: those in the job's cgroup, or else its process
+        // group. Without job control, jobs share the shell's group, and only their members count.
+        if (job->cgroup) {
+            sample_cgroup(monitor, job->cgroup, page_kb, &usage);
+        } else if (state->job_control && job_state(job) != JOB_DONE) {
+            if (!snapshot) snapshot = proc_table_load(&monitor->table);
+            for (int p = 0; snapshot && p < monitor->table.count; p++) {
+                if (monitor->table.procs[p].pgid == job->pgid) {
+                    sample_process(monitor, monitor->table.procs[p].pid, page_kb, &usage);
+                }
+            }
         }
 
-        // Print the information for the job. We use the PGID as the job identifier.
-        printf("%d: %s - %s\n", job_pgid, job_name, display_state);
+        JobState job_now = job_state(job);
+        const char* display_state = job_now == JOB_DONE ? "Done" : job_now == JOB_STOPPED ? "Stopped" : "Running";
+        char cpu[16] = "-", rss[16] = "-", elapsed[32] = "-";
+        if (usage.procs > 0) {
+            if (seconds > 0) snprintf(cpu, sizeof(cpu), "%.1f", 100.0 * usage.ticks / (ticks_per_second * seconds));
+            format_size(usage.rss_kb, rss, sizeof(rss));
+            format_elapsed((long long)(uptime - usage.start_time / ticks_per_second), elapsed, sizeof(elapsed));
+        }
+        strbuf_appendf(out, "%8d  %-8s %6s %8s %11s %5d  %s\n", job->pgid, display_state, cpu, rss, elapsed,
+                       usage.procs, job->name);
+    }
+    drop_unseen(monitor);
+    monitor->sampled_ms = now;
+}
+
+static bool all_done(const ShellState* state) {
+    for (int i = 0; i < state->jobs.count; i++) {
+        if (job_state(state->jobs.jobs[i]) != JOB_DONE) return false;
+    }
+    return true;
+}
+
+int activities_watch(const ShellState* state, double interval) {
+    if (state->jobs.count == 0) {
+        printf("No background activities.\n");
+        return 0;
+    }
+    JobMonitor monitor;
+    job_monitor_init(&monitor);
+    WatchScreen screen;
+    watch_begin(&screen);
+    StrBuf frame;
+    strbuf_init(&frame);
+    int status = 0;
+    for (;;) {
+        strbuf_reset(&frame);
+        job_monitor_frame(&monitor, state, &frame);
+        if (!watch_draw(&screen, frame.data, frame.len)) {
+            status = 1;
+            break;
+        }
+        if (all_done(state) || !watch_sleep(&screen, interval)) break;
+    }
+    strbuf_free(&frame);
+    watch_end(&screen);
+    job_monitor_free(&monitor);
+    return status;
+}
+
+/**
+ * @brief Whether the parent of entry 'index' is another live member of 'job',
+ *        in which case it is drawn under that member rather than as a root.
+ */
+static bool parent_in_job(const ProcTree* tree, int index, const Job* job) {
+    int parent = tree->parent[index];
+    if (parent < 0) return false;
+    for (int m = 0; m < job->num_members; m++) {
+        if (job->members[m].state != JOB_DONE && job->members[m].pid == tree->table->procs[parent].pid) return true;
+    }
+    return false;
+}
+
+int activities_tree(const ShellState* state) {
+    if (state->jobs.count == 0) {
+        printf("No background activities.\n");
+        return 0;
+    }
+    ProcTable table = {0};
+    ProcTree tree = {0};
+    if (!proc_table_load(&table)) return 1;
+    if (!proc_tree_build(&tree, &table)) {
+        proc_table_free(&table);
+        return 1;
     }
-}
\ No newline at end of file
+    StrBuf out;
+    strbuf_init(&out);
+    strbuf_append_str(&out, "Background Activities:\n");
+    for (int i = 0; i < state->jobs.count; i++) {
+        const Job* job = state->jobs.jobs[i];
+        const char* display_state = (job_state(job) == JOB_STOPPED) ? "Stopped" : "Running";
+        strbuf_appendf(&out, "%d: %s - %s\n", job->pgid, job->name, display_state);
+        for (int m = 0; m < job->num_members; m++) {
+            if (job->members[m].state == JOB_DONE) continue;
+            const ProcInfo* proc = proc_table_find(&table, job->members[m].pid);
+            if (!proc) continue;
+            int index = (int)(proc - table.procs);
+            if (!parent_in_job(&tree, index, job)) proc_tree_format(&tree, index, "    ", &out);
+        }
+    }
+    fwrite(out.data, 1, out.len, stdout);
+    strbuf_free(&out);
+    proc_tree_free(&tree);
+    proc_table_free(&table);
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include "commands/alias.h"
+#include "core/aliases.h"
+#include "utils/error.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief An alias name may not contain blanks, quotes, expansions, '=', '/' or operators.
+ */
+static bool valid_alias_name(const char* name, size_t len) {
+    if (len == 0) return false;
+    for (size_t i = 0; i < len; i++) {
+        if (strchr(" \t\n\"'\\`$=/|&;<>(){}", name[i])) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Prints "alias name='value'", escaping single quotes in the value.
+ */
+static void print_alias(const char* name, const char* value) {
+    printf("alias %s='", name);
+    for (const char* p = value; *p; p++) {
+        if (*p == '\'') fputs("'\\''", stdout);
+        else putchar(*p);
+    }
+    printf("'\n");
+}
+
+static int compare_entries(const void* a, const void* b) {
+    return strcmp((*(const StrMapEntry* const*)a)->key, (*(const StrMapEntry* const*)b)->key);
+}
+
+static int list_aliases(void) {
+    const StrMap* table = alias_table();
+    if (table->count == 0) return 0;
+    const StrMapEntry** list = malloc(sizeof(StrMapEntry*) * table->count);
+    if (!list) {
+        print_shell_perror("alias: malloc failed");
+        return 1;
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < table->capacity; i++) {
+        if (table->slots[i].key) list[n++] = &table->slots[i];
+    }
+    qsort(list, n, sizeof(StrMapEntry*), compare_entries);
+    for (size_t i = 0; i < n; i++) print_alias(list[i]->key, list[i]->value);
+    free(list);
+    return 0;
+}
+
+int alias_execute(int argc, char* argv[], ShellState* state) {
+    (void)state;
+    if (argc == 1) return list_aliases();
+    int status = 0;
+    for (int i = 1; i < argc; i++) {
+        size_t name_len = strcspn(argv[i], "=");
+        if (argv[i][name_len] != '=') {
+            const char* value = alias_get(argv[i]);
+            if (value) {
+                print_alias(argv[i], value);
+            } else {
+                fprintf(stderr, _RED_ "Shell Error: " _RESET_ "alias: %s: not found\n", argv[i]);
+                status = 1;
+            }
+        } else if (!valid_alias_name(argv[i], name_len)) {
+            fprintf(stderr, _RED_ "Shell Error: " _RESET_ "alias: '%.*s': invalid alias name\n", (int)name_len, argv[i]);
+            status = 1;
+        } else {
+            argv[i][name_len] = '\0';
+            if (!alias_set(argv[i], argv[i] + name_len + 1)) status = 1;
+            argv[i][name_len] = '=';
+        }
+    }
+    return status;
+}
+
+int unalias_execute(int argc, char* argv[], ShellState* state) {
+    (void)state;
+    if (argc == 1) {
+        print_shell_error("Usage: unalias -a | unalias <name>...");
+        return 1;
+    }
+    if (argc == 2 && strcmp(argv[1], "-a") == 0) {
+        alias_clear();
+        return 0;
+    }
+    int status = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!alias_remove(argv[i])) {
+            fprintf(stderr, _RED_ "Shell Error: " _RESET_ "unalias: %s: not found\n", argv[i]);
+            status = 1;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,234 @@
+#define _GNU_SOURCE
+#include "commands/cat.h"
+#include "core/event_loop.h"
+#include "utils/error.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CAT_BUFFER_SIZE 65536
+#define CAT_KERNEL_CHUNK (1 << 30) ///< Bytes asked of copy_file_range() or splice() per call
+#define CAT_INTERRUPTED 130
+
+/**
+ * @brief The options, and the position in the output, which carries over between files.
+ */
+typedef struct {
+    bool number;          ///< -n
+    bool number_nonblank; ///< -b
+    bool squeeze;         ///< -s
+    bool show_ends;       ///< -E
+    bool show_tabs;       ///< -T
+    bool show_nonprinting; ///< -v
+    long line;
+    bool at_line_start;
+    int blank_lines;      ///< Empty lines in a row so far
+} CatOptions;
+
+static bool transforms(const CatOptions* opts) {
+    return opts->number || opts->number_nonblank || opts->squeeze || opts->show_ends ||
+           opts->show_tabs || opts->show_nonprinting;
+}
+
+/**
+ * @brief Waits until 'fd' can be read without blocking. The shell reads SIGINT
+ *        from its signalfd, so a blocking read() in the shell could not be interrupted.
+ * @return False if Ctrl+C was pressed.
+ */
+static bool wait_readable(int fd) {
+    if (signals_get_fd() < 0) return true; // In a child, where SIGINT is delivered as usual
+    for (;;) {
+        int events = event_loop_run_once(fd, -1);
+        if (events & SIGNAL_EVENT_INTERRUPT) return false;
+        if (events & EVENT_FD_READY) return true;
+    }
+}
+
+/**
+ * @brief True for errors that mean "this way of copying does not apply here".
+ */
+static bool unsupported(int error) {
+    return error == EINVAL || error == EXDEV || error == ENOSYS || error == EOPNOTSUPP || error == EBADF;
+}
+
+/**
+ * @brief Copies with read() and write(), transforming the text if options ask for it.
+ * @return 0, -1 on a read error or -2 on a write error (errno is set), or CAT_INTERRUPTED.
+ */
+static int copy_buffered(int in, bool wait_input, CatOptions* opts) {
+    static char buffer[CAT_BUFFER_SIZE];
+    for (;;) {
+        if (wait_input && !wait_readable(in)) return CAT_INTERRUPTED;
+        ssize_t n = read(in, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return -1;
+        if (n == 0) return 0;
+        if (!transforms(opts)) {
+            for (ssize_t done = 0; done < n;) {
+                ssize_t written = write(STDOUT_FILENO, buffer + done, n - done);
+                if (written < 0 && errno == EINTR) continue;
+                if (written < 0) return -2;
+                done += written;
+            }
+            continue;
+        }
+        for (ssize_t i = 0; i < n; i++) {
+            unsigned char c = buffer[i];
+            if (opts->at_line_start) {
+                opts->blank_lines = (c == '\n') ? opts->blank_lines + 1 : 0;
+                if (opts->squeeze && opts->blank_lines > 1) continue;
+                if (opts->number_nonblank ? c != '\n' : opts->number) printf("%6ld\t", ++opts->line);
+                opts->at_line_start = false;
+            }
+            if (c == '\n') {
+                if (opts->show_ends) putchar('$');
+                putchar('\n');
+                opts->at_line_start = true;
+                continue;
+            }
+            if (c == '\t') {
+                fputs(opts->show_tabs ? "^I" : "\t", stdout);
+                continue;
+            }
+            if (opts->show_nonprinting) {
+                if (c >= 128) {
+                    fputs("M-", stdout);
+                    c -= 128;
+                }
+                if (c < 32 || c == 127) {
+                    putchar('^');
+                    c = (c == 127) ? '?' : c + 64;
+                }
+            }
+            putchar(c);
+        }
+        if (ferror(stdout)) return -2;
+    }
+}
+
+/**
+ * @brief Copies one open file to standard output.
+ * @return As for copy_buffered().
+ */
+static int copy_file(int in, CatOptions* opts) {
+    struct stat in_st, out_st;
+    if (fstat(in, &in_st) < 0 || fstat(STDOUT_FILENO, &out_st) < 0) return -1;
+    bool wait_input = !S_ISREG(in_st.st_mode) && !S_ISBLK(in_st.st_mode);
+    if (transforms(opts)) return copy_buffered(in, wait_input, opts);
+
+    int out_flags = fcntl(STDOUT_FILENO, F_GETFL);
+    if (S_ISREG(in_st.st_mode) && S_ISREG(out_st.st_mode) && out_flags >= 0 && !(out_flags & O_APPEND)) {
+        // Between regular files the kernel copies (or reflinks) without user-space buffers.
+        // Not for '>>': copy_file_range() refuses an O_APPEND output.
+        for (;;) {
+            ssize_t n = copy_file_range(in, NULL, STDOUT_FILENO, NULL, CAT_KERNEL_CHUNK, 0);
+            if (n > 0) continue;
+            if (n == 0) return 0;
+            if (errno == EINTR) continue;
+            if (unsupported(errno)) break;
+            return (errno == ENOSPC || errno == EFBIG) ? -2 : -1;
+        }
+    } else if (S_ISFIFO(out_st.st_mode) && !S_ISREG(in_st.st_mode)) {
+        // Into a pipe, splice() moves the pages instead. Not from a regular file: the pipe
+        // would hold page cache pages, and a later write to the file would change what is read.
+        for (;;) {
+            if (wait_input && !wait_readable(in)) return CAT_INTERRUPTED;
+            ssize_t n = splice(in, NULL, STDOUT_FILENO, NULL, CAT_KERNEL_CHUNK, SPLICE_F_MOVE);
+            if (n > 0) continue;
+            if (n == 0) return 0;
+            if (errno == EINTR) continue;
+            if (unsupported(errno)) break;
+            return (errno == EPIPE) ? -2 : -1;
+        }
+    }
+    return copy_buffered(in, wait_input, opts);
+}
+
+/**
+ * @brief Parses option letters such as "-nE".
+ * @return False for an unknown letter (already reported).
+ */
+static bool parse_options(const char* arg, CatOptions* opts) {
+    for (const char* c = arg + 1; *c; c++) {
+        switch (*c) {
+        case 'b': opts->number_nonblank = true; break;
+        case 'n': opts->number = true; break;
+        case 's': opts->squeeze = true; break;
+        case 'E': opts->show_ends = true; break;
+        case 'T': opts->show_tabs = true; break;
+        case 'v': opts->show_nonprinting = true; break;
+        case 'A': opts->show_nonprinting = opts->show_ends = opts->show_tabs = true; break;
+        case 'e': opts->show_nonprinting = opts->show_ends = true; break;
+        case 't': opts->show_nonprinting = opts->show_tabs = true; break;
+        case 'u': break; // Output is never buffered between reads anyway
+        default:
+            fprintf(stderr, _RED_ "Shell Error: " _RESET_ "cat: invalid option -- '%c'\n", *c);
+            return false;
+        }
+    }
+    return true;
+}
+
+int cat_execute(int argc, char* argv[], ShellState* state) {
+    (void)state;
+    CatOptions opts;
+    memset(&opts, 0, sizeof(opts));
+    opts.at_line_start = true;
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+        if (strcmp(argv[i], "--") == 0) {
+            i++;
+            break;
+        }
+        if (!parse_options(argv[i], &opts)) return 1;
+    }
+
+    // Raw writes to the descriptor must not overtake text still in stdout's buffer.
+    fflush(stdout);
+    struct stat out_st;
+    bool out_regular = fstat(STDOUT_FILENO, &out_st) == 0 && S_ISREG(out_st.st_mode);
+    int status = 0;
+    char* stdin_name = "-";
+    char** files = (i < argc) ? argv + i : &stdin_name;
+    int num_files = (i < argc) ? argc - i : 1;
+    for (int k = 0; k < num_files; k++) {
+        const char* name = files[k];
+        bool is_stdin = strcmp(name, "-") == 0;
+        int in = is_stdin ? STDIN_FILENO : open(name, O_RDONLY | O_CLOEXEC);
+        if (in < 0) {
+            fprintf(stderr, _RED_ "Shell Error: " _RESET_ "cat: %s: %s\n", name, strerror(errno));
+            status = 1;
+            continue;
+        }
+        struct stat in_st;
+        int result;
+        if (out_regular && fstat(in, &in_st) == 0 && in_st.st_dev == out_st.st_dev &&
+            in_st.st_ino == out_st.st_ino && in_st.st_size > 0) {
+            // 'cat f >> f' would never reach the end of its input.
+            fprintf(stderr, _RED_ "Shell Error: " _RESET_ "cat: %s: input file is output file\n", name);
+            result = 1;
+        } else {
+            result = copy_file(in, &opts);
+        }
+        int error = errno;
+        if (!is_stdin) close(in);
+        fflush(stdout);
+        if (result == CAT_INTERRUPTED) {
+            printf("\n");
+            return CAT_INTERRUPTED;
+        }
+        if (result == -1) {
+            fprintf(stderr, _RED_ "Shell Error: " _RESET_ "cat: %s: %s\n", name, strerror(error));
+        } else if (result == -2) {
+            fprintf(stderr, _RED_ "Shell Error: " _RESET_ "cat: write error: %s\n", strerror(error));
+            clearerr(stdout);
+            return 1;
+        }
+        if (result != 0) status = 1;
+    }
+    return status;
+}
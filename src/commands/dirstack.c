@@ -0,0 +1,191 @@
+#include "commands/dirstack.h"
+#include "commands/warp.h"
+#include "utils/error.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * @brief Makes room for one more entry, so a push cannot fail after the directory changed.
+ */
+static bool reserve_entry(ShellState* state) {
+    if (state->dir_stack_count < state->dir_stack_capacity) return true;
+    int capacity = state->dir_stack_capacity ? state->dir_stack_capacity * 2 : 8;
+    char** stack = realloc(state->dir_stack, capacity * sizeof(char*));
+    if (!stack) {
+        print_shell_perror("pushd: realloc failed");
+        return false;
+    }
+    state->dir_stack = stack;
+    state->dir_stack_capacity = capacity;
+    return true;
+}
+
+/**
+ * @brief Warps quietly to 'dir', remembering the old directory for 'warp -'.
+ */
+static bool change_to(ShellState* state, const char* dir) {
+    return warp_quiet(dir, state);
+}
+
+/**
+ * @brief Reads a '+N' or '-N' argument as a position in the 'dirs' list of 'size' entries.
+ * @return False if 'arg' is not of that form.
+ */
+static bool parse_position(const char* arg, int size, int* out, bool* in_range) {
+    if ((arg[0] != '+' && arg[0] != '-') || !isdigit((unsigned char)arg[1])) return false;
+    char* end;
+    long n = strtol(arg + 1, &end, 10);
+    if (*end) return false;
+    *in_range = n < size;
+    *out = (arg[0] == '+') ? (int)n : size - 1 - (int)n;
+    return true;
+}
+
+/**
+ * @brief The 'dirs' list: entry 0 is the current directory, then the stack from its top.
+ */
+static const char* list_entry(const ShellState* state, int i) {
+    return i == 0 ? state->cwd : state->dir_stack[state->dir_stack_count - i];
+}
+
+static void print_entry(const ShellState* state, const char* path, bool long_paths) {
+    size_t home_len = strlen(state->home_dir);
+    if (!long_paths && strncmp(path, state->home_dir, home_len) == 0 && (path[home_len] == '/' || path[home_len] == '\0')) {
+        printf("~%s", path + home_len);
+    } else {
+        printf("%s", path);
+    }
+}
+
+static int print_stack(const ShellState* state, bool one_per_line, bool numbered, bool long_paths) {
+    for (int i = 0; i <= state->dir_stack_count; i++) {
+        if (numbered) printf("%2d  ", i);
+        print_entry(state, list_entry(state, i), long_paths);
+        printf((one_per_line || numbered || i == state->dir_stack_count) ? "\n" : " ");
+    }
+    return 0;
+}
+
+int pushd_execute(int argc, char* argv[], ShellState* state) {
+    if (argc > 2) {
+        print_shell_error("Usage: pushd [dir | +N | -N]");
+        return 1;
+    }
+    int count = state->dir_stack_count, position;
+    bool in_range;
+
+    if (argc == 1) {
+        // Swap the current directory with the top of the stack.
+        if (count == 0) {
+            print_shell_error("pushd: no other directory");
+            return 1;
+        }
+        char* saved = strdup(state->cwd);
+        if (!saved || !change_to(state, state->dir_stack[count - 1])) {
+            free(saved);
+            return 1;
+        }
+        free(state->dir_stack[count - 1]);
+        state->dir_stack[count - 1] = saved;
+    } else if (parse_position(argv[1], count + 1, &position, &in_range)) {
+        if (!in_range || position < 0) {
+            fprintf(stderr, _RED_ "Shell Error: " _RESET_ "pushd: %s: directory stack index out of range\n", argv[1]);
+            return 1;
+        }
+        if (position > 0) {
+            // Rotate the list so that entry 'position' comes first and becomes the current directory.
+            int size = count + 1;
+            char** list = malloc(size * sizeof(char*));
+            char* saved = strdup(state->cwd);
+            if (!list || !saved) {
+                print_shell_perror("pushd: malloc failed");
+                free(list);
+                free(saved);
+                return 1;
+            }
+            list[0] = saved;
+            for (int i = 1; i < size; i++) list[i] = state->dir_stack[count - i];
+            if (!change_to(state, list[position])) {
+                free(list);
+                free(saved);
+                return 1;
+            }
+            free(list[position]);
+            for (int j = 1; j < size; j++) state->dir_stack[count - j] = list[(position + j) % size];
+            free(list);
+        }
+    } else {
+        if (!reserve_entry(state)) return 1;
+        char* saved = strdup(state->cwd);
+        if (!saved || !change_to(state, argv[1])) {
+            free(saved);
+            return 1;
+        }
+        state->dir_stack[state->dir_stack_count++] = saved;
+    }
+    return print_stack(state, false, false, false);
+}
+
+int popd_execute(int argc, char* argv[], ShellState* state) {
+    if (argc > 2) {
+        print_shell_error("Usage: popd [+N | -N]");
+        return 1;
+    }
+    int count = state->dir_stack_count, position = 0;
+    bool in_range = true;
+    if (argc == 2 && !parse_position(argv[1], count + 1, &position, &in_range)) {
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "popd: %s: invalid argument\n", argv[1]);
+        return 1;
+    }
+    if (count == 0) {
+        print_shell_error("popd: directory stack empty");
+        return 1;
+    }
+    if (!in_range || position < 0) {
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "popd: %s: directory stack index out of range\n", argv[1]);
+        return 1;
+    }
+
+    if (position == 0) {
+        if (!change_to(state, state->dir_stack[count - 1])) return 1;
+        free(state->dir_stack[count - 1]);
+    } else {
+        // Drop the entry without changing directory.
+        int index = count - position;
+        free(state->dir_stack[index]);
+        memmove(state->dir_stack + index, state->dir_stack + index + 1, (count - index - 1) * sizeof(char*));
+    }
+    state->dir_stack_count--;
+    return print_stack(state, false, false, false);
+}
+
+int dirs_execute(int argc, char* argv[], ShellState* state) {
+    bool clear = false, one_per_line = false, numbered = false, long_paths = false;
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-' || !argv[i][1]) {
+            print_shell_error("Usage: dirs [-clpv]");
+            return 1;
+        }
+        for (const char* c = argv[i] + 1; *c; c++) {
+            switch (*c) {
+            case 'c': clear = true; break;
+            case 'p': one_per_line = true; break;
+            case 'v': numbered = true; break;
+            case 'l': long_paths = true; break;
+            default:
+                fprintf(stderr, _RED_ "Shell Error: " _RESET_ "dirs: invalid option -- '%c'\n", *c);
+                return 1;
+            }
+        }
+    }
+    if (clear) {
+        for (int i = 0; i < state->dir_stack_count; i++) free(state->dir_stack[i]);
+        state->dir_stack_count = 0;
+        return 0;
+    }
+    return print_stack(state, one_per_line, numbered, long_paths);
+}
@@ -1,111 +1,102 @@
 #include "commands/fg_bg.h"
+#include "commands/limit.h"
 #include "utils/error.h"
 
 #include <signal.h>
 #include <stdio.h>
 #include <string.h>
-#include <sys/wait.h>
 #include <unistd.h>
-#include <errno.h>
 
-void fg_execute(pid_t pid, ShellState* state) {
+/**
+ * @brief Finds the job containing 'pid' in the shell's job table.
+ * @param cmd_name "fg" or "bg", for error messages.
+ * @return The job, or NULL after printing an error.
+ */
+static Job* find_job_for_pid(pid_t pid, ShellState* state, const char* cmd_name) {
+    char message[128];
     // A PID of 0 is invalid for fg/bg.
     if (pid <= 0) {
-        print_shell_error("fg: Invalid PID provided.");
-        return;
+        snprintf(message, sizeof(message), "%s: Invalid PID provided.", cmd_name);
+        print_shell_error(message);
+        return NULL;
     }
 
     // Get the Process Group ID for the given PID. This is crucial for job control.
     pid_t job_pgid = getpgid(pid);
-    printf("%d\n", job_pgid);
     if (job_pgid < 0) {
-        print_shell_perror("fg: Could not find process with given PID");
-        return;
+        snprintf(message, sizeof(message), "%s: Could not find process with given PID", cmd_name);
+        print_shell_perror(message);
+        return NULL;
     }
 
-    // Find the job in our background list using its PGID.
-    int job_index = -1;
-    for (int i = 0; i < state->num_bg_processes; i++) {
-        if (state->background_pids[i] == job_pgid) {
-            job_index = i;
-            break;
-        }
-    }
-
-    if (job_index == -1) {
-        print_shell_error("fg: Job is not a background process of this shell.");
-        return;
+    Job* job = job_table_find(&state->jobs, job_pgid);
+    if (!job) {
+        snprintf(message, sizeof(message), "%s: Job is not a background process of this shell.", cmd_name);
+        print_shell_error(message);
     }
+    return job;
+}
 
-    // Save the job name before we remove it from the list.
-    char job_name[MAX_PATH_LEN];
-    strcpy(job_name, state->background_process_names[job_index]);
+int fg_execute(pid_t pid, ShellState* state) {
+    Job* job = find_job_for_pid(pid, state, "fg");
+    if (!job) return 1;
+    printf("%d\n", job->pgid);
 
     // Remove the job from the background list *before* bringing it to the foreground.
-    for (int i = job_index; i < state->num_bg_processes - 1; i++) {
-        state->background_pids[i] = state->background_pids[i + 1];
-        strcpy(state->background_process_names[i], state->background_process_names[i + 1]);
-    }
-    state->num_bg_processes--;
+    job_table_remove(&state->jobs, job);
 
     // 1. Give terminal control to the job's process group.
-    tcsetpgrp(STDIN_FILENO, job_pgid);
+    tcsetpgrp(STDIN_FILENO, job->pgid);
 
     // 2. Send SIGCONT to the entire process group to resume it.
-    if (kill(-job_pgid, SIGCONT) < 0) {
+    if (kill(-job->pgid, SIGCONT) < 0) {
         print_shell_perror("fg: Failed to send SIGCONT");
         // If we fail, we must take terminal control back.
         tcsetpgrp(STDIN_FILENO, getpgrp());
-        return;
+        job_table_add(&state->jobs, job);
+        return 1;
     }
+    job_mark_running(job);
 
-    // 3. Wait for the now-foreground job to complete or be stopped again.
-    int status;
-    state->foreground_pgid = job_pgid;
-    waitpid(-job_pgid, &status, WUNTRACED);
+    // 3. Wait for every member of the now-foreground job to finish, or for the job to stop again.
+    //    A job whose output is captured still writes to its ring; new output is copied to the terminal.
+    if (job->output) job->output->echo = true;
+    state->foreground_pgid = job->pgid;
+    JobState result = job_wait(job);
     state->foreground_pgid = -1;
+    if (job->output) {
+        job_output_drain(job->output); // What it wrote just before it stopped or exited
+        job->output->echo = false;
+    }
 
     // 4. The shell MUST take back control of the terminal.
     tcsetpgrp(STDIN_FILENO, getpgrp());
+    state->last_exit_status = job_exit_status(job, state->options.pipefail);
 
     // 5. If the job was stopped again (by Ctrl+Z), add it back to the background list.
-    if (WIFSTOPPED(status)) {
-        printf("\nStopped: %s (PGID %d)\n", job_name, job_pgid);
-        if (state->num_bg_processes < MAX_BG_PROCS) {
-            state->background_pids[state->num_bg_processes] = job_pgid;
-            strcpy(state->background_process_names[state->num_bg_processes], job_name);
-            state->num_bg_processes++;
+    if (result == JOB_STOPPED) {
+        printf("\nStopped: %s (PGID %d)\n", job->name, job->pgid);
+        if (job_table_add(&state->jobs, job)) return state->last_exit_status;
+    } else {
+        if (job->cgroup) limit_report(job);
+        if (job_interrupted(job)) {
+            printf("\n"); // Keep the next prompt off the "^C" line
+            state->interrupted = true; // Like Ctrl+C in the shell: abandon the rest of the line
         }
     }
+    job_free(job);
+    return state->last_exit_status;
 }
 
-void bg_execute(pid_t pid, ShellState* state) {
-    if (pid <= 0) {
-        print_shell_error("bg: Invalid PID provided.");
-        return;
-    }
-
-    pid_t job_pgid = getpgid(pid);
-    if (job_pgid < 0) {
-        print_shell_perror("bg: Could not find process with given PID");
-        return;
-    }
-
-    bool job_found = false;
-    for (int i = 0; i < state->num_bg_processes; i++) {
-        if (state->background_pids[i] == job_pgid) {
-            job_found = true;
-            break;
-        }
-    }
-
-    if (!job_found) {
-        print_shell_error("bg: Job is not a background process of this shell.");
-        return;
-    }
+int bg_execute(pid_t pid, ShellState* state) {
+    Job* job = find_job_for_pid(pid, state, "bg");
+    if (!job) return 1;
 
     // Send SIGCONT to resume the job in the background.
-    if (kill(-job_pgid, SIGCONT) < 0) {
+    if (kill(-job->pgid, SIGCONT) < 0) {
         print_shell_perror("bg: Failed to send SIGCONT");
+        return 1;
     }
-}
\ No newline at end of file
+    job_mark_running(job);
+    return 0;
+}
@@ -1,128 +1,312 @@
+#define _GNU_SOURCE
 #include "commands/iman.h"
 #include "utils/error.h"
 #include "utils/colors.h"
+#include "utils/roff.h"
+#include "utils/strbuf.h"
+#include "utils/html_text.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdint.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <netdb.h>
 
 // Constants moved from the old header file to the .c file
 #define HOSTNAME "man.he.net"
-#define SERVER_IP "65.19.140.5" // Note: Using a hardcoded IP is not robust, but preserved as requested.
+#define SERVER_IP "65.19.140.5" // Default remote backend; override with IMAN_SERVER=host[:port]
 #define SERVER_PORT 80
-#define BUFFER_SIZE 900000 // For heap allocation
-
-void printFormatted(char* start_ptr, char* end_ptr) {
-    char* curr = start_ptr;
-    char ans[900000] = {};
-    while(curr && curr < end_ptr){
-        char* new = strstr(curr, "<STRONG>");
-        if(new > end_ptr)
-            new = end_ptr;
-        strcpy(ans, "");
-        strncpy(ans, curr, new - curr);
-        ans[new - curr] = '\0';
-        printf("%s", ans);
-
-        char name[1000] = {};
-        char* name_start = strstr(new, "\">") + 2;
-        char* name_end = strstr(new, "</A>");
-        if(name_start - 2 && name_end && name_start < end_ptr) {
-            strncpy(name, name_start, name_end - name_start);
-            name[name_end - name_start] = '\0';
-            printf(_BLUE_"%s"_RESET_ " ", name);
+#define IMAN_RECV_CHUNK 4096
+
+#define IMAN_DEFAULT_MANPATH "/usr/local/share/man:/usr/share/man"
+#define IMAN_CACHE_MAGIC "shellby-iman 1"
+#define IMAN_MIN_WIDTH 40
+#define IMAN_MAX_WIDTH 160
+#define IMAN_PATH_LEN 4096
+
+// Search order used when no section is given (same spirit as man-db's default).
+static const char* const search_sections[] = {"1", "8", "2", "3", "4", "5", "6", "7", "9", "n", "l", NULL};
+
+/**
+ * @brief Finds an installed page under MANPATH (or the default man directories).
+ * @param name The page name (e.g., "ls").
+ * @param section A section to restrict the search to, or NULL for all.
+ * @param out Buffer receiving the page's path.
+ * @return True if a page was found.
+ */
+static bool find_local_page(const char* name, const char* section, char* out, size_t size) {
+    const char* manpath = getenv("MANPATH");
+    if (!manpath || !*manpath) manpath = IMAN_DEFAULT_MANPATH;
+    char* dirs = strdup(manpath);
+    if (!dirs) return false;
+
+    const char* single[] = {section, NULL};
+    const char* const* sections = section ? single : search_sections;
+    bool found = false;
+    for (int s = 0; sections[s] && !found; s++) {
+        char* saveptr;
+        char* list = strdup(dirs);
+        if (!list) break;
+        for (char* dir = strtok_r(list, ":", &saveptr); dir && !found; dir = strtok_r(NULL, ":", &saveptr)) {
+            struct stat st;
+            snprintf(out, size, "%s/man%s/%s.%s.gz", dir, sections[s], name, sections[s]);
+            if (stat(out, &st) == 0 && S_ISREG(st.st_mode)) { found = true; break; }
+            snprintf(out, size, "%s/man%s/%s.%s", dir, sections[s], name, sections[s]);
+            if (stat(out, &st) == 0 && S_ISREG(st.st_mode)) { found = true; break; }
+        }
+        free(list);
+    }
+    free(dirs);
+    return found;
+}
+
+static int terminal_width(void) {
+    struct winsize ws;
+    int width = 80;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0) width = ws.ws_col - 2;
+    if (width < IMAN_MIN_WIDTH) width = IMAN_MIN_WIDTH;
+    if (width > IMAN_MAX_WIDTH) width = IMAN_MAX_WIDTH;
+    return width;
+}
+
+/**
+ * @brief Builds the cache file path for a rendered page, creating the cache directory.
+ *
+ * The cache lives in $XDG_CACHE_HOME/shellby/iman (default ~/.cache/shellby/iman).
+ * Entries are named by a hash of the header, which already encodes the
+ * page path, mtime, size and render width.
+ */
+static bool cache_path_for(const char* header, char* out, size_t size) {
+    char dir[IMAN_PATH_LEN];
+    const char* xdg = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    if (xdg && *xdg) snprintf(dir, sizeof(dir), "%s/shellby/iman", xdg);
+    else if (home && *home) snprintf(dir, sizeof(dir), "%s/.cache/shellby/iman", home);
+    else return false;
+
+    // mkdir -p
+    for (char* p = dir + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            mkdir(dir, 0755);
+            *p = '/';
         }
+    }
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) return false;
+
+    uint64_t hash = 1469598103934665603ULL; // FNV-1a
+    for (const char* p = header; *p; p++) {
+        hash = (hash ^ (unsigned char)*p) * 1099511628211ULL;
+    }
+    snprintf(out, size, "%s/%016llx.txt", dir, (unsigned long long)hash);
+    return true;
+}
 
-        curr = strstr(new, "</STRONG>");
-        curr += 10;
+static bool write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
     }
+    return true;
 }
 
+/**
+ * @brief Prints a cached page straight from its memory mapping.
+ * @return True if a valid entry matching 'header' was found and shown.
+ */
+static bool show_cached(const char* cache_path, const char* header) {
+    int fd = open(cache_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
 
-// Your original iMan function, renamed and adapted
-void iman_execute(const char* command_name) {
-    char address[100] = {0};
-    snprintf(address, sizeof(address), "/?topic=%s&section=all", command_name);
+    struct stat st;
+    size_t header_len = strlen(header);
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < header_len) {
+        close(fd);
+        return false;
+    }
+    char* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
 
-    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
-    if (sockfd == -1) {
-        print_shell_error("iman: Socket creation failed");
-        return;
+    bool valid = memcmp(map, header, header_len) == 0; // Guards against hash collisions
+    if (valid) {
+        fflush(stdout);
+        write_all(STDOUT_FILENO, map + header_len, (size_t)st.st_size - header_len);
     }
+    munmap(map, (size_t)st.st_size);
+    return valid;
+}
 
-    struct sockaddr_in server_addr;
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(SERVER_PORT);
-    server_addr.sin_addr.s_addr = inet_addr(SERVER_IP);
+/**
+ * @brief Atomically writes a rendered page to the cache (write to a temp file, then rename).
+ */
+static void store_cache(const char* cache_path, const char* header, const StrBuf* rendered) {
+    char tmp_path[IMAN_PATH_LEN + 32];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%d.tmp", cache_path, (int)getpid());
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return; // Caching is best-effort
 
-    if (connect(sockfd, (struct sockaddr*)&server_addr, sizeof(server_addr)) == -1) {
-        print_shell_error("iman: Connection failed");
-        close(sockfd);
-        return;
+    bool ok = write_all(fd, header, strlen(header)) && write_all(fd, rendered->data, rendered->len);
+    if (close(fd) != 0) ok = false;
+    if (!ok || rename(tmp_path, cache_path) != 0) unlink(tmp_path);
+}
+
+/**
+ * @brief Renders an installed man page, using the cache when it is up to date.
+ * @return True if a local page was found.
+ */
+static bool iman_local(const char* command_name, const char* section) {
+    char page_path[IMAN_PATH_LEN];
+    if (!find_local_page(command_name, section, page_path, sizeof(page_path))) {
+        return false;
     }
 
-    char request[5000] = {0};
-    snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\nHost: %s\r\n\r\n", address, HOSTNAME);
-    if (send(sockfd, request, strlen(request), 0) == -1) {
-        print_shell_error("iman: Request sending failed");
-        close(sockfd);
-        return;
+    struct stat st;
+    if (stat(page_path, &st) != 0) return false;
+    int width = terminal_width();
+
+    char header[IMAN_PATH_LEN + 128];
+    snprintf(header, sizeof(header), IMAN_CACHE_MAGIC " %s %lld.%09ld %lld %d\n", page_path,
+             (long long)st.st_mtim.tv_sec, st.st_mtim.tv_nsec, (long long)st.st_size, width);
+
+    char cache_path[IMAN_PATH_LEN];
+    bool cacheable = cache_path_for(header, cache_path, sizeof(cache_path));
+    if (cacheable && show_cached(cache_path, header)) {
+        return true;
     }
 
-    // CRITICAL FIX: Allocate buffer on the heap, not the stack
-    char* buffer = (char*)malloc(BUFFER_SIZE);
-    if (!buffer) {
-        print_shell_perror("iman: Failed to allocate memory");
-        close(sockfd);
-        return;
+    StrBuf rendered;
+    strbuf_init(&rendered);
+    if (!roff_render_file(page_path, width, &rendered)) {
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "iman: Could not read '%s'\n", page_path);
+        strbuf_free(&rendered);
+        return true; // Found, but unreadable: don't fall through to "not found"
     }
+    fflush(stdout);
+    write_all(STDOUT_FILENO, rendered.data ? rendered.data : "", rendered.len);
+    if (cacheable) store_cache(cache_path, header, &rendered);
+    strbuf_free(&rendered);
+    return true;
+}
 
-    // Using recv in a loop is better, but this preserves the original MSG_WAITALL logic
-    ssize_t bytes_received = recv(sockfd, buffer, BUFFER_SIZE - 1, MSG_WAITALL);
-    close(sockfd); // Close socket as soon as data is received
+/**
+ * @brief Connects to the remote backend: IMAN_SERVER=host[:port] if set, otherwise man.he.net.
+ * @param host_header Receives the value for the HTTP Host header.
+ * @return A connected socket, or -1 on failure.
+ */
+static int connect_remote(char* host_header, size_t size) {
+    const char* server = getenv("IMAN_SERVER");
+    char host[256] = SERVER_IP;
+    char port[16];
+    snprintf(port, sizeof(port), "%d", SERVER_PORT);
+    snprintf(host_header, size, "%s", HOSTNAME);
 
-    if (bytes_received <= 0) {
-        print_shell_error("iman: Response receiving failed or connection closed");
-        free(buffer);
-        return;
+    if (server && *server) {
+        snprintf(host, sizeof(host), "%s", server);
+        char* colon = strrchr(host, ':');
+        if (colon) {
+            *colon = '\0';
+            snprintf(port, sizeof(port), "%s", colon + 1);
+        }
+        snprintf(host_header, size, "%s", host);
     }
-    buffer[bytes_received] = '\0';
 
-    if(strstr(buffer, "Search Again") != NULL){
-        printf(_RED_"ERROR: "_RESET_"iman: Command not found\n");
-        free(buffer);
-        return;
+    struct addrinfo hints = {0}, *results;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, port, &hints, &results) != 0) {
+        return -1;
     }
-    // print_shell_error(buffer);
-    char* start_ptr = strstr(buffer, "NAME\n");
-    if (!start_ptr) {
-        print_shell_error("iman: Could not find 'NAME' section in man page.");
-        free(buffer);
-        return;
+    int sockfd = -1;
+    for (struct addrinfo* ai = results; ai; ai = ai->ai_next) {
+        sockfd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (sockfd < 0) continue;
+        if (connect(sockfd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+        close(sockfd);
+        sockfd = -1;
     }
+    freeaddrinfo(results);
+    return sockfd;
+}
 
-    
-    char* end_ptr = NULL;
-    end_ptr = strstr(buffer, "</pre>");
-    if(!end_ptr) end_ptr = strstr(buffer, "Linux                             2");
-    if(!end_ptr) end_ptr = strstr(buffer, "Linux                             1");
-    if(!end_ptr) end_ptr = strstr(buffer, "GNU                               2");
-    if(!end_ptr) end_ptr = strstr(buffer, "GNU                               1");
-    if(!end_ptr) end_ptr = strstr(buffer, "</PRE");
+/**
+ * @brief The remote backend: fetches the page as HTML and streams it through
+ *        the HTML-to-text converter as it arrives.
+ */
+static int iman_remote(const char* command_name) {
+    char address[300] = {0};
+    snprintf(address, sizeof(address), "/?topic=%s&section=all", command_name);
 
-    if(!end_ptr){
-        print_shell_error("iman: Could not find end of man page content.");
-        free(buffer);
-        return;
+    char host_header[256];
+    int sockfd = connect_remote(host_header, sizeof(host_header));
+    if (sockfd == -1) {
+        print_shell_error("iman: Connection failed");
+        return 1;
     }
 
-    // Call your original formatting function
-    printFormatted(start_ptr, end_ptr);
-    printf("\n");
+    // HTTP/1.0 keeps the body free of chunked transfer encoding.
+    char request[600] = {0};
+    snprintf(request, sizeof(request), "GET %s HTTP/1.0\r\nHost: %s\r\nConnection: close\r\n\r\n", address, host_header);
+    if (send(sockfd, request, strlen(request), MSG_NOSIGNAL) == -1) {
+        print_shell_error("iman: Request sending failed");
+        close(sockfd);
+        return 1;
+    }
 
-    free(buffer); // Free the heap-allocated memory
-}
\ No newline at end of file
+    HtmlText html;
+    html_text_init(&html, true);
+    char chunk[IMAN_RECV_CHUNK];
+    bool receive_failed = false;
+    for (;;) {
+        ssize_t n = recv(sockfd, chunk, sizeof(chunk), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) receive_failed = true;
+        if (n <= 0) break;
+        if (!html_text_feed(&html, chunk, (size_t)n, stdout)) break;
+    }
+    close(sockfd);
+    html_text_finish(&html, stdout);
+
+    if (html.started) {
+        printf("\n");
+        return 0;
+    }
+    if (receive_failed) {
+        print_shell_error("iman: Response receiving failed or connection closed");
+    } else if (html.not_found) {
+        printf(_RED_"ERROR: "_RESET_"iman: Command not found\n");
+    } else {
+        print_shell_error("iman: Could not find 'NAME' section in man page.");
+    }
+    return 1;
+}
+
+int iman_execute(const char* command_name, const char* section, bool use_remote) {
+    if (strchr(command_name, '/') || (section && strchr(section, '/'))) {
+        print_shell_error("iman: Invalid page name.");
+        return 1;
+    }
+    if (use_remote) {
+        return iman_remote(command_name);
+    }
+    if (!iman_local(command_name, section)) {
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "iman: No local manual entry for '%s'%s%s (use 'iman -r %s' to fetch it online)\n",
+                command_name, section ? " in section " : "", section ? section : "", command_name);
+        return 1;
+    }
+    return 0;
+}
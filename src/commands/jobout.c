@@ -0,0 +1,113 @@
+#include "commands/jobout.h"
+#include "core/event_loop.h"
+#include "utils/error.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define JOBOUT_USAGE "Usage: jobout [-f] [<pid>] | jobout -l"
+
+static bool job_has_pid(const Job* job, pid_t pid) {
+    if (job->pgid == pid) return true;
+    for (int m = 0; m < job->num_members; m++) {
+        if (job->members[m].pid == pid) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief The job with captured output that 'pid' names (0: the most recent), or NULL.
+ */
+static Job* find_captured(const ShellState* state, pid_t pid) {
+    // Running jobs first: they are newer than any that have ended.
+    for (int i = state->jobs.count - 1; i >= 0; i--) {
+        Job* job = state->jobs.jobs[i];
+        if (job->output && (pid == 0 || job_has_pid(job, pid))) return job;
+    }
+    for (int i = state->finished.count - 1; i >= 0; i--) {
+        Job* job = state->finished.jobs[i];
+        if (pid == 0 || job_has_pid(job, pid)) return job;
+    }
+    return NULL;
+}
+
+static void list_captured(const ShellState* state) {
+    printf("%8s  %-8s %10s  %s\n", "PGID", "STATE", "BYTES", "COMMAND");
+    for (int i = 0; i < state->finished.count; i++) {
+        const Job* job = state->finished.jobs[i];
+        printf("%8d  %-8s %10llu  %s\n", job->pgid, "Done", job->output->total, job->name);
+    }
+    for (int i = 0; i < state->jobs.count; i++) {
+        Job* job = state->jobs.jobs[i];
+        if (!job->output) continue;
+        job_output_drain(job->output);
+        printf("%8d  %-8s %10llu  %s\n", job->pgid, job_state(job) == JOB_STOPPED ? "Stopped" : "Running",
+               job->output->total, job->name);
+    }
+}
+
+/**
+ * @brief Writes the captured bytes from 'from' on, noting any that were overwritten first.
+ * @return The offset to continue from.
+ */
+static unsigned long long show_from(const JobOutput* output, unsigned long long from) {
+    unsigned long long oldest = job_output_oldest(output);
+    if (from < oldest) {
+        // Start at the first whole line that is left, as tail would.
+        unsigned long long start = oldest;
+        while (start < output->total && output->data[start % output->size] != '\n') start++;
+        if (start < output->total) oldest = start + 1;
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "jobout: %llu bytes were overwritten; showing the last %llu\n",
+                oldest - from, output->total - oldest);
+        from = oldest;
+    }
+    return job_output_write(output, from, STDOUT_FILENO);
+}
+
+int jobout_execute(int argc, char* argv[], ShellState* state) {
+    bool follow = false, list = false;
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+        if (strcmp(argv[i], "-f") == 0) follow = true;
+        else if (strcmp(argv[i], "-l") == 0) list = true;
+        else {
+            print_shell_error(JOBOUT_USAGE);
+            return 1;
+        }
+    }
+    char* end = NULL;
+    long pid = (i < argc) ? strtol(argv[i], &end, 10) : 0;
+    if (argc - i > 1 || (i < argc && (*argv[i] == '\0' || *end != '\0' || pid <= 0)) || (list && (follow || i < argc))) {
+        print_shell_error(JOBOUT_USAGE);
+        return 1;
+    }
+    if (list) {
+        list_captured(state);
+        return 0;
+    }
+
+    Job* job = find_captured(state, (pid_t)pid);
+    if (!job) {
+        if (pid) fprintf(stderr, _RED_ "Shell Error: " _RESET_ "jobout: %ld: no captured output for this process\n", pid);
+        else print_shell_error(state->options.jobcapture ? "jobout: no job has captured output yet"
+                                                         : "jobout: no captured output (see 'set -o jobcapture')");
+        return 1;
+    }
+    JobOutput* output = job->output;
+    job_output_drain(output);
+    fflush(stdout); // The ring is written to the descriptor directly
+    unsigned long long shown = show_from(output, 0);
+    while (follow && output->fd >= 0) {
+        // The event loop drains the ring; whatever it added is printed after each wakeup.
+        int events = event_loop_run_once(-1, -1);
+        if (events & SIGNAL_EVENT_INTERRUPT) {
+            printf("\n");
+            break;
+        }
+        job_output_drain(output);
+        shown = show_from(output, shown);
+    }
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include "commands/limit.h"
+#include "utils/error.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LIMIT_USAGE "Usage: limit [-m <size>] [-c <percent>] [-p <count>] [--] <command>..."
+
+/**
+ * @brief Reads a size such as "512M" or "2G" (powers of 1024), or plain bytes.
+ * @return The size, or -1 if it is not one.
+ */
+static long long parse_size(const char* text) {
+    char* end;
+    double value = strtod(text, &end);
+    if (end == text || value <= 0) return -1;
+    const char* units = "KMGT";
+    const char* unit = (*end) ? strchr(units, toupper((unsigned char)*end)) : NULL;
+    if (unit) {
+        for (const char* u = units; u <= unit; u++) value *= 1024;
+        end++;
+        if (toupper((unsigned char)*end) == 'B') end++;
+    }
+    return *end ? -1 : (long long)value;
+}
+
+/**
+ * @brief Reads a positive count, with an optional '%' after it if 'percent'.
+ * @return The count, or -1 if it is not one.
+ */
+static int parse_count(const char* text, bool percent) {
+    char* end;
+    long value = strtol(text, &end, 10);
+    if (end == text || value <= 0 || value > 1000000) return -1;
+    if (percent && *end == '%') end++;
+    return *end ? -1 : (int)value;
+}
+
+bool limit_parse(SimpleCommand* cmd, CgroupLimits* limits) {
+    memset(limits, 0, sizeof(*limits));
+    int i = 1;
+    for (; i < cmd->argc && cmd->args[i][0] == '-'; i++) {
+        const char* option = cmd->args[i];
+        if (strcmp(option, "--") == 0) {
+            i++;
+            break;
+        }
+        bool known = strcmp(option, "-m") == 0 || strcmp(option, "-c") == 0 || strcmp(option, "-p") == 0;
+        if (!known || i + 1 == cmd->argc) {
+            print_shell_error(LIMIT_USAGE);
+            return false;
+        }
+        const char* value = cmd->args[++i];
+        bool ok;
+        if (option[1] == 'm') ok = (limits->memory_max = parse_size(value)) > 0;
+        else if (option[1] == 'c') ok = (limits->cpu_percent = parse_count(value, true)) > 0;
+        else ok = (limits->pids_max = parse_count(value, false)) > 0;
+        if (!ok) {
+            fprintf(stderr, _RED_ "Shell Error: " _RESET_ "limit: %s: invalid %s\n", value,
+                    option[1] == 'm' ? "size" : option[1] == 'c' ? "CPU percentage" : "process count");
+            return false;
+        }
+    }
+    if (i == cmd->argc) {
+        print_shell_error(LIMIT_USAGE);
+        return false;
+    }
+    for (int k = 0; k < i; k++) free(cmd->args[k]);
+    memmove(cmd->args, cmd->args + i, (cmd->argc - i + 1) * sizeof(char*));
+    cmd->argc -= i;
+    return true;
+}
+
+static void format_bytes(long long bytes, char* out, size_t size) {
+    if (bytes < 1024 * 1024) snprintf(out, size, "%.1fK", bytes / 1024.0);
+    else if (bytes < 1024LL * 1024 * 1024) snprintf(out, size, "%.1fM", bytes / (1024.0 * 1024.0));
+    else snprintf(out, size, "%.2fG", bytes / (1024.0 * 1024.0 * 1024.0));
+}
+
+void limit_report(const Job* job) {
+    CgroupUsage usage;
+    if (!job->cgroup || !cgroup_read_usage(job->cgroup, &usage)) return;
+    char line[256];
+    int len = snprintf(line, sizeof(line), "limit: %s (PGID %d): cpu %.2fs (user %.2fs, system %.2fs)",
+                       job->name, job->pgid, usage.usage_usec / 1e6, usage.user_usec / 1e6, usage.system_usec / 1e6);
+    if (usage.memory_peak >= 0 && len < (int)sizeof(line)) {
+        char peak[32];
+        format_bytes(usage.memory_peak, peak, sizeof(peak));
+        len += snprintf(line + len, sizeof(line) - len, ", memory peak %s", peak);
+    }
+    if (usage.oom_kills > 0 && len < (int)sizeof(line)) {
+        snprintf(line + len, sizeof(line) - len, ", %lld killed out of memory", usage.oom_kills);
+    }
+    fprintf(stderr, "%s\n", line);
+}
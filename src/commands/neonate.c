@@ -82,9 +82,9 @@ static void print_latest_pid() {
     free(namelist);
 }
 
-void neonate_execute(int time_arg) {
+int neonate_execute(int time_arg) {
     if (!enable_raw_mode()) {
-        return;
+        return 1;
     }
 
     time_t last_print_time = 0;
@@ -107,4 +107,5 @@ void neonate_execute(int time_arg) {
     }
 
     disable_raw_mode();
+    return 0;
 }
\ No newline at end of file
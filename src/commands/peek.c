@@ -1,3 +1,4 @@
+#define _GNU_SOURCE // For scandirat
 #include "commands/peek.h"
 #include "core/shell_state.h" // For constants and colors
 #include "utils/error.h"      // For print_shell_perror
@@ -6,6 +7,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <dirent.h>
 #include <sys/stat.h>
 #include <pwd.h>
@@ -15,20 +17,17 @@
 
 /**
  * @brief Helper function to prepare the target directory path for peek.
- * Expands '~', handles NULL dir_arg for current directory.
+ * Expands '~', handles NULL dir_arg for current directory; other paths stay
+ * relative, to be opened from the shell's directory.
  * @param input_dir_arg The directory argument from the user.
  * @param home_dir The user's home directory.
  * @param output_path_buffer Buffer to store the resolved path.
  * @param buffer_size Size of the output_path_buffer.
- * @return True if path resolution was successful, false otherwise.
  */
-static bool resolve_peek_path(const char* input_dir_arg, const char* home_dir,
+static void resolve_peek_path(const char* input_dir_arg, const char* home_dir,
                               char* output_path_buffer, size_t buffer_size) {
     if (!input_dir_arg || strlen(input_dir_arg) == 0) { // Peek current directory
-        if (getcwd(output_path_buffer, buffer_size) == NULL) {
-            print_shell_perror("peek: getcwd failed");
-            return false;
-        }
+        snprintf(output_path_buffer, buffer_size, ".");
     } else {
         if (input_dir_arg[0] == '~') {
             if (strlen(input_dir_arg) == 1 || (input_dir_arg[1] == '/' || input_dir_arg[1] == '\0')) { // ~ or ~/path
@@ -41,7 +40,6 @@ static bool resolve_peek_path(const char* input_dir_arg, const char* home_dir,
             output_path_buffer[buffer_size - 1] = '\0';
         }
     }
-    return true;
 }
 
 void print_file_permissions(mode_t perms) {
@@ -57,19 +55,22 @@ void print_file_permissions(mode_t perms) {
     printf((perms & S_IXOTH) ? "x" : "-");
 }
 
-void peek_execute(const char* dir_arg, const char* home_dir, bool list_long, bool show_hidden) {
+int peek_execute(const char* dir_arg, const ShellState* state, bool list_long, bool show_hidden) {
     char target_dir_path[MAX_PATH_LEN];
-    if (!resolve_peek_path(dir_arg, home_dir, target_dir_path, sizeof(target_dir_path))) {
-        return;
-    }
+    resolve_peek_path(dir_arg, state->home_dir, target_dir_path, sizeof(target_dir_path));
 
+    // Entries are looked up relative to the directory's descriptor, not by full path.
     struct dirent **name_list;
-    int count = scandir(target_dir_path, &name_list, NULL, alphasort);
+    int count = -1;
+    int dir_fd = openat(state->cwd_fd >= 0 ? state->cwd_fd : AT_FDCWD, target_dir_path,
+                        O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) count = scandirat(dir_fd, ".", &name_list, NULL, alphasort);
 
     if (count < 0) {
         fprintf(stderr, _RED_ "Shell Error: " _RESET_ "peek: Could not scan directory '%s': %s\n",
                 target_dir_path, strerror(errno));
-        return;
+        if (dir_fd >= 0) close(dir_fd);
+        return 1;
     }
 
     if (list_long) {
@@ -78,10 +79,8 @@ void peek_execute(const char* dir_arg, const char* home_dir, bool list_long, boo
             if (!show_hidden && name_list[i]->d_name[0] == '.') {
                 continue;
             }
-            char item_full_path[MAX_PATH_LEN * 2]; // Path + name
-            snprintf(item_full_path, sizeof(item_full_path), "%s/%s", target_dir_path, name_list[i]->d_name);
             struct stat item_stat;
-            if (lstat(item_full_path, &item_stat) == 0) { // Use lstat for symlinks
+            if (fstatat(dir_fd, name_list[i]->d_name, &item_stat, AT_SYMLINK_NOFOLLOW) == 0) { // Don't follow symlinks
                 total_blocks += item_stat.st_blocks;
             }
         }
@@ -94,13 +93,11 @@ void peek_execute(const char* dir_arg, const char* home_dir, bool list_long, boo
             continue;
         }
 
-        char item_full_path[MAX_PATH_LEN * 2];
-        snprintf(item_full_path, sizeof(item_full_path), "%s/%s", target_dir_path, name_list[i]->d_name);
         struct stat item_stat;
 
-        if (lstat(item_full_path, &item_stat) == -1) {
-            fprintf(stderr, _RED_ "Shell Error: " _RESET_ "peek: lstat failed for '%s': %s\n",
-                    item_full_path, strerror(errno));
+        if (fstatat(dir_fd, name_list[i]->d_name, &item_stat, AT_SYMLINK_NOFOLLOW) == -1) {
+            fprintf(stderr, _RED_ "Shell Error: " _RESET_ "peek: lstat failed for '%s/%s': %s\n",
+                    target_dir_path, name_list[i]->d_name, strerror(errno));
             free(name_list[i]);
             continue;
         }
@@ -128,7 +125,7 @@ void peek_execute(const char* dir_arg, const char* home_dir, bool list_long, boo
             printf(_BLUE_ "%s\n" _RESET_, name_list[i]->d_name);
         } else if (S_ISLNK(item_stat.st_mode) && list_long) {
              char link_target[MAX_PATH_LEN];
-             ssize_t len = readlink(item_full_path, link_target, sizeof(link_target) - 1);
+             ssize_t len = readlinkat(dir_fd, name_list[i]->d_name, link_target, sizeof(link_target) - 1);
              if (len != -1) {
                  link_target[len] = '\0';
                  printf(_CYAN_ "%s" _RESET_ " -> %s\n", name_list[i]->d_name, link_target);
@@ -146,4 +143,6 @@ void peek_execute(const char* dir_arg, const char* home_dir, bool list_long, boo
         free(name_list[i]);
     }
     free(name_list);
+    close(dir_fd);
+    return 0;
 }
\ No newline at end of file
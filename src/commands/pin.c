@@ -0,0 +1,65 @@
+#include "commands/pin.h"
+#include "utils/error.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PIN_USAGE "Usage: pin [--reset] [-c <cpus>] [-n <nice>] [--io <class>] [--] [<command>...]"
+
+bool pin_parse(SimpleCommand* cmd, Placement* placement, bool* reset) {
+    memset(placement, 0, sizeof(*placement));
+    *reset = false;
+    int i = 1;
+    for (; i < cmd->argc && cmd->args[i][0] == '-'; i++) {
+        const char* option = cmd->args[i];
+        if (strcmp(option, "--") == 0) {
+            i++;
+            break;
+        }
+        if (strcmp(option, "--reset") == 0 || strcmp(option, "-r") == 0) {
+            *reset = true;
+            continue;
+        }
+        bool cpus = strcmp(option, "-c") == 0, nice = strcmp(option, "-n") == 0;
+        bool io = strcmp(option, "--io") == 0 || strcmp(option, "-i") == 0;
+        if (!(cpus || nice || io) || i + 1 == cmd->argc) {
+            print_shell_error(PIN_USAGE);
+            return false;
+        }
+        const char* value = cmd->args[++i];
+        if (cpus && !placement_parse_cpus(value, placement)) return false;
+        if (io && !placement_parse_io(value, placement)) return false;
+        if (nice) {
+            char* end;
+            long level = strtol(value, &end, 10);
+            if (end == value || *end != '\0' || level < -20 || level > 19) {
+                fprintf(stderr, _RED_ "Shell Error: " _RESET_ "pin: %s: invalid nice value (-20 to 19)\n", value);
+                return false;
+            }
+            placement->has_nice = true;
+            placement->nice = (int)level;
+        }
+    }
+    for (int k = 0; k < i; k++) free(cmd->args[k]);
+    memmove(cmd->args, cmd->args + i, (cmd->argc - i + 1) * sizeof(char*));
+    cmd->argc -= i;
+    return true;
+}
+
+int pin_set_defaults(ShellState* state, const Placement* placement, bool reset) {
+    if (reset) memset(&state->job_placement, 0, sizeof(state->job_placement));
+    placement_merge(&state->job_placement, placement);
+    StrBuf out;
+    strbuf_init(&out);
+    if (placement_is_set(&state->job_placement)) {
+        strbuf_append_str(&out, "pin: jobs start with ");
+        placement_format(&state->job_placement, &out);
+        strbuf_putc(&out, '\n');
+    } else {
+        strbuf_append_str(&out, "pin: no defaults\n");
+    }
+    fwrite(out.data, 1, out.len, stdout);
+    strbuf_free(&out);
+    return 0;
+}
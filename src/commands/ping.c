@@ -1,20 +1,253 @@
+#define _GNU_SOURCE // For sigabbrev_np
 #include "commands/ping.h"
+#include "core/procfs.h"
+#include "core/signals.h"
 #include "utils/error.h"
 
-#include <signal.h> // For kill()
+#include <ctype.h>
 #include <errno.h>
+#include <fnmatch.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
-// Your original 'ping' function, renamed and adapted for consistency.
-void ping_execute(pid_t pid, int signal_number) {
-    // Preserve the original signal number wrapping logic.
-    signal_number %= 32;
+/**
+ * @brief A process a target resolved to.
+ */
+typedef struct {
+    pid_t pid;
+    unsigned long long start_time; ///< From the snapshot, to tell a reused PID apart; 0 for a literal PID
+} PingVictim;
+
+/**
+ * @brief The processes resolved so far, each PID once. A hash of the PIDs keeps
+ *        adding one constant-time, for patterns or subtrees with many processes.
+ */
+typedef struct {
+    PingVictim* items;
+    int count;
+    int capacity;
+    int* slots;    ///< Open addressing: index into 'items' plus one, or 0 for a free slot
+    int num_slots; ///< Twice 'capacity' (a power of two), so it is never more than half full
+} VictimList;
+
+/**
+ * @brief The slot holding 'pid', or the free slot where it would go.
+ */
+static int find_slot(const VictimList* list, pid_t pid) {
+    int mask = list->num_slots - 1;
+    int i = (int)(((unsigned)pid * 2654435761u) & (unsigned)mask);
+    while (list->slots[i] && list->items[list->slots[i] - 1].pid != pid) i = (i + 1) & mask;
+    return i;
+}
+
+static bool grow_victims(VictimList* list) {
+    int capacity = list->capacity ? list->capacity * 2 : 16;
+    PingVictim* items = realloc(list->items, capacity * sizeof(PingVictim));
+    if (items) list->items = items;
+    int* slots = calloc(capacity * 2, sizeof(int));
+    if (!items || !slots) {
+        print_shell_perror("ping: realloc failed");
+        free(slots);
+        return false;
+    }
+    free(list->slots);
+    list->slots = slots;
+    list->num_slots = capacity * 2;
+    list->capacity = capacity;
+    for (int i = 0; i < list->count; i++) list->slots[find_slot(list, list->items[i].pid)] = i + 1;
+    return true;
+}
+
+/**
+ * @brief Adds a process unless its PID is already in the list.
+ * @return False if out of memory (reported).
+ */
+static bool add_victim(VictimList* list, pid_t pid, unsigned long long start_time) {
+    if (list->slots && list->slots[find_slot(list, pid)]) return true;
+    if (list->count == list->capacity && !grow_victims(list)) return false;
+    list->items[list->count++] = (PingVictim){ pid, start_time };
+    list->slots[find_slot(list, pid)] = list->count;
+    return true;
+}
+
+static void clear_victims(VictimList* list) {
+    list->count = 0;
+    if (list->slots) memset(list->slots, 0, list->num_slots * sizeof(int));
+}
+
+static void free_victims(VictimList* list) {
+    free(list->items);
+    free(list->slots);
+}
+
+static bool is_number(const char* s) {
+    if (!*s) return false;
+    for (; *s; s++) {
+        if (!isdigit((unsigned char)*s)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Reads a signal given as a number, which may be signed (wrapped into
+ *        0-31, as ping always did: -1 is 31), or a name with or without "SIG"
+ *        ("TERM", "sigkill").
+ * @return The signal, or -1 if 'arg' is neither.
+ */
+static int parse_signal(const char* arg) {
+    if (!is_number((arg[0] == '-' || arg[0] == '+') ? arg + 1 : arg)) return signals_from_name(arg);
+    int signal_number = atoi(arg) % 32;
+    return (signal_number < 0) ? signal_number + 32 : signal_number;
+}
+
+static void format_signal(int sig, char* out, size_t size) {
+    const char* name = sigabbrev_np(sig);
+    if (name) snprintf(out, size, "SIG%s", name);
+    else snprintf(out, size, "signal %d", sig);
+}
+
+/**
+ * @brief The job a '%' spec names: '%%', '%+' or '%' for the newest, '%-' for the
+ *        one before it, '%N' for the Nth in the table, '%name' by the start of its name.
+ */
+static Job* find_job(const char* spec, const JobTable* jobs) {
+    if (jobs->count == 0) return NULL;
+    if (*spec == '\0' || strcmp(spec, "%") == 0 || strcmp(spec, "+") == 0) return jobs->jobs[jobs->count - 1];
+    if (strcmp(spec, "-") == 0) return jobs->count > 1 ? jobs->jobs[jobs->count - 2] : NULL;
+    if (is_number(spec)) {
+        int n = atoi(spec);
+        return (n >= 1 && n <= jobs->count) ? jobs->jobs[n - 1] : NULL;
+    }
+    for (int i = jobs->count - 1; i >= 0; i--) {
+        if (strncmp(jobs->jobs[i]->name, spec, strlen(spec)) == 0) return jobs->jobs[i];
+    }
+    return NULL;
+}
+
+/**
+ * @brief Adds 'root' and every process below it in the snapshot.
+ */
+static bool add_subtree(const ProcTree* tree, int root, VictimList* out) {
+    const ProcInfo* proc = &tree->table->procs[root];
+    if (!add_victim(out, proc->pid, proc->start_time)) return false;
+    for (int c = tree->child_start[root]; c < tree->child_start[root + 1]; c++) {
+        if (!add_subtree(tree, tree->children[c], out)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Resolves one target against the snapshot.
+ * @return False after reporting an error; an empty 'out' means nothing matched.
+ */
+static bool resolve_target(const char* target, const ProcTree* tree, const ShellState* state, VictimList* out) {
+    const ProcTable* table = tree->table;
+    if (target[0] == '%') { // A job: its live members and everything else in its process group
+        const Job* job = find_job(target + 1, &state->jobs);
+        if (!job) {
+            fprintf(stderr, _RED_ "Shell Error: " _RESET_ "ping: %s: no such job\n", target);
+            return false;
+        }
+        for (int i = 0; i < job->num_members; i++) {
+            const ProcInfo* proc = proc_table_find(table, job->members[i].pid);
+            if (job->members[i].state != JOB_DONE && proc && !add_victim(out, proc->pid, proc->start_time)) return false;
+        }
+        for (int i = 0; job->own_group && i < table->count; i++) {
+            if (table->procs[i].pgid == job->pgid && !add_victim(out, table->procs[i].pid, table->procs[i].start_time)) return false;
+        }
+    } else if ((target[0] == '-' || target[0] == '+') && is_number(target + 1)) {
+        pid_t id = (pid_t)atoi(target + 1);
+        if (target[0] == '+') { // A process and all its descendants
+            const ProcInfo* root = proc_table_find(table, id);
+            return !root || add_subtree(tree, (int)(root - table->procs), out);
+        }
+        for (int i = 0; i < table->count; i++) { // A process group
+            if (table->procs[i].pgid == id && !add_victim(out, table->procs[i].pid, table->procs[i].start_time)) return false;
+        }
+    } else if (is_number(target)) {
+        return add_victim(out, (pid_t)atoi(target), 0);
+    } else { // A name pattern, never matching the shell itself
+        for (int i = 0; i < table->count; i++) {
+            const ProcInfo* proc = &table->procs[i];
+            if (proc->pid != getpid() && fnmatch(target, proc->comm, 0) == 0 && !add_victim(out, proc->pid, proc->start_time)) return false;
+        }
+    }
+    return true;
+}
+
+int ping_execute(int argc, char* argv[], ShellState* state) {
+    if (argc < 3) {
+        print_shell_error("Usage: ping <target>... <signal>");
+        return 1;
+    }
+    int signal_number = parse_signal(argv[argc - 1]);
     if (signal_number < 0) {
-        signal_number += 32;
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "ping: %s: invalid signal\n", argv[argc - 1]);
+        return 1;
+    }
+    char signal_name[32];
+    format_signal(signal_number, signal_name, sizeof(signal_name));
+
+    // Every target is resolved against the same single pass over /proc.
+    ProcTable table = {0};
+    ProcTree tree = { .table = &table };
+    for (int i = 1; i < argc - 1; i++) {
+        if (!is_number(argv[i]) && !table.procs && !proc_table_load(&table)) return 1;
+        if (argv[i][0] == '+' && !tree.parent && !proc_tree_build(&tree, &table)) {
+            proc_table_free(&table);
+            return 1;
+        }
     }
 
-    // Use kill() to send the signal.
-    // On failure, use the project's standard error reporting function.
-    if (kill(pid, signal_number) == -1) {
-        print_shell_perror("ping"); // Provides a more descriptive error, e.g., "ping: No such process"
+    int status = 0;
+    VictimList victims = {0}, signalled = {0};
+    for (int i = 1; i < argc - 1; i++) {
+        const char* target = argv[i];
+        clear_victims(&victims);
+        if (!resolve_target(target, &tree, state, &victims)) {
+            status = 1;
+            continue;
+        }
+        char sent[1024] = "";
+        size_t sent_len = 0;
+        int sent_count = 0, failed = 0, repeated = 0;
+        for (int j = 0; j < victims.count; j++) {
+            const PingVictim* victim = &victims.items[j];
+            int before = signalled.count;
+            if (!add_victim(&signalled, victim->pid, victim->start_time)) break;
+            if (signalled.count == before) { // Already signalled for an earlier target
+                repeated++;
+                continue;
+            }
+            int error = procfs_signal(victim->pid, victim->start_time, signal_number);
+            if (error == ESRCH) continue; // Exited since the snapshot
+            if (error) {
+                fprintf(stderr, _RED_ "Shell Error: " _RESET_ "ping: %s: %d: %s\n", target, victim->pid, strerror(error));
+                failed++;
+                continue;
+            }
+            sent_count++;
+            if (sent_len < sizeof(sent)) {
+                sent_len += snprintf(sent + sent_len, sizeof(sent) - sent_len, " %d", victim->pid);
+            }
+        }
+        if (failed > 0) status = 1;
+        if (sent_count == 0 && failed == 0 && repeated == 0) {
+            fprintf(stderr, _RED_ "Shell Error: " _RESET_ "ping: %s: no such process\n", target);
+            status = 1;
+        } else if (sent_count == 1 && is_number(target)) {
+            printf("%s: %s sent\n", target, signal_name);
+        } else if (sent_count > 0) {
+            printf("%s: %s sent to %d process%s:%s%s\n", target, signal_name, sent_count, sent_count == 1 ? "" : "es",
+                   sent, sent_len >= sizeof(sent) ? " ..." : "");
+        }
     }
-}
\ No newline at end of file
+    free_victims(&victims);
+    free_victims(&signalled);
+    proc_tree_free(&tree);
+    proc_table_free(&table);
+    return status;
+}
@@ -0,0 +1,279 @@
+#include "commands/print.h"
+#include "utils/error.h"
+#include "utils/strbuf.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PRINTF_SPEC_MAX 64 ///< Room for one rebuilt conversion, e.g. "%-+#0*.*jd" with the numbers filled in
+
+/**
+ * @brief Appends the character for the backslash escape whose letter is at 's'.
+ * @param format_octal printf's format takes \NNN; echo -e and %b take \0NNN.
+ * @return Characters used after the backslash, or -1 for \c (stop all output).
+ */
+static int append_escape(StrBuf* out, const char* s, bool format_octal) {
+    static const char letters[] = "abefnrtv\\";
+    static const char codes[] = "\a\b\033\f\n\r\t\v\\";
+    const char* letter = *s ? strchr(letters, *s) : NULL;
+    if (letter) {
+        strbuf_putc(out, codes[letter - letters]);
+        return 1;
+    }
+    if (*s == 'c') return -1;
+
+    int used = 0, base = 0, max_digits = 0;
+    if (*s == 'x') {
+        used = 1, base = 16, max_digits = 2;
+    } else if (*s == '0' && !format_octal) {
+        used = 1, base = 8, max_digits = 3;
+    } else if (*s >= '0' && *s <= '7' && format_octal) {
+        base = 8, max_digits = 3;
+    }
+    if (base) {
+        int value = 0, digits = 0;
+        for (; digits < max_digits; digits++) {
+            char c = s[used + digits];
+            int digit = (c >= '0' && c <= '9') ? c - '0'
+                      : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+                      : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : 99;
+            if (digit >= base) break;
+            value = value * base + digit;
+        }
+        if (digits > 0 || base == 8) {
+            strbuf_putc(out, (char)value);
+            return used + digits;
+        }
+    }
+    // Not an escape: keep the backslash.
+    strbuf_putc(out, '\\');
+    return 0;
+}
+
+/**
+ * @brief Appends 'text' with its backslash escapes interpreted.
+ * @return False if a \c ended the output.
+ */
+static bool append_escaped(StrBuf* out, const char* text, bool format_octal) {
+    for (const char* p = text; *p; p++) {
+        if (*p != '\\') {
+            strbuf_putc(out, *p);
+            continue;
+        }
+        int used = append_escape(out, p + 1, format_octal);
+        if (used < 0) return false;
+        p += used;
+    }
+    return true;
+}
+
+/**
+ * @brief Writes a builtin's output in one go and reports a failed write.
+ */
+static int write_output(const char* name, const StrBuf* out) {
+    if (out->len > 0) fwrite(out->data, 1, out->len, stdout);
+    if (fflush(stdout) == EOF) {
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "%s: write error: %s\n", name, strerror(errno));
+        clearerr(stdout);
+        return 1;
+    }
+    return 0;
+}
+
+int echo_execute(int argc, char* argv[], ShellState* state) {
+    (void)state;
+    bool newline = true, escapes = false;
+    int i = 1;
+    // Only arguments made entirely of option letters are options: 'echo -x' prints "-x".
+    for (; i < argc && argv[i][0] == '-' && argv[i][1] && strspn(argv[i] + 1, "neE") == strlen(argv[i] + 1); i++) {
+        for (const char* c = argv[i] + 1; *c; c++) {
+            if (*c == 'n') newline = false;
+            else escapes = (*c == 'e');
+        }
+    }
+
+    StrBuf out;
+    strbuf_init(&out);
+    bool stopped = false;
+    for (; i < argc && !stopped; i++) {
+        if (escapes) stopped = !append_escaped(&out, argv[i], false);
+        else strbuf_append_str(&out, argv[i]);
+        if (i < argc - 1 && !stopped) strbuf_putc(&out, ' ');
+    }
+    if (newline && !stopped) strbuf_putc(&out, '\n');
+    int status = write_output("echo", &out);
+    strbuf_free(&out);
+    return status;
+}
+
+/**
+ * @brief The arguments of one printf call, consumed as conversions need them.
+ */
+typedef struct {
+    char** args;
+    int count;
+    int next;
+    bool invalid; ///< An argument was not a valid number
+} PrintfArgs;
+
+static const char* next_arg(PrintfArgs* args) {
+    return args->next < args->count ? args->args[args->next++] : NULL;
+}
+
+/**
+ * @brief Reports a numeric argument that was not entirely a number.
+ */
+static void check_number(PrintfArgs* args, const char* text, const char* end) {
+    if (*end == '\0' && errno != ERANGE) return;
+    fprintf(stderr, _RED_ "Shell Error: " _RESET_ "printf: %s: invalid number\n", text);
+    args->invalid = true;
+}
+
+/**
+ * @brief Converts the next argument for an integer conversion. "'c" gives c's code.
+ */
+static intmax_t next_integer(PrintfArgs* args, bool is_unsigned) {
+    const char* text = next_arg(args);
+    if (!text || !*text) return 0;
+    if (text[0] == '\'' || text[0] == '"') return (unsigned char)text[1];
+    char* end;
+    errno = 0;
+    intmax_t value = (is_unsigned && text[0] != '-') ? (intmax_t)strtoumax(text, &end, 0) : strtoimax(text, &end, 0);
+    check_number(args, text, end);
+    return value;
+}
+
+static double next_double(PrintfArgs* args) {
+    const char* text = next_arg(args);
+    if (!text || !*text) return 0;
+    if (text[0] == '\'' || text[0] == '"') return (unsigned char)text[1];
+    char* end;
+    errno = 0;
+    double value = strtod(text, &end);
+    check_number(args, text, end);
+    return value;
+}
+
+/**
+ * @brief Formats one conversion, which starts at 'f' (the '%').
+ * @return Characters of the format used, 0 if a \c in a %b argument ended the
+ *         output, or -1 for an invalid conversion (already reported).
+ */
+static int format_conversion(StrBuf* out, const char* f, PrintfArgs* args) {
+    char spec[PRINTF_SPEC_MAX];
+    size_t len = 0;
+    const char* p = f + 1;
+    spec[len++] = '%';
+    while (*p && strchr("-+ #0", *p) && len < 8) spec[len++] = *p++;
+    // Width and precision: digits, or '*' for the next argument.
+    for (int field = 0; field < 2; field++) {
+        if (field == 1) {
+            if (*p != '.') break;
+            spec[len++] = *p++;
+        }
+        if (*p == '*') {
+            len += snprintf(spec + len, sizeof(spec) - len, "%d", (int)next_integer(args, false));
+            p++;
+        } else {
+            while (*p >= '0' && *p <= '9' && len < PRINTF_SPEC_MAX / 2) spec[len++] = *p++;
+        }
+    }
+    char conversion = *p;
+    int used = (int)(p - f) + (conversion ? 1 : 0);
+    spec[len] = '\0';
+
+    switch (conversion) {
+    case 'd':
+    case 'i':
+    case 'o':
+    case 'u':
+    case 'x':
+    case 'X': {
+        intmax_t value = next_integer(args, conversion != 'd' && conversion != 'i');
+        spec[len++] = 'j';
+        spec[len++] = conversion;
+        spec[len] = '\0';
+        strbuf_appendf(out, spec, value);
+        return used;
+    }
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+        spec[len++] = conversion;
+        spec[len] = '\0';
+        strbuf_appendf(out, spec, next_double(args));
+        return used;
+    case 'c': {
+        // The first character of the argument (nothing for an empty one).
+        const char* text = next_arg(args);
+        char first[2] = {text ? text[0] : '\0', '\0'};
+        char* dot = strchr(spec, '.');
+        if (dot) *dot = '\0';
+        strncat(spec, "s", sizeof(spec) - strlen(spec) - 1);
+        strbuf_appendf(out, spec, first);
+        return used;
+    }
+    case 's':
+    case 'b': {
+        const char* text = next_arg(args);
+        if (!text) text = "";
+        bool complete = true;
+        StrBuf expanded;
+        strbuf_init(&expanded);
+        if (conversion == 'b') {
+            complete = append_escaped(&expanded, text, false);
+            text = expanded.data ? expanded.data : "";
+        }
+        spec[len++] = 's';
+        spec[len] = '\0';
+        strbuf_appendf(out, spec, text);
+        strbuf_free(&expanded);
+        return complete ? used : 0;
+    }
+    default:
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "printf: %%%c: invalid directive\n", conversion ? conversion : ' ');
+        return -1;
+    }
+}
+
+int printf_execute(int argc, char* argv[], ShellState* state) {
+    (void)state;
+    int first = (argc > 1 && strcmp(argv[1], "--") == 0) ? 2 : 1;
+    if (argc <= first) {
+        print_shell_error("Usage: printf format [arguments]");
+        return 2;
+    }
+    const char* format = argv[first];
+    PrintfArgs args = {argv + first + 1, argc - first - 1, 0, false};
+
+    StrBuf out;
+    strbuf_init(&out);
+    bool stopped = false, failed = false;
+    // The format is reused while arguments remain, but always printed at least once.
+    do {
+        int start = args.next;
+        for (const char* f = format; *f && !stopped && !failed; f++) {
+            if (*f == '\\') {
+                int used = append_escape(&out, f + 1, true);
+                if (used < 0) stopped = true;
+                else f += used;
+            } else if (*f == '%' && f[1] == '%') {
+                strbuf_putc(&out, '%');
+                f++;
+            } else if (*f == '%') {
+                int used = format_conversion(&out, f, &args);
+                if (used < 0) failed = true;
+                else if (used == 0) stopped = true;
+                else f += used - 1;
+            } else {
+                strbuf_putc(&out, *f);
+            }
+        }
+        if (args.next == start) break; // The format takes no arguments
+    } while (args.next < args.count && !stopped && !failed);
+
+    int status = write_output("printf", &out);
+    strbuf_free(&out);
+    return (failed || args.invalid) ? 1 : status;
+}
@@ -1,81 +1,258 @@
+#define _GNU_SOURCE // For getdents64
 #include "commands/proclore.h"
+#include "core/placement.h"
+#include "core/procfs.h"
 #include "core/shell_state.h"
-#include "utils/error.h" 
+#include "core/watch.h"
+#include "utils/error.h"
+#include "utils/strbuf.h"
 
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include <sys/types.h>
-#include <errno.h>
 
-void proclore_execute(int pid, const char* home_dir) {
-    char proc_status_path[MAX_PATH_LEN];
-    snprintf(proc_status_path, sizeof(proc_status_path), "/proc/%d/status", pid);
+/**
+ * @brief The files of one process that proclore reads, kept open between samples.
+ */
+typedef struct {
+    ProcHandle handle;
+    int smaps_fd;                  ///< smaps_rollup, or -1 if it cannot be read
+    int fd_dir;                    ///< The fd directory, or -1 if it cannot be read
+    char exe[MAX_PATH_LEN];        ///< Executable path as displayed, or "" if unknown
+    char cmdline[1024];
+    ProcInfo stat;
+    long long sampled_ms;          ///< When 'stat' was read
+    double cpu_percent;            ///< Over the last interval; negative until there were two samples
+    long long pss_kb;              ///< -1 if unknown
+    int fd_count;                  ///< -1 if unknown
+    Placement placement;           ///< Effective CPU affinity, nice value and I/O class
+    bool has_placement;
+} ProcSampler;
+
+static long long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief The executable path, shortened with '~' inside 'home_dir'.
+ */
+static void read_exe(ProcSampler* s, const char* home_dir) {
+    char executable_path[MAX_PATH_LEN];
+    ssize_t len = readlinkat(s->handle.dir_fd, "exe", executable_path, sizeof(executable_path) - 1);
+    s->exe[0] = '\0';
+    // readlink can fail if process is a zombie or due to permissions
+    if (len < 0) return;
+    executable_path[len] = '\0';
+    size_t home_dir_len = strlen(home_dir);
+    if (strncmp(executable_path, home_dir, home_dir_len) == 0 &&
+        (executable_path[home_dir_len] == '/' || executable_path[home_dir_len] == '\0')) {
+        snprintf(s->exe, sizeof(s->exe), "~%s", executable_path + home_dir_len);
+    } else {
+        snprintf(s->exe, sizeof(s->exe), "%s", executable_path);
+    }
+}
 
-    FILE* f_status = fopen(proc_status_path, "r");
-    if (!f_status) {
-        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "proclore: Could not open %s: %s\n",
-                proc_status_path, strerror(errno));
-        return;
+static void read_cmdline(ProcSampler* s) {
+    int fd = openat(s->handle.dir_fd, "cmdline", O_RDONLY | O_CLOEXEC);
+    ssize_t len = (fd >= 0) ? procfs_pread_file(fd, s->cmdline, sizeof(s->cmdline)) : -1;
+    if (fd >= 0) close(fd);
+    if (len < 0) len = 0;
+    // Arguments are separated by NULs; a kernel thread has none.
+    while (len > 0 && s->cmdline[len - 1] == '\0') len--;
+    for (ssize_t i = 0; i < len; i++) {
+        if (s->cmdline[i] == '\0') s->cmdline[i] = ' ';
     }
+    s->cmdline[len] = '\0';
+}
 
-    printf(_BLUE_ "pid : " _RESET_ "%d\n", pid);
+static bool sampler_open(ProcSampler* s, pid_t pid, const char* home_dir, bool extended) {
+    memset(s, 0, sizeof(*s));
+    s->smaps_fd = s->fd_dir = -1;
+    s->cpu_percent = -1;
+    s->pss_kb = -1;
+    s->fd_count = -1;
+    if (!proc_handle_open(&s->handle, pid)) return false;
+    read_exe(s, home_dir);
+    if (extended) {
+        s->smaps_fd = openat(s->handle.dir_fd, "smaps_rollup", O_RDONLY | O_CLOEXEC);
+        s->fd_dir = openat(s->handle.dir_fd, "fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        read_cmdline(s);
+    }
+    return true;
+}
 
-    char line_buffer[256];
-    char process_state[32] = "N/A";
-    char vm_size[32] = "N/A";
-    pid_t process_group_id = -1;
+static void sampler_close(ProcSampler* s) {
+    if (s->smaps_fd >= 0) close(s->smaps_fd);
+    if (s->fd_dir >= 0) close(s->fd_dir);
+    proc_handle_close(&s->handle);
+}
 
-    while (fgets(line_buffer, sizeof(line_buffer), f_status)) {
-        if (strncmp(line_buffer, "State:", 6) == 0) {
-            sscanf(line_buffer, "State:\t%s", process_state);
-        } else if (strncmp(line_buffer, "VmSize:", 7) == 0) {
-            sscanf(line_buffer, "VmSize:\t%s kB", vm_size); // VmSize is usually in kB
-        } else if (strncmp(line_buffer, "PPid:", 5) == 0) { // Example: could also get PGid from /proc/[pid]/stat
-            // For process group, it's better to use getpgid()
+/**
+ * @brief Counts the entries of the open fd directory, rewinding it first.
+ */
+static int count_fds(int dir_fd) {
+    char buffer[8192];
+    int count = 0;
+    if (lseek(dir_fd, 0, SEEK_SET) < 0) return -1;
+    for (;;) {
+        ssize_t n = getdents64(dir_fd, buffer, sizeof(buffer));
+        if (n < 0) return -1;
+        if (n == 0) break;
+        for (ssize_t off = 0; off < n;) {
+            struct dirent64* entry = (struct dirent64*)(buffer + off);
+            if (entry->d_name[0] != '.') count++;
+            off += entry->d_reclen;
         }
     }
-    fclose(f_status);
+    return count;
+}
 
-    process_group_id = getpgid(pid);
-    if (process_group_id == -1) {
-        // Error getting pgid, but continue if other info was found
-        // print_shell_perror("proclore: getpgid failed");
+/**
+ * @brief Takes a new sample: one pread() of stat, and with the extended files
+ *        one of smaps_rollup and a rewind and read of the fd directory.
+ * @return False if the process has exited.
+ */
+static bool sampler_update(ProcSampler* s) {
+    ProcInfo previous = s->stat;
+    long long previous_ms = s->sampled_ms;
+    if (!proc_handle_read_stat(&s->handle, &s->stat)) return false;
+    s->sampled_ms = now_ms();
+    if (previous_ms > 0 && s->sampled_ms > previous_ms) {
+        unsigned long long ticks = (s->stat.utime + s->stat.stime) - (previous.utime + previous.stime);
+        double seconds = (double)(s->sampled_ms - previous_ms) / 1000.0;
+        s->cpu_percent = 100.0 * (double)ticks / ((double)sysconf(_SC_CLK_TCK) * seconds);
     }
+    if (s->smaps_fd >= 0) {
+        char buffer[2048];
+        if (procfs_pread_file(s->smaps_fd, buffer, sizeof(buffer)) > 0) {
+            const char* pss = strstr(buffer, "\nPss:");
+            if (pss) s->pss_kb = atoll(pss + 5);
+        }
+    }
+    if (s->fd_dir >= 0) s->fd_count = count_fds(s->fd_dir);
+    s->has_placement = placement_read(s->handle.pid, &s->placement);
+    return true;
+}
 
-    // Determine if foreground (+)
-    // A process is foreground if its process group ID is the same as the
-    // foreground process group ID of the controlling terminal.
-    pid_t terminal_pgid = tcgetpgrp(STDIN_FILENO); // Get foreground process group of terminal
-    
-    printf(_BLUE_ "Process State : " _RESET_ "%s%s\n", process_state,
-           (terminal_pgid != -1 && process_group_id == terminal_pgid) ? "+" : "");
-    printf(_BLUE_ "Process Group : " _RESET_ "%d\n", process_group_id);
-    printf(_BLUE_ "Virtual Memory : " _RESET_ "%s kB\n", vm_size);
+static void render(const ProcSampler* s, bool extended, StrBuf* out) {
+    // A process is in the foreground if its process group is the terminal's foreground group.
+    pid_t terminal_pgid = tcgetpgrp(STDIN_FILENO);
+    strbuf_appendf(out, _BLUE_ "pid : " _RESET_ "%d\n", s->handle.pid);
+    strbuf_appendf(out, _BLUE_ "Process State : " _RESET_ "%c%s\n", s->stat.state,
+                   (terminal_pgid != -1 && s->stat.pgid == terminal_pgid) ? "+" : "");
+    strbuf_appendf(out, _BLUE_ "Process Group : " _RESET_ "%d\n", s->stat.pgid);
+    strbuf_appendf(out, _BLUE_ "Virtual Memory : " _RESET_ "%llu kB\n", s->stat.vsize / 1024);
+    strbuf_appendf(out, _BLUE_ "Executable Path : " _RESET_ "%s\n",
+                   s->exe[0] ? s->exe : "[Permission Denied or Path Not Found]");
+    if (s->has_placement) {
+        strbuf_append_str(out, _BLUE_ "CPU Affinity : " _RESET_);
+        placement_format_cpus(&s->placement, out);
+        strbuf_putc(out, '\n');
+    }
+    if (!extended) return;
 
+    long long rss_kb = s->stat.rss * (sysconf(_SC_PAGESIZE) / 1024);
+    if (s->pss_kb >= 0) {
+        strbuf_appendf(out, _BLUE_ "Resident Memory : " _RESET_ "%lld kB (PSS %lld kB)\n", rss_kb, s->pss_kb);
+    } else {
+        strbuf_appendf(out, _BLUE_ "Resident Memory : " _RESET_ "%lld kB\n", rss_kb);
+    }
+    strbuf_appendf(out, _BLUE_ "Threads : " _RESET_ "%ld\n", s->stat.num_threads);
+    if (s->fd_count >= 0) strbuf_appendf(out, _BLUE_ "Open Files : " _RESET_ "%d\n", s->fd_count);
+    else strbuf_append_str(out, _BLUE_ "Open Files : " _RESET_ "[Permission Denied]\n");
+    if (s->cpu_percent >= 0) strbuf_appendf(out, _BLUE_ "CPU : " _RESET_ "%.1f%%\n", s->cpu_percent);
+    else strbuf_append_str(out, _BLUE_ "CPU : " _RESET_ "-\n");
+    if (s->has_placement && s->placement.has_nice) strbuf_appendf(out, _BLUE_ "Nice : " _RESET_ "%d\n", s->placement.nice);
+    if (s->has_placement && s->placement.has_io) {
+        strbuf_append_str(out, _BLUE_ "I/O Priority : " _RESET_);
+        placement_format_io(&s->placement, out);
+        strbuf_putc(out, '\n');
+    }
+    strbuf_appendf(out, _BLUE_ "Command Line : " _RESET_ "%s\n", s->cmdline[0] ? s->cmdline : "[none]");
+}
 
-    char proc_exe_path[MAX_PATH_LEN];
-    snprintf(proc_exe_path, sizeof(proc_exe_path), "/proc/%d/exe", pid);
-    char executable_path[MAX_PATH_LEN] = {0}; // Initialize to empty
-    ssize_t len = readlink(proc_exe_path, executable_path, sizeof(executable_path) - 1);
+static bool open_and_sample(ProcSampler* s, int pid, const char* home_dir, bool extended) {
+    errno = 0;
+    if (!sampler_open(s, pid, home_dir, extended) || !sampler_update(s)) {
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "proclore: Could not read /proc/%d/stat: %s\n",
+                pid, strerror(errno ? errno : ESRCH));
+        sampler_close(s);
+        return false;
+    }
+    return true;
+}
 
-    if (len != -1) {
-        executable_path[len] = '\0';
-        char display_exe_path[MAX_PATH_LEN];
-        size_t home_dir_len = strlen(home_dir);
+int proclore_execute(int pid, const char* home_dir, bool extended, double interval) {
+    ProcSampler sampler;
+    if (!open_and_sample(&sampler, pid, home_dir, extended)) return 1;
+    if (extended) {
+        // CPU usage needs a second sample; Ctrl+C cuts the interval short.
+        WatchScreen timer = {0};
+        watch_sleep(&timer, interval);
+        sampler_update(&sampler);
+    }
+    StrBuf out;
+    strbuf_init(&out);
+    render(&sampler, extended, &out);
+    fwrite(out.data, 1, out.len, stdout);
+    strbuf_free(&out);
+    sampler_close(&sampler);
+    return 0;
+}
 
-        if (strncmp(executable_path, home_dir, home_dir_len) == 0 &&
-            (executable_path[home_dir_len] == '/' || executable_path[home_dir_len] == '\0')) {
-            snprintf(display_exe_path, sizeof(display_exe_path), "~%s", executable_path + home_dir_len);
-        } else {
-            strncpy(display_exe_path, executable_path, sizeof(display_exe_path) - 1);
-            display_exe_path[sizeof(display_exe_path) -1] = '\0';
+int proclore_watch(int pid, const char* home_dir, double interval) {
+    ProcSampler sampler;
+    if (!open_and_sample(&sampler, pid, home_dir, true)) return 1;
+    WatchScreen screen;
+    watch_begin(&screen);
+    StrBuf frame;
+    strbuf_init(&frame);
+    int status = 0;
+    for (;;) {
+        strbuf_reset(&frame);
+        render(&sampler, true, &frame);
+        if (!watch_draw(&screen, frame.data, frame.len)) {
+            status = 1;
+            break;
         }
-        printf(_BLUE_ "Executable Path : " _RESET_ "%s\n", display_exe_path);
-    } else {
-        // readlink can fail if process is a zombie or due to permissions
-        // print_shell_perror("proclore: readlink for executable path failed");
-        printf(_BLUE_ "Executable Path : " _RESET_ "[Permission Denied or Path Not Found]\n");
+        if (!watch_sleep(&screen, interval)) break;
+        // An exited child of this shell stays a zombie until the shell reaps it.
+        if (!sampler_update(&sampler) || sampler.stat.state == 'Z') {
+            printf("proclore: process %d has exited\n", pid);
+            break;
+        }
+    }
+    strbuf_free(&frame);
+    watch_end(&screen);
+    sampler_close(&sampler);
+    return status;
+}
+
+int proclore_tree(int pid) {
+    ProcTable table = {0};
+    ProcTree tree = {0};
+    if (!proc_table_load(&table)) return 1;
+    int status = 1;
+    const ProcInfo* root = proc_table_find(&table, pid);
+    if (!root) {
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "proclore: %d: no such process\n", pid);
+    } else if (proc_tree_build(&tree, &table)) {
+        StrBuf out;
+        strbuf_init(&out);
+        proc_tree_format(&tree, (int)(root - table.procs), "", &out);
+        fwrite(out.data, 1, out.len, stdout);
+        strbuf_free(&out);
+        status = 0;
     }
-}
\ No newline at end of file
+    proc_tree_free(&tree);
+    proc_table_free(&table);
+    return status;
+}
@@ -1,5 +1,5 @@
 #include "commands/seek.h"
-#include "core/shell_state.h" // For constants like MAX_PATH_LEN and colors
+#include "core/cwd.h"         // For cwd_absolute
 #include "utils/error.h"      // For print_shell_error
 #include "commands/warp.h"    // For the warp() function
 
@@ -7,111 +7,89 @@
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <dirent.h>
 #include <sys/stat.h>
 #include <errno.h>
 
-// The rest of the file (static bool resolve_seek_search_path, seek_execute, etc.) remains the same...
-
-// Forward declaration for recursive helper
-static int seek_recursive(const char* target_name, const char* current_dir_path,
-                           const char* base_search_dir_path, const char* home_dir, char* prev_dir_shell,
-                           bool search_dirs_only, bool search_files_only, bool execute_on_match,
-                           int* match_count, bool* executed_action);
-
+/**
+ * @brief What one seek walk is looking for, and how far it has got.
+ */
+typedef struct {
+    const char* target_name;
+    const char* base_path;   ///< Absolute path of the search directory
+    ShellState* state;
+    bool search_dirs_only;
+    bool search_files_only;
+    bool execute_on_match;
+    int match_count;
+    bool executed_action;    ///< The -e action happens only once
+} SeekWalk;
 
 /**
  * @brief Helper function to prepare the target directory path for seek.
- * Expands '~'.
+ * Expands '~'; other paths are left relative, to be opened from the shell's directory.
  * @param input_dir_arg The directory argument from the user.
  * @param home_dir The user's home directory.
  * @param output_path_buffer Buffer to store the resolved path.
  * @param buffer_size Size of the output_path_buffer.
- * @return True if path resolution was successful, false otherwise.
  */
-static bool resolve_seek_search_path(const char* input_dir_arg, const char* home_dir,
+static void resolve_seek_search_path(const char* input_dir_arg, const char* home_dir,
                                      char* output_path_buffer, size_t buffer_size) {
     if (!input_dir_arg || strlen(input_dir_arg) == 0) { // Default to current directory
-        if (getcwd(output_path_buffer, buffer_size) == NULL) {
-            print_shell_perror("seek: getcwd for search path failed");
-            return false;
+        snprintf(output_path_buffer, buffer_size, ".");
+    } else if (input_dir_arg[0] == '~') {
+        if (input_dir_arg[1] == '/' || input_dir_arg[1] == '\0') {
+            snprintf(output_path_buffer, buffer_size, "%s%s", home_dir, input_dir_arg + 1);
+        } else {
+            snprintf(output_path_buffer, buffer_size, "%s/%s", home_dir, input_dir_arg + 1);
         }
-    } else {
-        if (input_dir_arg[0] == '~') {
-            if (strlen(input_dir_arg) == 1 || (input_dir_arg[1] == '/' || input_dir_arg[1] == '\0')) {
-                snprintf(output_path_buffer, buffer_size, "%s%s", home_dir, input_dir_arg + 1);
-            } else {
-                snprintf(output_path_buffer, buffer_size, "%s/%s", home_dir, input_dir_arg + 1);
-            }
-        } else { // Absolute or relative path
-            // If relative, we need to make it absolute for consistent base_search_dir_path
-            if (input_dir_arg[0] != '/') {
-                char temp_cwd[MAX_PATH_LEN];
-                if (getcwd(temp_cwd, sizeof(temp_cwd)) == NULL) {
-                    print_shell_perror("seek: getcwd for relative path resolution failed");
-                    return false;
-                }
-                snprintf(output_path_buffer, buffer_size, "%s/%s", temp_cwd, input_dir_arg);
-            } else {
-                strncpy(output_path_buffer, input_dir_arg, buffer_size - 1);
-                output_path_buffer[buffer_size - 1] = '\0';
-            }
-        }
-    }
-    // Normalize path (remove trailing slashes unless it's root)
-    size_t len = strlen(output_path_buffer);
-    while (len > 1 && output_path_buffer[len - 1] == '/') {
-        output_path_buffer[len - 1] = '\0';
-        len--;
+    } else { // Absolute or relative path
+        snprintf(output_path_buffer, buffer_size, "%s", input_dir_arg);
     }
-    return true;
 }
 
-
-void seek_execute(const char* target_name, const char* search_dir_arg,
-                  const char* home_dir, char* prev_dir_shell, // prev_dir_shell is mutable for warp
-                  bool search_dirs_only, bool search_files_only, bool execute_on_match) {
-
-    if (!target_name || strlen(target_name) == 0) {
-        print_shell_error("seek: Target name not specified.");
-        return;
-    }
-
-    char resolved_search_dir[MAX_PATH_LEN];
-    if (!resolve_seek_search_path(search_dir_arg, home_dir, resolved_search_dir, sizeof(resolved_search_dir))) {
-        return;
-    }
-    
-    // Check if resolved_search_dir is actually a directory
-    struct stat dir_stat;
-    if (stat(resolved_search_dir, &dir_stat) != 0 || !S_ISDIR(dir_stat.st_mode)) {
-        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "seek: Search path '%s' is not a valid directory.\n", resolved_search_dir);
+/**
+ * @brief Runs the -e action on a match: prints a file, or warps into a directory.
+ */
+static void execute_match(SeekWalk* walk, int dir_fd, const char* name, const char* relative_path, bool is_dir) {
+    char full_path[MAX_PATH_LEN * 2];
+    snprintf(full_path, sizeof(full_path), "%s/%s", walk->base_path, relative_path);
+    if (is_dir) {
+        warp(full_path, walk->state);
+        walk->executed_action = true;
         return;
     }
-
-
-    int match_count = 0;
-    bool executed_action = false; // To ensure -e action happens only once
-
-    seek_recursive(target_name, resolved_search_dir, resolved_search_dir, home_dir, prev_dir_shell,
-                   search_dirs_only, search_files_only, execute_on_match,
-                   &match_count, &executed_action);
-
-    if (match_count == 0) {
-        printf("No match found.\n");
+    int fd = openat(dir_fd, name, O_RDONLY | O_CLOEXEC);
+    FILE* f_content = (fd >= 0) ? fdopen(fd, "r") : NULL;
+    if (f_content) {
+        int c;
+        while ((c = fgetc(f_content)) != EOF) {
+            putchar(c);
+        }
+        fclose(f_content);
+    } else {
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "seek: Could not open file '%s' for reading: %s\n",
+                full_path, strerror(errno));
+        if (fd >= 0) close(fd);
     }
+    walk->executed_action = true;
 }
 
-static int seek_recursive(const char* target_name, const char* current_dir_path,
-                           const char* base_search_dir_path, const char* home_dir, char* prev_dir_shell,
-                           bool search_dirs_only, bool search_files_only, bool execute_on_match,
-                           int* match_count, bool* executed_action) {
-    DIR* dir_stream = opendir(current_dir_path);
+/**
+ * @brief Searches the directory open as 'dir_fd' (taken over and closed here),
+ *        which is 'relative_dir' below the search directory ("" for itself).
+ *
+ * Entries are opened relative to their directory's descriptor, so the kernel
+ * never walks the path from the root again, and types come from d_type,
+ * falling back to fstatat() only where the filesystem does not report them.
+ */
+static void seek_recursive(SeekWalk* walk, int dir_fd, const char* relative_dir) {
+    DIR* dir_stream = fdopendir(dir_fd);
     if (!dir_stream) {
-        // Suppress error for non-readable directories to mimic find behavior
-        // fprintf(stderr, _RED_ "Shell Error: " _RESET_ "seek: Cannot open directory '%s': %s\n",
-        //         current_dir_path, strerror(errno));
-        return 0; // Indicate 0 found in this path
+        // Suppress errors for unreadable directories to mimic find behavior
+        close(dir_fd);
+        return;
     }
 
     struct dirent* entry;
@@ -120,90 +98,86 @@ static int seek_recursive(const char* target_name, const char* current_dir_path,
             continue;
         }
 
-        char item_full_path[MAX_PATH_LEN * 2];
-        snprintf(item_full_path, sizeof(item_full_path), "%s/%s", current_dir_path, entry->d_name);
-
-        struct stat item_stat;
-        if (lstat(item_full_path, &item_stat) == -1) {
-            // fprintf(stderr, _RED_ "Shell Error: " _RESET_ "seek: lstat failed for '%s': %s\n",
-            //         item_full_path, strerror(errno));
-            continue; // Skip if cannot stat
+        bool is_dir = entry->d_type == DT_DIR;
+        bool is_file = entry->d_type == DT_REG;
+        if (entry->d_type == DT_UNKNOWN) {
+            struct stat item_stat;
+            if (fstatat(dir_fd, entry->d_name, &item_stat, AT_SYMLINK_NOFOLLOW) == -1) {
+                continue; // Skip if cannot stat
+            }
+            is_dir = S_ISDIR(item_stat.st_mode);
+            is_file = S_ISREG(item_stat.st_mode);
         }
 
-        bool is_dir = S_ISDIR(item_stat.st_mode);
-        bool is_file = S_ISREG(item_stat.st_mode);
-        bool name_matches = (strcmp(entry->d_name, target_name) == 0);
-        // For case where target_name might have extension, e.g. "file.txt"
-        // And entry->d_name is "file.txt"
-        // The original code used strncmp(entry->d_name, target, strlen(target))
-        // This means "file" would match "file.txt". Let's stick to exact match for simplicity.
-        // If prefix match is desired: name_matches = (strncmp(entry->d_name, target_name, strlen(target_name)) == 0);
-
-        // Construct relative path for display
-        char relative_display_path[MAX_PATH_LEN * 2] = "./"; // Default prefix
-        if (strcmp(current_dir_path, base_search_dir_path) == 0) { // Item is in the top search dir
-             strncat(relative_display_path, entry->d_name, sizeof(relative_display_path) - strlen(relative_display_path) -1);
-        } else { // Item is in a subdirectory
-            // current_dir_path = /base/sub1/sub2, base_search_dir_path = /base
-            // relative part is sub1/sub2/entry_name
-            const char* relative_part_of_current = current_dir_path + strlen(base_search_dir_path) +1; // +1 for slash
-            if (strlen(base_search_dir_path) == 1 && base_search_dir_path[0] == '/') { // base is root
-                 relative_part_of_current = current_dir_path +1;
-            } else if (strlen(current_dir_path) <= strlen(base_search_dir_path)) { // Should not happen if logic is correct
-                 relative_part_of_current = ""; // Safety
-            }
-            snprintf(relative_display_path, sizeof(relative_display_path), "./%s/%s",
-                     relative_part_of_current, entry->d_name);
+        // Path below the search directory, displayed with a "./" prefix
+        char relative_path[MAX_PATH_LEN * 2];
+        if (relative_dir[0] == '\0') {
+            snprintf(relative_path, sizeof(relative_path), "%s", entry->d_name);
+        } else {
+            snprintf(relative_path, sizeof(relative_path), "%s/%s", relative_dir, entry->d_name);
         }
 
+        if (strcmp(entry->d_name, walk->target_name) == 0) {
+            if ((is_dir && !walk->search_files_only) || (is_file && !walk->search_dirs_only) ||
+                (!walk->search_dirs_only && !walk->search_files_only)) {
+                walk->match_count++;
+                if (is_dir) printf(_BLUE_ "./%s\n" _RESET_, relative_path);
+                else if (is_file) printf(_GREEN_ "./%s\n" _RESET_, relative_path);
+                else printf("./%s\n", relative_path); // Other types
 
-        if (name_matches) {
-            if ((is_dir && !search_files_only) || (is_file && !search_dirs_only) || (!search_dirs_only && !search_files_only)) {
-                (*match_count)++;
-                if (is_dir) printf(_BLUE_ "%s\n" _RESET_, relative_display_path);
-                else if (is_file) printf(_GREEN_ "%s\n" _RESET_, relative_display_path);
-                else printf("%s\n", relative_display_path); // Other types
-
-                if (execute_on_match && !(*executed_action)) {
-                    if (is_dir && (search_dirs_only || !search_files_only)) {
-                        char* old_prev = warp(item_full_path, home_dir, prev_dir_shell);
-                        if (old_prev && strlen(old_prev) > 0) {
-                            strncpy(prev_dir_shell, old_prev, MAX_PATH_LEN -1);
-                            prev_dir_shell[MAX_PATH_LEN-1] = '\0';
-                        }
-                        free(old_prev);
-                        *executed_action = true;
-                    } else if (is_file && (search_files_only || !search_dirs_only)) {
-                        FILE* f_content = fopen(item_full_path, "r");
-                        if (f_content) {
-                            int c;
-                            while ((c = fgetc(f_content)) != EOF) {
-                                putchar(c);
-                            }
-                            fclose(f_content);
-                            // Add a newline if content didn't end with one, for cleaner output
-                            // if (last_char_printed != '\n') putchar('\n');
-                        } else {
-                            fprintf(stderr, _RED_ "Shell Error: " _RESET_ "seek: Could not open file '%s' for reading: %s\n",
-                                    item_full_path, strerror(errno));
-                        }
-                        *executed_action = true;
-                    }
+                if (walk->execute_on_match && !walk->executed_action && (is_dir || is_file)) {
+                    execute_match(walk, dir_fd, entry->d_name, relative_path, is_dir);
                 }
             }
         }
 
         // Recurse if it's a directory
         if (is_dir) {
-            seek_recursive(target_name, item_full_path, base_search_dir_path, home_dir, prev_dir_shell,
-                           search_dirs_only, search_files_only, execute_on_match,
-                           match_count, executed_action);
-            if (execute_on_match && *executed_action) { // If action taken in recursion, stop further search
-                closedir(dir_stream);
-                return *match_count;
+            int child_fd = openat(dir_fd, entry->d_name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            if (child_fd >= 0) seek_recursive(walk, child_fd, relative_path);
+            if (walk->execute_on_match && walk->executed_action) { // If action taken in recursion, stop further search
+                break;
             }
         }
     }
     closedir(dir_stream);
-    return *match_count;
-}
\ No newline at end of file
+}
+
+int seek_execute(const char* target_name, const char* search_dir_arg, ShellState* state,
+                  bool search_dirs_only, bool search_files_only, bool execute_on_match) {
+
+    if (!target_name || strlen(target_name) == 0) {
+        print_shell_error("seek: Target name not specified.");
+        return 1;
+    }
+
+    char search_path[MAX_PATH_LEN], resolved_search_dir[MAX_PATH_LEN];
+    resolve_seek_search_path(search_dir_arg, state->home_dir, search_path, sizeof(search_path));
+    if (!cwd_absolute(state, search_path, resolved_search_dir, sizeof(resolved_search_dir))) {
+        print_shell_error("seek: Search path is too long.");
+        return 1;
+    }
+
+    // Opening it also checks that it is actually a directory
+    int dir_fd = openat(state->cwd_fd >= 0 ? state->cwd_fd : AT_FDCWD, search_path,
+                        O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) {
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "seek: Search path '%s' is not a valid directory.\n", resolved_search_dir);
+        return 1;
+    }
+
+    SeekWalk walk = {
+        .target_name = target_name,
+        .base_path = strcmp(resolved_search_dir, "/") == 0 ? "" : resolved_search_dir,
+        .state = state,
+        .search_dirs_only = search_dirs_only,
+        .search_files_only = search_files_only,
+        .execute_on_match = execute_on_match,
+    };
+    seek_recursive(&walk, dir_fd, "");
+
+    if (walk.match_count == 0) {
+        printf("No match found.\n");
+    }
+    return walk.match_count == 0 ? 1 : 0;
+}
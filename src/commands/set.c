@@ -0,0 +1,43 @@
+#include "commands/set.h"
+#include "utils/error.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    const char* name;
+    size_t offset; ///< Offset of the bool inside ShellOptions
+} OptionEntry;
+
+static const OptionEntry option_table[] = {
+    {"pipefail", offsetof(ShellOptions, pipefail)},
+    {"noclobber", offsetof(ShellOptions, noclobber)},
+    {"jobcapture", offsetof(ShellOptions, jobcapture)},
+    {NULL, 0}
+};
+
+static bool* option_flag(ShellState* state, const OptionEntry* entry) {
+    return (bool*)((char*)&state->options + entry->offset);
+}
+
+int set_execute(int argc, char* argv[], ShellState* state) {
+    if (argc == 1 || (argc == 2 && strcmp(argv[1], "-o") == 0)) {
+        for (const OptionEntry* entry = option_table; entry->name; entry++) {
+            printf("%-15s %s\n", entry->name, *option_flag(state, entry) ? "on" : "off");
+        }
+        return 0;
+    }
+    if (argc != 3 || (strcmp(argv[1], "-o") != 0 && strcmp(argv[1], "+o") != 0)) {
+        print_shell_error("Usage: set [-o | +o] <option>");
+        return 1;
+    }
+    for (const OptionEntry* entry = option_table; entry->name; entry++) {
+        if (strcmp(entry->name, argv[2]) == 0) {
+            *option_flag(state, entry) = (argv[1][0] == '-');
+            return 0;
+        }
+    }
+    fprintf(stderr, _RED_ "Shell Error: " _RESET_ "set: %s: invalid option name\n", argv[2]);
+    return 1;
+}
@@ -0,0 +1,32 @@
+#include "commands/shellstat.h"
+#include "utils/trace.h"
+#include "utils/error.h"
+
+#include <stdio.h>
+#include <string.h>
+
+int shellstat_execute(int argc, char* argv[]) {
+    if (argc == 1) {
+        trace_print_histograms(stdout);
+    } else if (argc == 2 && strcmp(argv[1], "on") == 0) {
+        trace_set_enabled(true);
+        printf("Shell: Tracing enabled.\n");
+    } else if (argc == 2 && strcmp(argv[1], "off") == 0) {
+        trace_set_enabled(false);
+        printf("Shell: Tracing disabled.\n");
+    } else if (argc == 2 && strcmp(argv[1], "reset") == 0) {
+        trace_reset();
+        printf("Shell: Trace data cleared.\n");
+    } else if (argc == 3 && strcmp(argv[1], "export") == 0) {
+        if (trace_export_chrome_json(argv[2]) == -1) {
+            print_shell_perror(argv[2]);
+            return 1;
+        } else {
+            printf("Shell: Trace written to %s\n", argv[2]);
+        }
+    } else {
+        print_shell_error("Usage: shellstat [on | off | reset | export <file>]");
+        return 1;
+    }
+    return 0;
+}
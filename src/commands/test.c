@@ -0,0 +1,232 @@
+#define _GNU_SOURCE
+#include "commands/test.h"
+#include "utils/error.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief The operands of one test, read left to right by the expression parser.
+ */
+typedef struct {
+    char** args;
+    int count;
+    int pos;
+    bool error; ///< A syntax error was found (already reported)
+} TestParser;
+
+static void test_error(TestParser* t, const char* what, const char* arg) {
+    if (t->error) return;
+    if (arg) fprintf(stderr, _RED_ "Shell Error: " _RESET_ "test: %s: %s\n", arg, what);
+    else fprintf(stderr, _RED_ "Shell Error: " _RESET_ "test: %s\n", what);
+    t->error = true;
+}
+
+static bool is_unary_op(const char* s) {
+    return s[0] == '-' && s[1] && !s[2] && strchr("nzefdbcpSLhsrwxugkOGt", s[1]);
+}
+
+static bool is_binary_op(const char* s) {
+    static const char* const ops[] = {"=", "==", "!=", "<", ">", "-eq", "-ne", "-lt", "-le", "-gt",
+                                      "-ge", "-nt", "-ot", "-ef", NULL};
+    for (int i = 0; ops[i]; i++) {
+        if (strcmp(s, ops[i]) == 0) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Parses an integer operand, allowing surrounding blanks as other shells do.
+ */
+static long long test_integer(TestParser* t, const char* text) {
+    char* end;
+    errno = 0;
+    long long value = strtoll(text, &end, 10);
+    while (isspace((unsigned char)*end)) end++;
+    if (end == text || *end || errno == ERANGE) test_error(t, "integer expression expected", text);
+    return value;
+}
+
+static bool unary_test(TestParser* t, char op, const char* arg) {
+    if (op == 'n') return arg[0] != '\0';
+    if (op == 'z') return arg[0] == '\0';
+    if (op == 't') return isatty((int)test_integer(t, arg));
+
+    struct stat st;
+    if ((op == 'L' || op == 'h') ? lstat(arg, &st) != 0 : stat(arg, &st) != 0) return false;
+    switch (op) {
+    case 'e': return true;
+    case 'f': return S_ISREG(st.st_mode);
+    case 'd': return S_ISDIR(st.st_mode);
+    case 'b': return S_ISBLK(st.st_mode);
+    case 'c': return S_ISCHR(st.st_mode);
+    case 'p': return S_ISFIFO(st.st_mode);
+    case 'S': return S_ISSOCK(st.st_mode);
+    case 'L':
+    case 'h': return S_ISLNK(st.st_mode);
+    case 's': return st.st_size > 0;
+    case 'r': return eaccess(arg, R_OK) == 0;
+    case 'w': return eaccess(arg, W_OK) == 0;
+    case 'x': return eaccess(arg, X_OK) == 0;
+    case 'u': return (st.st_mode & S_ISUID) != 0;
+    case 'g': return (st.st_mode & S_ISGID) != 0;
+    case 'k': return (st.st_mode & S_ISVTX) != 0;
+    case 'O': return st.st_uid == geteuid();
+    case 'G': return st.st_gid == getegid();
+    }
+    return false;
+}
+
+/**
+ * @brief Compares two modification times: <0, 0 or >0.
+ */
+static int compare_mtime(const struct stat* a, const struct stat* b) {
+    if (a->st_mtim.tv_sec != b->st_mtim.tv_sec) return a->st_mtim.tv_sec < b->st_mtim.tv_sec ? -1 : 1;
+    if (a->st_mtim.tv_nsec != b->st_mtim.tv_nsec) return a->st_mtim.tv_nsec < b->st_mtim.tv_nsec ? -1 : 1;
+    return 0;
+}
+
+static bool binary_test(TestParser* t, const char* left, const char* op, const char* right) {
+    if (strcmp(op, "=") == 0 || strcmp(op, "==") == 0) return strcmp(left, right) == 0;
+    if (strcmp(op, "!=") == 0) return strcmp(left, right) != 0;
+    if (strcmp(op, "<") == 0) return strcoll(left, right) < 0;
+    if (strcmp(op, ">") == 0) return strcoll(left, right) > 0;
+
+    if (strcmp(op, "-nt") == 0 || strcmp(op, "-ot") == 0 || strcmp(op, "-ef") == 0) {
+        struct stat a, b;
+        bool has_a = stat(left, &a) == 0, has_b = stat(right, &b) == 0;
+        // A file that exists is newer than one that does not.
+        if (op[1] == 'n') return has_a && (!has_b || compare_mtime(&a, &b) > 0);
+        if (op[1] == 'o') return has_b && (!has_a || compare_mtime(&a, &b) < 0);
+        return has_a && has_b && a.st_dev == b.st_dev && a.st_ino == b.st_ino;
+    }
+
+    long long a = test_integer(t, left), b = test_integer(t, right);
+    if (strcmp(op, "-eq") == 0) return a == b;
+    if (strcmp(op, "-ne") == 0) return a != b;
+    if (strcmp(op, "-lt") == 0) return a < b;
+    if (strcmp(op, "-le") == 0) return a <= b;
+    if (strcmp(op, "-gt") == 0) return a > b;
+    return a >= b; // -ge
+}
+
+static const char* peek_arg(const TestParser* t, int offset) {
+    return (t->pos + offset < t->count) ? t->args[t->pos + offset] : NULL;
+}
+
+static bool parse_or(TestParser* t);
+
+/**
+ * @brief primary := '(' expr ')' | unary-op arg | arg binary-op arg | arg
+ */
+static bool parse_primary(TestParser* t) {
+    const char* arg = peek_arg(t, 0);
+    if (!arg) {
+        test_error(t, "argument expected", NULL);
+        return false;
+    }
+    const char* next = peek_arg(t, 1);
+    if (next && is_binary_op(next) && peek_arg(t, 2)) {
+        t->pos += 3;
+        return binary_test(t, arg, next, t->args[t->pos - 1]);
+    }
+    if (strcmp(arg, "(") == 0) {
+        t->pos++;
+        bool value = parse_or(t);
+        if (!peek_arg(t, 0) || strcmp(peek_arg(t, 0), ")") != 0) test_error(t, "')' expected", NULL);
+        t->pos++;
+        return value;
+    }
+    if (is_unary_op(arg) && next) {
+        t->pos += 2;
+        return unary_test(t, arg[1], next);
+    }
+    t->pos++;
+    return arg[0] != '\0';
+}
+
+static bool parse_not(TestParser* t) {
+    const char* arg = peek_arg(t, 0);
+    if (arg && strcmp(arg, "!") == 0) {
+        t->pos++;
+        return !parse_not(t);
+    }
+    return parse_primary(t);
+}
+
+static bool parse_and(TestParser* t) {
+    bool value = parse_not(t);
+    while (!t->error && peek_arg(t, 0) && strcmp(peek_arg(t, 0), "-a") == 0) {
+        t->pos++;
+        bool right = parse_not(t); // Both sides are parsed, so errors are still found
+        value = value && right;
+    }
+    return value;
+}
+
+static bool parse_or(TestParser* t) {
+    bool value = parse_and(t);
+    while (!t->error && peek_arg(t, 0) && strcmp(peek_arg(t, 0), "-o") == 0) {
+        t->pos++;
+        bool right = parse_and(t);
+        value = value || right;
+    }
+    return value;
+}
+
+/**
+ * @brief Evaluates 'count' arguments by the POSIX rules, which read one to four
+ *        arguments by their number alone; longer expressions are parsed.
+ */
+static bool evaluate(TestParser* t, char** args, int count) {
+    const char* first = count > 0 ? args[0] : NULL;
+    switch (count) {
+    case 0:
+        return false;
+    case 1:
+        return first[0] != '\0';
+    case 2:
+        if (strcmp(first, "!") == 0) return args[1][0] == '\0';
+        if (is_unary_op(first)) return unary_test(t, first[1], args[1]);
+        test_error(t, "unary operator expected", first);
+        return false;
+    case 3:
+        if (is_binary_op(args[1])) return binary_test(t, first, args[1], args[2]);
+        if (strcmp(args[1], "-a") == 0) return first[0] && args[2][0];
+        if (strcmp(args[1], "-o") == 0) return first[0] || args[2][0];
+        if (strcmp(first, "!") == 0) return !evaluate(t, args + 1, 2);
+        if (strcmp(first, "(") == 0 && strcmp(args[2], ")") == 0) return args[1][0] != '\0';
+        test_error(t, "binary operator expected", args[1]);
+        return false;
+    case 4:
+        if (strcmp(first, "!") == 0) return !evaluate(t, args + 1, 3);
+        if (strcmp(first, "(") == 0 && strcmp(args[3], ")") == 0) return evaluate(t, args + 1, 2);
+        break;
+    }
+    t->args = args;
+    t->count = count;
+    t->pos = 0;
+    bool value = parse_or(t);
+    if (!t->error && t->pos < t->count) test_error(t, "too many arguments", t->args[t->pos]);
+    return value;
+}
+
+int test_execute(int argc, char* argv[], ShellState* state) {
+    (void)state;
+    if (strcmp(argv[0], "[") == 0) {
+        if (strcmp(argv[argc - 1], "]") != 0) {
+            print_shell_error("[: missing ']'");
+            return 2;
+        }
+        argc--;
+    }
+    TestParser t = {NULL, 0, 0, false};
+    bool value = evaluate(&t, argv + 1, argc - 1);
+    if (t.error) return 2;
+    return value ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+#include "commands/timeout.h"
+#include "core/signals.h"
+#include "utils/error.h"
+
+#include <ctype.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TIMEOUT_USAGE "Usage: timeout [-s <signal>] [-k <duration>] [--] <duration> <command>..."
+
+/**
+ * @brief Reads a duration such as "10", "0.5s", "2m" or "1h".
+ * @return The seconds, or -1 if it is not one.
+ */
+static double parse_duration(const char* text) {
+    char* end;
+    double value = strtod(text, &end);
+    if (end == text || value < 0 || (!isdigit((unsigned char)text[0]) && text[0] != '.')) return -1;
+    if (*end == 'm') value *= 60;
+    else if (*end == 'h') value *= 60 * 60;
+    else if (*end == 'd') value *= 24 * 60 * 60;
+    else if (*end && *end != 's') return -1;
+    return (*end && end[1]) || value > 1e9 ? -1 : value;
+}
+
+/**
+ * @brief Reads a signal given as a number or a name ("TERM", "SIGKILL").
+ * @return The signal, or -1 if it is neither.
+ */
+static int parse_signal(const char* text) {
+    char* end;
+    long number = strtol(text, &end, 10);
+    if (end != text && *end == '\0') return (number > 0 && number < NSIG) ? (int)number : -1;
+    return signals_from_name(text);
+}
+
+bool timeout_parse(SimpleCommand* cmd, TimeoutSpec* spec) {
+    memset(spec, 0, sizeof(*spec));
+    spec->signal = SIGTERM;
+    int i = 1;
+    for (; i < cmd->argc && cmd->args[i][0] == '-'; i++) {
+        const char* option = cmd->args[i];
+        if (strcmp(option, "--") == 0) {
+            i++;
+            break;
+        }
+        bool known = strcmp(option, "-s") == 0 || strcmp(option, "-k") == 0;
+        if (!known || i + 1 == cmd->argc) {
+            print_shell_error(TIMEOUT_USAGE);
+            return false;
+        }
+        const char* value = cmd->args[++i];
+        bool ok;
+        if (option[1] == 's') ok = (spec->signal = parse_signal(value)) > 0;
+        else ok = (spec->kill_after = parse_duration(value)) >= 0;
+        if (!ok) {
+            fprintf(stderr, _RED_ "Shell Error: " _RESET_ "timeout: %s: invalid %s\n", value,
+                    option[1] == 's' ? "signal" : "duration");
+            return false;
+        }
+    }
+    if (cmd->argc - i < 2) {
+        print_shell_error(TIMEOUT_USAGE);
+        return false;
+    }
+    if ((spec->seconds = parse_duration(cmd->args[i])) < 0) {
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "timeout: %s: invalid duration\n", cmd->args[i]);
+        return false;
+    }
+    i++;
+    for (int k = 0; k < i; k++) free(cmd->args[k]);
+    memmove(cmd->args, cmd->args + i, (cmd->argc - i + 1) * sizeof(char*));
+    cmd->argc -= i;
+    return true;
+}
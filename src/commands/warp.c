@@ -1,5 +1,6 @@
 #include "commands/warp.h"
-#include "core/shell_state.h" // For constants and colors
+#include "core/cwd.h"
+#include "core/dirdb.h"
 #include "utils/error.h"      // For print_shell_error and print_shell_perror
 
 #include <stdio.h>
@@ -7,71 +8,80 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <errno.h>
+#include <sys/stat.h>
 
 /**
  * @brief Changes the current working directory.
  *
- * Supports ".", "..", "-", "~", "~/path", and absolute/relative paths.
+ * Supports ".", "..", "-", "~", "~/path", and absolute/relative paths. The new
+ * directory is recorded in the frecency database used by 'warp -z'.
  *
  * @param dir_arg The target directory argument string. Can be NULL or empty for warp to home.
- * @param home_dir The user's home directory path.
- * @param prev_dir_global A string containing the path of the OLDPWD.
- * @return A dynamically allocated string containing the path of the directory *before*
- *         a successful warp. The caller must free this string. Returns an empty,
- *         dynamically allocated string on failure (e.g. chdir fails, OLDPWD not set for "warp -").
- *         The returned string will also be empty if strdup fails.
+ * @param announce Print the new directory, as 'warp' does.
+ * @param state The shell state, whose logical directory and OLDPWD are updated.
+ * @return True on success, false on failure (e.g. the directory cannot be entered,
+ *         OLDPWD not set for "warp -").
  */
-char* warp(const char* dir_arg, const char* home_dir, const char* prev_dir_global) {
-    char current_cwd_before_warp[MAX_PATH_LEN];
-    if (getcwd(current_cwd_before_warp, sizeof(current_cwd_before_warp)) == NULL) {
-        print_shell_perror("warp: getcwd (before warp) failed");
-        char* empty_ret = strdup("");
-        if (!empty_ret) print_shell_perror("warp: strdup failed for empty return");
-        return empty_ret ? empty_ret : ""; // Should ideally not return literal ""
-    }
-
+static bool change_directory(const char* dir_arg, bool announce, ShellState* state) {
     char target_dir_processed[MAX_PATH_LEN];
 
     if (!dir_arg || strlen(dir_arg) == 0 || strcmp(dir_arg, "~") == 0) { // warp, warp ~, warp ""
-        strncpy(target_dir_processed, home_dir, sizeof(target_dir_processed) - 1);
+        strncpy(target_dir_processed, state->home_dir, sizeof(target_dir_processed) - 1);
     } else if (strcmp(dir_arg, "-") == 0) {
-        if (strlen(prev_dir_global) == 0) {
+        if (strlen(state->prev_dir) == 0) {
             print_shell_error("warp: OLDPWD not set");
-            char* empty_ret = strdup("");
-            if (!empty_ret) print_shell_perror("warp: strdup failed for OLDPWD error");
-            return empty_ret ? empty_ret : "";
+            return false;
         }
-        strncpy(target_dir_processed, prev_dir_global, sizeof(target_dir_processed) - 1);
+        strncpy(target_dir_processed, state->prev_dir, sizeof(target_dir_processed) - 1);
     } else if (dir_arg[0] == '~' && (dir_arg[1] == '/' || dir_arg[1] == '\0')) { // ~/path or ~
-        snprintf(target_dir_processed, sizeof(target_dir_processed), "%s%s", home_dir, dir_arg + 1);
+        snprintf(target_dir_processed, sizeof(target_dir_processed), "%s%s", state->home_dir, dir_arg + 1);
     } else { // Relative or absolute path
         strncpy(target_dir_processed, dir_arg, sizeof(target_dir_processed) - 1);
     }
     target_dir_processed[sizeof(target_dir_processed) - 1] = '\0';
 
-
-    if (chdir(target_dir_processed) < 0) {
+    if (!cwd_change(state, target_dir_processed)) {
         fprintf(stderr, _RED_ "Shell Error: " _RESET_ "warp: Failed to change directory to '%s': %s\n",
                 target_dir_processed, strerror(errno));
-        char* empty_ret = strdup("");
-        if (!empty_ret) print_shell_perror("warp: strdup failed for chdir error");
-        return empty_ret ? empty_ret : "";
+        return false;
     }
 
     // Print the new current directory (as per original functionality)
-    char new_cwd_after_warp[MAX_PATH_LEN];
-    if (getcwd(new_cwd_after_warp, sizeof(new_cwd_after_warp)) != NULL) {
-        printf("%s\n", new_cwd_after_warp);
-    } else {
-        print_shell_perror("warp: getcwd (after warp) failed, though chdir succeeded");
+    if (announce) printf("%s\n", state->cwd);
+    dirdb_visit(state->cwd);
+    return true;
+}
+
+bool warp(const char* dir_arg, ShellState* state) {
+    return change_directory(dir_arg, true, state);
+}
+
+bool warp_quiet(const char* dir_arg, ShellState* state) {
+    return change_directory(dir_arg, false, state);
+}
+
+bool warp_frecent(char* const fragments[], int num_fragments, ShellState* state) {
+    char target[MAX_PATH_LEN], stale[MAX_PATH_LEN] = "";
+    while (dirdb_best(fragments, num_fragments, state->cwd, target, sizeof(target))) {
+        struct stat st;
+        if (stat(target, &st) == 0 && S_ISDIR(st.st_mode)) {
+            return warp(target, state);
+        }
+        if (strcmp(target, stale) == 0) break; // Could not be removed
+        dirdb_remove(target); // Removed or renamed since it was visited
+        strcpy(stale, target);
     }
+    print_shell_error("warp: -z: no visited directory matches");
+    return false;
+}
 
-    char* old_cwd_to_return = strdup(current_cwd_before_warp);
-    if (!old_cwd_to_return) {
-        print_shell_perror("warp: strdup failed for old_cwd_to_return");
-        // Fallback to returning an empty string if strdup fails catastrophically
-        char* empty_ret = strdup("");
-        return empty_ret ? empty_ret : "";
+int warp_list_frecent(char* const fragments[], int num_fragments) {
+    DirMatch* matches;
+    int count = dirdb_list(fragments, num_fragments, &matches);
+    if (count < 0) return 1;
+    for (int i = 0; i < count; i++) {
+        printf("%10.1f  %s\n", matches[i].score, matches[i].path);
     }
-    return old_cwd_to_return;
-}
\ No newline at end of file
+    dirdb_free_matches(matches, count);
+    return count > 0 ? 0 : 1;
+}
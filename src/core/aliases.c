@@ -0,0 +1,49 @@
+#include "core/aliases.h"
+#include "utils/error.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static StrMap aliases;
+static unsigned generation = 0;
+
+const char* alias_get(const char* name) {
+    return strmap_get(&aliases, name);
+}
+
+bool alias_set(const char* name, const char* value) {
+    char* copy = strdup(value);
+    if (!copy) {
+        print_shell_perror("alias: strdup failed");
+        return false;
+    }
+    void* old_value;
+    if (!strmap_put(&aliases, name, copy, &old_value)) {
+        free(copy);
+        return false;
+    }
+    free(old_value);
+    generation++;
+    return true;
+}
+
+bool alias_remove(const char* name) {
+    char* value = strmap_remove(&aliases, name);
+    if (!value) return false;
+    free(value);
+    generation++;
+    return true;
+}
+
+void alias_clear(void) {
+    strmap_clear(&aliases, free);
+    generation++;
+}
+
+const StrMap* alias_table(void) {
+    return &aliases;
+}
+
+unsigned alias_generation(void) {
+    return generation;
+}
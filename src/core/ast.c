@@ -0,0 +1,119 @@
+#include "core/ast.h"
+#include "utils/error.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_ARRAY_CAPACITY 4
+
+/**
+ * @brief Makes room for one more element in a growable array, doubling as needed.
+ * @return True on success, false if memory could not be allocated.
+ */
+static bool grow_array(void** array, int count, int* capacity, size_t element_size) {
+    if (count < *capacity) return true;
+    int new_capacity = *capacity ? *capacity * 2 : INITIAL_ARRAY_CAPACITY;
+    void* grown = realloc(*array, element_size * new_capacity);
+    if (!grown) {
+        print_shell_perror("parser: realloc failed");
+        return false;
+    }
+    *array = grown;
+    *capacity = new_capacity;
+    return true;
+}
+
+Node* node_new(NodeType type) {
+    Node* node = calloc(1, sizeof(Node));
+    if (!node) {
+        print_shell_perror("parser: calloc for node failed");
+        return NULL;
+    }
+    node->type = type;
+    node->refs = 1;
+    return node;
+}
+
+Node* node_retain(Node* node) {
+    node->refs++;
+    return node;
+}
+
+void node_free(Node* node) {
+    if (!node || --node->refs > 0) return;
+    node_free(node->left);
+    node_free(node->right);
+    node_free(node->alternate);
+    for (int i = 0; i < node->num_stages; i++) node_free(node->stages[i]);
+    free(node->stages);
+    for (int i = 0; i < node->num_words; i++) word_clear(&node->words[i]);
+    free(node->words);
+    for (int i = 0; i < node->num_redirects; i++) word_clear(&node->redirects[i].target);
+    free(node->redirects);
+    free(node);
+}
+
+bool node_add_stage(Node* pipeline, Node* stage) {
+    if (!grow_array((void**)&pipeline->stages, pipeline->num_stages, &pipeline->stages_capacity, sizeof(Node*))) {
+        return false;
+    }
+    pipeline->stages[pipeline->num_stages++] = stage;
+    return true;
+}
+
+bool node_add_word(Node* command, Word* word) {
+    if (!grow_array((void**)&command->words, command->num_words, &command->words_capacity, sizeof(Word))) {
+        return false;
+    }
+    command->words[command->num_words++] = *word;
+    memset(word, 0, sizeof(*word));
+    return true;
+}
+
+bool node_add_redirect(Node* command, RedirectType type, int fd, Word* target) {
+    if (!grow_array((void**)&command->redirects, command->num_redirects, &command->redirects_capacity, sizeof(Redirect))) {
+        return false;
+    }
+    Redirect* redirect = &command->redirects[command->num_redirects++];
+    redirect->type = type;
+    redirect->fd = fd;
+    redirect->target = *target;
+    memset(target, 0, sizeof(*target));
+    return true;
+}
+
+bool word_add_part(Word* word, WordPartType type, const char* text, bool quoted) {
+    if (!grow_array((void**)&word->parts, word->num_parts, &word->parts_capacity, sizeof(WordPart))) {
+        return false;
+    }
+    char* copy = strdup(text);
+    if (!copy) {
+        print_shell_perror("parser: strdup for word failed");
+        return false;
+    }
+    word->parts[word->num_parts++] = (WordPart){type, copy, quoted, NULL};
+    return true;
+}
+
+bool word_add_command_part(Word* word, WordPartType type, const char* text, Node* command, bool quoted) {
+    if (!word_add_part(word, type, text, quoted)) {
+        node_free(command);
+        return false;
+    }
+    word->parts[word->num_parts - 1].command = command;
+    return true;
+}
+
+void word_clear(Word* word) {
+    for (int i = 0; i < word->num_parts; i++) {
+        free(word->parts[i].text);
+        node_free(word->parts[i].command);
+    }
+    free(word->parts);
+    memset(word, 0, sizeof(*word));
+}
+
+bool word_is_bare(const Word* word, const char* text) {
+    return !word->has_quotes && word->num_parts == 1 && word->parts[0].type == PART_LITERAL &&
+           strcmp(word->parts[0].text, text) == 0;
+}
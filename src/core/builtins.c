@@ -0,0 +1,388 @@
+#include "core/builtins.h"
+#include "core/ast.h"
+#include "utils/error.h"
+#include "commands/warp.h"
+#include "commands/dirstack.h"
+#include "commands/peek.h"
+#include "commands/proclore.h"
+#include "commands/seek.h"
+#include "commands/iman.h"
+#include "commands/activities.h"
+#include "commands/ping.h"
+#include "commands/neonate.h"
+#include "commands/fg_bg.h"
+#include "commands/jobout.h"
+#include "commands/shellstat.h"
+#include "commands/set.h"
+#include "commands/alias.h"
+#include "commands/print.h"
+#include "commands/test.h"
+#include "commands/cat.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static int builtin_exit(int argc, char* argv[], ShellState* state) {
+    if (argc > 2) {
+        print_shell_error("Usage: exit [status]");
+        return 1;
+    }
+    state->is_running = false;
+    // With no argument the shell exits with the status of the last command.
+    if (argc == 2) state->last_exit_status = atoi(argv[1]) & 0xff;
+    return state->last_exit_status;
+}
+
+/**
+ * @brief break [n] and continue [n]: leave (or start the next iteration of) the nth enclosing loop.
+ */
+static int builtin_loop_control(int argc, char* argv[], ShellState* state) {
+    if (argc > 2) {
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "Usage: %s [n]\n", argv[0]);
+        return 1;
+    }
+    char* end = NULL;
+    long levels = (argc == 2) ? strtol(argv[1], &end, 10) : 1;
+    if (argc == 2 && (*argv[1] == '\0' || *end != '\0' || levels < 1)) {
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "%s: '%s': loop count out of range\n", argv[0], argv[1]);
+        return 1;
+    }
+    if (state->loop_depth == 0) {
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "%s: only meaningful in a loop\n", argv[0]);
+        return 1;
+    }
+    state->flow = (strcmp(argv[0], "continue") == 0) ? FLOW_CONTINUE : FLOW_BREAK;
+    state->flow_count = (levels < state->loop_depth) ? (int)levels : state->loop_depth;
+    return 0;
+}
+
+static int builtin_return(int argc, char* argv[], ShellState* state) {
+    if (argc > 2) {
+        print_shell_error("Usage: return [status]");
+        return 1;
+    }
+    if (state->function_depth == 0) {
+        print_shell_error("return: can only be used in a function");
+        return 1;
+    }
+    state->flow = FLOW_RETURN;
+    return (argc == 2) ? atoi(argv[1]) & 0xff : state->last_exit_status;
+}
+
+static int builtin_true(int argc, char* argv[], ShellState* state) {
+    (void)argc; (void)argv; (void)state;
+    return 0;
+}
+
+static int builtin_false(int argc, char* argv[], ShellState* state) {
+    (void)argc; (void)argv; (void)state;
+    return 1;
+}
+
+static int builtin_pwd(int argc, char* argv[], ShellState* state) {
+    // -L (the default) prints the logical directory the shell tracks; -P resolves symlinks.
+    bool physical = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-L") == 0) {
+            physical = false;
+        } else if (strcmp(argv[i], "-P") == 0) {
+            physical = true;
+        } else {
+            print_shell_error("Usage: pwd [-L | -P]");
+            return 1;
+        }
+    }
+    if (!physical) {
+        printf("%s\n", state->cwd);
+        return 0;
+    }
+    char cwd[MAX_PATH_LEN];
+    if (!getcwd(cwd, sizeof(cwd))) {
+        print_shell_perror("pwd");
+        return 1;
+    }
+    printf("%s\n", cwd);
+    return 0;
+}
+
+static int builtin_warp(int argc, char* argv[], ShellState* state) {
+    if (argc > 1 && strcmp(argv[1], "-z") == 0) {
+        // warp -z <fragment>...: jump by frecency; with -l, or no fragments, list the matches.
+        bool list = argc > 2 && strcmp(argv[2], "-l") == 0;
+        int first = list ? 3 : 2;
+        if (list || argc == 2) return warp_list_frecent(argv + first, argc - first);
+        return warp_frecent(argv + 2, argc - 2, state) ? 0 : 1;
+    }
+    int status = 0;
+    for (int j = (argc < 2) ? 0 : 1; j < argc; j++) {
+        if (!warp(argc < 2 ? "~" : argv[j], state)) {
+            status = 1;
+        }
+    }
+    return status;
+}
+
+static int builtin_peek(int argc, char* argv[], ShellState* state) {
+    bool l = false, a = false; char* path = NULL;
+    for(int i=1; i<argc; ++i) {
+        if(argv[i][0] == '-') for(size_t j=1; j<strlen(argv[i]); ++j) { if(argv[i][j]=='l') l=true; else if(argv[i][j]=='a') a=true; }
+        else path = argv[i];
+    }
+    return peek_execute(path, state, l, a);
+}
+
+static int builtin_pastevents(int argc, char* argv[], ShellState* state) {
+    if (argc == 1) {
+        display_history(state->history_queue);
+    } else if (argc == 2 && strcmp(argv[1], "purge") == 0) {
+        purge_history(state->history_queue);
+        write_history_to_file(state->history_queue, state->home_dir);
+    } else {
+        // 'pastevents execute <n>' is substituted before parsing; reaching here means it was malformed.
+        print_shell_error("pastevents: Invalid arguments.");
+        return 1;
+    }
+    return 0;
+}
+
+static int builtin_proclore(int argc, char* argv[], ShellState* state) {
+    bool extended = false, watch = false, tree = false;
+    double interval = 0;
+    int pid = getpid(), i = 1;
+    for (; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+        for (const char* c = argv[i] + 1; *c; c++) {
+            if (*c == 'x') extended = true;
+            else if (*c == 'w') watch = true;
+            else if (*c == 't') tree = true;
+            else if (*c == 'n' && c[1] == '\0' && i + 1 < argc && atof(argv[i + 1]) > 0) interval = atof(argv[++i]);
+            else {
+                print_shell_error("Usage: proclore [-x] [-w] [-n <seconds>] [<pid>] | proclore -t [<pid>]");
+                return 1;
+            }
+            if (*c == 'n') break;
+        }
+    }
+    if (i < argc) pid = atoi(argv[i++]);
+    if (i < argc || (tree && (extended || watch || interval > 0))) {
+        print_shell_error("Usage: proclore [-x] [-w] [-n <seconds>] [<pid>] | proclore -t [<pid>]");
+        return 1;
+    }
+    if (tree) return proclore_tree(pid);
+    if (watch) return proclore_watch(pid, state->home_dir, interval > 0 ? interval : PROCLORE_WATCH_INTERVAL);
+    return proclore_execute(pid, state->home_dir, extended, interval > 0 ? interval : PROCLORE_SAMPLE_INTERVAL);
+}
+
+static int builtin_seek(int argc, char* argv[], ShellState* state) {
+    bool d=false, f=false, e=false; char* name=NULL; char* dir="."; int i=1;
+    while(i < argc && argv[i][0] == '-') {
+        for(size_t j=1; j<strlen(argv[i]); ++j) { if(argv[i][j]=='d') d=true; else if(argv[i][j]=='f') f=true; else if(argv[i][j]=='e') e=true; }
+        i++;
+    }
+    if(i < argc) name = argv[i++];
+    if(i < argc) dir = argv[i];
+    if(!name) { print_shell_error("seek: Target name not specified."); return 1; }
+    if(d && f) { print_shell_error("seek: Flags -d and -f are mutually exclusive."); return 1; }
+    return seek_execute(name, dir, state, d, f, e);
+}
+
+static int builtin_iman(int argc, char* argv[], ShellState* state) {
+    (void)state;
+    bool remote = false; int i = 1;
+    if (i < argc && strcmp(argv[i], "-r") == 0) { remote = true; i++; }
+    if (argc - i == 1) return iman_execute(argv[i], NULL, remote);
+    if (argc - i == 2) return iman_execute(argv[i + 1], argv[i], remote);
+    print_shell_error("Usage: iman [-r] [section] <command_name>");
+    return 1;
+}
+
+static int builtin_activities(int argc, char* argv[], ShellState* state) {
+    bool watch = false, tree = false, interval_given = false;
+    double interval = ACTIVITIES_WATCH_INTERVAL;
+    bool usage_error = false;
+    for (int i = 1; i < argc && !usage_error; i++) {
+        if (strcmp(argv[i], "-w") == 0 && !tree) {
+            watch = true;
+        } else if (strcmp(argv[i], "-t") == 0 && !watch) {
+            tree = true;
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc && atof(argv[i + 1]) > 0) {
+            interval = atof(argv[++i]);
+            interval_given = true;
+        } else {
+            usage_error = true;
+        }
+    }
+    if (usage_error || (interval_given && !watch)) { // -n is the refresh interval of -w; alone it means nothing
+        print_shell_error("Usage: activities [-t | -w [-n <seconds>]]");
+        return 1;
+    }
+    if (tree) return activities_tree(state);
+    return watch ? activities_watch(state, interval) : activities_execute(state);
+}
+
+static int builtin_ping(int argc, char* argv[], ShellState* state) {
+    return ping_execute(argc, argv, state);
+}
+
+static int builtin_neonate(int argc, char* argv[], ShellState* state) {
+    (void)state;
+    if (argc != 3 || strcmp(argv[1], "-n") != 0) {
+        print_shell_error("Usage: neonate -n <time_in_seconds>");
+        return 1;
+    }
+    int time_arg = atoi(argv[2]);
+    if (time_arg <= 0) {
+        print_shell_error("neonate: time argument must be a positive integer.");
+        return 1;
+    }
+    return neonate_execute(time_arg);
+}
+
+static int builtin_fg(int argc, char* argv[], ShellState* state) {
+    if (argc != 2) {
+        print_shell_error("Usage: fg <pid>");
+        return 1;
+    }
+    return fg_execute(atoi(argv[1]), state);
+}
+
+static int builtin_bg(int argc, char* argv[], ShellState* state) {
+    if (argc != 2) {
+        print_shell_error("Usage: bg <pid>");
+        return 1;
+    }
+    return bg_execute(atoi(argv[1]), state);
+}
+
+static int compare_var_names(const void* a, const void* b) {
+    return strcmp((*(const Var* const*)a)->name, (*(const Var* const*)b)->name);
+}
+
+/**
+ * @brief Prints the exported variables, sorted, in a form that can be read back.
+ */
+static int list_exports(const VarStore* vars) {
+    const Var** list = malloc(sizeof(Var*) * (vars->used + 1));
+    if (!list) {
+        print_shell_perror("export: malloc failed");
+        return 1;
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < vars->capacity; i++) {
+        if (vars->slots[i].name && vars->slots[i].exported) list[n++] = &vars->slots[i];
+    }
+    qsort(list, n, sizeof(Var*), compare_var_names);
+    for (size_t i = 0; i < n; i++) {
+        if (!list[i]->value) {
+            printf("export %s\n", list[i]->name);
+            continue;
+        }
+        printf("export %s=\"", list[i]->name);
+        for (const char* p = list[i]->value; *p; p++) {
+            if (strchr("\"\\$`", *p)) putchar('\\');
+            putchar(*p);
+        }
+        printf("\"\n");
+    }
+    free(list);
+    return 0;
+}
+
+static int builtin_export(int argc, char* argv[], ShellState* state) {
+    if (argc == 1 || (argc == 2 && strcmp(argv[1], "-p") == 0)) return list_exports(&state->vars);
+    int status = 0;
+    for (int i = 1; i < argc; i++) {
+        size_t name_len = strcspn(argv[i], "=");
+        if (!vars_valid_name(argv[i], name_len)) {
+            fprintf(stderr, _RED_ "Shell Error: " _RESET_ "export: '%s': not a valid identifier\n", argv[i]);
+            status = 1;
+        } else if (argv[i][name_len] == '=') {
+            if (!vars_assign(&state->vars, argv[i], true)) status = 1;
+        } else if (!vars_export(&state->vars, argv[i], true)) {
+            status = 1;
+        }
+    }
+    return status;
+}
+
+static int builtin_unset(int argc, char* argv[], ShellState* state) {
+    int status = 0;
+    int i = 1;
+    bool functions = false; // -f: the names are functions; -v (the default): variables
+    for (; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+        if (strcmp(argv[i], "-f") == 0) functions = true;
+        else if (strcmp(argv[i], "-v") == 0) functions = false;
+        else {
+            print_shell_error("Usage: unset [-f | -v] <name>...");
+            return 1;
+        }
+    }
+    for (; i < argc; i++) {
+        if (functions) {
+            node_free(strmap_remove(&state->functions, argv[i]));
+            continue;
+        }
+        if (!vars_valid_name(argv[i], strlen(argv[i]))) {
+            fprintf(stderr, _RED_ "Shell Error: " _RESET_ "unset: '%s': not a valid identifier\n", argv[i]);
+            status = 1;
+            continue;
+        }
+        vars_unset(&state->vars, argv[i]);
+    }
+    return status;
+}
+
+static int builtin_shellstat(int argc, char* argv[], ShellState* state) {
+    (void)state;
+    return shellstat_execute(argc, argv);
+}
+
+static const Builtin builtin_table[] = {
+    {"q", builtin_exit},
+    {"quit", builtin_exit},
+    {"exit", builtin_exit},
+    {"break", builtin_loop_control},
+    {"continue", builtin_loop_control},
+    {"return", builtin_return},
+    {"warp", builtin_warp},
+    {"pushd", pushd_execute},
+    {"popd", popd_execute},
+    {"dirs", dirs_execute},
+    {"peek", builtin_peek},
+    {"pastevents", builtin_pastevents},
+    {"proclore", builtin_proclore},
+    {"seek", builtin_seek},
+    {"iman", builtin_iman},
+    {"activities", builtin_activities},
+    {"ping", builtin_ping},
+    {"neonate", builtin_neonate},
+    {"fg", builtin_fg},
+    {"bg", builtin_bg},
+    {"jobout", jobout_execute},
+    {"shellstat", builtin_shellstat},
+    {"set", set_execute},
+    {"export", builtin_export},
+    {"unset", builtin_unset},
+    {"alias", alias_execute},
+    {"unalias", unalias_execute},
+    // Common utilities, run in the shell instead of forking a process each time.
+    {"echo", echo_execute},
+    {"printf", printf_execute},
+    {"test", test_execute},
+    {"[", test_execute},
+    {"true", builtin_true},
+    {":", builtin_true},
+    {"false", builtin_false},
+    {"pwd", builtin_pwd},
+    {"cat", cat_execute},
+    {NULL, NULL}
+};
+
+const Builtin* builtin_lookup(const char* name) {
+    if (!name) return NULL;
+    for (const Builtin* builtin = builtin_table; builtin->name; builtin++) {
+        if (strcmp(builtin->name, name) == 0) return builtin;
+    }
+    return NULL;
+}
@@ -0,0 +1,321 @@
+#define _GNU_SOURCE
+#include "core/cgroup.h"
+#include "core/procfs.h"
+#include "utils/error.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/magic.h>
+#include <linux/sched.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#include <sys/syscall.h>
+
+// Once the shell has moved into its leaf ("shellby-<pid>"), the cgroup it left, where
+// job cgroups keep being created, and the controllers it enabled there.
+static char left_cgroup[PATH_MAX];
+static pid_t leaf_owner;
+static const char* enabled_controllers[3];
+static int num_enabled_controllers;
+
+/**
+ * @brief Reads a small cgroup file of 'dir_fd' into 'buf' (NUL-terminated).
+ * @return False if it could not be read.
+ */
+static bool read_file(int dir_fd, const char* name, char* buf, size_t size) {
+    int fd = openat(dir_fd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    ssize_t len = procfs_pread_file(fd, buf, size - 1);
+    close(fd);
+    if (len < 0) return false;
+    buf[len] = '\0';
+    return true;
+}
+
+/**
+ * @brief Writes 'value' to a cgroup file of 'dir_fd' in one write(), as the kernel expects.
+ * @return False with errno set on failure.
+ */
+static bool write_file(int dir_fd, const char* name, const char* value) {
+    int fd = openat(dir_fd, name, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    ssize_t len = (ssize_t)strlen(value);
+    bool ok = write(fd, value, len) == len;
+    int saved = errno;
+    close(fd);
+    errno = saved;
+    return ok;
+}
+
+/**
+ * @brief The value after 'key' in a flat keyed file such as cpu.stat, or -1.
+ */
+static long long keyed_value(const char* text, const char* key) {
+    size_t key_len = strlen(key);
+    for (const char* line = text; line; line = strchr(line, '\n')) {
+        if (*line == '\n') line++;
+        if (strncmp(line, key, key_len) == 0 && line[key_len] == ' ') return atoll(line + key_len + 1);
+    }
+    return -1;
+}
+
+/**
+ * @brief Finds the cgroup the job cgroups are created in.
+ * @param configured $SHELLBY_CGROUP, or NULL.
+ * @param own Set to true if it is the shell's own cgroup, which the shell may
+ *        have to leave before controllers can be enabled in it.
+ * @return False after reporting why there is none.
+ */
+static bool find_parent(const char* configured, char* path, size_t size, bool* own) {
+    *own = !configured || !*configured;
+    if (!*own) {
+        snprintf(path, size, "%s", configured);
+        return true;
+    }
+    if (left_cgroup[0]) { // Not the leaf the shell is in now
+        snprintf(path, size, "%s", left_cgroup);
+        return true;
+    }
+
+    // The cgroup2 mount (on a hybrid host, /sys/fs/cgroup/unified) and the part of the hierarchy it shows.
+    char line[4096], mount_root[PATH_MAX] = "", mount_point[PATH_MAX] = "";
+    FILE* mounts = fopen("/proc/self/mountinfo", "re");
+    while (mounts && fgets(line, sizeof(line), mounts)) {
+        const char* fs = strstr(line, " - ");
+        if (fs && strncmp(fs, " - cgroup2 ", 11) == 0 &&
+            sscanf(line, "%*d %*d %*s %4095s %4095s", mount_root, mount_point) == 2) break;
+        mount_point[0] = '\0';
+    }
+    if (mounts) fclose(mounts);
+    if (!mount_point[0]) {
+        print_shell_error("limit: cgroup v2 is not mounted; running without limits");
+        return false;
+    }
+
+    char own_path[PATH_MAX] = "";
+    FILE* cgroups = fopen("/proc/self/cgroup", "re");
+    while (cgroups && fgets(line, sizeof(line), cgroups)) {
+        if (strncmp(line, "0::", 3) == 0) {
+            line[strcspn(line, "\n")] = '\0';
+            snprintf(own_path, sizeof(own_path), "%s", line + 3);
+            break;
+        }
+    }
+    if (cgroups) fclose(cgroups);
+    if (!own_path[0]) {
+        print_shell_error("limit: the shell is not in a cgroup v2 hierarchy; running without limits");
+        return false;
+    }
+    size_t root_len = strcmp(mount_root, "/") == 0 ? 0 : strlen(mount_root);
+    const char* relative = strncmp(own_path, mount_root, root_len) == 0 ? own_path + root_len : own_path;
+    snprintf(path, size, "%s%s", mount_point, strcmp(relative, "/") == 0 ? "" : relative);
+    return true;
+}
+
+/**
+ * @brief Makes 'controller' available to the children of 'parent_fd'.
+ *
+ * A cgroup with processes of its own cannot pass controllers down (except at
+ * the root), so if 'own' the shell first moves into a leaf beside the jobs,
+ * as in any delegated subtree. cgroup_leave_leaf() undoes both.
+ */
+static bool enable_controller(int parent_fd, const char* parent, const char* controller, bool own) {
+    char buf[512], enable[32];
+    if (read_file(parent_fd, "cgroup.subtree_control", buf, sizeof(buf))) {
+        for (char* word = strtok(buf, " \n"); word; word = strtok(NULL, " \n")) {
+            if (strcmp(word, controller) == 0) return true;
+        }
+    }
+    snprintf(enable, sizeof(enable), "+%s", controller);
+    bool enabled = write_file(parent_fd, "cgroup.subtree_control", enable);
+    if (!enabled && errno == EBUSY && own && !left_cgroup[0]) {
+        char leaf[64];
+        snprintf(leaf, sizeof(leaf), "shellby-%d", getpid());
+        if (mkdirat(parent_fd, leaf, 0755) < 0 && errno != EEXIST) return false;
+        int leaf_fd = openat(parent_fd, leaf, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (leaf_fd < 0) return false;
+        bool moved = write_file(leaf_fd, "cgroup.procs", "0");
+        close(leaf_fd);
+        if (!moved) {
+            int saved = errno;
+            unlinkat(parent_fd, leaf, AT_REMOVEDIR);
+            errno = saved;
+            return false;
+        }
+        snprintf(left_cgroup, sizeof(left_cgroup), "%s", parent);
+        leaf_owner = getpid();
+        enabled = write_file(parent_fd, "cgroup.subtree_control", enable);
+    }
+    if (enabled && own && left_cgroup[0] &&
+        num_enabled_controllers < (int)(sizeof(enabled_controllers) / sizeof(enabled_controllers[0]))) {
+        enabled_controllers[num_enabled_controllers++] = controller;
+    }
+    return enabled;
+}
+
+/**
+ * @brief Whether 'leaf' is the only cgroup below 'parent_fd', so that no other
+ *        group can be relying on the controllers the shell enabled there.
+ */
+static bool only_child(int parent_fd, const char* leaf) {
+    int fd = openat(parent_fd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    DIR* dir = fd >= 0 ? fdopendir(fd) : NULL;
+    if (!dir) {
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    bool only = true;
+    struct dirent* entry;
+    while (only && (entry = readdir(dir))) {
+        if (entry->d_type == DT_DIR && strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0 &&
+            strcmp(entry->d_name, leaf) != 0) {
+            only = false;
+        }
+    }
+    closedir(dir);
+    return only;
+}
+
+void cgroup_leave_leaf(void) {
+    if (!left_cgroup[0] || leaf_owner != getpid()) return;
+    int parent_fd = open(left_cgroup, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    left_cgroup[0] = '\0';
+    if (parent_fd < 0) return;
+    char leaf[64];
+    snprintf(leaf, sizeof(leaf), "shellby-%d", getpid());
+    // A cgroup that passes controllers down cannot hold processes: disable them first.
+    if (!write_file(parent_fd, "cgroup.procs", "0") && errno == EBUSY && only_child(parent_fd, leaf)) {
+        char disable[32];
+        for (int i = 0; i < num_enabled_controllers; i++) {
+            snprintf(disable, sizeof(disable), "-%s", enabled_controllers[i]);
+            write_file(parent_fd, "cgroup.subtree_control", disable);
+        }
+        write_file(parent_fd, "cgroup.procs", "0");
+    }
+    num_enabled_controllers = 0;
+    unlinkat(parent_fd, leaf, AT_REMOVEDIR); // Fails with EBUSY while jobs started from the leaf still run
+    close(parent_fd);
+}
+
+/**
+ * @brief Writes one limit, warning if its controller is not available.
+ */
+static void apply_limit(Cgroup* cgroup, int parent_fd, const char* parent, bool own, const char* controller,
+                        const char* file, const char* value) {
+    if (enable_controller(parent_fd, parent, controller, own) && write_file(cgroup->dir_fd, file, value)) return;
+    if (errno == ENOENT) { // Not in the parent's cgroup.controllers, e.g. still bound to a v1 hierarchy
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "limit: %s not applied: the %s controller is not available here\n",
+                file, controller);
+    } else {
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "limit: %s not applied: %s\n", file, strerror(errno));
+    }
+}
+
+Cgroup* cgroup_create(const char* parent_dir, const CgroupLimits* limits) {
+    static unsigned sequence;
+    char parent[PATH_MAX];
+    bool own;
+    if (!find_parent(parent_dir, parent, sizeof(parent), &own)) return NULL;
+    int parent_fd = open(parent, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    struct statfs fs;
+    if (parent_fd >= 0 && (fstatfs(parent_fd, &fs) < 0 || fs.f_type != CGROUP2_SUPER_MAGIC)) {
+        close(parent_fd);
+        parent_fd = -1;
+        errno = ENOTDIR;
+    }
+    if (parent_fd < 0) {
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "limit: %s: %s; running without limits\n", parent,
+                errno == ENOTDIR ? "not a cgroup v2 directory" : strerror(errno));
+        return NULL;
+    }
+
+    Cgroup* cgroup = calloc(1, sizeof(Cgroup));
+    char name[64];
+    snprintf(name, sizeof(name), "shellby-%d-job%u", getpid(), ++sequence);
+    if (cgroup && mkdirat(parent_fd, name, 0755) == 0) {
+        if (asprintf(&cgroup->path, "%s/%s", parent, name) < 0) cgroup->path = NULL;
+        cgroup->dir_fd = openat(parent_fd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (!cgroup->path || cgroup->dir_fd < 0) {
+            unlinkat(parent_fd, name, AT_REMOVEDIR);
+            free(cgroup->path);
+            free(cgroup);
+            cgroup = NULL;
+        }
+    } else {
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "limit: cannot create a cgroup in %s: %s; running without limits\n",
+                parent, strerror(cgroup ? errno : ENOMEM));
+        free(cgroup);
+        cgroup = NULL;
+    }
+    if (!cgroup) {
+        close(parent_fd);
+        return NULL;
+    }
+
+    char value[64];
+    if (limits->memory_max > 0) {
+        snprintf(value, sizeof(value), "%lld", limits->memory_max);
+        apply_limit(cgroup, parent_fd, parent, own, "memory", "memory.max", value);
+    } else {
+        enable_controller(parent_fd, parent, "memory", own); // For memory.peak; nothing is limited
+    }
+    if (limits->cpu_percent > 0) {
+        snprintf(value, sizeof(value), "%d 100000", limits->cpu_percent * 1000); // Quota per 100ms period
+        apply_limit(cgroup, parent_fd, parent, own, "cpu", "cpu.max", value);
+    }
+    if (limits->pids_max > 0) {
+        snprintf(value, sizeof(value), "%d", limits->pids_max);
+        apply_limit(cgroup, parent_fd, parent, own, "pids", "pids.max", value);
+    }
+    close(parent_fd);
+    return cgroup;
+}
+
+pid_t cgroup_fork(const Cgroup* cgroup) {
+#if defined(SYS_clone3) && defined(CLONE_INTO_CGROUP)
+    static bool unsupported; // Kernels before 5.7
+    if (!unsupported) {
+        struct clone_args args;
+        memset(&args, 0, sizeof(args));
+        args.flags = CLONE_INTO_CGROUP;
+        args.exit_signal = SIGCHLD;
+        args.cgroup = (unsigned)cgroup->dir_fd;
+        // The shell has a single thread, so this is fork() apart from where the child starts.
+        pid_t pid = (pid_t)syscall(SYS_clone3, &args, sizeof(args));
+        if (pid >= 0) return pid;
+        if (errno == ENOSYS || errno == E2BIG) unsupported = true;
+    }
+#endif
+    pid_t pid = fork();
+    if (pid == 0) {
+        // Before it runs anything, so no process of the job starts outside.
+        write_file(cgroup->dir_fd, "cgroup.procs", "0");
+    }
+    return pid;
+}
+
+bool cgroup_read_usage(const Cgroup* cgroup, CgroupUsage* usage) {
+    char buf[1024];
+    if (!read_file(cgroup->dir_fd, "cpu.stat", buf, sizeof(buf))) return false;
+    usage->usage_usec = keyed_value(buf, "usage_usec");
+    usage->user_usec = keyed_value(buf, "user_usec");
+    usage->system_usec = keyed_value(buf, "system_usec");
+    usage->memory_peak = read_file(cgroup->dir_fd, "memory.peak", buf, sizeof(buf)) ? atoll(buf) : -1;
+    usage->oom_kills = read_file(cgroup->dir_fd, "memory.events", buf, sizeof(buf)) ? keyed_value(buf, "oom_kill") : -1;
+    return true;
+}
+
+void cgroup_destroy(Cgroup* cgroup) {
+    if (!cgroup) return;
+    close(cgroup->dir_fd);
+    rmdir(cgroup->path); // Fails with EBUSY while processes that outlived the job are inside
+    free(cgroup->path);
+    free(cgroup);
+}
@@ -0,0 +1,125 @@
+#define _GNU_SOURCE
+#include "core/cwd.h"
+#include "utils/error.h"
+#include "utils/fd.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Appends the components of 'path' to the absolute path 'out', which
+ *        holds 'len' bytes, dropping '.' and letting '..' remove the last one.
+ * @return The new length, or 0 if it would not fit.
+ */
+static size_t append_components(char* out, size_t len, size_t size, const char* path) {
+    while (*path) {
+        while (*path == '/') path++;
+        size_t part = strcspn(path, "/");
+        if (part == 0 || (part == 1 && path[0] == '.')) {
+            // Empty or "."
+        } else if (part == 2 && path[0] == '.' && path[1] == '.') {
+            while (len > 0 && out[len - 1] != '/') len--;
+            if (len > 1) len--; // The slash before it, except the root's
+        } else {
+            if (len + part + 2 > size) return 0;
+            if (len > 1) out[len++] = '/';
+            memcpy(out + len, path, part);
+            len += part;
+        }
+        path += part;
+    }
+    out[len] = '\0';
+    return len;
+}
+
+bool cwd_absolute(const ShellState* state, const char* path, char* out, size_t size) {
+    size_t len;
+    if (path[0] == '/') {
+        out[0] = '/';
+        len = 1;
+    } else {
+        len = strlen(state->cwd);
+        if (len + 2 > size) return false;
+        memcpy(out, state->cwd, len + 1);
+    }
+    return append_components(out, len, size, path) > 0;
+}
+
+/**
+ * @brief True if resolving 'path' in the text and following it physically
+ *        from the current directory must give the same place.
+ */
+static bool relative_without_dotdot(const char* path) {
+    if (path[0] == '/') return false;
+    for (const char* p = path; (p = strstr(p, "..")); p += 2) {
+        if ((p == path || p[-1] == '/') && (p[2] == '/' || p[2] == '\0')) return false;
+    }
+    return true;
+}
+
+static void export_dirs(ShellState* state) {
+    vars_set(&state->vars, "PWD", state->cwd, true);
+    if (state->prev_dir[0]) vars_set(&state->vars, "OLDPWD", state->prev_dir, true);
+}
+
+bool cwd_init(ShellState* state) {
+    struct stat dot, named;
+    char logical[MAX_PATH_LEN];
+    const char* pwd = vars_get(&state->vars, "PWD");
+    // An inherited $PWD keeps the caller's logical path, if it really is where we are.
+    if (pwd && pwd[0] == '/' && cwd_absolute(state, pwd, logical, sizeof(logical)) && stat(".", &dot) == 0 &&
+        stat(logical, &named) == 0 && dot.st_dev == named.st_dev && dot.st_ino == named.st_ino) {
+        strcpy(state->cwd, logical);
+    } else if (getcwd(state->cwd, sizeof(state->cwd)) == NULL) {
+        print_shell_perror("Failed to get initial working directory");
+        return false;
+    }
+    state->cwd_fd = fd_keep(open(".", O_PATH | O_DIRECTORY | O_CLOEXEC));
+    export_dirs(state);
+    return true;
+}
+
+void cwd_destroy(ShellState* state) {
+    fd_close(state->cwd_fd);
+    state->cwd_fd = -1;
+}
+
+bool cwd_change(ShellState* state, const char* path) {
+    char target[MAX_PATH_LEN];
+    if (!cwd_absolute(state, path, target, sizeof(target))) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+    // A plain relative path is opened from the directory we hold, without walking from the root.
+    int base = (state->cwd_fd >= 0) ? state->cwd_fd : AT_FDCWD;
+    bool physical = false;
+    int fd = relative_without_dotdot(path) ? openat(base, path, O_PATH | O_DIRECTORY | O_CLOEXEC)
+                                           : open(target, O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0 && errno == ENOENT && !relative_without_dotdot(path)) {
+        fd = openat(base, path, O_PATH | O_DIRECTORY | O_CLOEXEC);
+        physical = true;
+    }
+    if (fd < 0) return false;
+    fd = fd_keep(fd);
+    if (fchdir(fd) < 0) { // Checks search permission, which opening with O_PATH does not
+        int error = errno;
+        fd_close(fd);
+        errno = error;
+        return false;
+    }
+    if (physical && getcwd(target, sizeof(target)) == NULL) {
+        // Entered, but with no name we can know; keep the text we have.
+        cwd_absolute(state, path, target, sizeof(target));
+    }
+
+    strcpy(state->prev_dir, state->cwd);
+    strcpy(state->cwd, target);
+    fd_close(state->cwd_fd);
+    state->cwd_fd = fd;
+    export_dirs(state);
+    return true;
+}
@@ -0,0 +1,619 @@
+#define _GNU_SOURCE
+#include "core/dirdb.h"
+#include "core/shell_state.h" // For MAX_PATH_LEN
+#include "utils/error.h"
+#include "utils/fd.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DIRDB_MAGIC 0x31424444u       ///< "DDB1"
+#define DIRDB_INITIAL_SIZE (64 * 1024)
+#define DIRDB_MAX_TOTAL_RANK 50000.0  ///< Summed ranks above which every entry is aged
+#define DIRDB_AGING_FACTOR 0.9
+#define DIRDB_MAX_FRAGMENTS 16
+#define DIRDB_PAIR_BITS 128
+#define DIRDB_ROWS (DIRDB_PAIR_BITS + 64) ///< Bitmap rows: one per bit of 'pairs', then of 'tail'
+
+/**
+ * @brief The start of the file. Records follow it back to back.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t record_size; ///< sizeof(DirRecord) when written, so a layout change is noticed
+    uint64_t size;        ///< Size of the file; every shell maps all of it
+    uint64_t used;        ///< Bytes of records after the header
+    uint64_t generation;  ///< Bumped whenever records move or go away, so other shells re-index
+    uint32_t count;       ///< Records
+    uint32_t reserved;
+    double total_rank;
+    char padding[16];
+} DirDbHeader;
+
+/**
+ * @brief One directory. Records are padded to 8 bytes.
+ */
+typedef struct {
+    uint64_t pairs[2];    ///< Character pairs present in the path (see pair_bit())
+    uint64_t tail;        ///< Characters and character pairs of the last component (see tail_signature())
+    float rank;           ///< Visits, scaled down by aging
+    uint32_t last_access; ///< Seconds since the epoch
+    uint32_t hash;
+    uint16_t len;
+    uint16_t reserved;
+    char path[];          ///< 'len' bytes and a NUL
+} DirRecord;
+
+/**
+ * @brief The open database, and this process's index of it.
+ *
+ * The index maps path hashes to records for visits, and keeps one bitmap per
+ * signature bit with a bit set for every record that has it, so a query ANDs
+ * a few bitmaps a word at a time and only compares text for the survivors.
+ * It covers the records up to 'indexed_used'; records appended since (by any
+ * shell) are added on the next access, and it is rebuilt if the generation
+ * shows records were moved.
+ */
+static struct {
+    int fd;
+    pid_t owner;          ///< A forked child reopens the file, so its flock() is its own
+    char* path;
+    DirDbHeader* map;
+    size_t map_size;
+
+    uint32_t* slots;      ///< Open addressing over record offsets; 0 is empty (no record starts there)
+    size_t num_slots;     ///< A power of two
+    uint32_t* offsets;    ///< Record offset by position in the file
+    size_t num_indexed;
+    uint64_t* bits;       ///< DIRDB_ROWS rows of 'words' words
+    size_t words;
+    uint64_t indexed_generation; ///< 0: nothing indexed
+    uint64_t indexed_used;
+} db = {.fd = -1};
+
+/**
+ * @brief A query, folded to lower case once.
+ */
+typedef struct {
+    char text[MAX_PATH_LEN];
+    const char* fragments[DIRDB_MAX_FRAGMENTS];
+    size_t lengths[DIRDB_MAX_FRAGMENTS];
+    int count;
+    uint64_t pairs[2];
+    uint64_t tail;        ///< Signature the last component needs (0 if the last fragment has a '/')
+} DirQuery;
+
+static size_t record_bytes(size_t len) {
+    return (sizeof(DirRecord) + len + 1 + 7) & ~(size_t)7;
+}
+
+static DirRecord* record_at(uint64_t offset) {
+    return (DirRecord*)((char*)db.map + offset);
+}
+
+static uint64_t records_end(void) {
+    return sizeof(DirDbHeader) + db.map->used;
+}
+
+/**
+ * @brief The offset of the record after the one at 'offset', or 0 if the
+ *        record runs past the end (a damaged file: stop there).
+ */
+static uint64_t next_record(uint64_t offset) {
+    uint64_t next = offset + record_bytes(record_at(offset)->len);
+    return next <= records_end() ? next : 0;
+}
+
+static uint32_t hash_path(const char* path, size_t len) {
+    uint32_t hash = 2166136261u; // FNV-1a
+    for (size_t i = 0; i < len; i++) hash = (hash ^ (unsigned char)path[i]) * 16777619u;
+    return hash;
+}
+
+/**
+ * @brief ASCII lower case; paths are compared byte by byte, whatever the locale.
+ */
+static inline unsigned char fold(unsigned char c) {
+    return (unsigned char)(c - 'A') < 26 ? c + ('a' - 'A') : c;
+}
+
+/**
+ * @brief Hashes the pair of characters at 'text' to one of 2^bits bits.
+ *        Pairs tell names apart far better than single characters.
+ */
+static unsigned pair_bit(const char* text, int bits) {
+    return ((uint32_t)(fold(text[0]) << 8 | fold(text[1])) * 2654435761u) >> (32 - bits);
+}
+
+/**
+ * @brief Adds every adjacent pair of characters of 'text' to a DIRDB_PAIR_BITS-bit set.
+ */
+static void add_pairs(uint64_t pairs[2], const char* text, size_t len) {
+    for (size_t i = 0; i + 1 < len; i++) {
+        unsigned bit = pair_bit(text + i, 7);
+        pairs[bit / 64] |= 1ull << (bit % 64);
+    }
+}
+
+/**
+ * @brief The characters and character pairs of a last component, in 64 bits.
+ *        Single characters are included so a one-letter fragment still narrows the search.
+ */
+static uint64_t tail_signature(const char* text, size_t len) {
+    uint64_t sig = 0;
+    for (size_t i = 0; i < len; i++) {
+        sig |= 1ull << ((fold(text[i]) * 31u) & 63);
+        if (i + 1 < len) sig |= 1ull << pair_bit(text + i, 6);
+    }
+    return sig;
+}
+
+static const char* last_component(const char* path, size_t len) {
+    const char* slash = memrchr(path, '/', len);
+    return slash ? slash + 1 : path;
+}
+
+static bool lock(int operation) {
+    while (flock(db.fd, operation) < 0) {
+        if (errno != EINTR) return false;
+    }
+    return true;
+}
+
+static void unlock(void) {
+    flock(db.fd, LOCK_UN);
+}
+
+/**
+ * @brief Follows a size change made by another shell (or this one).
+ */
+static bool remap(size_t size) {
+    void* map = mremap(db.map, db.map_size, size, MREMAP_MAYMOVE);
+    if (map == MAP_FAILED) return false;
+    db.map = map;
+    db.map_size = size;
+    return true;
+}
+
+static bool mapping_valid(void) {
+    if (db.map->size != db.map_size && !remap(db.map->size)) return false;
+    return db.map->used <= db.map_size - sizeof(DirDbHeader);
+}
+
+/**
+ * @brief Writes an empty database into the (locked) file.
+ */
+static bool format_file(void) {
+    if (ftruncate(db.fd, DIRDB_INITIAL_SIZE) < 0) return false;
+    if (db.map_size != DIRDB_INITIAL_SIZE && !remap(DIRDB_INITIAL_SIZE)) return false;
+    memset(db.map, 0, sizeof(DirDbHeader));
+    db.map->magic = DIRDB_MAGIC;
+    db.map->record_size = sizeof(DirRecord);
+    db.map->size = DIRDB_INITIAL_SIZE;
+    db.map->generation = 1;
+    return true;
+}
+
+static void slot_insert(uint32_t offset) {
+    size_t mask = db.num_slots - 1;
+    size_t slot = record_at(offset)->hash & mask;
+    while (db.slots[slot]) slot = (slot + 1) & mask;
+    db.slots[slot] = offset;
+}
+
+/**
+ * @brief Makes room in the index for one more record.
+ */
+static bool reserve_index(void) {
+    size_t needed = db.num_indexed + 1;
+    if (needed * 2 > db.num_slots) {
+        size_t num_slots = db.num_slots ? db.num_slots * 2 : 64;
+        uint32_t* slots = calloc(num_slots, sizeof(uint32_t));
+        uint32_t* offsets = realloc(db.offsets, num_slots / 2 * sizeof(uint32_t));
+        if (offsets) db.offsets = offsets;
+        if (!slots || !offsets) {
+            free(slots);
+            return false;
+        }
+        free(db.slots);
+        db.slots = slots;
+        db.num_slots = num_slots;
+        for (size_t i = 0; i < db.num_indexed; i++) slot_insert(db.offsets[i]);
+    }
+    if (needed > db.words * 64) {
+        size_t words = db.words ? db.words * 2 : 4;
+        uint64_t* bits = calloc(DIRDB_ROWS * words, sizeof(uint64_t));
+        if (!bits) return false;
+        for (int row = 0; row < DIRDB_ROWS && db.words; row++) {
+            memcpy(bits + row * words, db.bits + row * db.words, db.words * sizeof(uint64_t));
+        }
+        free(db.bits);
+        db.bits = bits;
+        db.words = words;
+    }
+    return true;
+}
+
+static bool index_record(uint64_t offset) {
+    if (!reserve_index()) return false;
+    const DirRecord* r = record_at(offset);
+    size_t id = db.num_indexed++;
+    db.offsets[id] = (uint32_t)offset;
+    slot_insert((uint32_t)offset);
+    uint64_t word_bit = 1ull << (id % 64);
+    for (int b = 0; b < DIRDB_PAIR_BITS; b++) {
+        if (r->pairs[b / 64] >> (b % 64) & 1) db.bits[b * db.words + id / 64] |= word_bit;
+    }
+    for (int b = 0; b < 64; b++) {
+        if (r->tail >> b & 1) db.bits[(DIRDB_PAIR_BITS + b) * db.words + id / 64] |= word_bit;
+    }
+    return true;
+}
+
+/**
+ * @brief Brings the index up to date with the file (locked, in either mode).
+ */
+static bool sync_index(void) {
+    if (db.indexed_generation != db.map->generation || db.indexed_used > db.map->used) {
+        db.num_indexed = 0;
+        db.indexed_used = 0;
+        if (db.slots) memset(db.slots, 0, db.num_slots * sizeof(uint32_t));
+        if (db.bits) memset(db.bits, 0, DIRDB_ROWS * db.words * sizeof(uint64_t));
+    }
+    db.indexed_generation = 0;
+    uint64_t offset = sizeof(DirDbHeader) + db.indexed_used;
+    for (; offset && offset < records_end(); offset = next_record(offset)) {
+        if (!index_record(offset)) return false; // Left marked stale, so it is rebuilt next time
+    }
+    db.indexed_used = db.map->used;
+    db.indexed_generation = db.map->generation;
+    return true;
+}
+
+/**
+ * @brief The offset of the record for 'path', or 0.
+ */
+static uint64_t index_find(const char* path, size_t len, uint32_t hash) {
+    if (!db.num_slots) return 0;
+    size_t mask = db.num_slots - 1;
+    for (size_t slot = hash & mask; db.slots[slot]; slot = (slot + 1) & mask) {
+        DirRecord* r = record_at(db.slots[slot]);
+        if (r->hash == hash && r->len == len && memcmp(r->path, path, len) == 0) return db.slots[slot];
+    }
+    return 0;
+}
+
+/**
+ * @brief Scales every rank down and drops the records that fall below one visit.
+ */
+static void age_records(void) {
+    uint64_t write = sizeof(DirDbHeader);
+    uint32_t count = 0;
+    double total = 0;
+    for (uint64_t offset = write; offset && offset < records_end(); offset = next_record(offset)) {
+        DirRecord* r = record_at(offset);
+        r->rank *= DIRDB_AGING_FACTOR;
+        if (r->rank < 1) continue;
+        total += r->rank;
+        count++;
+        size_t bytes = record_bytes(r->len);
+        if (write != offset) memmove(record_at(write), r, bytes);
+        write += bytes;
+    }
+    db.map->used = write - sizeof(DirDbHeader);
+    db.map->count = count;
+    db.map->total_rank = total;
+    db.map->generation++;
+}
+
+static void close_mapping(void) {
+    if (db.map) munmap(db.map, db.map_size);
+    fd_close(db.fd);
+    free(db.slots);
+    free(db.offsets);
+    free(db.bits);
+    db.map = NULL;
+    db.map_size = 0;
+    db.fd = -1;
+    db.slots = db.offsets = NULL;
+    db.bits = NULL;
+    db.num_slots = db.num_indexed = db.words = 0;
+    db.indexed_generation = db.indexed_used = 0;
+}
+
+static bool open_mapping(void) {
+    db.fd = fd_keep(open(db.path, O_RDWR | O_CREAT | O_CLOEXEC, 0600));
+    if (db.fd < 0) return false;
+    db.owner = getpid();
+    if (!lock(LOCK_EX)) return false;
+    struct stat st;
+    bool ok = fstat(db.fd, &st) == 0;
+    size_t size = (ok && (size_t)st.st_size >= sizeof(DirDbHeader)) ? (size_t)st.st_size : DIRDB_INITIAL_SIZE;
+    if (ok && (size_t)st.st_size < size) ok = ftruncate(db.fd, size) == 0;
+    if (ok) {
+        db.map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, db.fd, 0);
+        if (db.map == MAP_FAILED) {
+            db.map = NULL;
+            ok = false;
+        }
+        db.map_size = size;
+    }
+    // A new, foreign or damaged file is started afresh.
+    if (ok && (db.map->magic != DIRDB_MAGIC || db.map->record_size != sizeof(DirRecord) ||
+               db.map->size != size || db.map->used > size - sizeof(DirDbHeader))) {
+        ok = format_file();
+    }
+    unlock();
+    return ok;
+}
+
+bool dirdb_open(const char* path) {
+    dirdb_close();
+    db.path = strdup(path);
+    if (!db.path || !open_mapping()) {
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "%s: cannot open directory database: %s\n", path, strerror(errno));
+        dirdb_close();
+        return false;
+    }
+    return true;
+}
+
+void dirdb_close(void) {
+    close_mapping();
+    free(db.path);
+    db.path = NULL;
+}
+
+/**
+ * @brief Locks the database, following any change of its size, and syncs the index.
+ * @return False if there is no usable database.
+ */
+static bool acquire(int operation) {
+    if (!db.path) return false;
+    if (db.owner != getpid()) {
+        // A subshell shares the parent's open file, and with it the parent's lock.
+        close_mapping();
+        if (!open_mapping()) {
+            close_mapping();
+            return false;
+        }
+    }
+    if (!db.map || !lock(operation)) return false;
+    if (!mapping_valid() || !sync_index()) {
+        unlock();
+        return false;
+    }
+    return true;
+}
+
+void dirdb_visit(const char* path) {
+    size_t len = strlen(path);
+    if (len == 0 || len >= MAX_PATH_LEN || !acquire(LOCK_EX)) return;
+    uint32_t hash = hash_path(path, len);
+    uint64_t offset = index_find(path, len, hash);
+    if (!offset) {
+        size_t bytes = record_bytes(len);
+        if (records_end() + bytes > db.map_size) {
+            size_t size = db.map_size * 2;
+            while (records_end() + bytes > size) size *= 2;
+            if (ftruncate(db.fd, size) < 0 || !remap(size)) {
+                unlock();
+                return;
+            }
+            db.map->size = size;
+        }
+        offset = records_end();
+        DirRecord* r = record_at(offset);
+        memset(r, 0, bytes);
+        add_pairs(r->pairs, path, len);
+        const char* tail = last_component(path, len);
+        r->tail = tail_signature(tail, path + len - tail);
+        r->hash = hash;
+        r->len = (uint16_t)len;
+        memcpy(r->path, path, len);
+        db.map->used += bytes;
+        db.map->count++;
+        sync_index();
+    }
+    DirRecord* r = record_at(offset);
+    r->rank += 1;
+    r->last_access = (uint32_t)time(NULL);
+    db.map->total_rank += 1;
+    if (db.map->total_rank > DIRDB_MAX_TOTAL_RANK) age_records();
+    unlock();
+}
+
+void dirdb_remove(const char* path) {
+    size_t len = strlen(path);
+    if (!acquire(LOCK_EX)) return;
+    uint64_t offset = index_find(path, len, hash_path(path, len));
+    if (offset) {
+        DirRecord* r = record_at(offset);
+        size_t bytes = record_bytes(r->len);
+        db.map->total_rank -= r->rank;
+        memmove(r, (char*)r + bytes, records_end() - offset - bytes);
+        db.map->used -= bytes;
+        db.map->count--;
+        db.map->generation++;
+    }
+    unlock();
+}
+
+/**
+ * @brief Folds the fragments to lower case and works out the signatures they need.
+ */
+static void prepare_query(DirQuery* q, char* const fragments[], int num_fragments) {
+    size_t used = 0;
+    q->count = 0;
+    q->pairs[0] = q->pairs[1] = 0;
+    for (int i = 0; i < num_fragments && q->count < DIRDB_MAX_FRAGMENTS; i++) {
+        size_t len = strlen(fragments[i]);
+        if (len == 0 || used + len + 1 > sizeof(q->text)) continue;
+        char* text = q->text + used;
+        for (size_t k = 0; k < len; k++) text[k] = fold(fragments[i][k]);
+        text[len] = '\0';
+        used += len + 1;
+        q->fragments[q->count] = text;
+        q->lengths[q->count++] = len;
+        add_pairs(q->pairs, text, len);
+    }
+    const char* last = q->count ? q->fragments[q->count - 1] : NULL;
+    q->tail = (last && !strchr(last, '/')) ? tail_signature(last, q->lengths[q->count - 1]) : 0;
+}
+
+/**
+ * @brief Finds the folded 'needle' in 'text[from, len)'.
+ * @return The offset just past the match, or 0 if there is none.
+ */
+static size_t find_folded(const char* text, size_t from, size_t len, const char* needle, size_t needle_len) {
+    unsigned char first = needle[0];
+    for (size_t i = from; i + needle_len <= len; i++) {
+        if (fold(text[i]) != first) continue;
+        size_t k = 1;
+        while (k < needle_len && fold(text[i + k]) == (unsigned char)needle[k]) k++;
+        if (k == needle_len) return i + needle_len;
+    }
+    return 0;
+}
+
+/**
+ * @brief The text comparison, for a record whose signatures passed.
+ */
+static bool record_matches(const DirRecord* r, const DirQuery* q) {
+    int last = q->count - 1;
+    size_t component = 0;
+    if (q->tail) {
+        // The last fragment must be in the last component, which is the shortest search.
+        component = last_component(r->path, r->len) - r->path;
+        if (!find_folded(r->path, component, r->len, q->fragments[last], q->lengths[last])) return false;
+    }
+    size_t pos = 0;
+    for (int i = 0; i < q->count; i++) {
+        if (i == last && component > pos) pos = component;
+        pos = find_folded(r->path, pos, r->len, q->fragments[i], q->lengths[i]);
+        if (!pos) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Calls 'fn' for each record matching the query (the database is locked).
+ */
+static void for_each_match(const DirQuery* q, void (*fn)(const DirRecord*, void*), void* context) {
+    const uint64_t* rows[DIRDB_ROWS];
+    int num_rows = 0;
+    for (int b = 0; b < DIRDB_PAIR_BITS; b++) {
+        if (q->pairs[b / 64] >> (b % 64) & 1) rows[num_rows++] = db.bits + b * db.words;
+    }
+    for (int b = 0; b < 64; b++) {
+        if (q->tail >> b & 1) rows[num_rows++] = db.bits + (DIRDB_PAIR_BITS + b) * db.words;
+    }
+    size_t num_words = (db.num_indexed + 63) / 64;
+    for (size_t w = 0; w < num_words; w++) {
+        uint64_t candidates = (w == num_words - 1 && db.num_indexed % 64) ? (1ull << (db.num_indexed % 64)) - 1 : ~0ull;
+        for (int i = 0; i < num_rows && candidates; i++) candidates &= rows[i][w];
+        while (candidates) {
+            size_t id = w * 64 + __builtin_ctzll(candidates);
+            candidates &= candidates - 1;
+            const DirRecord* r = record_at(db.offsets[id]);
+            if (record_matches(r, q)) fn(r, context);
+        }
+    }
+}
+
+/**
+ * @brief Weights a rank by the age of the last visit, as z does.
+ */
+static double frecency(const DirRecord* r, time_t now) {
+    time_t age = now - (time_t)r->last_access;
+    if (age < 3600) return r->rank * 4.0;
+    if (age < 86400) return r->rank * 2.0;
+    if (age < 7 * 86400) return r->rank * 0.5;
+    return r->rank * 0.25;
+}
+
+typedef struct {
+    time_t now;
+    const char* exclude;
+    size_t exclude_len;
+    const DirRecord* best;
+    double best_score;
+} BestSearch;
+
+static void consider_best(const DirRecord* r, void* context) {
+    BestSearch* search = context;
+    if (search->exclude && r->len == search->exclude_len && memcmp(r->path, search->exclude, r->len) == 0) return;
+    double score = frecency(r, search->now);
+    if (!search->best || score > search->best_score) {
+        search->best = r;
+        search->best_score = score;
+    }
+}
+
+bool dirdb_best(char* const fragments[], int num_fragments, const char* exclude, char* out, size_t out_size) {
+    DirQuery q;
+    prepare_query(&q, fragments, num_fragments);
+    if (!acquire(LOCK_SH)) return false;
+    BestSearch search = {time(NULL), exclude, exclude ? strlen(exclude) : 0, NULL, 0};
+    for_each_match(&q, consider_best, &search);
+    bool found = search.best && search.best->len < out_size;
+    if (found) memcpy(out, search.best->path, search.best->len + 1);
+    unlock();
+    return found;
+}
+
+typedef struct {
+    time_t now;
+    DirMatch* matches;
+    int count;
+    bool failed;
+} MatchList;
+
+static void add_match(const DirRecord* r, void* context) {
+    MatchList* list = context;
+    if (list->failed) return;
+    char* path = strndup(r->path, r->len);
+    if (!path) {
+        list->failed = true;
+        return;
+    }
+    list->matches[list->count].path = path;
+    list->matches[list->count++].score = frecency(r, list->now);
+}
+
+static int compare_matches(const void* a, const void* b) {
+    double sa = ((const DirMatch*)a)->score, sb = ((const DirMatch*)b)->score;
+    return (sa < sb) - (sa > sb);
+}
+
+int dirdb_list(char* const fragments[], int num_fragments, DirMatch** out) {
+    *out = NULL;
+    DirQuery q;
+    prepare_query(&q, fragments, num_fragments);
+    if (!acquire(LOCK_SH)) return 0;
+    MatchList list = {time(NULL), malloc((db.num_indexed + 1) * sizeof(DirMatch)), 0, false};
+    if (list.matches) for_each_match(&q, add_match, &list);
+    unlock();
+    if (!list.matches || list.failed) {
+        print_shell_perror("warp: malloc failed");
+        dirdb_free_matches(list.matches, list.count);
+        return -1;
+    }
+    qsort(list.matches, list.count, sizeof(DirMatch), compare_matches);
+    *out = list.matches;
+    return list.count;
+}
+
+void dirdb_free_matches(DirMatch* matches, int count) {
+    for (int i = 0; i < count; i++) free(matches[i].path);
+    free(matches);
+}
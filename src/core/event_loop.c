@@ -0,0 +1,76 @@
+#include "core/event_loop.h"
+#include "utils/error.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdbool.h>
+
+typedef struct {
+    int fd;
+    short events;
+    EventHandler handler;
+    void* data;
+} Watcher;
+
+static Watcher watchers[EVENT_LOOP_MAX_WATCHERS];
+static int num_watchers = 0;
+
+int event_loop_add(int fd, short events, EventHandler handler, void* data) {
+    if (num_watchers >= EVENT_LOOP_MAX_WATCHERS) {
+        print_shell_error("event loop: Too many watched descriptors.");
+        return -1;
+    }
+    watchers[num_watchers++] = (Watcher){fd, events, handler, data};
+    return 0;
+}
+
+void event_loop_remove(int fd) {
+    for (int i = 0; i < num_watchers; i++) {
+        if (watchers[i].fd == fd) {
+            watchers[i] = watchers[--num_watchers];
+            return;
+        }
+    }
+}
+
+int event_loop_run_once(int wait_fd, int timeout_ms) {
+    // Layout: [signalfd] [wait_fd] [watchers...]; slots that are unused hold fd -1,
+    // which poll() skips.
+    struct pollfd fds[2 + EVENT_LOOP_MAX_WATCHERS];
+    Watcher snapshot[EVENT_LOOP_MAX_WATCHERS];
+    int count = num_watchers;
+
+    fds[0] = (struct pollfd){signals_get_fd(), POLLIN, 0};
+    fds[1] = (struct pollfd){wait_fd, POLLIN, 0};
+    for (int i = 0; i < count; i++) {
+        snapshot[i] = watchers[i];
+        fds[2 + i] = (struct pollfd){watchers[i].fd, watchers[i].events, 0};
+    }
+    if (fds[0].fd < 0 && wait_fd < 0 && count == 0) {
+        return 0; // Nothing could ever wake us up
+    }
+
+    int ready = poll(fds, 2 + count, timeout_ms);
+    if (ready < 0) {
+        if (errno != EINTR) print_shell_perror("event loop: poll failed");
+        return 0;
+    }
+
+    int events = 0;
+    if (fds[0].revents & POLLIN) {
+        events |= signals_dispatch();
+    }
+    if (fds[1].revents) {
+        events |= EVENT_FD_READY;
+    }
+    for (int i = 0; i < count; i++) {
+        if (!fds[2 + i].revents) continue;
+        // A handler may have removed (or replaced) a later watcher; only run live ones.
+        bool live = false;
+        for (int j = 0; j < num_watchers && !live; j++) {
+            live = watchers[j].fd == snapshot[i].fd && watchers[j].handler == snapshot[i].handler;
+        }
+        if (live) snapshot[i].handler(snapshot[i].fd, fds[2 + i].revents, snapshot[i].data);
+    }
+    return events;
+}
@@ -1,346 +1,1338 @@
+#define _GNU_SOURCE
 #include "core/executor.h"
 #include "core/parser.h"
+#include "core/expand.h"
+#include "core/builtins.h"
+#include "core/jobs.h"
+#include "core/signals.h"
+#include "core/event_loop.h"
+#include "core/vars.h"
+#include "core/parse_cache.h"
+#include "core/redirect.h"
+#include "commands/limit.h"
+#include "commands/pin.h"
+#include "commands/timeout.h"
 #include "utils/error.h"
-#include "commands/warp.h"
-#include "commands/peek.h"
-#include "commands/proclore.h"
-#include "commands/seek.h"
-#include "commands/iman.h"
-#include "commands/activities.h"
-#include "commands/ping.h"
-#include "commands/neonate.h"
-#include "commands/fg_bg.h"
+#include "utils/strbuf.h"
+#include "utils/trace.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
-#include <sys/wait.h>
+#include <signal.h>
 #include <fcntl.h>
 #include <time.h>
+#include <sys/select.h>
+#include <sys/wait.h>
 #include <ctype.h>
+#include <errno.h>
+#include <spawn.h>
 
-// Forward declarations for internal functions
-static void execute_pipeline(SimpleCommand commands[], int num_commands, bool is_background, ShellState* state);
-static void check_background_processes(ShellState* state);
-static void execute_builtin_command(SimpleCommand* cmd, ShellState* state);
-static bool is_builtin_command(const char* cmd_name);
+#define PASTEVENTS_EXECUTE "pastevents execute"
+#define CAPTURE_READ_CHUNK 4096
+#define FUNCTION_MAX_DEPTH 1000 ///< Nested calls allowed before a runaway recursion is stopped
 
-// This is the main entry point from the main loop
-void process_input_line(char* input_line, ShellState* state) {
-    check_background_processes(state);
+/**
+ * @brief Checks that a command's argv plus the environment fits the kernel's ARG_MAX.
+ *
+ * This reports "Argument list too long" up front instead of letting every
+ * stage of the pipeline fork only to fail in execvp. The environment's size is
+ * kept with the cached envp, so only the arguments are measured here.
+ */
+static bool check_arg_max(const SimpleCommand* cmd, const VarStore* vars) {
+    static long arg_max = 0;
+    if (arg_max == 0) {
+        arg_max = sysconf(_SC_ARG_MAX);
+        if (arg_max <= 0) arg_max = -1; // Unknown: don't check
+    }
+    if (arg_max < 0) return true;
 
-    char original_input_for_history[MAX_INPUT_LEN];
-    strncpy(original_input_for_history, input_line, sizeof(original_input_for_history) - 1);
-    original_input_for_history[sizeof(original_input_for_history) - 1] = '\0';
+    long total = (long)vars->envp_bytes;
+    for (int k = 0; k < cmd->argc; k++) total += strlen(cmd->args[k]) + 1 + sizeof(char*);
+    for (int k = 0; k < cmd->num_assigns; k++) total += strlen(cmd->assigns[k]) + 1 + sizeof(char*);
+    if (total > arg_max) {
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "%s: Argument list too long (%ld bytes, ARG_MAX is %ld)\n",
+                cmd->args[0], total, arg_max);
+        return false;
+    }
+    return true;
+}
 
-    bool add_original_to_history = true;
+static int execute_node(const Node* node, ShellState* state);
+static int run_compound(const Node* node, ShellState* state);
 
-    char* sc_saveptr;
-    char* current_sc_command_str = strtok_r(input_line, ";", &sc_saveptr);
+/**
+ * @brief True for the commands that hold a list: groups, if, while, until and for.
+ */
+static bool is_compound(const Node* node) {
+    switch (node->type) {
+    case NODE_GROUP:
+    case NODE_IF:
+    case NODE_WHILE:
+    case NODE_UNTIL:
+    case NODE_FOR:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Replaces every 'pastevents execute <n>' at the start of a command with
+ *        history entry n, before the line is parsed. Quoted or escaped text and
+ *        here-document bodies are copied as they are, so
+ *        "echo 'a; pastevents execute 1'" prints its argument.
+ * @param out Set to the rewritten line (caller frees) if anything was replaced.
+ * @return 1 if something was replaced, 0 if not, -1 on error (already reported).
+ */
+/**
+ * @brief Reads the word after '<<' at p as a here-document delimiter, with its quotes removed.
+ * @return A pointer past the word.
+ */
+static const char* scan_heredoc_delimiter(const char* p, StrBuf* delimiter) {
+    char quote = '\0';
+    while (*p && (quote || (!isspace((unsigned char)*p) && !strchr(";&|<>(){}", *p)))) {
+        char c = *p++;
+        if (c == '\\' && quote != '\'' && *p) {
+            strbuf_putc(delimiter, *p++);
+        } else if (quote ? c == quote : (c == '\'' || c == '"')) {
+            quote = quote ? '\0' : c;
+        } else {
+            strbuf_putc(delimiter, c);
+        }
+    }
+    return p;
+}
+
+/**
+ * @brief Copies here-document bodies from p to out unchanged, through each one's delimiter line.
+ * @return A pointer past the last line copied.
+ */
+static const char* copy_heredoc_bodies(const char* p, const HeredocEnd* ends, int num_ends, StrBuf* out) {
+    for (int i = 0; i < num_ends && *p; i++) {
+        bool ended = false;
+        while (*p && !ended) {
+            const char* line = p;
+            size_t len = strcspn(line, "\n");
+            p = line[len] ? line + len + 1 : line + len;
+            strbuf_append(out, line, (size_t)(p - line));
+            ended = heredoc_end_matches(&ends[i], line, len);
+        }
+    }
+    return p;
+}
 
-    while (current_sc_command_str != NULL) {
-        char command_to_process[MAX_COMMAND_LEN];
-        strncpy(command_to_process, current_sc_command_str, sizeof(command_to_process) - 1);
-        command_to_process[sizeof(command_to_process) - 1] = '\0';
+static int substitute_pastevents(const char* line, const ShellState* state, char** out) {
+    *out = NULL;
+    if (!strstr(line, PASTEVENTS_EXECUTE)) return 0;
 
-        // Trim whitespace
-        char* trimmed_cmd = command_to_process;
-        while (isspace((unsigned char)*trimmed_cmd)) trimmed_cmd++;
-        if (*trimmed_cmd == '\0') {
-            current_sc_command_str = strtok_r(NULL, ";", &sc_saveptr);
+    StrBuf result;
+    strbuf_init(&result);
+    const char* p = line;
+    bool at_command_start = true;
+    char quote = '\0'; // The quote character of the quoted text the scan is in, if any
+    HeredocEnd* ends = NULL; // Here-documents whose bodies start on the next line
+    int num_ends = 0;
+    int replaced = 0;
+    while (*p) {
+        if (!quote && at_command_start && strncmp(p, PASTEVENTS_EXECUTE, strlen(PASTEVENTS_EXECUTE)) == 0) {
+            const char* num = p + strlen(PASTEVENTS_EXECUTE);
+            while (*num == ' ' || *num == '\t') num++;
+            if (!isdigit((unsigned char)*num)) {
+                print_shell_error("pastevents execute: Number not provided.");
+                heredoc_ends_free(ends, num_ends);
+                strbuf_free(&result);
+                return -1;
+            }
+            char* hist_cmd = get_kth_history_element(state->history_queue, atoi(num));
+            if (!hist_cmd) { // Error already printed
+                heredoc_ends_free(ends, num_ends);
+                strbuf_free(&result);
+                return -1;
+            }
+            strbuf_append_str(&result, hist_cmd);
+            while (isdigit((unsigned char)*num)) num++;
+            if (strchr(hist_cmd, '\n')) {
+                // A here-document's delimiter must stay alone on its line: what followed goes on the next.
+                while (*num == ' ' || *num == '\t') num++;
+                if (*num == ';') num++;
+                while (*num == ' ' || *num == '\t') num++;
+                strbuf_putc(&result, '\n');
+            }
+            free(hist_cmd);
+            p = num;
+            at_command_start = false;
+            replaced = 1;
             continue;
         }
-        char* end = trimmed_cmd + strlen(trimmed_cmd) - 1;
-        while (end > trimmed_cmd && isspace((unsigned char)*end)) end--;
-        *(end + 1) = '\0';
-
-        // Handle 'pastevents execute' before any other parsing
-        if (strncmp(trimmed_cmd, "pastevents execute", 18) == 0) {
-            char temp_cmd[MAX_COMMAND_LEN];
-            strcpy(temp_cmd, trimmed_cmd);
-            char* pe_saveptr;
-            strtok_r(temp_cmd, " \t", &pe_saveptr); // "pastevents"
-            strtok_r(NULL, " \t", &pe_saveptr);   // "execute"
-            char* num_str = strtok_r(NULL, " \t", &pe_saveptr);
-            if (num_str) {
-                int k = atoi(num_str);
-                char* hist_cmd = get_kth_history_element(state->history_queue, k);
-                if (hist_cmd) {
-                    strcpy(trimmed_cmd, hist_cmd); // Overwrite with command from history
-                    add_history_element(state->history_queue, hist_cmd);
-                    add_original_to_history = false;
-                    free(hist_cmd);
-                } else {
-                    current_sc_command_str = strtok_r(NULL, ";", &sc_saveptr);
-                    continue; // Skip this invalid command
-                }
+        if (!quote && strncmp(p, "<<", 2) == 0 && p[2] != '<') {
+            const char* word = p + 2;
+            bool strip_tabs = *word == '-';
+            if (strip_tabs) word++;
+            while (*word == ' ' || *word == '\t') word++;
+            StrBuf delimiter;
+            strbuf_init(&delimiter);
+            scan_heredoc_delimiter(word, &delimiter);
+            HeredocEnd* grown = realloc(ends, sizeof(HeredocEnd) * (num_ends + 1));
+            char* text = strbuf_detach(&delimiter);
+            if (grown && text) {
+                ends = grown;
+                ends[num_ends++] = (HeredocEnd){text, strip_tabs};
             } else {
-                print_shell_error("pastevents execute: Number not provided.");
-                current_sc_command_str = strtok_r(NULL, ";", &sc_saveptr);
-                continue;
+                if (grown) ends = grown;
+                free(text);
             }
+            strbuf_append(&result, p, (size_t)(word - p)); // The word itself is scanned as usual
+            p = word;
+            at_command_start = false;
+            continue;
+        }
+        char c = *p++;
+        strbuf_putc(&result, c);
+        if (c == '\n' && !quote && num_ends > 0) { // A body is text, never a command
+            p = copy_heredoc_bodies(p, ends, num_ends, &result);
+            heredoc_ends_free(ends, num_ends);
+            ends = NULL;
+            num_ends = 0;
+            at_command_start = true;
+        } else if (c == '\\' && quote != '\'' && *p) { // The escaped character is never special
+            strbuf_putc(&result, *p++);
+            at_command_start = false;
+        } else if (quote) {
+            if (c == quote) quote = '\0';
+        } else if (c == '\'' || c == '"') {
+            quote = c;
+            at_command_start = false;
+        } else if (strchr(";&|{\n", c)) {
+            at_command_start = true;
+        } else if (!isspace((unsigned char)c)) {
+            at_command_start = false;
         }
+    }
+    heredoc_ends_free(ends, num_ends);
+    if (!replaced) {
+        strbuf_free(&result);
+        return 0;
+    }
+    *out = strbuf_detach(&result);
+    return 1;
+}
+
+/**
+ * @brief True if text[0..end) ends with a reserved word that the next line
+ *        continues, such as 'then' or 'do', written where a command could start.
+ */
+static bool ends_with_opening_word(const char* text, size_t end) {
+    static const char* const opening[] = {"if", "then", "elif", "else", "while", "until", "do", NULL};
+    size_t start = end;
+    while (start > 0 && !isspace((unsigned char)text[start - 1]) && !strchr(";&|{", text[start - 1])) start--;
+    size_t before = start;
+    while (before > 0 && isspace((unsigned char)text[before - 1])) before--;
+    if (before > 0 && !strchr(";&|{", text[before - 1])) return false; // An argument, as in 'echo do'
+    for (int i = 0; opening[i]; i++) {
+        if (end - start == strlen(opening[i]) && strncmp(text + start, opening[i], end - start) == 0) return true;
+    }
+    return false;
+}
 
-        long start_time = time(NULL);
+/**
+ * @brief Joins the lines of a multi-line command into one history entry.
+ *
+ * A line break after an operator or reserved word that continues the command
+ * becomes a space, any other one becomes "; ". A command that may hold a
+ * here-document keeps its lines: joined, a body would lose its delimiter line,
+ * and recalling it would read every later line into the body.
+ */
+static char* history_text(const char* text) {
+    StrBuf out;
+    strbuf_init(&out);
+    if (strstr(text, "<<")) {
+        size_t len = strlen(text);
+        while (len > 0 && text[len - 1] == '\n') len--;
+        strbuf_append(&out, text, len);
+        return strbuf_detach(&out);
+    }
+    for (const char* p = text; *p; p++) {
+        if (*p != '\n') {
+            strbuf_putc(&out, *p);
+            continue;
+        }
+        size_t end = out.len;
+        while (end > 0 && isspace((unsigned char)out.data[end - 1])) end--;
+        if (end == 0 || p[1] == '\0') continue;
+        bool continues = strchr("|&{;", out.data[end - 1]) || ends_with_opening_word(out.data, end);
+        strbuf_append_str(&out, continues ? " " : "; ");
+    }
+    return strbuf_detach(&out);
+}
 
-        SimpleCommand commands[MAX_ARGS];
-        bool is_background = false;
-        int num_commands = parse_pipeline(trimmed_cmd, commands, MAX_ARGS, &is_background);
+/**
+ * @brief process_input_line(), which also reports the here-document bodies
+ *        incomplete text ends inside of, when 'open' is not NULL.
+ */
+static bool run_input(const char* input_line, ShellState* state, HeredocEnd** open, int* num_open) {
+    TRACE_BEGIN(line_start);
+    reap_background_jobs(state);
+    state->interrupted = false;
 
-        if (num_commands > 0) {
-            // Set command name for prompt
-            strncpy(state->last_command_name, commands[0].args[0], MAX_COMMAND_LEN - 1);
-            state->last_command_name[MAX_COMMAND_LEN - 1] = '\0';
+    char* substituted = NULL;
+    if (substitute_pastevents(input_line, state, &substituted) < 0) {
+        state->last_exit_status = 1;
+        TRACE_END(TRACE_INPUT, line_start);
+        return true;
+    }
+    const char* text = substituted ? substituted : input_line;
 
-            if (num_commands == 1 && is_builtin_command(commands[0].args[0])) {
-                execute_builtin_command(&commands[0], state);
-            } else {
-                execute_pipeline(commands, num_commands, is_background, state);
-            }
-            free_simple_commands(commands, num_commands);
-        } else if (num_commands == -1) {
-            // Parsing error already printed by parser
-        }
+    Node* tree = NULL;
+    ParseStatus status = parse_cached(text, &tree);
+    if (status == PARSE_INCOMPLETE) {
+        // Incomplete text is not cached, so only a here-document makes it worth parsing twice.
+        if (open && strstr(text, "<<")) parse_program_open(text, &tree, open, num_open);
+        free(substituted);
+        TRACE_END(TRACE_INPUT, line_start);
+        return false; // The caller reads another line and tries again
+    }
 
-        state->time_taken_for_prompt = time(NULL) - start_time;
-        current_sc_command_str = strtok_r(NULL, ";", &sc_saveptr);
+    // The history keeps what was run: a recalled command replaces 'pastevents execute'.
+    if (state->interactive) {
+        char* entry = history_text(text);
+        if (entry) add_history_element(state->history_queue, entry);
+        free(entry);
     }
 
-    if (add_original_to_history && strlen(original_input_for_history) > 0) {
-        add_history_element(state->history_queue, original_input_for_history);
+    if (status == PARSE_ERROR) {
+        state->last_exit_status = 2;
+    } else if (tree) {
+        execute_node(tree, state);
     }
+    node_free(tree);
+    free(substituted);
+    TRACE_END(TRACE_INPUT, line_start);
+    return true;
 }
 
-static bool is_builtin_command(const char* cmd_name) {
-    if (!cmd_name) return false;
-    const char* builtins[] = {"q", "quit", "exit", "warp", "peek", "pastevents", "proclore", "seek", "iman", "activities", "ping", "neonate", "fg", "bg", NULL};
-    for (int i = 0; builtins[i] != NULL; i++) {
-        if (strcmp(cmd_name, builtins[i]) == 0) {
-            return true;
-        }
+// This is the main entry point from the main loop
+bool process_input_line(const char* input_line, ShellState* state) {
+    return run_input(input_line, state, NULL, NULL);
+}
+
+void pending_command_init(PendingCommand* pending) {
+    memset(pending, 0, sizeof(*pending));
+    strbuf_init(&pending->text);
+}
+
+bool pending_command_add(PendingCommand* pending, const char* line, size_t len, ShellState* state) {
+    if (pending->text.len > 0) strbuf_putc(&pending->text, '\n');
+    strbuf_append(&pending->text, line, len);
+    if (pending->heredoc < pending->num_heredocs) {
+        // Nothing before the delimiter line can change how the text parses.
+        if (!heredoc_end_matches(&pending->heredocs[pending->heredoc], line, len)) return false;
+        if (++pending->heredoc < pending->num_heredocs) return false;
     }
-    return false;
+    heredoc_ends_free(pending->heredocs, pending->num_heredocs);
+    pending->heredocs = NULL;
+    pending->num_heredocs = pending->heredoc = 0;
+    if (!run_input(pending->text.data, state, &pending->heredocs, &pending->num_heredocs)) return false;
+    strbuf_reset(&pending->text);
+    return true;
 }
 
-static void execute_builtin_command(SimpleCommand* cmd, ShellState* state) {
-    int argc = 0;
-    while(cmd->args[argc] != NULL) argc++;
-    char* cmd_name = cmd->args[0];
+void pending_command_reset(PendingCommand* pending) {
+    heredoc_ends_free(pending->heredocs, pending->num_heredocs);
+    pending->heredocs = NULL;
+    pending->num_heredocs = pending->heredoc = 0;
+    strbuf_reset(&pending->text);
+}
 
-    if (strcmp(cmd_name, "q") == 0 || strcmp(cmd_name, "quit") == 0 || strcmp(cmd_name, "exit") == 0) {
-        state->is_running = false;
-    } else if (strcmp(cmd_name, "warp") == 0) {
-        if (argc < 2) {
-            char* result = warp("~", state->home_dir, state->prev_dir);
-            if (result) { strncpy(state->prev_dir, result, sizeof(state->prev_dir) - 1); free(result); }
-        } else {
-            for (int j = 1; j < argc; j++) {
-                char* result = warp(cmd->args[j], state->home_dir, state->prev_dir);
-                if (result) { strncpy(state->prev_dir, result, sizeof(state->prev_dir) - 1); free(result); }
-            }
-        }
-    } else if (strcmp(cmd_name, "peek") == 0) {
-        bool l = false, a = false; char* path = NULL;
-        for(int i=1; i<argc; ++i) {
-            if(cmd->args[i][0] == '-') for(size_t j=1; j<strlen(cmd->args[i]); ++j) { if(cmd->args[i][j]=='l') l=true; else if(cmd->args[i][j]=='a') a=true; }
-            else path = cmd->args[i];
-        }
-        peek_execute(path, state->home_dir, l, a);
-    } else if (strcmp(cmd_name, "pastevents") == 0) {
-        if (argc == 1) display_history(state->history_queue);
-        else if (argc == 2 && strcmp(cmd->args[1], "purge") == 0) {
-            purge_history(state->history_queue);
-            write_history_to_file(state->history_queue, state->home_dir);
-        } else print_shell_error("pastevents: Invalid arguments.");
-    } else if (strcmp(cmd_name, "proclore") == 0) {
-        proclore_execute(argc > 1 ? atoi(cmd->args[1]) : getpid(), state->home_dir);
-    } else if (strcmp(cmd_name, "seek") == 0) {
-        bool d=false, f=false, e=false; char* name=NULL; char* dir="."; int i=1;
-        while(i < argc && cmd->args[i][0] == '-') {
-            for(size_t j=1; j<strlen(cmd->args[i]); ++j) { if(cmd->args[i][j]=='d') d=true; else if(cmd->args[i][j]=='f') f=true; else if(cmd->args[i][j]=='e') e=true; }
-            i++;
-        }
-        if(i < argc) name = cmd->args[i++];
-        if(i < argc) dir = cmd->args[i];
-        if(!name) { print_shell_error("seek: Target name not specified."); return; }
-        if(d && f) { print_shell_error("seek: Flags -d and -f are mutually exclusive."); return; }
-        seek_execute(name, dir, state->home_dir, state->prev_dir, d, f, e);
-    } else if (strcmp(cmd_name, "iman") == 0) {
-        if (argc != 2) {
-            print_shell_error("Usage: iman <command_name>");
-        } else {
-            iman_execute(cmd->args[1]);
-        }
-    } else if (strcmp(cmd_name, "activities") == 0) {
-        if (argc != 1) {
-            print_shell_error("Usage: activities (takes no arguments)");
-        } else {
-            activities_execute(state);
+void pending_command_free(PendingCommand* pending) {
+    pending_command_reset(pending);
+    strbuf_free(&pending->text);
+}
+
+/**
+ * @brief Records how long a command took, for the prompt (the slowest command of the line wins).
+ */
+static void note_command_time(ShellState* state, const char* name, long elapsed) {
+    if (elapsed <= state->time_taken_for_prompt) return;
+    strncpy(state->last_command_name, name, MAX_COMMAND_LEN - 1);
+    state->last_command_name[MAX_COMMAND_LEN - 1] = '\0';
+    state->time_taken_for_prompt = elapsed;
+}
+
+/**
+ * @brief A display name for a job: its first command word as written.
+ */
+static const char* node_display_name(const Node* node) {
+    while (node) {
+        switch (node->type) {
+        case NODE_IF:    return "if";
+        case NODE_WHILE: return "while";
+        case NODE_UNTIL: return "until";
+        case NODE_FOR:   return "for";
+        default:         break;
         }
-    } else if (strcmp(cmd_name, "ping") == 0) {
-        if (argc != 3) {
-            print_shell_error("Usage: ping <pid> <signal_number>");
-        } else {
-            pid_t target_pid = atoi(cmd->args[1]);
-            int signal_num = atoi(cmd->args[2]);
-            ping_execute(target_pid, signal_num);
+        if (node->type == NODE_COMMAND) {
+            const Word* word = &node->words[0];
+            return word->parts[0].type == PART_LITERAL ? word->parts[0].text : "$";
         }
-    } else if (strcmp(cmd_name, "neonate") == 0) {
-        if (argc != 3 || strcmp(cmd->args[1], "-n") != 0) {
-            print_shell_error("Usage: neonate -n <time_in_seconds>");
-        } else {
-            int time_arg = atoi(cmd->args[2]);
-            if (time_arg <= 0) {
-                print_shell_error("neonate: time argument must be a positive integer.");
+        node = (node->type == NODE_PIPELINE) ? node->stages[0] : node->left;
+    }
+    return "?";
+}
+
+/// Shell ends of the process substitution pipes open in this process (those below FD_SETSIZE).
+static fd_set open_substitutions;
+
+/**
+ * @brief Prepares a forked child to run shell code (a group, or a builtin in a
+ *        pipeline): it must not manage the parent's jobs or the terminal.
+ * @param own The command the child runs, whose substitution pipes it keeps; NULL for none.
+ */
+static void enter_subshell(ShellState* state, const SimpleCommand* own) {
+    state->job_control = false;
+    // Close-on-exec does not help shell code, which never execs. Any other command's
+    // pipe left open here would keep the process at its far end from seeing EOF or EPIPE.
+    for (int fd = 0; fd < FD_SETSIZE; fd++) {
+        if (!FD_ISSET(fd, &open_substitutions)) continue;
+        bool owned = false;
+        for (int k = 0; own && k < own->num_subst_fds && !owned; k++) owned = (own->subst_fds[k] == fd);
+        if (!owned) close_process_substitution(fd);
+    }
+    // The parent drains its jobs' captured output; anything read here would be lost to it.
+    // What was already captured stays readable, for 'jobout ... | grep'.
+    for (int i = 0; i < state->jobs.count; i++) {
+        if (state->jobs.jobs[i]->output) job_output_close(state->jobs.jobs[i]->output);
+        if (state->jobs.jobs[i]->timer) job_timer_close(state->jobs.jobs[i]->timer); // Nor are their deadlines ours
+    }
+    for (int i = 0; i < state->finished.count; i++) job_output_close(state->finished.jobs[i]->output);
+    state->jobs.count = 0; // The parent's jobs; not ours to reap or kill
+    state->substitutions.count = 0;
+    state->foreground_pgid = -1;
+    state->interactive = false;
+}
+
+/**
+ * @brief The body of the function named 'name', or NULL if there is none.
+ */
+static Node* function_lookup(const ShellState* state, const char* name) {
+    return strmap_get(&state->functions, name);
+}
+
+/**
+ * @brief True if 'name' runs as shell code (a function or builtin) rather than a program.
+ */
+static bool is_shell_command(const ShellState* state, const char* name) {
+    return function_lookup(state, name) || builtin_lookup(name);
+}
+
+/**
+ * @brief Runs a function body with the command's arguments as $1, $2, ...
+ *
+ * The body is the tree parsed when the function was defined; nothing is
+ * parsed again. $0 stays the shell's (or script's) name.
+ */
+static int call_function(Node* body, SimpleCommand* cmd, ShellState* state) {
+    if (state->function_depth >= FUNCTION_MAX_DEPTH) {
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "%s: maximum function nesting level (%d) exceeded\n",
+                cmd->args[0], FUNCTION_MAX_DEPTH);
+        return 1;
+    }
+    // Keep the body alive even if the function redefines or unsets itself.
+    node_retain(body);
+    char** saved_positional = state->positional;
+    int saved_num_positional = state->num_positional;
+    char* name = cmd->args[0];
+    cmd->args[0] = saved_positional[0];
+    state->positional = cmd->args;
+    state->num_positional = cmd->argc;
+    state->function_depth++;
+    // 'break' inside the function does not reach loops in the caller.
+    int saved_loop_depth = state->loop_depth;
+    state->loop_depth = 0;
+
+    int status = execute_node(body, state);
+    if (state->flow == FLOW_RETURN) state->flow = FLOW_NORMAL;
+
+    state->loop_depth = saved_loop_depth;
+    state->function_depth--;
+    state->positional = saved_positional;
+    state->num_positional = saved_num_positional;
+    cmd->args[0] = name;
+    node_free(body);
+    return status;
+}
+
+/**
+ * @brief Runs one pipeline stage in a forked child. Never returns.
+ */
+static void run_stage_in_child(const Node* stage, SimpleCommand* cmd, ShellState* state) {
+    if (stage->type == NODE_COMMAND) {
+        Node* function = function_lookup(state, cmd->args[0]);
+        const Builtin* builtin = function ? NULL : builtin_lookup(cmd->args[0]);
+        if (!function && !builtin) {
+            if (cmd->num_assigns > 0) {
+                // VAR=x cmd: the overrides go in front of the cached environment; nothing else is copied.
+                char** envp = vars_layer_envp(&state->vars, cmd->assigns, cmd->num_assigns);
+                if (envp) environ = envp;
+            }
+            execvp(cmd->args[0], cmd->args);
+            int not_found = (errno == ENOENT);
+            if (not_found) {
+                fprintf(stderr, _RED_ "Shell Error: Command '%s' not found" _RESET_ "\n", cmd->args[0]);
             } else {
-                neonate_execute(time_arg);
+                print_shell_perror(cmd->args[0]);
             }
+            // Conventional shell statuses. _exit skips stdio cleanup, which would otherwise
+            // rewind a script file whose offset the child shares with the shell.
+            _exit(not_found ? 127 : 126);
         }
-    } else if (strcmp(cmd_name, "bg") == 0) {
-        if (argc != 2) {
-            print_shell_error("Usage: bg <pid>");
-        } else {
-            pid_t target_pid = atoi(cmd->args[1]);
-            bg_execute(target_pid, state);
+        enter_subshell(state, cmd);
+        for (int k = 0; k < cmd->num_assigns; k++) vars_assign(&state->vars, cmd->assigns[k], true);
+        vars_apply_environ(&state->vars);
+        int status = function ? call_function(function, cmd, state) : builtin->func(cmd->argc, cmd->args, state);
+        fflush(stdout);
+        _exit(status);
+    }
+    enter_subshell(state, cmd);
+    // A compound command's redirections were applied along with the pipes.
+    int status = is_compound(stage) ? run_compound(stage, state) : execute_node(stage, state);
+    fflush(stdout);
+    _exit(status);
+}
+
+/**
+ * @brief Where a pipeline's ends are connected, and whether it is a job of its own.
+ */
+typedef struct {
+    int in_fd;        ///< stdin of the first stage (STDIN_FILENO to inherit)
+    int out_fd;       ///< stdout of the last stage (STDOUT_FILENO to inherit)
+    int err_fd;       ///< stderr of every stage (STDERR_FILENO to inherit)
+    bool job_control; ///< Put the pipeline in its own process group
+    bool foreground;  ///< With job_control: give it the terminal
+    const Cgroup* cgroup; ///< Start every stage inside this cgroup ('limit'), or NULL
+    const Placement* placement; ///< CPUs, nice value and I/O class for every stage ('pin'), or NULL
+} SpawnOptions;
+
+/**
+ * @brief Starts an external command with posix_spawn. In glibc the new process
+ *        shares the shell's memory until exec instead of copying its page tables,
+ *        which is much cheaper than fork for a large shell.
+ *
+ * The file actions repeat what the forked child in spawn_pipeline() does, in
+ * the same order: terminal handover, pipes, then the command's redirections.
+ *
+ * @param out_pipe The pipe to the next stage, or NULL for the last stage.
+ * @param pgid The pipeline's process group, or 0 to start one (used with job control).
+ * @return The PID, or -1 if the command could not be started this way; fork
+ *         then runs it, and reports the error if there is one.
+ */
+static pid_t spawn_external(SimpleCommand* cmd, int input_fd, const int* out_pipe, pid_t pgid,
+                            const SpawnOptions* opts, ShellState* state) {
+    posix_spawn_file_actions_t file_actions;
+    posix_spawnattr_t attr;
+    if (posix_spawn_file_actions_init(&file_actions) != 0) return -1;
+    if (posix_spawnattr_init(&attr) != 0) {
+        posix_spawn_file_actions_destroy(&file_actions);
+        return -1;
+    }
+
+    sigset_t defaults, mask;
+    signals_child_defaults(&defaults, &mask);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    short flags = POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK;
+    int error = 0;
+    if (opts->job_control) {
+        flags |= POSIX_SPAWN_SETPGROUP;
+        posix_spawnattr_setpgroup(&attr, pgid);
+        if (opts->foreground) error = posix_spawn_file_actions_addtcsetpgrp_np(&file_actions, STDIN_FILENO);
+    }
+    posix_spawnattr_setflags(&attr, flags);
+
+    if (!error && input_fd != STDIN_FILENO) {
+        error = posix_spawn_file_actions_adddup2(&file_actions, input_fd, STDIN_FILENO);
+        if (!error) error = posix_spawn_file_actions_addclose(&file_actions, input_fd);
+    }
+    if (!error && out_pipe) {
+        error = posix_spawn_file_actions_adddup2(&file_actions, out_pipe[1], STDOUT_FILENO);
+        if (!error) error = posix_spawn_file_actions_addclose(&file_actions, out_pipe[0]);
+        if (!error) error = posix_spawn_file_actions_addclose(&file_actions, out_pipe[1]);
+    } else if (!error && opts->out_fd != STDOUT_FILENO) {
+        error = posix_spawn_file_actions_adddup2(&file_actions, opts->out_fd, STDOUT_FILENO);
+    }
+    if (!error && opts->err_fd != STDERR_FILENO) {
+        error = posix_spawn_file_actions_adddup2(&file_actions, opts->err_fd, STDERR_FILENO);
+    }
+    if (!error) error = redirects_add_file_actions(&cmd->redirects, &file_actions);
+    // dup2 onto itself clears close-on-exec, so this command's process substitution pipes survive.
+    for (int k = 0; !error && k < cmd->num_subst_fds; k++) {
+        error = posix_spawn_file_actions_adddup2(&file_actions, cmd->subst_fds[k], cmd->subst_fds[k]);
+    }
+
+    char** envp = environ;
+    char** layered = NULL;
+    if (!error && cmd->num_assigns > 0) {
+        layered = vars_layer_envp(&state->vars, cmd->assigns, cmd->num_assigns);
+        if (layered) envp = layered;
+        else error = ENOMEM;
+    }
+
+    pid_t pid = -1;
+    if (!error) {
+        TRACE_BEGIN(spawn_start);
+        error = posix_spawnp(&pid, cmd->args[0], &file_actions, &attr, cmd->args, envp);
+        TRACE_END(TRACE_FORK, spawn_start);
+        if (error) pid = -1;
+    }
+    free(layered);
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&file_actions);
+    return pid;
+}
+
+/**
+ * @brief Expands the command stages of a pipeline in the parent, so expansion
+ *        errors stop the job before anything forks.
+ * @param first If not NULL, stage 0 already expanded; it is moved into commands[0].
+ * @return True on success, false on error (already reported).
+ */
+static bool expand_stages(Node* const* stages, int num_commands, SimpleCommand* commands,
+                          SimpleCommand* first, ShellState* state) {
+    for (int i = 0; i < num_commands; i++) {
+        if (is_compound(stages[i])) {
+            // The child applies a compound command's redirections before running its body.
+            if (!expand_redirects(stages[i], state, &commands[i])) return false;
+            continue;
         }
-    } else if (strcmp(cmd_name, "fg") == 0) {
-        if (argc != 2) {
-            print_shell_error("Usage: fg <pid>");
-        } else {
-            pid_t target_pid = atoi(cmd->args[1]);
-            fg_execute(target_pid, state);
+        if (stages[i]->type != NODE_COMMAND) continue;
+        if (i == 0 && first) {
+            commands[0] = *first;
+            memset(first, 0, sizeof(*first));
+        } else if (!expand_command(stages[i], state, &commands[i])) {
+            return false;
+        }
+        if (commands[i].argc == 0) { // Every word expanded to nothing
+            commands[i].args = calloc(2, sizeof(char*));
+            if (!commands[i].args) return false;
+            commands[i].args[0] = strdup("true");
+            if (!commands[i].args[0]) return false;
+            commands[i].argc = 1;
         }
+        if (!is_shell_command(state, commands[i].args[0]) && !check_arg_max(&commands[i], &state->vars)) return false;
     }
+    return true;
 }
 
-static void execute_pipeline(SimpleCommand commands[], int num_commands, bool is_background, ShellState* state) {
-    int input_fd = STDIN_FILENO;
+/**
+ * @brief Forks every stage of a pipeline and connects them. Does not wait.
+ *
+ * This is the one place the shell creates processes: foreground and background
+ * jobs, command substitutions and process substitutions all come through here.
+ *
+ * @param stages The stages; command stages must already be expanded into 'commands'.
+ * @return The job, or NULL on failure (already reported; nothing is left running).
+ */
+static Job* spawn_pipeline(Node* const* stages, SimpleCommand* commands, int num_commands,
+                           const char* job_name, const SpawnOptions* opts, ShellState* state) {
+    int input_fd = opts->in_fd;
     int pipe_fds[2];
-    pid_t pids[num_commands];
     pid_t pgid = 0; // The process group ID for this pipeline
+    pid_t* pids = malloc(sizeof(pid_t) * num_commands);
+    if (!pids) {
+        print_shell_perror("execute: malloc for pipeline failed");
+        return NULL;
+    }
+
+    // Children inherit environ; it only needs rebuilding if an exported variable changed.
+    vars_apply_environ(&state->vars);
+    // Anything still buffered would otherwise be written again by each child.
+    fflush(stdout);
+    fflush(stderr);
 
+    int spawned = 0;
     for (int i = 0; i < num_commands; i++) {
         if (i < num_commands - 1) {
-            if (pipe(pipe_fds) < 0) { print_shell_perror("pipe failed"); return; }
+            if (pipe(pipe_fds) < 0) { print_shell_perror("pipe failed"); break; }
         }
-        pids[i] = fork();
-        if (pids[i] < 0) { print_shell_perror("fork failed"); return; }
-
-        if (pids[i] == 0) { // --- Child Process ---
-            // Set the process group ID. The first child sets it for the whole pipeline.
-            pgid = (i == 0) ? getpid() : pgid;
-            setpgid(0, pgid);
-
-            if (!is_background) {
-                // If it's a foreground job, it needs terminal control.
-                tcsetpgrp(STDIN_FILENO, pgid);
-            }
-            // A child process should not ignore signals. Reset to default handlers.
-            signal(SIGINT, SIG_DFL);
-            signal(SIGTSTP, SIG_DFL);
-
-            // --- I/O Redirection Logic (unchanged) ---
-            if (i > 0) { dup2(input_fd, STDIN_FILENO); close(input_fd); }
-            if (commands[i].input_file) {
-                int in_fd = open(commands[i].input_file, O_RDONLY);
-                if (in_fd < 0) { print_shell_perror(commands[i].input_file); exit(EXIT_FAILURE); }
-                dup2(in_fd, STDIN_FILENO); close(in_fd);
+        // Here-document text is made readable before the process starts; it only has to dup2 it.
+        if (!redirects_prepare(&commands[i].redirects)) {
+            if (i < num_commands - 1) { close(pipe_fds[0]); close(pipe_fds[1]); }
+            break;
+        }
+        // External commands are started with posix_spawn. If it fails, fork takes over:
+        // the forked child reports the error, or manages what posix_spawn could not.
+        pids[i] = -1;
+        // posix_spawn can neither start a process in a cgroup nor set its placement; those are forked.
+        if (stages[i]->type == NODE_COMMAND && !opts->cgroup && !opts->placement &&
+            !is_shell_command(state, commands[i].args[0])) {
+            pids[i] = spawn_external(&commands[i], input_fd, (i < num_commands - 1) ? pipe_fds : NULL,
+                                     (i == 0) ? 0 : pgid, opts, state);
+        }
+        if (pids[i] < 0) {
+            // While tracing, a close-on-exec pipe tells the parent when the child's exec succeeded.
+            // Only for a stage that will exec: shell code runs on in the child and never closes it.
+            int exec_pipe[2] = {-1, -1};
+            bool will_exec = stages[i]->type == NODE_COMMAND && !is_shell_command(state, commands[i].args[0]);
+            if (g_trace_enabled && will_exec && pipe2(exec_pipe, O_CLOEXEC) < 0) {
+                exec_pipe[0] = exec_pipe[1] = -1;
             }
-            if (i < num_commands - 1) {
-                dup2(pipe_fds[1], STDOUT_FILENO);
-                close(pipe_fds[0]); close(pipe_fds[1]);
+
+            TRACE_BEGIN(fork_start);
+            pids[i] = opts->cgroup ? cgroup_fork(opts->cgroup) : fork();
+            TRACE_END(TRACE_FORK, fork_start);
+            if (pids[i] < 0) {
+                print_shell_perror("fork failed");
+                if (i < num_commands - 1) { close(pipe_fds[0]); close(pipe_fds[1]); }
+                if (exec_pipe[0] >= 0) { close(exec_pipe[0]); close(exec_pipe[1]); }
+                break;
             }
-            if (commands[i].output_file) {
-                int flags = O_WRONLY | O_CREAT | (commands[i].append_mode ? O_APPEND : O_TRUNC);
-                int out_fd = open(commands[i].output_file, flags, 0644);
-                if (out_fd < 0) { print_shell_perror(commands[i].output_file); exit(EXIT_FAILURE); }
-                dup2(out_fd, STDOUT_FILENO); close(out_fd);
+
+            if (pids[i] == 0) { // --- Child Process ---
+                if (exec_pipe[0] >= 0) close(exec_pipe[0]);
+                if (opts->job_control) {
+                    // Set the process group ID. The first child sets it for the whole pipeline.
+                    pgid = (i == 0) ? getpid() : pgid;
+                    setpgid(0, pgid);
+
+                    if (opts->foreground) {
+                        // If it's a foreground job, it needs terminal control.
+                        tcsetpgrp(STDIN_FILENO, pgid);
+                    }
+                }
+                // A child process should not ignore or block signals. Reset to defaults.
+                signals_reset_for_child();
+                // Rather than run where it was kept from running, the job fails.
+                if (opts->placement && !placement_apply(opts->placement)) _exit(126);
+
+                // --- I/O Redirection Logic ---
+                // Pipes first, then the command's own redirections: 'cmd 2>&1 | less' pipes both streams.
+                if (input_fd != STDIN_FILENO) { dup2(input_fd, STDIN_FILENO); close(input_fd); }
+                if (i < num_commands - 1) {
+                    dup2(pipe_fds[1], STDOUT_FILENO);
+                    close(pipe_fds[0]); close(pipe_fds[1]);
+                } else if (opts->out_fd != STDOUT_FILENO) {
+                    dup2(opts->out_fd, STDOUT_FILENO);
+                }
+                if (opts->err_fd != STDERR_FILENO) dup2(opts->err_fd, STDERR_FILENO);
+                if (!redirects_apply(&commands[i].redirects)) _exit(EXIT_FAILURE);
+                // The shell holds process substitution pipes close-on-exec; this command's own must survive.
+                for (int k = 0; k < commands[i].num_subst_fds; k++) fcntl(commands[i].subst_fds[k], F_SETFD, 0);
+                run_stage_in_child(stages[i], &commands[i], state);
             }
-            // --- Execution (unchanged) ---
-            if (execvp(commands[i].args[0], commands[i].args) == -1) {
-                fprintf(stderr, _RED_ "Shell Error: Command '%s' not found" _RESET_ "\n", commands[i].args[0]);
-                exit(EXIT_FAILURE);
+            if (exec_pipe[0] >= 0) {
+                uint64_t exec_start = trace_now_ns();
+                close(exec_pipe[1]);
+                char discard;
+                while (read(exec_pipe[0], &discard, 1) > 0) {} // EOF once execvp succeeds (or the child exits)
+                close(exec_pipe[0]);
+                TRACE_END(TRACE_EXEC, exec_start);
             }
         }
         // --- Parent Process ---
+        spawned++;
+
         // The first child's PID becomes the PGID for the whole group.
         if (i == 0) {
             pgid = pids[0];
         }
-        setpgid(pids[i], pgid); // Set PGID for all children in the pipeline
+        if (opts->job_control) {
+            setpgid(pids[i], pgid); // Set PGID for all children in the pipeline
+        }
 
-        if (input_fd != STDIN_FILENO) close(input_fd);
+        if (input_fd != opts->in_fd) close(input_fd);
         if (i < num_commands - 1) { close(pipe_fds[1]); input_fd = pipe_fds[0]; }
     }
+    if (input_fd != opts->in_fd) close(input_fd);
+
+    Job* job = NULL;
+    if (spawned == num_commands) {
+        job = job_create(job_name, pids, num_commands, opts->job_control);
+        if (!job) print_shell_perror("execute: malloc for job failed");
+    }
+    if (!job) { // Untracked processes would linger forever
+        for (int i = 0; i < spawned; i++) kill(pids[i], SIGKILL);
+        for (int i = 0; i < spawned; i++) waitpid(pids[i], NULL, 0);
+    }
+    free(pids);
+    return job;
+}
+
+/**
+ * @brief Expands and runs a pipeline as a job, and waits for it unless it runs
+ *        in the background.
+ * @param first If not NULL, stage 0 already expanded (ownership is taken).
+ * @return The job's exit status (0 for a background job).
+ */
+static int run_pipeline(Node* const* stages, int num_commands, bool is_background,
+                        SimpleCommand* first, ShellState* state) {
+    TRACE_BEGIN(execute_start);
+    time_t start_time = time(NULL);
+    int status = 1;
+
+    SimpleCommand* commands = calloc(num_commands, sizeof(SimpleCommand));
+    if (!commands) {
+        print_shell_perror("execute: malloc for pipeline failed");
+        if (first) simple_command_clear(first);
+        TRACE_END(TRACE_EXECUTE, execute_start);
+        return 1;
+    }
+    if (!expand_stages(stages, num_commands, commands, first, state)) goto cleanup;
+    // 'limit ...', 'pin ...' and 'timeout ...' before the first command apply to the whole job.
+    bool limited = false;
+    CgroupLimits limits;
+    TimeoutSpec deadline = {0};
+    Placement placement = state->job_placement;
+    while (stages[0]->type == NODE_COMMAND && commands[0].argc > 0 && !function_lookup(state, commands[0].args[0])) {
+        if (strcmp(commands[0].args[0], "limit") == 0) {
+            if (!limit_parse(&commands[0], &limits)) goto cleanup;
+            limited = true;
+        } else if (strcmp(commands[0].args[0], "pin") == 0) {
+            Placement requested;
+            bool reset;
+            if (!pin_parse(&commands[0], &requested, &reset)) goto cleanup;
+            if (commands[0].argc == 0) { // No command: the options become the defaults
+                if (num_commands == 1 && !limited) status = pin_set_defaults(state, &requested, reset);
+                else print_shell_error("pin: a command must follow the options here");
+                goto cleanup;
+            }
+            if (reset) memset(&placement, 0, sizeof(placement)); // Just this job, without the defaults
+            placement_merge(&placement, &requested);
+        } else if (strcmp(commands[0].args[0], "timeout") == 0) {
+            if (!timeout_parse(&commands[0], &deadline)) goto cleanup;
+        } else {
+            break;
+        }
+    }
+    // Without a cgroup (already reported why), the job runs unlimited.
+    Cgroup* cgroup = limited ? cgroup_create(vars_get(&state->vars, "SHELLBY_CGROUP"), &limits) : NULL;
+    const char* job_name = (stages[0]->type == NODE_COMMAND) ? commands[0].args[0] : node_display_name(stages[0]);
+
+    // With jobcapture, a background job's stdout and stderr go to a ring instead of the terminal.
+    int capture_fd = -1;
+    JobOutput* output = (is_background && state->options.jobcapture) ? job_output_open(&capture_fd) : NULL;
+
+    SpawnOptions opts = {STDIN_FILENO, output ? capture_fd : STDOUT_FILENO, output ? capture_fd : STDERR_FILENO,
+                         state->job_control, !is_background, cgroup, placement_is_set(&placement) ? &placement : NULL};
+    Job* job = spawn_pipeline(stages, commands, num_commands, job_name, &opts, state);
+    if (output) close(capture_fd); // Only the job writes to it now, so EOF comes when the job is done
+    if (!job) {
+        cgroup_destroy(cgroup);
+        job_output_free(output);
+        goto cleanup;
+    }
+    job->cgroup = cgroup;
+    job->output = output;
+    if (deadline.seconds > 0) {
+        // Without a timer (already reported why), the job runs with no deadline.
+        pid_t pids[job->num_members];
+        for (int i = 0; i < job->num_members; i++) pids[i] = job->members[i].pid;
+        job->timer = job_timer_start(&deadline, job->pgid, job->own_group, pids, job->num_members);
+    }
+    pid_t pgid = job->pgid;
 
-    // --- Parent Process Waits or Continues ---
     if (!is_background) {
         // --- FOREGROUND JOB ---
-        state->foreground_pgid = pgid; // Set global state
-        tcsetpgrp(STDIN_FILENO, pgid); // Give terminal control to the child group
-
-        // Wait for all processes in the pipeline to finish or be stopped
-        for (int i = 0; i < num_commands; i++) {
-            int status;
-            // WUNTRACED is crucial for catching Ctrl+Z (SIGTSTP)
-            waitpid(pids[i], &status, WUNTRACED);
-
-            if (WIFSTOPPED(status)) {
-                // Process was stopped by Ctrl+Z
-                printf("\nStopped: %s (PID %d)\n", commands[i].args[0], pids[i]);
-                // Add the entire pipeline to background jobs
-                if (state->num_bg_processes < MAX_BG_PROCS) {
-                    state->background_pids[state->num_bg_processes] = pgid; // Track by PGID
-                    strncpy(state->background_process_names[state->num_bg_processes], commands[0].args[0], MAX_PATH_LEN - 1);
-                    state->num_bg_processes++;
-                }
-                break; // Stop waiting for other processes in the pipeline
-            }
+        if (state->job_control) {
+            state->foreground_pgid = pgid; // Set global state
+            tcsetpgrp(STDIN_FILENO, pgid); // Give terminal control to the child group
+        }
+
+        // Every stage is tracked until it is reaped or the whole job stops.
+        TRACE_BEGIN(wait_start);
+        JobState job_result = job_wait(job);
+        TRACE_END(TRACE_WAIT, wait_start);
+
+        if (state->job_control) {
+            tcsetpgrp(STDIN_FILENO, getpgrp()); // Take back terminal control
+            state->foreground_pgid = -1; // Reset global state
         }
+        status = job_exit_status(job, state->options.pipefail);
 
-        tcsetpgrp(STDIN_FILENO, getpgrp()); // Take back terminal control
-        state->foreground_pgid = -1; // Reset global state
+        if (job_result == JOB_STOPPED) {
+            // Stopped by Ctrl+Z: the entire pipeline becomes a background job
+            printf("\nStopped: %s (PGID %d)\n", job->name, pgid);
+            if (!job_table_add(&state->jobs, job)) {
+                print_shell_error("Maximum background processes reached.");
+                kill(-pgid, SIGKILL);
+                job_free(job);
+            }
+        } else {
+            if (job->cgroup) limit_report(job);
+            if (job_interrupted(job)) {
+                printf("\n"); // Keep the next prompt off the "^C" line
+                state->interrupted = true; // Like Ctrl+C in the shell: abandon the rest of the line
+            }
+            job_free(job);
+        }
     } else {
         // --- BACKGROUND JOB ---
-        if (state->num_bg_processes < MAX_BG_PROCS) {
-            state->background_pids[state->num_bg_processes] = pgid; // Track by PGID
-            strncpy(state->background_process_names[state->num_bg_processes], commands[0].args[0], MAX_PATH_LEN - 1);
-            state->num_bg_processes++;
-            printf("Shell: Started background job [%d] %s (PGID %d)\n", state->num_bg_processes, commands[0].args[0], pgid);
+        state->last_background_pid = job->members[num_commands - 1].pid;
+        if (job_table_add(&state->jobs, job)) {
+            printf("Shell: Started background job [%d] %s (PGID %d)\n", state->jobs.count, job->name, pgid);
         } else {
             print_shell_error("Maximum background processes reached.");
-            kill(-pgid, SIGKILL); // Kill the job if we can't track it
+            if (state->job_control) kill(-pgid, SIGKILL); // Kill the job if we can't track it
+            job_free(job);
         }
+        status = 0;
     }
+    note_command_time(state, job_name, time(NULL) - start_time);
+
+cleanup:
+    for (int i = 0; i < num_commands; i++) simple_command_clear(&commands[i]);
+    free(commands);
+    TRACE_END(TRACE_EXECUTE, execute_start);
+    return status;
 }
 
-static void check_background_processes(ShellState* state) {
-    int current_valid_idx = 0;
-    for (int i = 0; i < state->num_bg_processes; i++) {
-        int status;
-        // CRITICAL FIX: Use -pgid to wait for any process in the group.
-        // WNOHANG makes the call non-blocking.
-        pid_t result = waitpid(-state->background_pids[i], &status, WNOHANG);
+/**
+ * @brief Spawns a command tree with one end of its pipeline redirected, without
+ *        job control (it stays in the shell's process group), for substitutions.
+ * @return The job, or NULL on failure (already reported).
+ */
+static Job* spawn_substitution(const Node* tree, int in_fd, int out_fd, const char* name, ShellState* state) {
+    // A pipeline's stages are spawned directly; anything else runs in one child.
+    Node* single = (Node*)tree;
+    Node* const* stages = (tree->type == NODE_PIPELINE) ? tree->stages : &single;
+    int num_commands = (tree->type == NODE_PIPELINE) ? tree->num_stages : 1;
 
-        if (result > 0) { // A process in the group terminated.
-            // We consider the entire job terminated if one of its processes exits.
-            // A more complex shell might wait for all, but this is a robust simplification.
-            printf("\nShell: Background job '%s' (PGID %d) has terminated.\n",
-                   state->background_process_names[i], state->background_pids[i]);
-            // Do not copy this job to the compacted list, effectively removing it.
-        } else if (result == 0) { // No change in the process group, job is still running.
-            if (i != current_valid_idx) {
-                state->background_pids[current_valid_idx] = state->background_pids[i];
-                strcpy(state->background_process_names[current_valid_idx], state->background_process_names[i]);
-            }
-            current_valid_idx++;
-        } else { // An error occurred, or the process group no longer exists.
-            if (errno != ECHILD) {
-                // This case is rare, but we should handle it.
-                // We assume the job is gone and remove it.
+    SimpleCommand* commands = calloc(num_commands, sizeof(SimpleCommand));
+    if (!commands) {
+        print_shell_perror("execute: malloc for substitution failed");
+        return NULL;
+    }
+    Job* job = NULL;
+    if (expand_stages(stages, num_commands, commands, NULL, state)) {
+        SpawnOptions opts = {in_fd, out_fd, STDERR_FILENO, false, false, NULL, NULL};
+        job = spawn_pipeline(stages, commands, num_commands, name, &opts, state);
+    }
+    for (int i = 0; i < num_commands; i++) simple_command_clear(&commands[i]);
+    free(commands);
+    return job;
+}
+
+char* capture_command_output(const Node* tree, ShellState* state, int* status) {
+    *status = 0;
+    if (!tree) return strdup(""); // $()
+
+    int pipe_fds[2];
+    if (pipe2(pipe_fds, O_CLOEXEC) < 0) {
+        print_shell_perror("command substitution: pipe failed");
+        *status = 1;
+        return NULL;
+    }
+    Job* job = spawn_substitution(tree, STDIN_FILENO, pipe_fds[1], "$(...)", state);
+    close(pipe_fds[1]);
+    if (!job) {
+        close(pipe_fds[0]);
+        *status = 1;
+        return NULL;
+    }
+
+    // Read until every writer has exited. Signals are still dispatched while we wait.
+    StrBuf output;
+    strbuf_init(&output);
+    bool use_loop = signals_get_fd() >= 0;
+    bool ok = true;
+    for (;;) {
+        if (use_loop && !(event_loop_run_once(pipe_fds[0], -1) & EVENT_FD_READY)) continue;
+        if (!strbuf_reserve(&output, CAPTURE_READ_CHUNK)) { ok = false; break; }
+        ssize_t n = read(pipe_fds[0], output.data + output.len, CAPTURE_READ_CHUNK);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        output.len += (size_t)n;
+        output.data[output.len] = '\0';
+    }
+    close(pipe_fds[0]);
+    job_wait(job);
+    *status = job_exit_status(job, state->options.pipefail);
+    job_free(job);
+
+    if (!ok) {
+        print_shell_perror("command substitution: out of memory");
+        strbuf_free(&output);
+        return NULL;
+    }
+    if (*status == 128 + SIGINT) { // Ctrl+C abandons the whole command, not just the substitution
+        printf("\n");
+        strbuf_free(&output);
+        return NULL;
+    }
+    // Trailing newlines are removed, as in other shells.
+    while (output.len > 0 && output.data[output.len - 1] == '\n') output.data[--output.len] = '\0';
+    return strbuf_detach(&output);
+}
+
+int open_process_substitution(const Node* tree, bool output, ShellState* state) {
+    int pipe_fds[2];
+    if (pipe2(pipe_fds, O_CLOEXEC) < 0) {
+        print_shell_perror("process substitution: pipe failed");
+        return -1;
+    }
+    // <(cmd): the command writes and the shell keeps the read end; >(cmd) is the reverse.
+    int child_end = output ? pipe_fds[0] : pipe_fds[1];
+    int shell_end = output ? pipe_fds[1] : pipe_fds[0];
+    // Recorded before the command starts: shell code there must not hold its own pipe's other end.
+    if (shell_end < FD_SETSIZE) FD_SET(shell_end, &open_substitutions);
+    Job* job = NULL;
+    if (tree) {
+        job = output ? spawn_substitution(tree, child_end, STDOUT_FILENO, ">(...)", state)
+                     : spawn_substitution(tree, STDIN_FILENO, child_end, "<(...)", state);
+    }
+    close(child_end);
+    if (tree && !job) {
+        close_process_substitution(shell_end);
+        return -1;
+    }
+    // Nobody waits for a process substitution; it is reaped with the background jobs.
+    if (job && !job_table_add(&state->substitutions, job)) {
+        print_shell_error("process substitution: Too many running.");
+        kill(job->members[0].pid, SIGKILL);
+        job_wait(job);
+        job_free(job);
+        close_process_substitution(shell_end);
+        return -1;
+    }
+    return shell_end;
+}
+
+void close_process_substitution(int fd) {
+    if (fd < 0) return;
+    if (fd < FD_SETSIZE) FD_CLR(fd, &open_substitutions);
+    close(fd);
+}
+
+/**
+ * @brief A variable's value and export flag, saved while a builtin runs with VAR=x overrides.
+ */
+typedef struct {
+    char* value;
+    bool exported;
+} SavedVar;
+
+/**
+ * @brief Runs a builtin or function in the shell process. Assignments before it
+ *        apply to this command only: they are exported while it runs, then undone.
+ * @param function The function's body, or NULL to run 'builtin'.
+ */
+static int run_in_shell(const Builtin* builtin, Node* function, SimpleCommand* cmd, ShellState* state) {
+    SavedVar* saved = NULL;
+    if (cmd->num_assigns > 0) {
+        saved = calloc(cmd->num_assigns, sizeof(SavedVar));
+        if (!saved) {
+            print_shell_perror("execute: calloc for assignments failed");
+            return 1;
+        }
+        for (int k = 0; k < cmd->num_assigns; k++) {
+            char* name = strndup(cmd->assigns[k], strcspn(cmd->assigns[k], "="));
+            const Var* var = name ? vars_find(&state->vars, name) : NULL;
+            if (var && var->value) saved[k].value = strdup(var->value);
+            saved[k].exported = var && var->exported;
+            free(name);
+            vars_assign(&state->vars, cmd->assigns[k], true);
+        }
+        vars_apply_environ(&state->vars);
+    }
+
+    int status = function ? call_function(function, cmd, state) : builtin->func(cmd->argc, cmd->args, state);
+
+    // Undo in reverse order, so 'A=1 A=2 cmd' restores A's original value.
+    for (int k = cmd->num_assigns - 1; k >= 0; k--) {
+        char* name = strndup(cmd->assigns[k], strcspn(cmd->assigns[k], "="));
+        if (!name) continue;
+        if (saved[k].value) {
+            vars_set(&state->vars, name, saved[k].value, false);
+            vars_export(&state->vars, name, saved[k].exported);
+        } else {
+            vars_unset(&state->vars, name);
+            if (saved[k].exported) vars_export(&state->vars, name, true);
+        }
+        free(saved[k].value);
+        free(name);
+    }
+    free(saved);
+    return status;
+}
+
+/**
+ * @brief Applies redirections in the shell process itself, for a builtin or a compound command.
+ * @return True if they were applied; undo them with redirects_restore().
+ */
+static bool redirect_in_shell(RedirectList* redirects, SavedFds* saved) {
+    return redirects_prepare(redirects) && redirects_apply_saved(redirects, saved);
+}
+
+/**
+ * @brief Runs a simple command: functions and builtins in the shell process,
+ *        anything else as a job.
+ */
+static int execute_command(const Node* node, ShellState* state) {
+    SimpleCommand cmd;
+    if (!expand_command(node, state, &cmd)) return 1;
+    SavedFds saved;
+    if (cmd.argc == 0) { // Only assignments (or every word expanded to nothing)
+        int status = cmd.subst_status; // X=$(cmd) reports cmd's status
+        if (redirect_in_shell(&cmd.redirects, &saved)) {
+            for (int k = 0; k < cmd.num_assigns; k++) {
+                if (!vars_assign(&state->vars, cmd.assigns[k], false)) status = 1;
             }
+            redirects_restore(&saved);
+        } else {
+            status = 1;
+        }
+        simple_command_clear(&cmd);
+        return status;
+    }
+    // Functions take precedence over builtins, so a function can wrap one.
+    Node* function = function_lookup(state, cmd.args[0]);
+    const Builtin* builtin = function ? NULL : builtin_lookup(cmd.args[0]);
+    if (!function && !builtin) {
+        Node* stage = (Node*)node;
+        return run_pipeline(&stage, 1, false, &cmd, state); // Takes over 'cmd'; nothing is expanded twice
+    }
+    time_t start_time = time(NULL);
+    int status = 1;
+    if (redirect_in_shell(&cmd.redirects, &saved)) {
+        status = run_in_shell(builtin, function, &cmd, state);
+        redirects_restore(&saved);
+    }
+    note_command_time(state, cmd.args[0], time(NULL) - start_time);
+    simple_command_clear(&cmd);
+    return status;
+}
+
+/**
+ * @brief True if the next command of a list should run: nothing has exited
+ *        the shell, been interrupted, or started a break, continue or return.
+ */
+static bool keep_going(const ShellState* state) {
+    return state->is_running && !state->interrupted && state->flow == FLOW_NORMAL;
+}
+
+/**
+ * @brief Decides, after an iteration of a loop, whether the loop goes on.
+ *        A break or continue aimed at this loop is consumed here.
+ */
+static bool loop_continues(ShellState* state) {
+    // A loop of builtins never waits for a job, so Ctrl+C has to be looked for.
+    if (!state->interrupted && signals_interrupt_pending()) {
+        printf("\n");
+        state->interrupted = true;
+    }
+    if (!state->is_running || state->interrupted) return false;
+    if (state->flow == FLOW_NORMAL) return true;
+    if (state->flow == FLOW_RETURN || --state->flow_count > 0) return false; // Aimed further out
+    bool next = (state->flow == FLOW_CONTINUE);
+    state->flow = FLOW_NORMAL;
+    return next;
+}
+
+static int execute_if(const Node* node, ShellState* state) {
+    int status = execute_node(node->left, state);
+    if (!keep_going(state)) return status;
+    if (status == 0) return execute_node(node->right, state);
+    return node->alternate ? execute_node(node->alternate, state) : 0;
+}
+
+/**
+ * @brief Runs a while or until loop. The tree is walked again on each
+ *        iteration; nothing is lexed or parsed again.
+ * @return The status of the last body run, 0 if it never ran, or 130 if Ctrl+C stopped it.
+ */
+static int execute_while(const Node* node, ShellState* state) {
+    int status = 0;
+    state->loop_depth++;
+    for (;;) {
+        int test = execute_node(node->left, state);
+        if (keep_going(state)) {
+            if ((test == 0) == (node->type == NODE_UNTIL)) break;
+            status = execute_node(node->right, state);
+        }
+        if (!loop_continues(state)) break;
+    }
+    state->loop_depth--;
+    return state->interrupted ? 128 + SIGINT : status;
+}
+
+/**
+ * @brief Runs a for loop. The list is expanded once, before the first iteration.
+ */
+static int execute_for(const Node* node, ShellState* state) {
+    SimpleCommand list;
+    if (!expand_word_list(node->words + 1, node->num_words - 1, state, &list)) return 1;
+    const char* name = node->words[0].parts[0].text;
+    int status = 0;
+    state->loop_depth++;
+    for (int i = 0; i < list.argc; i++) {
+        if (!vars_set(&state->vars, name, list.args[i], false)) {
+            status = 1;
+            break;
         }
+        status = execute_node(node->right, state);
+        if (!loop_continues(state)) break;
     }
-    state->num_bg_processes = current_valid_idx;
-}
\ No newline at end of file
+    state->loop_depth--;
+    simple_command_clear(&list);
+    return state->interrupted ? 128 + SIGINT : status;
+}
+
+/**
+ * @brief Runs a compound command's body, without its redirections.
+ */
+static int run_compound(const Node* node, ShellState* state) {
+    switch (node->type) {
+    case NODE_IF:
+        return execute_if(node, state);
+    case NODE_WHILE:
+    case NODE_UNTIL:
+        return execute_while(node, state);
+    case NODE_FOR:
+        return execute_for(node, state);
+    default:
+        return execute_node(node->left, state);
+    }
+}
+
+/**
+ * @brief Runs a compound command in the shell, with its redirections applied around the body.
+ */
+static int execute_compound(const Node* node, ShellState* state) {
+    if (node->num_redirects == 0) return run_compound(node, state);
+    SimpleCommand redirects;
+    memset(&redirects, 0, sizeof(redirects));
+    SavedFds saved;
+    int status = 1;
+    if (expand_redirects(node, state, &redirects) && redirect_in_shell(&redirects.redirects, &saved)) {
+        status = run_compound(node, state);
+        redirects_restore(&saved);
+    }
+    simple_command_clear(&redirects);
+    return status;
+}
+
+/**
+ * @brief Evaluates a command tree and records its status in state->last_exit_status ($?).
+ * @return The exit status.
+ */
+static int execute_node(const Node* node, ShellState* state) {
+    int status = 0;
+    switch (node->type) {
+    case NODE_COMMAND:
+        status = execute_command(node, state);
+        break;
+    case NODE_PIPELINE:
+        status = run_pipeline(node->stages, node->num_stages, false, NULL, state);
+        break;
+    case NODE_AND:
+        // The right side only runs (and only forks) if the left side succeeded.
+        status = execute_node(node->left, state);
+        if (status == 0 && keep_going(state)) status = execute_node(node->right, state);
+        break;
+    case NODE_OR:
+        status = execute_node(node->left, state);
+        if (status != 0 && keep_going(state)) status = execute_node(node->right, state);
+        break;
+    case NODE_SEQUENCE:
+        status = execute_node(node->left, state);
+        if (keep_going(state)) status = execute_node(node->right, state);
+        break;
+    case NODE_BACKGROUND: {
+        // A pipeline becomes the job itself; anything else runs in a forked subshell.
+        const Node* body = node->left;
+        if (body->type == NODE_PIPELINE) {
+            status = run_pipeline(body->stages, body->num_stages, true, NULL, state);
+        } else {
+            Node* stage = (Node*)body;
+            status = run_pipeline(&stage, 1, true, NULL, state);
+        }
+        break;
+    }
+    case NODE_GROUP:
+    case NODE_IF:
+    case NODE_WHILE:
+    case NODE_UNTIL:
+    case NODE_FOR:
+        status = execute_compound(node, state);
+        break;
+    case NODE_FUNCTION: {
+        // The body parsed with this line becomes the definition; it is not parsed again.
+        Node* body = node_retain(node->left);
+        void* old_body;
+        if (strmap_put(&state->functions, node->words[0].parts[0].text, body, &old_body)) {
+            node_free(old_body);
+        } else {
+            node_free(body);
+            status = 1;
+        }
+        break;
+    }
+    }
+    state->last_exit_status = status;
+    return status;
+}
+
+/**
+ * @brief Keeps an ended job with captured output for 'jobout', dropping the
+ *        oldest one kept once there are JOB_OUTPUT_KEEP.
+ */
+static void keep_finished_job(ShellState* state, Job* job) {
+    job_output_drain(job->output); // Whatever it wrote last, before saying how much there is
+    if (job->output->total == 0 && job->output->fd < 0) { // Nothing was written, and nothing can be
+        job_free(job);
+        return;
+    }
+    if (job->output->total > 0) {
+        printf("Shell: %llu bytes of output captured; see 'jobout %d'.\n", job->output->total, job->pgid);
+    }
+    cgroup_destroy(job->cgroup); // Only the output is kept
+    job->cgroup = NULL;
+    if (state->finished.count == JOB_OUTPUT_KEEP) {
+        Job* oldest = state->finished.jobs[0];
+        job_table_remove(&state->finished, oldest);
+        job_free(oldest);
+    }
+    job_table_add(&state->finished, job);
+}
+
+int reap_background_jobs(ShellState* state) {
+    // Finished process substitutions are reaped quietly.
+    for (int i = 0; i < state->substitutions.count; ) {
+        Job* job = state->substitutions.jobs[i];
+        job_poll(job);
+        if (job_state(job) != JOB_DONE) {
+            i++;
+            continue;
+        }
+        job_table_remove(&state->substitutions, job);
+        job_free(job);
+    }
+
+    int reaped = 0;
+    for (int i = 0; i < state->jobs.count; ) {
+        Job* job = state->jobs.jobs[i];
+        job_poll(job); // Non-blocking; collects every member's changes
+        if (job_state(job) != JOB_DONE) {
+            i++;
+            continue;
+        }
+        // A job has terminated only once all of its processes have.
+        printf("\nShell: Background job '%s' (PGID %d) has terminated.\n", job->name, job->pgid);
+        if (job->timer && job->timer->expired) {
+            printf("Shell: It ran out of time after %gs%s.\n", job->timer->spec.seconds,
+                   job->timer->killed ? " and was killed" : "");
+        }
+        if (job->cgroup) {
+            fflush(stdout);
+            limit_report(job);
+        }
+        job_table_remove(&state->jobs, job);
+        if (job->output) {
+            keep_finished_job(state, job);
+        } else {
+            job_free(job);
+        }
+        reaped++;
+    }
+    return reaped;
+}
@@ -0,0 +1,405 @@
+#include "core/expand.h"
+#include "core/executor.h"
+#include "utils/error.h"
+#include "utils/strbuf.h"
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define INITIAL_ARGS_CAPACITY 8
+
+/**
+ * @brief Appends a string to a growable, NULL-terminated vector. Takes ownership of 'str'.
+ * @return True on success, false if memory could not be allocated.
+ */
+static bool append_string(char*** vector, int* count, int* capacity, char* str) {
+    // Keep one slot spare for the NULL terminator execvp expects.
+    if (*count + 1 >= *capacity) {
+        int new_capacity = *capacity ? *capacity * 2 : INITIAL_ARGS_CAPACITY;
+        char** new_vector = realloc(*vector, sizeof(char*) * new_capacity);
+        if (!new_vector) {
+            print_shell_perror("expand: realloc for arguments failed");
+            free(str);
+            return false;
+        }
+        *vector = new_vector;
+        *capacity = new_capacity;
+    }
+    (*vector)[(*count)++] = str;
+    (*vector)[*count] = NULL;
+    return true;
+}
+
+/**
+ * @brief The value of a parameter that expands to a single string.
+ * @param scratch Holds numeric values; must outlive the returned pointer.
+ * @return The value, or NULL if it is unset.
+ */
+static const char* param_value(const char* name, ShellState* state, char scratch[32]) {
+    if (strcmp(name, "?") == 0) {
+        snprintf(scratch, 32, "%d", state->last_exit_status);
+        return scratch;
+    }
+    if (strcmp(name, "$") == 0) {
+        snprintf(scratch, 32, "%d", (int)getpid());
+        return scratch;
+    }
+    if (strcmp(name, "!") == 0) {
+        if (state->last_background_pid <= 0) return NULL;
+        snprintf(scratch, 32, "%d", (int)state->last_background_pid);
+        return scratch;
+    }
+    if (strcmp(name, "#") == 0) {
+        snprintf(scratch, 32, "%d", state->num_positional - 1);
+        return scratch;
+    }
+    if (isdigit((unsigned char)name[0])) {
+        int index = atoi(name);
+        return index < state->num_positional ? state->positional[index] : NULL;
+    }
+    return vars_get(&state->vars, name);
+}
+
+static bool is_positional_list(const char* name) {
+    return strcmp(name, "@") == 0 || strcmp(name, "*") == 0;
+}
+
+/**
+ * @brief Appends the value of parameter 'name' to 'out'. $@ and $* are joined with spaces.
+ */
+static bool append_param(StrBuf* out, const char* name, ShellState* state) {
+    if (is_positional_list(name)) {
+        for (int i = 1; i < state->num_positional; i++) {
+            if (i > 1 && !strbuf_putc(out, ' ')) return false;
+            if (!strbuf_append_str(out, state->positional[i])) return false;
+        }
+        return true;
+    }
+    char scratch[32];
+    const char* value = param_value(name, state, scratch);
+    return value ? strbuf_append_str(out, value) : true;
+}
+
+/**
+ * @brief Runs a $(...) and keeps its status for the command being expanded.
+ * @return The output (caller frees), or NULL on failure (already reported).
+ */
+static char* substitute_command(const WordPart* part, ShellState* state, SimpleCommand* owner) {
+    int status;
+    char* output = capture_command_output(part->command, state, &status);
+    if (owner) owner->subst_status = status;
+    return output;
+}
+
+/**
+ * @brief Starts a <(...) or >(...) and appends its /dev/fd path to 'out'.
+ *        The pipe stays open (owned by 'owner') until the command is done.
+ */
+static bool substitute_process(StrBuf* out, const WordPart* part, ShellState* state, SimpleCommand* owner) {
+    if (!owner) {
+        print_shell_error("Process substitution is not allowed here.");
+        return false;
+    }
+    int fd = open_process_substitution(part->command, part->type == PART_PROCESS_OUT, state);
+    if (fd < 0) return false;
+    if (owner->num_subst_fds >= owner->subst_fds_capacity) {
+        int new_capacity = owner->subst_fds_capacity ? owner->subst_fds_capacity * 2 : INITIAL_ARGS_CAPACITY;
+        int* grown = realloc(owner->subst_fds, sizeof(int) * new_capacity);
+        if (!grown) {
+            print_shell_perror("expand: realloc for substitutions failed");
+            close_process_substitution(fd);
+            return false;
+        }
+        owner->subst_fds = grown;
+        owner->subst_fds_capacity = new_capacity;
+    }
+    owner->subst_fds[owner->num_subst_fds++] = fd;
+    return strbuf_appendf(out, "/dev/fd/%d", fd);
+}
+
+/**
+ * @brief Expands a word to one string; substitutions are recorded in 'owner' (may be NULL).
+ */
+static char* expand_word_for(const Word* word, ShellState* state, SimpleCommand* owner) {
+    StrBuf out;
+    strbuf_init(&out);
+    for (int i = 0; i < word->num_parts; i++) {
+        const WordPart* part = &word->parts[i];
+        bool ok;
+        if (part->type == PART_LITERAL) {
+            ok = strbuf_append_str(&out, part->text);
+        } else if (part->type == PART_PARAM) {
+            ok = append_param(&out, part->text, state);
+        } else if (part->type == PART_COMMAND) {
+            char* output = substitute_command(part, state, owner);
+            if (!output) {
+                strbuf_free(&out);
+                return NULL;
+            }
+            ok = strbuf_append_str(&out, output);
+            free(output);
+        } else if (!substitute_process(&out, part, state, owner)) {
+            strbuf_free(&out);
+            return NULL;
+        } else {
+            ok = true;
+        }
+        if (!ok) {
+            print_shell_perror("expand: out of memory");
+            strbuf_free(&out);
+            return NULL;
+        }
+    }
+    return strbuf_detach(&out);
+}
+
+char* expand_word(const Word* word, ShellState* state) {
+    return expand_word_for(word, state, NULL);
+}
+
+/**
+ * @brief Collects the fields a word expands to.
+ */
+typedef struct {
+    StrBuf field;     ///< The field being built
+    bool started;     ///< The field exists even if empty (it had quoted or literal text)
+    const char* ifs;
+    SimpleCommand* out;
+} FieldSplitter;
+
+static bool emit_field(FieldSplitter* fs) {
+    if (!fs->started) return true;
+    fs->started = false;
+    char* field = strbuf_detach(&fs->field);
+    if (!field) return false;
+    return append_string(&fs->out->args, &fs->out->argc, &fs->out->args_capacity, field);
+}
+
+/**
+ * @brief Appends an unquoted expansion, splitting it into fields at IFS characters.
+ *
+ * Runs of IFS whitespace separate fields; any other IFS character ends the
+ * current field, even an empty one.
+ */
+static bool split_value(FieldSplitter* fs, const char* value) {
+    for (const char* p = value; *p; p++) {
+        if (!strchr(fs->ifs, *p)) {
+            if (!strbuf_putc(&fs->field, *p)) return false;
+            fs->started = true;
+        } else if (!isspace((unsigned char)*p)) {
+            fs->started = true;
+            if (!emit_field(fs)) return false;
+        } else if (!emit_field(fs)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Expands a word into zero or more arguments.
+ *
+ * Literal and double-quoted text is kept together; unquoted expansions are
+ * split into fields, and "$@" gives one field per positional parameter.
+ */
+static bool expand_fields(const Word* word, ShellState* state, SimpleCommand* out) {
+    FieldSplitter fs = {.started = false, .out = out};
+    strbuf_init(&fs.field);
+    const char* ifs = vars_get(&state->vars, "IFS");
+    fs.ifs = ifs ? ifs : " \t\n";
+
+    bool ok = true;
+    for (int i = 0; ok && i < word->num_parts; i++) {
+        const WordPart* part = &word->parts[i];
+        if (part->type == PART_LITERAL) {
+            ok = strbuf_append_str(&fs.field, part->text);
+            fs.started = true;
+        } else if (is_positional_list(part->text)) {
+            for (int k = 1; ok && k < state->num_positional; k++) {
+                if (part->quoted && strcmp(part->text, "@") == 0) {
+                    if (k > 1) ok = emit_field(&fs);
+                    ok = ok && strbuf_append_str(&fs.field, state->positional[k]);
+                    fs.started = true;
+                } else if (part->quoted) { // "$*": one field, joined with spaces
+                    ok = (k == 1 || strbuf_putc(&fs.field, ' ')) && strbuf_append_str(&fs.field, state->positional[k]);
+                    fs.started = true;
+                } else {
+                    ok = (k == 1 || emit_field(&fs)) && split_value(&fs, state->positional[k]);
+                }
+            }
+            if (part->quoted && strcmp(part->text, "*") == 0) fs.started = true;
+        } else if (part->type == PART_COMMAND) {
+            char* output = substitute_command(part, state, out);
+            if (!output) {
+                strbuf_free(&fs.field);
+                return false;
+            }
+            // Unquoted output is split into words right where it was read.
+            if (part->quoted) {
+                ok = strbuf_append_str(&fs.field, output);
+                fs.started = true;
+            } else {
+                ok = split_value(&fs, output);
+            }
+            free(output);
+        } else if (part->type != PART_PARAM) {
+            if (!substitute_process(&fs.field, part, state, out)) {
+                strbuf_free(&fs.field);
+                return false;
+            }
+            fs.started = true;
+        } else {
+            char scratch[32];
+            const char* value = param_value(part->text, state, scratch);
+            if (part->quoted) {
+                ok = !value || strbuf_append_str(&fs.field, value);
+                fs.started = true;
+            } else if (value) {
+                ok = split_value(&fs, value);
+            }
+        }
+    }
+    ok = ok && emit_field(&fs);
+    strbuf_free(&fs.field);
+    if (!ok) print_shell_perror("expand: out of memory");
+    return ok;
+}
+
+/**
+ * @brief Parses the target of '>&' or '<&': a descriptor number, or '-'.
+ * @return The descriptor, -2 for '-', or -1 if the target is neither.
+ */
+static int parse_dup_target(const char* target) {
+    if (strcmp(target, "-") == 0) return -2;
+    if (!*target || strlen(target) > 4) return -1;
+    for (const char* c = target; *c; c++) {
+        if (!isdigit((unsigned char)*c)) return -1;
+    }
+    return atoi(target);
+}
+
+bool expand_redirects(const Node* node, ShellState* state, SimpleCommand* out) {
+    RedirectList* list = &out->redirects;
+    int truncate = state->options.noclobber ? O_EXCL : O_TRUNC;
+    for (int r = 0; r < node->num_redirects; r++) {
+        const Redirect* redirect = &node->redirects[r];
+        char* target = expand_word_for(&redirect->target, state, out);
+        if (!target) return false;
+        int fd = redirect->fd;
+        bool ok = true;
+        switch (redirect->type) {
+        case REDIR_INPUT:
+            ok = redirects_add(list, FD_ACTION_OPEN, fd < 0 ? 0 : fd, -1, O_RDONLY, target);
+            break;
+        case REDIR_OUTPUT:
+            ok = redirects_add(list, FD_ACTION_OPEN, fd < 0 ? 1 : fd, -1, O_WRONLY | O_CREAT | truncate, target);
+            break;
+        case REDIR_CLOBBER:
+            ok = redirects_add(list, FD_ACTION_OPEN, fd < 0 ? 1 : fd, -1, O_WRONLY | O_CREAT | O_TRUNC, target);
+            break;
+        case REDIR_APPEND:
+            ok = redirects_add(list, FD_ACTION_OPEN, fd < 0 ? 1 : fd, -1, O_WRONLY | O_CREAT | O_APPEND, target);
+            break;
+        case REDIR_READ_WRITE:
+            ok = redirects_add(list, FD_ACTION_OPEN, fd < 0 ? 0 : fd, -1, O_RDWR | O_CREAT, target);
+            break;
+        case REDIR_DUP_INPUT:
+        case REDIR_DUP_OUTPUT: {
+            int source = parse_dup_target(target);
+            int dest = (fd >= 0) ? fd : (redirect->type == REDIR_DUP_INPUT ? 0 : 1);
+            if (source == -1 && redirect->type == REDIR_DUP_OUTPUT && fd < 0) {
+                // '>&file' is the older spelling of '&>file'.
+                ok = redirects_add(list, FD_ACTION_OPEN, 1, -1, O_WRONLY | O_CREAT | truncate, target) &&
+                     redirects_add(list, FD_ACTION_DUP, 2, 1, 0, NULL);
+            } else if (source == -1) {
+                fprintf(stderr, _RED_ "Shell Error: " _RESET_ "%s: Not a file descriptor\n", target);
+                free(target);
+                return false;
+            } else {
+                free(target);
+                ok = (source == -2) ? redirects_add(list, FD_ACTION_CLOSE, dest, -1, 0, NULL)
+                                    : redirects_add(list, FD_ACTION_DUP, dest, source, 0, NULL);
+            }
+            break;
+        }
+        case REDIR_OUTPUT_ALL:
+        case REDIR_APPEND_ALL: {
+            int mode = (redirect->type == REDIR_APPEND_ALL) ? O_APPEND : truncate;
+            ok = redirects_add(list, FD_ACTION_OPEN, 1, -1, O_WRONLY | O_CREAT | mode, target) &&
+                 redirects_add(list, FD_ACTION_DUP, 2, 1, 0, NULL);
+            break;
+        }
+        case REDIR_HEREDOC:
+        case REDIR_HERESTRING:
+            if (redirect->type == REDIR_HERESTRING) {
+                // A here-string gets the newline a here-document's last line already has.
+                size_t len = strlen(target);
+                char* line = realloc(target, len + 2);
+                if (!line) {
+                    free(target);
+                    print_shell_perror("expand: out of memory");
+                    return false;
+                }
+                memcpy(line + len, "\n", 2);
+                target = line;
+            }
+            ok = redirects_add(list, FD_ACTION_DATA, fd < 0 ? 0 : fd, -1, 0, target);
+            break;
+        }
+        if (!ok) return false;
+    }
+    return true;
+}
+
+bool expand_command(const Node* command, ShellState* state, SimpleCommand* out) {
+    memset(out, 0, sizeof(*out));
+    int i = 0;
+    // Leading NAME=value words are assignments; they are not split.
+    for (; i < command->num_words && command->words[i].assign_len > 0; i++) {
+        char* assignment = expand_word_for(&command->words[i], state, out);
+        if (!assignment || !append_string(&out->assigns, &out->num_assigns, &out->assigns_capacity, assignment)) {
+            goto fail;
+        }
+    }
+    for (; i < command->num_words; i++) {
+        if (!expand_fields(&command->words[i], state, out)) goto fail;
+    }
+    if (!expand_redirects(command, state, out)) goto fail;
+    return true;
+
+fail:
+    simple_command_clear(out);
+    return false;
+}
+
+bool expand_word_list(const Word* words, int num_words, ShellState* state, SimpleCommand* out) {
+    memset(out, 0, sizeof(*out));
+    for (int i = 0; i < num_words; i++) {
+        if (!expand_fields(&words[i], state, out)) {
+            simple_command_clear(out);
+            return false;
+        }
+    }
+    return true;
+}
+
+void simple_command_clear(SimpleCommand* cmd) {
+    for (int k = 0; k < cmd->argc; ++k) {
+        free(cmd->args[k]);
+    }
+    free(cmd->args);
+    for (int k = 0; k < cmd->num_assigns; ++k) {
+        free(cmd->assigns[k]);
+    }
+    free(cmd->assigns);
+    for (int k = 0; k < cmd->num_subst_fds; ++k) {
+        close_process_substitution(cmd->subst_fds[k]);
+    }
+    free(cmd->subst_fds);
+    redirects_clear(&cmd->redirects);
+    memset(cmd, 0, sizeof(*cmd));
+}
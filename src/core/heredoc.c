@@ -0,0 +1,67 @@
+#define _GNU_SOURCE
+#include "core/heredoc.h"
+#include "utils/error.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/**
+ * @brief Writes all of 'data', retrying after short writes.
+ */
+static bool write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+/**
+ * @brief A pipe already holding 'data', or -1 if it would not fit in the pipe buffer.
+ */
+static int open_pipe(const char* data, size_t len) {
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC | O_NONBLOCK) < 0) return -1;
+    int capacity = fcntl(fds[1], F_GETPIPE_SZ);
+    if (capacity < 0 || len > (size_t)capacity || !write_all(fds[1], data, len)) {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    close(fds[1]);
+    // The reader expects an ordinary blocking stdin.
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) & ~O_NONBLOCK);
+    return fds[0];
+}
+
+/**
+ * @brief A sealed memfd holding 'data', rewound for reading.
+ */
+static int open_memfd(const char* data, size_t len) {
+    int fd = memfd_create("shellby-heredoc", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        print_shell_perror("here-document: memfd_create failed");
+        return -1;
+    }
+    if (!write_all(fd, data, len) || lseek(fd, 0, SEEK_SET) < 0) {
+        print_shell_perror("here-document: write failed");
+        close(fd);
+        return -1;
+    }
+    // The reader gets a fixed snapshot: nobody can change it under them.
+    fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+    return fd;
+}
+
+int heredoc_open(const char* data, size_t len) {
+    int fd = open_pipe(data, len);
+    return fd >= 0 ? fd : open_memfd(data, len);
+}
@@ -1,4 +1,8 @@
 #include "core/input.h"
+#include "core/event_loop.h"
+#include "core/executor.h"
+#include "utils/error.h"
+#include <errno.h>
 #include <termios.h>
 #include <unistd.h>
 #include <stdio.h>
@@ -6,90 +10,182 @@
 #include <stdlib.h>
 #include <ctype.h>
 
-// This function is almost identical to the one in your main.c,
-// but it takes a ShellState pointer instead of multiple arguments.
-int get_line_with_history(char* buffer, int size, const ShellState* state) {
+#define INITIAL_LINE_CAPACITY 256
+#define INPUT_READ_CHUNK 256
+
+// Pseudo-keys returned by read_key() besides plain bytes.
+#define KEY_EOF (-1)
+#define KEY_INTERRUPT (-2)
+#define KEY_CSI 0x1000 // OR'ed with the final byte of an ESC '[' sequence
+
+// Bytes read from the terminal but not consumed yet (a paste can arrive in one read).
+static unsigned char pending[INPUT_READ_CHUNK];
+static size_t pending_pos = 0, pending_len = 0;
+
+/**
+ * @brief Makes sure *buffer can hold 'needed' bytes, doubling its capacity as required.
+ * @return True on success, false if memory could not be allocated.
+ */
+static bool ensure_capacity(char** buffer, size_t* capacity, size_t needed) {
+    if (needed <= *capacity) return true;
+    size_t new_capacity = *capacity ? *capacity : INITIAL_LINE_CAPACITY;
+    while (new_capacity < needed) new_capacity *= 2;
+    char* grown = realloc(*buffer, new_capacity);
+    if (!grown) {
+        print_shell_perror("input: realloc for line buffer failed");
+        return false;
+    }
+    *buffer = grown;
+    *capacity = new_capacity;
+    return true;
+}
+
+/**
+ * @brief Replaces the line being edited with 'text'.
+ */
+static bool set_line(char** buffer, size_t* capacity, size_t* length, const char* text) {
+    size_t text_len = strlen(text);
+    if (!ensure_capacity(buffer, capacity, text_len + 1)) return false;
+    memcpy(*buffer, text, text_len + 1);
+    *length = text_len;
+    return true;
+}
+
+/**
+ * @brief Redraws the prompt and the line being edited (e.g., after a job notice).
+ */
+static void redraw_line(const ShellState* state, const char* line) {
+    printf("\r");
+    display_shell_prompt(state);
+    printf("%s\033[K", line);
+    fflush(stdout);
+}
+
+/**
+ * @brief Returns the next input byte, waiting in the event loop when none is buffered.
+ *
+ * While waiting, terminated background jobs are reported and the line is redrawn
+ * below the notice; it is also redrawn when the terminal is resized. Input is read with read(2) in chunks rather than through
+ * stdio, so that poll(2) on the descriptor tells the truth.
+ *
+ * @return The byte, KEY_EOF at end of input, or KEY_INTERRUPT on Ctrl+C.
+ */
+static int read_key(ShellState* state, const char* line) {
+    while (pending_pos >= pending_len) {
+        int events = event_loop_run_once(STDIN_FILENO, -1);
+        if (events & SIGNAL_EVENT_INTERRUPT) return KEY_INTERRUPT;
+        bool reported = (events & SIGNAL_EVENT_CHILD) && reap_background_jobs(state) > 0;
+        if (reported || (events & SIGNAL_EVENT_RESIZE)) redraw_line(state, line);
+        if (!(events & EVENT_FD_READY)) continue;
+
+        ssize_t n = read(STDIN_FILENO, pending, sizeof(pending));
+        if (n < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+        if (n <= 0) return KEY_EOF;
+        pending_pos = 0;
+        pending_len = (size_t)n;
+    }
+    return pending[pending_pos++];
+}
+
+long get_line_with_history(char** buffer, size_t* capacity, ShellState* state) {
+    if (!ensure_capacity(buffer, capacity, INITIAL_LINE_CAPACITY)) return -1;
+
     struct termios old_term, new_term;
     tcgetattr(STDIN_FILENO, &old_term);
     new_term = old_term;
     new_term.c_lflag &= ~(ICANON | ECHO);
     tcsetattr(STDIN_FILENO, TCSANOW, &new_term);
 
-    int buffer_pos = 0;
-    buffer[0] = '\0';
+    size_t buffer_pos = 0;
+    (*buffer)[0] = '\0';
     int c;
     int history_index = 0;
     char* temp_command_storage = NULL;
 
     while (1) {
-        c = getchar();
+        c = read_key(state, *buffer);
+        if (c == '\x1b') {
+            // Arrow keys arrive as ESC '[' <letter>; anything else is dropped.
+            c = read_key(state, *buffer);
+            if (c == '[') {
+                c = read_key(state, *buffer);
+                if (c >= 0) c |= KEY_CSI;
+            } else if (c >= 0) {
+                c = 0;
+            }
+        }
 
-        if (c == EOF || c == 4) { // Ctrl+D
+        if (c == KEY_INTERRUPT) { // Ctrl+C: abandon the line and start over
+            if (state->in_continuation) { // ...and the command it was continuing
+                free(temp_command_storage);
+                tcsetattr(STDIN_FILENO, TCSANOW, &old_term);
+                printf("\n");
+                return LINE_INTERRUPTED;
+            }
+            buffer_pos = 0;
+            (*buffer)[0] = '\0';
+            history_index = 0;
+            printf("\n");
+            redraw_line(state, *buffer);
+        } else if (c == KEY_EOF || c == 4) { // Ctrl+D
             if (buffer_pos == 0) {
+                free(temp_command_storage);
                 tcsetattr(STDIN_FILENO, TCSANOW, &old_term);
                 return -1;
             }
+            if (c == KEY_EOF) { // Input ended mid-line: hand back what we have
+                free(temp_command_storage);
+                tcsetattr(STDIN_FILENO, TCSANOW, &old_term);
+                printf("\n");
+                return (long)buffer_pos;
+            }
         } else if (c == '\n') {
             free(temp_command_storage);
             tcsetattr(STDIN_FILENO, TCSANOW, &old_term);
             printf("\n");
-            return 0;
+            return (long)buffer_pos;
         } else if (c == 127 || c == '\b') {
             if (buffer_pos > 0) {
                 buffer_pos--;
-                buffer[buffer_pos] = '\0';
+                (*buffer)[buffer_pos] = '\0';
                 printf("\b \b");
                 fflush(stdout);
             }
-        } else if (c == '\x1b') {
-            if (getchar() == '[') {
-                switch (getchar()) {
-                    case 'A': // Up
-                        if (history_index < get_history_size(state->history_queue)) {
-                            if (history_index == 0) {
-                                free(temp_command_storage);
-                                temp_command_storage = strdup(buffer);
-                            }
-                            history_index++;
-                            char* hist_cmd = get_kth_history_element_silent(state->history_queue, history_index);
-                            if (hist_cmd) {
-                                strncpy(buffer, hist_cmd, size - 1);
-                                buffer[size - 1] = '\0';
-                                buffer_pos = strlen(buffer);
-                                free(hist_cmd);
-                            }
-                        }
-                        break;
-                    case 'B': // Down
-                        if (history_index > 0) {
-                            history_index--;
-                            if (history_index == 0) {
-                                strncpy(buffer, temp_command_storage ? temp_command_storage : "", size - 1);
-                                buffer[size-1] = '\0';
-                            } else {
-                                char* hist_cmd = get_kth_history_element_silent(state->history_queue, history_index);
-                                if (hist_cmd) {
-                                    strncpy(buffer, hist_cmd, size - 1);
-                                    buffer[size - 1] = '\0';
-                                    free(hist_cmd);
-                                }
-                            }
-                            buffer_pos = strlen(buffer);
-                        }
-                        break;
+        } else if (c == (KEY_CSI | 'A')) { // Up
+            if (history_index < get_history_size(state->history_queue)) {
+                if (history_index == 0) {
+                    free(temp_command_storage);
+                    temp_command_storage = strdup(*buffer);
+                }
+                history_index++;
+                char* hist_cmd = get_kth_history_element_silent(state->history_queue, history_index);
+                if (hist_cmd) {
+                    set_line(buffer, capacity, &buffer_pos, hist_cmd);
+                    free(hist_cmd);
+                }
+            }
+            redraw_line(state, *buffer);
+        } else if (c == (KEY_CSI | 'B')) { // Down
+            if (history_index > 0) {
+                history_index--;
+                if (history_index == 0) {
+                    set_line(buffer, capacity, &buffer_pos, temp_command_storage ? temp_command_storage : "");
+                } else {
+                    char* hist_cmd = get_kth_history_element_silent(state->history_queue, history_index);
+                    if (hist_cmd) {
+                        set_line(buffer, capacity, &buffer_pos, hist_cmd);
+                        free(hist_cmd);
+                    }
                 }
-                printf("\r");
-                display_shell_prompt(state);
-                printf("%s\033[K", buffer);
-                fflush(stdout);
             }
-        } else if (isprint(c)) {
-            if (buffer_pos < size - 1) {
-                buffer[buffer_pos++] = c;
-                buffer[buffer_pos] = '\0';
+            redraw_line(state, *buffer);
+        } else if (c >= 0 && c < 256 && isprint(c)) {
+            if (ensure_capacity(buffer, capacity, buffer_pos + 2)) {
+                (*buffer)[buffer_pos++] = (char)c;
+                (*buffer)[buffer_pos] = '\0';
                 putchar(c);
                 fflush(stdout);
             }
         }
     }
-}
\ No newline at end of file
+}
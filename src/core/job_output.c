@@ -0,0 +1,102 @@
+#define _GNU_SOURCE // For pipe2
+#include "core/job_output.h"
+#include "core/event_loop.h"
+#include "utils/error.h"
+#include "utils/fd.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+static void on_readable(int fd, short revents, void* data) {
+    (void)fd; (void)revents;
+    job_output_drain(data);
+}
+
+JobOutput* job_output_open(int* write_fd) {
+    JobOutput* output = calloc(1, sizeof(JobOutput));
+    int fds[2];
+    if (!output || !(output->data = malloc(JOB_OUTPUT_SIZE))) {
+        print_shell_perror("jobcapture: malloc failed");
+        free(output);
+        return NULL;
+    }
+    if (pipe2(fds, O_CLOEXEC) < 0) {
+        print_shell_perror("jobcapture: pipe failed");
+        free(output->data);
+        free(output);
+        return NULL;
+    }
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    output->fd = fd_keep(fds[0]);
+    output->size = JOB_OUTPUT_SIZE;
+    if (event_loop_add(output->fd, POLLIN, on_readable, output) < 0) {
+        fd_close(output->fd);
+        close(fds[1]);
+        free(output->data);
+        free(output);
+        return NULL;
+    }
+    *write_fd = fds[1];
+    return output;
+}
+
+void job_output_drain(JobOutput* output) {
+    // At most one ring's worth per call, so a job that never stops writing cannot hold up the loop.
+    for (size_t budget = output->size; output->fd >= 0 && budget > 0;) {
+        // Straight into the ring: from the write position to the end, then around from the start.
+        size_t at = (size_t)(output->total % output->size);
+        struct iovec parts[2] = {
+            {output->data + at, output->size - at},
+            {output->data, at},
+        };
+        ssize_t n = readv(output->fd, parts, at ? 2 : 1);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno == EAGAIN) return;
+        if (n <= 0) { // EOF: every process of the job has closed its end
+            job_output_close(output);
+            return;
+        }
+        unsigned long long start = output->total;
+        output->total += (unsigned long long)n;
+        // Like a foreground job writing to the terminal; a failed write only loses the copy.
+        if (output->echo) job_output_write(output, start, STDOUT_FILENO);
+        budget -= (size_t)n < budget ? (size_t)n : budget;
+    }
+}
+
+unsigned long long job_output_oldest(const JobOutput* output) {
+    return output->total > output->size ? output->total - output->size : 0;
+}
+
+unsigned long long job_output_write(const JobOutput* output, unsigned long long from, int fd) {
+    unsigned long long oldest = job_output_oldest(output);
+    if (from < oldest) from = oldest;
+    while (from < output->total) {
+        size_t at = (size_t)(from % output->size);
+        size_t len = (size_t)(output->total - from);
+        if (len > output->size - at) len = output->size - at; // Up to the end of the ring; the rest next time round
+        ssize_t n = write(fd, output->data + at, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        from += (unsigned long long)n;
+    }
+    return from;
+}
+
+void job_output_close(JobOutput* output) {
+    if (output->fd < 0) return;
+    event_loop_remove(output->fd);
+    fd_close(output->fd);
+    output->fd = -1;
+}
+
+void job_output_free(JobOutput* output) {
+    if (!output) return;
+    job_output_close(output);
+    free(output->data);
+    free(output);
+}
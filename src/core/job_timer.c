@@ -0,0 +1,163 @@
+#include "core/job_timer.h"
+#include "core/event_loop.h"
+#include "core/procfs.h"
+#include "utils/error.h"
+#include "utils/fd.h"
+
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+
+static void arm(int timer_fd, double seconds) {
+    struct itimerspec when = {0};
+    when.it_value.tv_sec = (time_t)seconds;
+    when.it_value.tv_nsec = (long)((seconds - (double)when.it_value.tv_sec) * 1e9);
+    if (when.it_value.tv_sec == 0 && when.it_value.tv_nsec == 0) when.it_value.tv_nsec = 1; // Zero would disarm it
+    timerfd_settime(timer_fd, 0, &when, NULL);
+}
+
+/**
+ * @brief Whether any process of the job has yet to exit. A pidfd becomes
+ *        readable when its process exits, whatever its PID is used for afterwards.
+ */
+static bool any_alive(const JobTimer* timer) {
+    if (timer->num_pidfds == 0) return true; // Without pidfds there is no telling; the group is signalled anyway
+    for (int i = 0; i < timer->num_pidfds; i++) {
+        struct pollfd exited = {timer->pidfds[i], POLLIN, 0};
+        if (poll(&exited, 1, 0) == 0) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Signals every process below entry 'root' of the snapshot.
+ */
+static void signal_descendants(const ProcTree* tree, int root, int signal_number) {
+    for (int c = tree->child_start[root]; c < tree->child_start[root + 1]; c++) {
+        const ProcInfo* proc = &tree->table->procs[tree->children[c]];
+        procfs_signal(proc->pid, proc->start_time, signal_number);
+        if (signal_number != SIGKILL) procfs_signal(proc->pid, proc->start_time, SIGCONT);
+        signal_descendants(tree, tree->children[c], signal_number);
+    }
+}
+
+static void signal_job(const JobTimer* timer, int signal_number) {
+    // SIGCONT after it, as coreutils timeout does, so a stopped job acts on the signal too.
+    if (timer->own_group) {
+        kill(-timer->pgid, signal_number);
+        if (signal_number != SIGKILL) kill(-timer->pgid, SIGCONT);
+        return;
+    }
+    ProcTable table = {0};
+    ProcTree tree = {0};
+    bool have_tree = proc_table_load(&table) && proc_tree_build(&tree, &table);
+    for (int i = 0; i < timer->num_pidfds; i++) {
+        const ProcInfo* proc = have_tree ? proc_table_find(&table, timer->pids[i]) : NULL;
+        if (proc) signal_descendants(&tree, (int)(proc - table.procs), signal_number);
+#ifdef SYS_pidfd_send_signal
+        syscall(SYS_pidfd_send_signal, timer->pidfds[i], signal_number, NULL, 0);
+        if (signal_number != SIGKILL) syscall(SYS_pidfd_send_signal, timer->pidfds[i], SIGCONT, NULL, 0);
+#endif
+    }
+    proc_tree_free(&tree);
+    proc_table_free(&table);
+}
+
+/**
+ * @brief Stops the clock; the pidfds stay, to wake a wait when the job exits.
+ */
+static void stop_clock(JobTimer* timer) {
+    if (timer->timer_fd < 0) return;
+    event_loop_remove(timer->timer_fd);
+    fd_close(timer->timer_fd);
+    timer->timer_fd = -1;
+}
+
+static void on_deadline(int fd, short revents, void* data) {
+    (void)revents;
+    JobTimer* timer = data;
+    uint64_t expirations;
+    if (read(fd, &expirations, sizeof(expirations)) < 0) return;
+    if (!any_alive(timer)) {
+        stop_clock(timer);
+        return;
+    }
+    if (!timer->expired) {
+        timer->expired = true;
+        signal_job(timer, timer->spec.signal);
+        if (timer->spec.kill_after > 0) {
+            arm(fd, timer->spec.kill_after);
+            return;
+        }
+    } else {
+        timer->killed = true;
+        signal_job(timer, SIGKILL);
+    }
+    stop_clock(timer);
+}
+
+static void on_exit_fd(int fd, short revents, void* data) {
+    (void)revents; (void)data;
+    event_loop_remove(fd); // It stays readable from now on; the wakeup was all it was watched for
+}
+
+JobTimer* job_timer_start(const TimeoutSpec* spec, pid_t pgid, bool own_group, const pid_t* pids, int num_pids) {
+    JobTimer* timer = calloc(1, sizeof(JobTimer));
+    if (timer) {
+        timer->pids = calloc(num_pids, sizeof(pid_t));
+        timer->pidfds = calloc(num_pids, sizeof(int));
+    }
+    if (!timer || !timer->pids || !timer->pidfds) {
+        print_shell_perror("timeout: malloc failed");
+        if (timer) {
+            free(timer->pids);
+            free(timer->pidfds);
+        }
+        free(timer);
+        return NULL;
+    }
+    timer->spec = *spec;
+    timer->pgid = pgid;
+    timer->own_group = own_group;
+    timer->timer_fd = fd_keep(timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK));
+    if (timer->timer_fd < 0 || event_loop_add(timer->timer_fd, POLLIN, on_deadline, timer) < 0) {
+        if (timer->timer_fd < 0) print_shell_perror("timeout: timerfd_create");
+        else fd_close(timer->timer_fd);
+        timer->timer_fd = -1;
+        job_timer_free(timer);
+        return NULL;
+    }
+#ifdef SYS_pidfd_open
+    for (int i = 0; i < num_pids; i++) {
+        // Not reaped yet, so each PID still names the process that was spawned.
+        int pidfd = fd_keep((int)syscall(SYS_pidfd_open, pids[i], 0));
+        if (pidfd < 0) continue;
+        timer->pids[timer->num_pidfds] = pids[i];
+        timer->pidfds[timer->num_pidfds++] = pidfd;
+        event_loop_add(pidfd, POLLIN, on_exit_fd, NULL);
+    }
+#endif
+    arm(timer->timer_fd, spec->seconds);
+    return timer;
+}
+
+void job_timer_close(JobTimer* timer) {
+    stop_clock(timer);
+    for (int i = 0; i < timer->num_pidfds; i++) {
+        event_loop_remove(timer->pidfds[i]);
+        fd_close(timer->pidfds[i]);
+    }
+    timer->num_pidfds = 0;
+}
+
+void job_timer_free(JobTimer* timer) {
+    if (!timer) return;
+    job_timer_close(timer);
+    free(timer->pids);
+    free(timer->pidfds);
+    free(timer);
+}
@@ -0,0 +1,180 @@
+#include "core/jobs.h"
+#include "core/event_loop.h"
+#include "utils/error.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+
+Job* job_create(const char* name, const pid_t* pids, int num_pids, bool own_group) {
+    Job* job = calloc(1, sizeof(Job));
+    if (!job) return NULL;
+    job->name = strdup(name);
+    job->members = calloc(num_pids, sizeof(JobMember));
+    if (!job->name || !job->members) {
+        job_free(job);
+        return NULL;
+    }
+    job->pgid = pids[0];
+    job->num_members = num_pids;
+    job->own_group = own_group;
+    for (int i = 0; i < num_pids; i++) {
+        job->members[i].pid = pids[i];
+        job->members[i].state = JOB_RUNNING;
+    }
+    return job;
+}
+
+void job_free(Job* job) {
+    if (!job) return;
+    cgroup_destroy(job->cgroup);
+    job_output_free(job->output);
+    job_timer_free(job->timer);
+    free(job->name);
+    free(job->members);
+    free(job);
+}
+
+JobState job_state(const Job* job) {
+    bool any_stopped = false;
+    for (int i = 0; i < job->num_members; i++) {
+        if (job->members[i].state == JOB_RUNNING) return JOB_RUNNING;
+        if (job->members[i].state == JOB_STOPPED) any_stopped = true;
+    }
+    return any_stopped ? JOB_STOPPED : JOB_DONE;
+}
+
+/**
+ * @brief Collects one state change of the processes selected by id_type/id.
+ * @param flags Extra waitid flags (WNOHANG or 0).
+ * @return True if a change was collected and there may be more.
+ */
+static bool collect_from(Job* job, idtype_t id_type, id_t id, int flags) {
+    siginfo_t info;
+    memset(&info, 0, sizeof(info));
+    if (waitid(id_type, id, &info, WEXITED | WSTOPPED | WCONTINUED | flags) < 0) {
+        if (errno == ECHILD) {
+            // Nothing left to wait for: members we never saw were reaped elsewhere.
+            for (int i = 0; i < job->num_members; i++) {
+                if (id_type == P_PGID || job->members[i].pid == (pid_t)id) job->members[i].state = JOB_DONE;
+            }
+        } else if (errno != EINTR) {
+            print_shell_perror("waitid failed");
+        }
+        return false;
+    }
+    if (info.si_pid == 0) return false; // WNOHANG: no change pending
+
+    for (int i = 0; i < job->num_members; i++) {
+        JobMember* member = &job->members[i];
+        if (member->pid != info.si_pid) continue;
+        switch (info.si_code) {
+        case CLD_EXITED:
+            member->state = JOB_DONE;
+            member->status = info.si_status;
+            break;
+        case CLD_KILLED:
+        case CLD_DUMPED:
+            member->state = JOB_DONE;
+            member->status = 128 + info.si_status;
+            break;
+        case CLD_STOPPED:
+        case CLD_TRAPPED:
+            member->state = JOB_STOPPED;
+            break;
+        case CLD_CONTINUED:
+            member->state = JOB_RUNNING;
+            break;
+        }
+        break;
+    }
+    return true;
+}
+
+/**
+ * @brief Collects one state change from the job's members.
+ *
+ * A job with its own process group is waited for as a group. Without one (in a
+ * subshell) its members share the group with unrelated children, so they are
+ * waited for by PID: all of them when polling, the first running one when blocking.
+ *
+ * @param flags Extra waitid flags (WNOHANG or 0).
+ * @return True if a change was collected and there may be more.
+ */
+static bool collect_one(Job* job, int flags) {
+    if (job->own_group) return collect_from(job, P_PGID, job->pgid, flags);
+
+    bool collected = false;
+    for (int i = 0; i < job->num_members; i++) {
+        if (job->members[i].state != JOB_RUNNING) continue;
+        if (collect_from(job, P_PID, job->members[i].pid, flags)) collected = true;
+        if (!(flags & WNOHANG)) break;
+    }
+    return collected;
+}
+
+void job_poll(Job* job) {
+    while (job_state(job) != JOB_DONE && collect_one(job, WNOHANG)) {}
+}
+
+JobState job_wait(Job* job) {
+    bool use_loop = signals_get_fd() >= 0 || job->timer;
+    for (;;) {
+        job_poll(job);
+        JobState state = job_state(job);
+        if (state != JOB_RUNNING) return state;
+        // Without the signalfd there is nothing to wake the loop: block in waitid instead.
+        if (use_loop) event_loop_run_once(-1, -1);
+        else collect_one(job, 0);
+    }
+}
+
+void job_mark_running(Job* job) {
+    for (int i = 0; i < job->num_members; i++) {
+        if (job->members[i].state == JOB_STOPPED) job->members[i].state = JOB_RUNNING;
+    }
+}
+
+int job_exit_status(const Job* job, bool pipefail) {
+    if (job_state(job) == JOB_STOPPED) return 128 + SIGTSTP;
+    if (job->timer && job->timer->expired) return job->timer->killed ? 128 + SIGKILL : TIMEOUT_STATUS;
+    if (pipefail) {
+        for (int i = job->num_members - 1; i >= 0; i--) {
+            if (job->members[i].status != 0) return job->members[i].status;
+        }
+        return 0;
+    }
+    return job->members[job->num_members - 1].status;
+}
+
+bool job_interrupted(const Job* job) {
+    if (job->timer && job->timer->expired) return false;
+    for (int i = 0; i < job->num_members; i++) {
+        if (job->members[i].status == 128 + SIGINT) return true;
+    }
+    return false;
+}
+
+bool job_table_add(JobTable* table, Job* job) {
+    if (table->count >= MAX_JOBS) return false;
+    table->jobs[table->count++] = job;
+    return true;
+}
+
+Job* job_table_find(const JobTable* table, pid_t pgid) {
+    for (int i = 0; i < table->count; i++) {
+        if (table->jobs[i]->pgid == pgid) return table->jobs[i];
+    }
+    return NULL;
+}
+
+void job_table_remove(JobTable* table, Job* job) {
+    for (int i = 0; i < table->count; i++) {
+        if (table->jobs[i] != job) continue;
+        memmove(&table->jobs[i], &table->jobs[i + 1], (table->count - i - 1) * sizeof(Job*));
+        table->count--;
+        return;
+    }
+}
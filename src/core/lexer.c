@@ -0,0 +1,388 @@
+#include "core/lexer.h"
+#include "core/parser.h"
+#include "utils/error.h"
+#include "utils/strbuf.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SPECIAL_PARAMS "?$#@*!"
+#define IO_NUMBER_MAX_DIGITS 4 ///< Longer digit runs before '<' or '>' stay part of a word
+
+void lexer_init(Lexer* lexer, const char* input) {
+    lexer->input = input;
+    lexer->pos = 0;
+}
+
+const char* token_name(TokenType type) {
+    switch (type) {
+    case TOK_WORD:    return "word";
+    case TOK_AND_IF:  return "&&";
+    case TOK_OR_IF:   return "||";
+    case TOK_PIPE:    return "|";
+    case TOK_AMP:     return "&";
+    case TOK_SEMI:    return ";";
+    case TOK_LESS:    return "<";
+    case TOK_GREAT:   return ">";
+    case TOK_DGREAT:  return ">>";
+    case TOK_DLESS:   return "<<";
+    case TOK_DLESSDASH: return "<<-";
+    case TOK_TLESS:   return "<<<";
+    case TOK_LESSAND: return "<&";
+    case TOK_GREATAND: return ">&";
+    case TOK_LESSGREAT: return "<>";
+    case TOK_CLOBBER: return ">|";
+    case TOK_AND_GREAT: return "&>";
+    case TOK_AND_DGREAT: return "&>>";
+    case TOK_LPAREN:  return "(";
+    case TOK_RPAREN:  return ")";
+    case TOK_NEWLINE: return "newline";
+    case TOK_EOF:     return "end of input";
+    }
+    return "?";
+}
+
+static bool is_operator_char(char c) {
+    return c == '|' || c == '&' || c == ';' || c == '<' || c == '>' || c == '(' || c == ')';
+}
+
+static bool is_name_start(char c) {
+    return isalpha((unsigned char)c) || c == '_';
+}
+
+static bool is_name_char(char c) {
+    return isalnum((unsigned char)c) || c == '_';
+}
+
+/**
+ * @brief Moves the pending literal text into the word as a PART_LITERAL.
+ */
+static bool flush_literal(Word* word, StrBuf* literal) {
+    if (literal->len == 0) return true;
+    bool ok = word_add_part(word, PART_LITERAL, literal->data, false);
+    strbuf_reset(literal);
+    return ok;
+}
+
+/**
+ * @brief Finds the ')' that closes a '(' whose contents start at 'pos'.
+ *
+ * Quotes, escapes, comments and nested parentheses (including those of nested
+ * substitutions) are skipped.
+ *
+ * @return The position of the ')', or -1 if the input ends first.
+ */
+static long find_closing_paren(const char* in, size_t pos) {
+    int depth = 1;
+    bool in_double_quotes = false;
+    while (in[pos]) {
+        char c = in[pos];
+        if (c == '\\') {
+            if (!in[pos + 1]) return -1;
+            pos += 2;
+            continue;
+        }
+        if (in_double_quotes) {
+            if (c == '"') {
+                in_double_quotes = false;
+            } else if (c == '$' && in[pos + 1] == '(') {
+                long close = find_closing_paren(in, pos + 2);
+                if (close < 0) return -1;
+                pos = (size_t)close;
+            }
+            pos++;
+            continue;
+        }
+        if (c == '\'') {
+            const char* close = strchr(in + pos + 1, '\'');
+            if (!close) return -1;
+            pos = close - in;
+        } else if (c == '"') {
+            in_double_quotes = true;
+        } else if (c == '#' && (pos == 0 || isspace((unsigned char)in[pos - 1]))) {
+            while (in[pos + 1] && in[pos + 1] != '\n') pos++;
+        } else if (c == '(') {
+            depth++;
+        } else if (c == ')' && --depth == 0) {
+            return (long)pos;
+        }
+        pos++;
+    }
+    return -1;
+}
+
+/**
+ * @brief Scans $(...), <(...) or >(...) at the lexer's position (the '(' is at pos + 1).
+ *
+ * The command is parsed here, once, and kept with the word; running it later
+ * does not look at the text again.
+ */
+static LexStatus scan_substitution(Lexer* lexer, Word* word, StrBuf* literal, WordPartType type, bool quoted) {
+    const char* in = lexer->input;
+    size_t start = lexer->pos + 2;
+    long close = find_closing_paren(in, start);
+    if (close < 0) return LEX_INCOMPLETE;
+
+    char* source = strndup(in + start, (size_t)close - start);
+    if (!source) return LEX_ERROR;
+    Node* command = NULL;
+    ParseStatus parsed = parse_program(source, &command);
+    if (parsed != PARSE_OK) {
+        if (parsed == PARSE_INCOMPLETE) print_shell_error("Syntax error: Incomplete command inside '$(...)'.");
+        free(source);
+        return LEX_ERROR;
+    }
+    bool ok = flush_literal(word, literal) && word_add_command_part(word, type, source, command, quoted);
+    free(source);
+    if (!ok) return LEX_ERROR;
+    lexer->pos = (size_t)close + 1;
+    return LEX_OK;
+}
+
+/**
+ * @brief Scans a '$' expansion at the lexer's position.
+ *
+ * Recognizes $name, ${name}, $0-$9 and the special parameters. A '$' that
+ * starts none of these is kept as literal text.
+ */
+static LexStatus scan_param(Lexer* lexer, Word* word, StrBuf* literal, bool quoted) {
+    const char* start = lexer->input + lexer->pos + 1; // Just past the '$'
+    const char* name = start;
+    size_t name_len = 0;
+    size_t consumed;
+
+    if (*start == '(') return scan_substitution(lexer, word, literal, PART_COMMAND, quoted);
+    if (*start == '{') {
+        name = start + 1;
+        const char* close = strchr(name, '}');
+        if (!close) return LEX_INCOMPLETE;
+        name_len = close - name;
+        consumed = name_len + 2;
+        bool valid = name_len > 0 && (is_name_start(name[0]) || isdigit((unsigned char)name[0]) ||
+                                      (name_len == 1 && strchr(SPECIAL_PARAMS, name[0])));
+        for (size_t i = 1; valid && i < name_len; i++) valid = is_name_char(name[i]);
+        if (!valid) { // Not something we expand: keep the text as written
+            lexer->pos++;
+            return strbuf_putc(literal, '$') ? LEX_OK : LEX_ERROR;
+        }
+    } else if (is_name_start(*start)) {
+        while (is_name_char(start[name_len])) name_len++;
+        consumed = name_len;
+    } else if (*start && (isdigit((unsigned char)*start) || strchr(SPECIAL_PARAMS, *start))) {
+        name_len = 1;
+        consumed = 1;
+    } else {
+        lexer->pos++;
+        return strbuf_putc(literal, '$') ? LEX_OK : LEX_ERROR;
+    }
+
+    char name_buf[256];
+    if (name_len >= sizeof(name_buf)) name_len = sizeof(name_buf) - 1;
+    memcpy(name_buf, name, name_len);
+    name_buf[name_len] = '\0';
+
+    if (!flush_literal(word, literal) || !word_add_part(word, PART_PARAM, name_buf, quoted)) {
+        return LEX_ERROR;
+    }
+    lexer->pos += 1 + consumed;
+    return LEX_OK;
+}
+
+/**
+ * @brief Scans a word, removing quotes and recording expansions.
+ */
+static LexStatus scan_word(Lexer* lexer, Word* word) {
+    StrBuf literal;
+    strbuf_init(&literal);
+    LexStatus status = LEX_OK;
+    const char* in = lexer->input;
+
+    while (status == LEX_OK) {
+        char c = in[lexer->pos];
+        if ((c == '<' || c == '>') && in[lexer->pos + 1] == '(' && literal.len == 0 && word->num_parts == 0) {
+            status = scan_substitution(lexer, word, &literal, c == '<' ? PART_PROCESS_IN : PART_PROCESS_OUT, false);
+            continue;
+        }
+        if (c == '\0' || c == ' ' || c == '\t' || c == '\r' || c == '\n' || is_operator_char(c)) break;
+
+        if (c == '\\') {
+            char next = in[lexer->pos + 1];
+            if (next == '\0') { status = LEX_INCOMPLETE; break; }
+            lexer->pos += 2;
+            if (next == '\n') continue; // Line continuation
+            word->has_quotes = true;
+            if (!strbuf_putc(&literal, next)) status = LEX_ERROR;
+        } else if (c == '\'') {
+            const char* close = strchr(in + lexer->pos + 1, '\'');
+            if (!close) { status = LEX_INCOMPLETE; break; }
+            const char* text = in + lexer->pos + 1;
+            word->has_quotes = true;
+            if (!strbuf_append(&literal, text, close - text)) status = LEX_ERROR;
+            lexer->pos = close - in + 1;
+        } else if (c == '"') {
+            word->has_quotes = true;
+            lexer->pos++;
+            for (;;) {
+                char q = in[lexer->pos];
+                if (q == '\0') { status = LEX_INCOMPLETE; break; }
+                if (q == '"') { lexer->pos++; break; }
+                if (q == '\\' && in[lexer->pos + 1] && strchr("$`\"\\\n", in[lexer->pos + 1])) {
+                    char next = in[lexer->pos + 1];
+                    lexer->pos += 2;
+                    if (next != '\n' && !strbuf_putc(&literal, next)) { status = LEX_ERROR; break; }
+                } else if (q == '$') {
+                    status = scan_param(lexer, word, &literal, true);
+                    if (status != LEX_OK) break;
+                } else {
+                    lexer->pos++;
+                    if (!strbuf_putc(&literal, q)) { status = LEX_ERROR; break; }
+                }
+            }
+        } else if (c == '$') {
+            status = scan_param(lexer, word, &literal, false);
+        } else if (c == '=' && word->num_parts == 0 && !word->has_quotes && word->assign_len == 0 &&
+                   literal.len > 0 && is_name_start(literal.data[0])) {
+            // An unquoted NAME= prefix makes the word an assignment (if it precedes the command name).
+            bool valid = true;
+            for (size_t i = 1; valid && i < literal.len; i++) valid = is_name_char(literal.data[i]);
+            if (valid) word->assign_len = literal.len + 1;
+            lexer->pos++;
+            if (!strbuf_putc(&literal, c)) status = LEX_ERROR;
+        } else {
+            lexer->pos++;
+            if (!strbuf_putc(&literal, c)) status = LEX_ERROR;
+        }
+    }
+
+    if (status == LEX_OK && !flush_literal(word, &literal)) status = LEX_ERROR;
+    // A word made only of empty quotes ("" or '') is still an (empty) argument.
+    if (status == LEX_OK && word->num_parts == 0 && !word_add_part(word, PART_LITERAL, "", false)) {
+        status = LEX_ERROR;
+    }
+    strbuf_free(&literal);
+    if (status != LEX_OK) word_clear(word);
+    return status;
+}
+
+LexStatus lexer_scan_heredoc(const char* body, Word* word) {
+    Lexer lexer;
+    lexer_init(&lexer, body);
+    StrBuf literal;
+    strbuf_init(&literal);
+    memset(word, 0, sizeof(*word));
+    LexStatus status = LEX_OK;
+
+    while (status == LEX_OK && body[lexer.pos]) {
+        char c = body[lexer.pos];
+        if (c == '\\' && body[lexer.pos + 1] && strchr("$`\\\n", body[lexer.pos + 1])) {
+            char next = body[lexer.pos + 1];
+            lexer.pos += 2;
+            if (next != '\n' && !strbuf_putc(&literal, next)) status = LEX_ERROR;
+        } else if (c == '$') {
+            status = scan_param(&lexer, word, &literal, true);
+        } else {
+            lexer.pos++;
+            if (!strbuf_putc(&literal, c)) status = LEX_ERROR;
+        }
+    }
+    if (status == LEX_INCOMPLETE) {
+        print_shell_error("Syntax error: Unterminated expansion in here-document.");
+        status = LEX_ERROR;
+    }
+    if (status == LEX_OK && !flush_literal(word, &literal)) status = LEX_ERROR;
+    strbuf_free(&literal);
+    if (status != LEX_OK) word_clear(word);
+    return status;
+}
+
+LexStatus lexer_next(Lexer* lexer, Token* token) {
+    const char* in = lexer->input;
+    memset(token, 0, sizeof(*token));
+    token->io_number = -1;
+
+    // Skip blanks and comments.
+    for (;;) {
+        char c = in[lexer->pos];
+        if (c == ' ' || c == '\t' || c == '\r') {
+            lexer->pos++;
+        } else if (c == '\\' && in[lexer->pos + 1] == '\n') {
+            lexer->pos += 2;
+        } else if (c == '#') {
+            while (in[lexer->pos] && in[lexer->pos] != '\n') lexer->pos++;
+        } else {
+            break;
+        }
+    }
+
+    // Digits right before '<' or '>' name the descriptor to redirect, as in 2>file.
+    size_t digits_end = lexer->pos;
+    while (isdigit((unsigned char)in[digits_end])) digits_end++;
+    if (digits_end > lexer->pos && digits_end - lexer->pos <= IO_NUMBER_MAX_DIGITS &&
+        (in[digits_end] == '<' || in[digits_end] == '>') && in[digits_end + 1] != '(') {
+        token->io_number = atoi(in + lexer->pos);
+        lexer->pos = digits_end;
+    }
+
+    char c = in[lexer->pos];
+    char next = c ? in[lexer->pos + 1] : '\0';
+    size_t length = 1;
+    if ((c == '<' || c == '>') && next == '(') { // Process substitution, not a redirection
+        token->type = TOK_WORD;
+        return scan_word(lexer, &token->word);
+    }
+    switch (c) {
+    case '\0': token->type = TOK_EOF; length = 0; break;
+    case '\n': token->type = TOK_NEWLINE; break;
+    case ';':  token->type = TOK_SEMI; break;
+    case '(':  token->type = TOK_LPAREN; break;
+    case ')':  token->type = TOK_RPAREN; break;
+    case '<':
+        if (next == '&' || next == '>') {
+            token->type = (next == '&') ? TOK_LESSAND : TOK_LESSGREAT;
+            length = 2;
+        } else if (next != '<') {
+            token->type = TOK_LESS;
+        } else if (in[lexer->pos + 2] == '<') {
+            token->type = TOK_TLESS;
+            length = 3;
+        } else if (in[lexer->pos + 2] == '-') {
+            token->type = TOK_DLESSDASH;
+            length = 3;
+        } else {
+            token->type = TOK_DLESS;
+            length = 2;
+        }
+        break;
+    case '&':
+        if (next == '>' && in[lexer->pos + 2] == '>') {
+            token->type = TOK_AND_DGREAT;
+            length = 3;
+        } else if (next == '>') {
+            token->type = TOK_AND_GREAT;
+            length = 2;
+        } else {
+            token->type = (next == '&') ? TOK_AND_IF : TOK_AMP;
+            length = (next == '&') ? 2 : 1;
+        }
+        break;
+    case '|':
+        token->type = (next == '|') ? TOK_OR_IF : TOK_PIPE;
+        length = (next == '|') ? 2 : 1;
+        break;
+    case '>':
+        switch (next) {
+        case '>': token->type = TOK_DGREAT; break;
+        case '&': token->type = TOK_GREATAND; break;
+        case '|': token->type = TOK_CLOBBER; break;
+        default:  token->type = TOK_GREAT; break;
+        }
+        length = (token->type == TOK_GREAT) ? 1 : 2;
+        break;
+    default:
+        token->type = TOK_WORD;
+        return scan_word(lexer, &token->word);
+    }
+    lexer->pos += length;
+    return LEX_OK;
+}
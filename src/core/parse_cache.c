@@ -0,0 +1,63 @@
+#include "core/parse_cache.h"
+#include "core/aliases.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PARSE_CACHE_SLOTS 64       ///< A power of two
+#define PARSE_CACHE_MAX_TEXT 4096  ///< Longer inputs (scripts, here-documents) are not kept
+
+typedef struct {
+    uint64_t hash;
+    char* text;
+    Node* tree;
+    unsigned alias_generation;
+} CacheEntry;
+
+static CacheEntry cache[PARSE_CACHE_SLOTS];
+
+/**
+ * @brief 64-bit FNV-1a, also giving the length it walked.
+ */
+static uint64_t hash_text(const char* text, size_t* len) {
+    uint64_t hash = 14695981039346656037ull;
+    const unsigned char* p = (const unsigned char*)text;
+    for (; *p; p++) {
+        hash ^= *p;
+        hash *= 1099511628211ull;
+    }
+    *len = (size_t)(p - (const unsigned char*)text);
+    return hash;
+}
+
+static void clear_entry(CacheEntry* entry) {
+    free(entry->text);
+    node_free(entry->tree);
+    memset(entry, 0, sizeof(*entry));
+}
+
+ParseStatus parse_cached(const char* input, Node** tree_out) {
+    size_t len;
+    uint64_t hash = hash_text(input, &len);
+    if (len > PARSE_CACHE_MAX_TEXT) return parse_program(input, tree_out);
+
+    CacheEntry* entry = &cache[hash & (PARSE_CACHE_SLOTS - 1)];
+    if (entry->tree && entry->hash == hash && entry->alias_generation == alias_generation() &&
+        strcmp(entry->text, input) == 0) {
+        *tree_out = node_retain(entry->tree);
+        return PARSE_OK;
+    }
+
+    ParseStatus status = parse_program(input, tree_out);
+    if (status != PARSE_OK || !*tree_out) return status;
+    char* text = strdup(input);
+    if (!text) return status; // Not caching is harmless
+    clear_entry(entry);
+    *entry = (CacheEntry){hash, text, node_retain(*tree_out), alias_generation()};
+    return status;
+}
+
+void parse_cache_clear(void) {
+    for (int i = 0; i < PARSE_CACHE_SLOTS; i++) clear_entry(&cache[i]);
+}
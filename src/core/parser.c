@@ -1,101 +1,677 @@
 #include "core/parser.h"
+#include "core/lexer.h"
+#include "core/aliases.h"
+#include "core/vars.h"
 #include "utils/error.h"
-#include <string.h>
+#include "utils/strbuf.h"
+#include "utils/trace.h"
+
+#include <stdio.h>
 #include <stdlib.h>
-#include <ctype.h>
-
-// This was previously in main.c
-static bool parse_simple_command(char* command_str, SimpleCommand* cmd) {
-    cmd->input_file = NULL;
-    cmd->output_file = NULL;
-    cmd->append_mode = false;
-    for (int i = 0; i < MAX_ARGS; i++) {
-        cmd->args[i] = NULL;
-    }
-
-    char* saveptr;
-    char temp_str[MAX_COMMAND_LEN];
-    strncpy(temp_str, command_str, sizeof(temp_str) - 1);
-    temp_str[sizeof(temp_str) - 1] = '\0';
-
-    int argc = 0;
-    char* token = strtok_r(temp_str, " \t\n\r", &saveptr);
-    while (token != NULL) {
-        if (strcmp(token, "<") == 0) {
-            if (cmd->input_file) { print_shell_error("Syntax error: Ambiguous input redirect."); return false; }
-            token = strtok_r(NULL, " \t\n\r", &saveptr);
-            if (!token || strcmp(token, ">") == 0 || strcmp(token, ">>") == 0 || strcmp(token, "<") == 0) {
-                print_shell_error("Syntax error: Missing name for input redirect."); return false;
+#include <string.h>
+
+#define ALIAS_MAX_DEPTH 16 ///< Aliases that may expand into one another for one command word
+
+/**
+ * @brief A here-document whose body has not been read yet (it starts on the next line).
+ */
+typedef struct {
+    Node* command;
+    int redirect_index;
+    HeredocEnd end;   ///< With <<-, leading tabs are also removed from each line of the body
+    bool quoted;      ///< The delimiter was quoted: the body is taken literally
+} PendingHeredoc;
+
+typedef struct {
+    Lexer lexer;
+    Token current;
+    ParseStatus status;
+    PendingHeredoc* pending;
+    int num_pending;
+    int pending_capacity;
+    int open_heredoc;     ///< The first pending here-document whose body the input ended in, or -1
+    char** alias_texts;   ///< Inputs rewritten by alias expansion, freed with the parser
+    int num_alias_texts;
+    char* alias_chain[ALIAS_MAX_DEPTH]; ///< Aliases expanded for the current command word
+    int alias_depth;
+} Parser;
+
+bool heredoc_end_matches(const HeredocEnd* end, const char* line, size_t len) {
+    if (end->strip_tabs) {
+        while (len > 0 && *line == '\t') { line++; len--; }
+    }
+    return len == strlen(end->delimiter) && memcmp(line, end->delimiter, len) == 0;
+}
+
+void heredoc_ends_free(HeredocEnd* ends, int count) {
+    for (int i = 0; i < count; i++) free(ends[i].delimiter);
+    free(ends);
+}
+
+/**
+ * @brief Reads the bodies of the pending here-documents, which follow the line
+ *        just ended, and moves the lexer past them. If the input ends inside
+ *        one, the pending list is kept for parse_program_open() to report.
+ */
+static void read_heredoc_bodies(Parser* p) {
+    const char* in = p->lexer.input;
+    size_t pos = p->lexer.pos;
+    for (int i = 0; i < p->num_pending && p->status == PARSE_OK; i++) {
+        PendingHeredoc* heredoc = &p->pending[i];
+        StrBuf body;
+        strbuf_init(&body);
+        for (;;) {
+            // Running out of input before the delimiter line means more lines are needed.
+            if (!in[pos]) { p->status = PARSE_INCOMPLETE; break; }
+            const char* line = in + pos;
+            size_t len = strcspn(line, "\n");
+            const char* text = line;
+            size_t text_len = len;
+            if (heredoc->end.strip_tabs) {
+                while (text_len > 0 && *text == '\t') { text++; text_len--; }
             }
-            cmd->input_file = strdup(token);
-        } else if (strcmp(token, ">") == 0) {
-            if (cmd->output_file) { print_shell_error("Syntax error: Ambiguous output redirect."); return false; }
-            token = strtok_r(NULL, " \t\n\r", &saveptr);
-            if (!token || strcmp(token, ">") == 0 || strcmp(token, ">>") == 0 || strcmp(token, "<") == 0) {
-                print_shell_error("Syntax error: Missing name for output redirect."); return false;
+            pos += len + (line[len] == '\n');
+            if (heredoc_end_matches(&heredoc->end, line, len)) break;
+            if (line[len] != '\n') { p->status = PARSE_INCOMPLETE; break; }
+            if (!strbuf_append(&body, text, text_len) || !strbuf_putc(&body, '\n')) {
+                p->status = PARSE_ERROR;
+                break;
             }
-            cmd->output_file = strdup(token);
-            cmd->append_mode = false;
-        } else if (strcmp(token, ">>") == 0) {
-            if (cmd->output_file) { print_shell_error("Syntax error: Ambiguous output redirect."); return false; }
-            token = strtok_r(NULL, " \t\n\r", &saveptr);
-            if (!token || strcmp(token, ">") == 0 || strcmp(token, ">>") == 0 || strcmp(token, "<") == 0) {
-                print_shell_error("Syntax error: Missing name for output redirect."); return false;
+        }
+
+        Word word;
+        memset(&word, 0, sizeof(word));
+        if (p->status == PARSE_OK) {
+            const char* text = body.data ? body.data : "";
+            bool ok = heredoc->quoted ? word_add_part(&word, PART_LITERAL, text, true)
+                                      : lexer_scan_heredoc(text, &word) == LEX_OK;
+            if (ok) {
+                Redirect* redirect = &heredoc->command->redirects[heredoc->redirect_index];
+                word_clear(&redirect->target);
+                redirect->target = word;
+            } else {
+                p->status = PARSE_ERROR;
             }
-            cmd->output_file = strdup(token);
-            cmd->append_mode = true;
+        }
+        strbuf_free(&body);
+        if (p->status == PARSE_INCOMPLETE) {
+            p->open_heredoc = i;
+            return;
+        }
+    }
+    p->lexer.pos = pos;
+    for (int i = 0; i < p->num_pending; i++) free(p->pending[i].end.delimiter);
+    p->num_pending = 0;
+}
+
+/**
+ * @brief Moves to the next token, releasing the current one's word if it was not taken.
+ * @return False if the input could not be tokenized (the status says why).
+ */
+static bool advance(Parser* p) {
+    word_clear(&p->current.word);
+    LexStatus lex = lexer_next(&p->lexer, &p->current);
+    if (lex == LEX_OK) {
+        if (p->current.type == TOK_NEWLINE && p->num_pending > 0) read_heredoc_bodies(p);
+        return true;
+    }
+    p->current.type = TOK_EOF;
+    if (p->status == PARSE_OK) p->status = (lex == LEX_INCOMPLETE) ? PARSE_INCOMPLETE : PARSE_ERROR;
+    return false;
+}
+
+/**
+ * @brief Remembers a here-document, whose body will be read after the current line.
+ * @param delimiter_word The word after '<<' (its text, with quotes removed, is the delimiter).
+ */
+static bool add_pending_heredoc(Parser* p, Node* command, const Word* delimiter_word, bool strip_tabs) {
+    if (p->num_pending >= p->pending_capacity) {
+        int new_capacity = p->pending_capacity ? p->pending_capacity * 2 : 4;
+        PendingHeredoc* grown = realloc(p->pending, sizeof(PendingHeredoc) * new_capacity);
+        if (!grown) return false;
+        p->pending = grown;
+        p->pending_capacity = new_capacity;
+    }
+    // The delimiter is never expanded: '$' in it is just a character.
+    StrBuf delimiter;
+    strbuf_init(&delimiter);
+    for (int i = 0; i < delimiter_word->num_parts; i++) {
+        const WordPart* part = &delimiter_word->parts[i];
+        if (part->type == PART_PARAM) strbuf_putc(&delimiter, '$');
+        strbuf_append_str(&delimiter, part->text);
+    }
+    char* text = strbuf_detach(&delimiter);
+    if (!text) return false;
+    p->pending[p->num_pending++] = (PendingHeredoc){command, command->num_redirects - 1, {text, strip_tabs},
+                                                    delimiter_word->has_quotes};
+    return true;
+}
+
+static void syntax_error(Parser* p, const char* message) {
+    if (p->status != PARSE_OK) return;
+    print_shell_error(message);
+    p->status = PARSE_ERROR;
+}
+
+/**
+ * @brief Reports the current token as unexpected. Running out of input where
+ *        something is required is not an error: more lines may follow.
+ */
+static void unexpected_token(Parser* p) {
+    if (p->status != PARSE_OK) return;
+    if (p->current.type == TOK_EOF) {
+        p->status = PARSE_INCOMPLETE;
+        return;
+    }
+    char message[128];
+    snprintf(message, sizeof(message), "Syntax error: Unexpected token '%s'.",
+             p->current.type == TOK_WORD ? p->current.word.parts[0].text : token_name(p->current.type));
+    syntax_error(p, message);
+}
+
+static void skip_newlines(Parser* p) {
+    while (p->status == PARSE_OK && p->current.type == TOK_NEWLINE) advance(p);
+}
+
+static bool at_word(const Parser* p, const char* text) {
+    return p->current.type == TOK_WORD && word_is_bare(&p->current.word, text);
+}
+
+/**
+ * @brief True at a reserved word that ends the list inside a compound command.
+ *        Like any reserved word, it is only recognized where a command could start.
+ */
+static bool at_list_end(const Parser* p) {
+    static const char* const closing[] = {"}", "then", "elif", "else", "fi", "do", "done", NULL};
+    if (p->current.type != TOK_WORD) return false;
+    for (int i = 0; closing[i]; i++) {
+        if (word_is_bare(&p->current.word, closing[i])) return true;
+    }
+    return false;
+}
+
+static Node* new_binary(NodeType type, Node* left, Node* right) {
+    Node* node = node_new(type);
+    if (!node) {
+        node_free(left);
+        node_free(right);
+        return NULL;
+    }
+    node->left = left;
+    node->right = right;
+    return node;
+}
+
+static Node* parse_list(Parser* p, bool nested);
+
+/**
+ * @brief The redirection an operator token introduces.
+ * @return False if the token is not a redirection operator.
+ */
+static bool redirect_type_for(TokenType token, RedirectType* type) {
+    switch (token) {
+    case TOK_LESS:       *type = REDIR_INPUT; break;
+    case TOK_GREAT:      *type = REDIR_OUTPUT; break;
+    case TOK_CLOBBER:    *type = REDIR_CLOBBER; break;
+    case TOK_DGREAT:     *type = REDIR_APPEND; break;
+    case TOK_LESSGREAT:  *type = REDIR_READ_WRITE; break;
+    case TOK_LESSAND:    *type = REDIR_DUP_INPUT; break;
+    case TOK_GREATAND:   *type = REDIR_DUP_OUTPUT; break;
+    case TOK_AND_GREAT:  *type = REDIR_OUTPUT_ALL; break;
+    case TOK_AND_DGREAT: *type = REDIR_APPEND_ALL; break;
+    case TOK_DLESS:
+    case TOK_DLESSDASH:  *type = REDIR_HEREDOC; break;
+    case TOK_TLESS:      *type = REDIR_HERESTRING; break;
+    default:             return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Parses one redirection, if the current token starts one, and adds it to 'node'.
+ * @return True if a redirection was parsed; false if there was none or on error (see the status).
+ */
+static bool parse_redirect(Parser* p, Node* node) {
+    TokenType token = p->current.type;
+    int fd = p->current.io_number;
+    RedirectType type;
+    if (!redirect_type_for(token, &type) || !advance(p)) return false;
+    if (p->current.type != TOK_WORD) {
+        if (type == REDIR_HEREDOC) {
+            syntax_error(p, "Syntax error: Missing here-document delimiter.");
         } else {
-            if (argc < MAX_ARGS - 1) {
-                cmd->args[argc++] = strdup(token);
-            }
+            char message[64];
+            snprintf(message, sizeof(message), "Syntax error: Missing target for '%s'.", token_name(token));
+            syntax_error(p, message);
+        }
+        return false;
+    }
+    if (type == REDIR_HEREDOC) {
+        // The target stays empty until the body has been read from the following lines.
+        Word placeholder;
+        memset(&placeholder, 0, sizeof(placeholder));
+        if (!node_add_redirect(node, type, fd, &placeholder) ||
+            !add_pending_heredoc(p, node, &p->current.word, token == TOK_DLESSDASH)) {
+            p->status = PARSE_ERROR;
+            return false;
         }
-        token = strtok_r(NULL, " \t\n\r", &saveptr);
+    } else if (!node_add_redirect(node, type, fd, &p->current.word)) {
+        p->status = PARSE_ERROR;
+        return false;
+    }
+    advance(p);
+    return p->status == PARSE_OK;
+}
+
+static void reset_alias_chain(Parser* p) {
+    for (int i = 0; i < p->alias_depth; i++) free(p->alias_chain[i]);
+    p->alias_depth = 0;
+}
+
+/**
+ * @brief Replaces the current word with the text of the alias it names.
+ *
+ * The rest of the input is appended to the alias text and lexing continues in
+ * the combined text, so an alias may stand for several words, a pipeline or a
+ * list. An alias is not expanded again within its own expansion, which makes
+ * alias ls='ls -F' work.
+ *
+ * @return True if the word was an alias; the current token is then the first of its text.
+ */
+static bool expand_alias(Parser* p) {
+    const Word* word = &p->current.word;
+    if (word->num_parts != 1 || word->parts[0].type != PART_LITERAL || word->has_quotes) return false;
+    const char* name = word->parts[0].text;
+    const char* value = alias_get(name);
+    if (!value || p->alias_depth >= ALIAS_MAX_DEPTH) return false;
+    for (int i = 0; i < p->alias_depth; i++) {
+        if (strcmp(p->alias_chain[i], name) == 0) return false;
     }
-    cmd->args[argc] = NULL;
+
+    const char* rest = p->lexer.input + p->lexer.pos;
+    size_t value_len = strlen(value), rest_len = strlen(rest);
+    char* text = malloc(value_len + rest_len + 2);
+    char* chain_name = strdup(name);
+    char** texts = realloc(p->alias_texts, sizeof(char*) * (p->num_alias_texts + 1));
+    if (texts) p->alias_texts = texts;
+    if (!text || !chain_name || !texts) {
+        print_shell_perror("parser: malloc for alias expansion failed");
+        free(text);
+        free(chain_name);
+        p->status = PARSE_ERROR;
+        return false;
+    }
+    memcpy(text, value, value_len);
+    text[value_len] = ' ';
+    memcpy(text + value_len + 1, rest, rest_len + 1);
+    p->alias_texts[p->num_alias_texts++] = text;
+    p->alias_chain[p->alias_depth++] = chain_name;
+    lexer_init(&p->lexer, text);
+    advance(p);
     return true;
 }
 
-int parse_pipeline(char* command_str, SimpleCommand commands[], int max_commands, bool* is_background) {
-    *is_background = false;
-    char* ampersand = strrchr(command_str, '&');
-    if (ampersand != NULL && (*(ampersand - 1) == ' ' || *(ampersand - 1) == '\t') && *(ampersand + 1) == '\0') {
-        *is_background = true;
-        *ampersand = '\0'; // Remove the ampersand from the string
+static Node* parse_command(Parser* p);
+
+/**
+ * @brief Parses 'name() { ...; }' once the '(' is the current token.
+ * @param command The command parsed so far, holding just the name. Ownership is taken.
+ */
+static Node* parse_function(Parser* p, Node* command) {
+    const Word* name = command->num_words == 1 ? &command->words[0] : NULL;
+    if (!name || command->num_redirects > 0 || name->num_parts != 1 || name->has_quotes ||
+        name->parts[0].type != PART_LITERAL || strchr(name->parts[0].text, '=')) {
+        unexpected_token(p);
+        node_free(command);
+        return NULL;
+    }
+    advance(p);
+    if (p->current.type != TOK_RPAREN) {
+        unexpected_token(p);
+        node_free(command);
+        return NULL;
+    }
+    advance(p);
+    skip_newlines(p);
+    if (p->status == PARSE_OK && p->current.type != TOK_EOF && !at_word(p, "{")) {
+        syntax_error(p, "Syntax error: A function body must be a { ...; } group.");
+    }
+    Node* body = (p->status == PARSE_OK) ? parse_command(p) : NULL;
+    Node* function = body ? node_new(NODE_FUNCTION) : NULL;
+    if (!function || !node_add_word(function, &command->words[0])) {
+        if (body && p->status == PARSE_OK) p->status = PARSE_ERROR;
+        node_free(body);
+        node_free(function);
+        node_free(command);
+        return NULL;
+    }
+    node_free(command);
+    function->left = body;
+    return function;
+}
+
+static Node* parse_simple_command(Parser* p) {
+    Node* command = node_new(NODE_COMMAND);
+    if (!command) { p->status = PARSE_ERROR; return NULL; }
+
+    while (p->status == PARSE_OK) {
+        if (p->current.type == TOK_WORD) {
+            if (command->num_words == 0) {
+                if (expand_alias(p)) continue;
+                reset_alias_chain(p);
+            }
+            if (!node_add_word(command, &p->current.word)) break;
+            advance(p);
+        } else if (p->current.type == TOK_LPAREN) {
+            return parse_function(p, command);
+        } else if (!parse_redirect(p, command)) {
+            break;
+        }
+    }
+
+    if (p->status == PARSE_OK && command->num_words == 0) {
+        if (command->num_redirects > 0) syntax_error(p, "Syntax error: Missing command name.");
+        else unexpected_token(p);
+    }
+    if (p->status != PARSE_OK) {
+        node_free(command);
+        return NULL;
+    }
+    return command;
+}
+
+/**
+ * @brief Parses the list inside a compound command, which may not be empty.
+ */
+static Node* parse_compound_list(Parser* p) {
+    Node* list = parse_list(p, true);
+    if (!list) unexpected_token(p); // Empty, or input ended before the list did
+    return list;
+}
+
+/**
+ * @brief Consumes the reserved word 'text', which must be the current token.
+ */
+static bool expect_word(Parser* p, const char* text) {
+    if (p->status != PARSE_OK) return false;
+    if (!at_word(p, text)) {
+        unexpected_token(p);
+        return false;
+    }
+    advance(p);
+    return p->status == PARSE_OK;
+}
+
+/**
+ * @brief Consumes the word that closes a compound command, then any
+ *        redirections after it, which apply to the whole command.
+ * @param node The command parsed so far. It is freed on failure.
+ */
+static Node* finish_compound(Parser* p, Node* node, const char* closing) {
+    if (expect_word(p, closing)) {
+        while (parse_redirect(p, node)) {}
+    }
+    if (p->status != PARSE_OK) {
+        node_free(node);
+        return NULL;
+    }
+    return node;
+}
+
+static Node* parse_group(Parser* p) {
+    advance(p);
+    Node* body = parse_compound_list(p);
+    if (!body) return NULL;
+    Node* group = node_new(NODE_GROUP);
+    if (!group) { node_free(body); p->status = PARSE_ERROR; return NULL; }
+    group->left = body;
+    return finish_compound(p, group, "}");
+}
+
+/**
+ * @brief Parses from 'if' or 'elif' up to the closing 'fi', which is left for the caller.
+ */
+static Node* parse_if_clause(Parser* p) {
+    advance(p);
+    Node* node = node_new(NODE_IF);
+    if (!node) { p->status = PARSE_ERROR; return NULL; }
+    node->left = parse_compound_list(p);
+    if (node->left && expect_word(p, "then")) node->right = parse_compound_list(p);
+    if (node->right) {
+        if (at_word(p, "elif")) {
+            node->alternate = parse_if_clause(p);
+        } else if (at_word(p, "else") && advance(p)) {
+            node->alternate = parse_compound_list(p);
+        }
+    }
+    if (p->status != PARSE_OK) {
+        node_free(node);
+        return NULL;
+    }
+    return node;
+}
+
+/**
+ * @brief Parses the 'do list done' that ends a while, until or for loop.
+ * @param loop The loop parsed so far. It is freed on failure.
+ */
+static Node* parse_loop_body(Parser* p, Node* loop) {
+    if (expect_word(p, "do")) loop->right = parse_compound_list(p);
+    if (!loop->right) {
+        node_free(loop);
+        return NULL;
+    }
+    return finish_compound(p, loop, "done");
+}
+
+static Node* parse_while(Parser* p) {
+    Node* loop = node_new(at_word(p, "while") ? NODE_WHILE : NODE_UNTIL);
+    if (!loop) { p->status = PARSE_ERROR; return NULL; }
+    advance(p);
+    loop->left = parse_compound_list(p);
+    if (!loop->left) {
+        node_free(loop);
+        return NULL;
+    }
+    return parse_loop_body(p, loop);
+}
+
+/**
+ * @brief Parses 'for name [in word...]; do list done'. Without 'in', the loop
+ *        runs over "$@", which is stored as the list so the executor need not know.
+ */
+static Node* parse_for(Parser* p) {
+    advance(p);
+    const Word* name = &p->current.word;
+    if (p->current.type != TOK_WORD || name->num_parts != 1 || name->has_quotes ||
+        name->parts[0].type != PART_LITERAL || !vars_valid_name(name->parts[0].text, strlen(name->parts[0].text))) {
+        if (p->current.type == TOK_WORD) syntax_error(p, "Syntax error: Bad variable name in 'for'.");
+        else unexpected_token(p);
+        return NULL;
+    }
+    Node* loop = node_new(NODE_FOR);
+    if (!loop || !node_add_word(loop, &p->current.word)) {
+        node_free(loop);
+        p->status = PARSE_ERROR;
+        return NULL;
+    }
+    advance(p);
+
+    bool has_list = false;
+    if (p->current.type == TOK_SEMI) {
+        advance(p);
+    } else {
+        skip_newlines(p);
+        if (at_word(p, "in")) {
+            has_list = true;
+            advance(p);
+            while (p->status == PARSE_OK && p->current.type == TOK_WORD) {
+                if (!node_add_word(loop, &p->current.word)) p->status = PARSE_ERROR;
+                else advance(p);
+            }
+            if (p->current.type == TOK_SEMI || p->current.type == TOK_NEWLINE) advance(p);
+            else unexpected_token(p);
+        }
+    }
+    if (!has_list && p->status == PARSE_OK) {
+        Word all;
+        memset(&all, 0, sizeof(all));
+        if (!word_add_part(&all, PART_PARAM, "@", true) || !node_add_word(loop, &all)) {
+            word_clear(&all);
+            p->status = PARSE_ERROR;
+        }
+    }
+    skip_newlines(p);
+    if (p->status != PARSE_OK) {
+        node_free(loop);
+        return NULL;
     }
+    return parse_loop_body(p, loop);
+}
 
-    int num_commands = 0;
-    char* pipe_saveptr;
-    char* pipe_segment = strtok_r(command_str, "|", &pipe_saveptr);
+static Node* parse_command(Parser* p) {
+    if (at_list_end(p)) {
+        unexpected_token(p);
+        return NULL;
+    }
+    if (at_word(p, "{")) return parse_group(p);
+    if (at_word(p, "if")) {
+        Node* node = parse_if_clause(p);
+        return node ? finish_compound(p, node, "fi") : NULL;
+    }
+    if (at_word(p, "while") || at_word(p, "until")) return parse_while(p);
+    if (at_word(p, "for")) return parse_for(p);
+    return parse_simple_command(p);
+}
 
-    while(pipe_segment != NULL && num_commands < max_commands) {
-        while (isspace((unsigned char)*pipe_segment)) pipe_segment++;
-        char* pipe_end = pipe_segment + strlen(pipe_segment) - 1;
-        while (pipe_end > pipe_segment && isspace((unsigned char)*pipe_end)) pipe_end--;
-        *(pipe_end + 1) = '\0';
+static Node* parse_pipeline(Parser* p) {
+    Node* first = parse_command(p);
+    if (!first || p->current.type != TOK_PIPE) return first;
 
-        if (strlen(pipe_segment) == 0) {
-            print_shell_error("Syntax error: Unexpected null command in pipeline.");
-            free_simple_commands(commands, num_commands);
-            return -1;
+    Node* pipeline = node_new(NODE_PIPELINE);
+    if (!pipeline || !node_add_stage(pipeline, first)) {
+        node_free(first);
+        node_free(pipeline);
+        p->status = PARSE_ERROR;
+        return NULL;
+    }
+    while (p->status == PARSE_OK && p->current.type == TOK_PIPE) {
+        advance(p);
+        skip_newlines(p);
+        Node* stage = parse_command(p);
+        if (!stage) break;
+        if (!node_add_stage(pipeline, stage)) {
+            node_free(stage);
+            p->status = PARSE_ERROR;
         }
+    }
+    if (p->status != PARSE_OK) {
+        node_free(pipeline);
+        return NULL;
+    }
+    return pipeline;
+}
 
-        if (!parse_simple_command(pipe_segment, &commands[num_commands])) {
-            free_simple_commands(commands, num_commands);
-            return -1;
+static Node* parse_and_or(Parser* p) {
+    Node* left = parse_pipeline(p);
+    while (left && (p->current.type == TOK_AND_IF || p->current.type == TOK_OR_IF)) {
+        NodeType type = (p->current.type == TOK_AND_IF) ? NODE_AND : NODE_OR;
+        advance(p);
+        skip_newlines(p);
+        Node* right = parse_pipeline(p);
+        if (!right) {
+            node_free(left);
+            return NULL;
         }
-        num_commands++;
-        pipe_segment = strtok_r(NULL, "|", &pipe_saveptr);
+        left = new_binary(type, left, right);
+        if (!left) p->status = PARSE_ERROR;
     }
+    return left;
+}
+
+/**
+ * @param nested Inside a compound command: stop at the reserved word that closes it.
+ */
+static Node* parse_list(Parser* p, bool nested) {
+    Node* result = NULL;
+    for (;;) {
+        skip_newlines(p);
+        if (p->status != PARSE_OK || p->current.type == TOK_EOF) break;
+        if (nested && at_list_end(p)) break;
 
-    return num_commands;
+        Node* item = parse_and_or(p);
+        if (!item) break;
+        if (p->current.type == TOK_AMP) {
+            Node* background = node_new(NODE_BACKGROUND);
+            if (!background) { node_free(item); p->status = PARSE_ERROR; break; }
+            background->left = item;
+            item = background;
+            advance(p);
+        } else if (p->current.type == TOK_SEMI) {
+            advance(p);
+        } else if (p->current.type != TOK_NEWLINE && p->current.type != TOK_EOF &&
+                   !(nested && at_list_end(p))) {
+            node_free(item);
+            unexpected_token(p);
+            break;
+        }
+        result = result ? new_binary(NODE_SEQUENCE, result, item) : item;
+        if (!result) { p->status = PARSE_ERROR; break; }
+    }
+    if (p->status != PARSE_OK) {
+        node_free(result);
+        return NULL;
+    }
+    return result;
 }
 
-void free_simple_commands(SimpleCommand commands[], int num_commands) {
-    for (int i = 0; i < num_commands; ++i) {
-        for (int k = 0; commands[i].args[k] != NULL; ++k) {
-            free(commands[i].args[k]);
+/**
+ * @brief Moves the delimiters of the here-documents from 'first' on out of the parser.
+ */
+static void take_open_heredocs(Parser* p, int first, HeredocEnd** open, int* num_open) {
+    *open = malloc(sizeof(HeredocEnd) * (p->num_pending - first));
+    if (!*open) return; // The caller parses again after every line instead
+    for (int i = first; i < p->num_pending; i++) {
+        (*open)[(*num_open)++] = p->pending[i].end;
+        p->pending[i].end.delimiter = NULL;
+    }
+}
+
+ParseStatus parse_program(const char* input, Node** tree_out) {
+    return parse_program_open(input, tree_out, NULL, NULL);
+}
+
+ParseStatus parse_program_open(const char* input, Node** tree_out, HeredocEnd** open, int* num_open) {
+    TRACE_BEGIN(parse_start);
+    Parser p;
+    memset(&p, 0, sizeof(p));
+    p.status = PARSE_OK;
+    p.open_heredoc = -1;
+    lexer_init(&p.lexer, input);
+
+    *tree_out = NULL;
+    if (open) {
+        *open = NULL;
+        *num_open = 0;
+    }
+    if (advance(&p)) {
+        Node* tree = parse_list(&p, false);
+        if (p.status == PARSE_OK && p.current.type != TOK_EOF) unexpected_token(&p);
+        // A here-document was started on the last line: its body has yet to be typed.
+        if (p.status == PARSE_OK && p.num_pending > 0) {
+            p.status = PARSE_INCOMPLETE;
+            p.open_heredoc = 0;
         }
-        free(commands[i].input_file);
-        free(commands[i].output_file);
+        if (p.status == PARSE_OK) *tree_out = tree;
+        else node_free(tree);
     }
-}
\ No newline at end of file
+    if (open && p.status == PARSE_INCOMPLETE && p.open_heredoc >= 0) take_open_heredocs(&p, p.open_heredoc, open, num_open);
+    word_clear(&p.current.word);
+    for (int i = 0; i < p.num_pending; i++) free(p.pending[i].end.delimiter);
+    free(p.pending);
+    reset_alias_chain(&p);
+    for (int i = 0; i < p.num_alias_texts; i++) free(p.alias_texts[i]);
+    free(p.alias_texts);
+    TRACE_END(TRACE_PARSE, parse_start);
+    return p.status;
+}
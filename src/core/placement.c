@@ -0,0 +1,187 @@
+#define _GNU_SOURCE // For cpu_set_t and sched_setaffinity
+#include "core/placement.h"
+#include "utils/error.h"
+
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/ioprio.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#define WORD_BITS (8 * sizeof(unsigned long))
+
+// The bits are kept in cpu_set_t's own layout, so masks are copied whole.
+_Static_assert(sizeof(cpu_set_t) == sizeof(((Placement*)0)->cpus), "cpus must match cpu_set_t");
+
+static bool cpu_isset(const Placement* placement, int cpu) {
+    return (placement->cpus[cpu / WORD_BITS] >> (cpu % WORD_BITS)) & 1UL;
+}
+
+bool placement_is_set(const Placement* placement) {
+    return placement->has_cpus || placement->has_nice || placement->has_io;
+}
+
+bool placement_parse_cpus(const char* list, Placement* placement) {
+    memset(placement->cpus, 0, sizeof(placement->cpus));
+    const char* p = list;
+    for (;;) {
+        char* end;
+        long first = strtol(p, &end, 10), last = first;
+        bool ok = end != p && first >= 0;
+        if (ok && *end == '-') {
+            p = end + 1;
+            last = strtol(p, &end, 10);
+            ok = end != p && last >= first;
+        }
+        if (!ok || last >= PLACEMENT_MAX_CPUS || (*end != ',' && *end != '\0')) {
+            fprintf(stderr, _RED_ "Shell Error: " _RESET_ "pin: %s: invalid CPU list\n", list);
+            return false;
+        }
+        for (long cpu = first; cpu <= last; cpu++) placement->cpus[cpu / WORD_BITS] |= 1UL << (cpu % WORD_BITS);
+        if (*end == '\0') break;
+        p = end + 1;
+    }
+
+    // Checked here rather than failing in every child: the kernel refuses a mask with no usable CPU.
+    unsigned long allowed[PLACEMENT_CPU_WORDS];
+    bool usable = sched_getaffinity(0, sizeof(allowed), (cpu_set_t*)allowed) < 0;
+    for (size_t word = 0; !usable && word < PLACEMENT_CPU_WORDS; word++) {
+        usable = (placement->cpus[word] & allowed[word]) != 0;
+    }
+    if (!usable) {
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "pin: %s: none of these CPUs is available\n", list);
+        return false;
+    }
+    placement->has_cpus = true;
+    return true;
+}
+
+bool placement_parse_io(const char* text, Placement* placement) {
+    size_t name_len = strcspn(text, ":");
+    int io_class = -1;
+    if (strncmp(text, "idle", name_len) == 0 && name_len == 4) io_class = IOPRIO_CLASS_IDLE;
+    else if ((name_len == 2 && strncmp(text, "be", 2) == 0) || (name_len == 11 && strncmp(text, "best-effort", 11) == 0)) io_class = IOPRIO_CLASS_BE;
+    else if ((name_len == 2 && strncmp(text, "rt", 2) == 0) || (name_len == 8 && strncmp(text, "realtime", 8) == 0)) io_class = IOPRIO_CLASS_RT;
+    int level = 4;
+    if (io_class >= 0 && text[name_len] == ':') {
+        char* end;
+        level = (int)strtol(text + name_len + 1, &end, 10);
+        if (end == text + name_len + 1 || *end != '\0' || level < 0 || level > 7 || io_class == IOPRIO_CLASS_IDLE) io_class = -1;
+    }
+    if (io_class < 0) {
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "pin: %s: invalid I/O class (idle, be[:0-7] or rt[:0-7])\n", text);
+        return false;
+    }
+    placement->has_io = true;
+    placement->io_class = io_class;
+    placement->io_level = (io_class == IOPRIO_CLASS_IDLE) ? 0 : level;
+    return true;
+}
+
+void placement_merge(Placement* into, const Placement* over) {
+    if (over->has_cpus) {
+        into->has_cpus = true;
+        memcpy(into->cpus, over->cpus, sizeof(into->cpus));
+    }
+    if (over->has_nice) {
+        into->has_nice = true;
+        into->nice = over->nice;
+    }
+    if (over->has_io) {
+        into->has_io = true;
+        into->io_class = over->io_class;
+        into->io_level = over->io_level;
+    }
+}
+
+bool placement_apply(const Placement* placement) {
+    if (placement->has_cpus) {
+        cpu_set_t cpus;
+        memcpy(&cpus, placement->cpus, sizeof(cpus));
+        if (sched_setaffinity(0, sizeof(cpus), &cpus) < 0) {
+            print_shell_perror("pin: sched_setaffinity");
+            return false;
+        }
+    }
+    // Lowering the nice value below the shell's needs CAP_SYS_NICE, like nice(1).
+    if (placement->has_nice && setpriority(PRIO_PROCESS, 0, placement->nice) < 0) {
+        print_shell_perror("pin: setpriority");
+        return false;
+    }
+    if (placement->has_io &&
+        syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_PRIO_VALUE(placement->io_class, placement->io_level)) < 0) {
+        print_shell_perror("pin: ioprio_set");
+        return false;
+    }
+    return true;
+}
+
+bool placement_read(pid_t pid, Placement* placement) {
+    memset(placement, 0, sizeof(*placement));
+    cpu_set_t cpus;
+    if (sched_getaffinity(pid, sizeof(cpus), &cpus) < 0) return false;
+    memcpy(placement->cpus, &cpus, sizeof(cpus));
+    placement->has_cpus = true;
+
+    errno = 0;
+    int nice = getpriority(PRIO_PROCESS, pid); // -1 is also a valid nice value
+    if (errno == 0) {
+        placement->has_nice = true;
+        placement->nice = nice;
+    }
+
+    long ioprio = syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, pid);
+    if (ioprio >= 0) {
+        placement->has_io = true;
+        placement->io_class = IOPRIO_PRIO_CLASS(ioprio);
+        placement->io_level = IOPRIO_PRIO_DATA(ioprio);
+        if (placement->io_class == IOPRIO_CLASS_NONE) {
+            // No class of its own: best-effort, at a level that follows the nice value.
+            placement->io_class = IOPRIO_CLASS_BE;
+            placement->io_level = placement->has_nice ? (placement->nice + 20) / 5 : 4;
+        }
+    }
+    return true;
+}
+
+void placement_format_cpus(const Placement* placement, StrBuf* out) {
+    bool first = true;
+    for (int cpu = 0; cpu < PLACEMENT_MAX_CPUS; cpu++) {
+        if (placement->cpus[cpu / WORD_BITS] == 0) { // Skip a word with no CPU
+            cpu += WORD_BITS - 1 - cpu % WORD_BITS;
+            continue;
+        }
+        if (!cpu_isset(placement, cpu)) continue;
+        int last = cpu;
+        while (last + 1 < PLACEMENT_MAX_CPUS && cpu_isset(placement, last + 1)) last++;
+        strbuf_appendf(out, (last == cpu) ? "%s%d" : "%s%d-%d", first ? "" : ",", cpu, last);
+        first = false;
+        cpu = last;
+    }
+}
+
+void placement_format_io(const Placement* placement, StrBuf* out) {
+    if (placement->io_class == IOPRIO_CLASS_IDLE) strbuf_append_str(out, "idle");
+    else strbuf_appendf(out, "%s: prio %d", placement->io_class == IOPRIO_CLASS_RT ? "realtime" : "best-effort", placement->io_level);
+}
+
+void placement_format(const Placement* placement, StrBuf* out) {
+    const char* separator = "";
+    if (placement->has_cpus) {
+        strbuf_append_str(out, "cpus ");
+        placement_format_cpus(placement, out);
+        separator = ", ";
+    }
+    if (placement->has_nice) {
+        strbuf_appendf(out, "%snice %d", separator, placement->nice);
+        separator = ", ";
+    }
+    if (placement->has_io) {
+        strbuf_appendf(out, "%sio ", separator);
+        placement_format_io(placement, out);
+    }
+}
@@ -0,0 +1,299 @@
+#include "core/procfs.h"
+#include "utils/error.h"
+
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#define STAT_BUFFER_SIZE 1024 ///< /proc/<pid>/stat is a few hundred bytes
+
+/**
+ * @brief Reads the next space-separated number, advancing '*p'.
+ */
+static long long next_field(const char** p, const char* end) {
+    const char* s = *p;
+    while (s < end && *s == ' ') s++;
+    bool negative = s < end && *s == '-';
+    if (negative) s++;
+    long long value = 0;
+    while (s < end && *s >= '0' && *s <= '9') value = value * 10 + (*s++ - '0');
+    *p = s;
+    return negative ? -value : value;
+}
+
+bool procfs_parse_stat(const char* text, size_t len, ProcInfo* out) {
+    const char* end = text + len;
+    const char* open = memchr(text, '(', len);
+    // The name may itself contain ')', so it ends at the last one.
+    const char* close = NULL;
+    for (const char* p = end; p > text; p--) {
+        if (p[-1] == ')') {
+            close = p - 1;
+            break;
+        }
+    }
+    if (!open || !close || close < open || close + 2 >= end) return false;
+
+    const char* p = text;
+    out->pid = (pid_t)next_field(&p, open);
+    size_t comm_len = (size_t)(close - open - 1);
+    if (comm_len >= sizeof(out->comm)) comm_len = sizeof(out->comm) - 1;
+    memcpy(out->comm, open + 1, comm_len);
+    out->comm[comm_len] = '\0';
+
+    p = close + 2;
+    out->state = *p++;
+    long long fields[22]; // fields[i] is field i + 3 of proc(5): ppid at 1 up to rss at 21
+    for (int i = 1; i < 22; i++) fields[i] = next_field(&p, end);
+    out->ppid = (pid_t)fields[1];
+    out->pgid = (pid_t)fields[2];
+    out->sid = (pid_t)fields[3];
+    out->utime = (unsigned long long)fields[11];
+    out->stime = (unsigned long long)fields[12];
+    out->num_threads = (long)fields[17];
+    out->start_time = (unsigned long long)fields[19];
+    out->vsize = (unsigned long long)fields[20];
+    out->rss = fields[21];
+    return true;
+}
+
+/**
+ * @brief Reads and parses "<pid>/stat" relative to 'proc_fd'.
+ */
+static bool read_stat_at(int proc_fd, const char* pid_name, ProcInfo* out) {
+    char path[32], buffer[STAT_BUFFER_SIZE];
+    snprintf(path, sizeof(path), "%s/stat", pid_name);
+    int fd = openat(proc_fd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    ssize_t len = read(fd, buffer, sizeof(buffer));
+    close(fd);
+    return len > 0 && procfs_parse_stat(buffer, (size_t)len, out);
+}
+
+bool procfs_read_stat(pid_t pid, ProcInfo* out) {
+    char pid_name[16];
+    snprintf(pid_name, sizeof(pid_name), "%d", (int)pid);
+    int proc_fd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (proc_fd < 0) return false;
+    bool ok = read_stat_at(proc_fd, pid_name, out);
+    close(proc_fd);
+    return ok;
+}
+
+bool proc_handle_open(ProcHandle* handle, pid_t pid) {
+    char path[32];
+    snprintf(path, sizeof(path), "/proc/%d", (int)pid);
+    handle->pid = pid;
+    handle->stat_fd = -1;
+    handle->dir_fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (handle->dir_fd < 0) return false;
+    handle->stat_fd = openat(handle->dir_fd, "stat", O_RDONLY | O_CLOEXEC);
+    if (handle->stat_fd < 0) {
+        int error = errno;
+        proc_handle_close(handle);
+        errno = error;
+        return false;
+    }
+    return true;
+}
+
+ssize_t procfs_pread_file(int fd, char* buffer, size_t size) {
+    size_t len = 0;
+    while (len + 1 < size) {
+        size_t wanted = size - 1 - len;
+        ssize_t n = pread(fd, buffer + len, wanted, (off_t)len);
+        if (n < 0) return -1;
+        len += (size_t)n;
+        if ((size_t)n < wanted) break; // A short read of a /proc file is its end
+    }
+    buffer[len] = '\0';
+    return (ssize_t)len;
+}
+
+bool proc_handle_read_stat(const ProcHandle* handle, ProcInfo* out) {
+    char buffer[STAT_BUFFER_SIZE];
+    ssize_t len = procfs_pread_file(handle->stat_fd, buffer, sizeof(buffer));
+    return len > 0 && procfs_parse_stat(buffer, (size_t)len, out);
+}
+
+void proc_handle_close(ProcHandle* handle) {
+    if (handle->stat_fd >= 0) close(handle->stat_fd);
+    if (handle->dir_fd >= 0) close(handle->dir_fd);
+    handle->stat_fd = handle->dir_fd = -1;
+}
+
+static int compare_pid(const void* a, const void* b) {
+    pid_t x = ((const ProcInfo*)a)->pid, y = ((const ProcInfo*)b)->pid;
+    return (x > y) - (x < y);
+}
+
+bool proc_table_load(ProcTable* table) {
+    table->count = 0;
+    DIR* proc_dir = opendir("/proc");
+    if (!proc_dir) {
+        print_shell_perror("procfs: cannot read /proc");
+        return false;
+    }
+    int proc_fd = dirfd(proc_dir);
+    bool sorted = true;
+    struct dirent* entry;
+    while ((entry = readdir(proc_dir)) != NULL) {
+        if (!isdigit((unsigned char)entry->d_name[0])) continue;
+        if (table->count == table->capacity) {
+            int capacity = table->capacity ? table->capacity * 2 : 512;
+            ProcInfo* procs = realloc(table->procs, capacity * sizeof(ProcInfo));
+            if (!procs) {
+                print_shell_perror("procfs: realloc failed");
+                closedir(proc_dir);
+                return false;
+            }
+            table->procs = procs;
+            table->capacity = capacity;
+        }
+        ProcInfo* info = &table->procs[table->count];
+        // A process that exits while we read is simply not in the snapshot.
+        if (!read_stat_at(proc_fd, entry->d_name, info)) continue;
+        if (table->count > 0 && info->pid < info[-1].pid) sorted = false;
+        table->count++;
+    }
+    closedir(proc_dir);
+    if (!sorted) qsort(table->procs, table->count, sizeof(ProcInfo), compare_pid);
+    return true;
+}
+
+void proc_table_free(ProcTable* table) {
+    free(table->procs);
+    table->procs = NULL;
+    table->count = table->capacity = 0;
+}
+
+const ProcInfo* proc_table_find(const ProcTable* table, pid_t pid) {
+    ProcInfo key = { .pid = pid };
+    return table->count ? bsearch(&key, table->procs, table->count, sizeof(ProcInfo), compare_pid) : NULL;
+}
+
+/**
+ * @brief An open-addressed PID -> index map over the snapshot, so resolving every
+ *        parent is one probe rather than a binary search through the entries.
+ */
+typedef struct {
+    pid_t* pids; ///< 0 marks an empty slot
+    int* indexes;
+    unsigned mask;
+} PidIndex;
+
+static unsigned pid_slot(const PidIndex* map, pid_t pid) {
+    return ((unsigned)pid * 2654435761u) & map->mask;
+}
+
+static bool pid_index_build(PidIndex* map, const ProcTable* table) {
+    unsigned size = 16;
+    while (size < (unsigned)table->count * 2) size *= 2;
+    map->mask = size - 1;
+    map->pids = calloc(size, sizeof(pid_t));
+    map->indexes = malloc(size * sizeof(int));
+    if (!map->pids || !map->indexes) return false;
+    for (int i = 0; i < table->count; i++) {
+        unsigned slot = pid_slot(map, table->procs[i].pid);
+        while (map->pids[slot] != 0) slot = (slot + 1) & map->mask;
+        map->pids[slot] = table->procs[i].pid;
+        map->indexes[slot] = i;
+    }
+    return true;
+}
+
+static int pid_index_find(const PidIndex* map, pid_t pid) {
+    for (unsigned slot = pid_slot(map, pid); map->pids[slot] != 0; slot = (slot + 1) & map->mask) {
+        if (map->pids[slot] == pid) return map->indexes[slot];
+    }
+    return -1;
+}
+
+bool proc_tree_build(ProcTree* tree, const ProcTable* table) {
+    int n = table->count;
+    PidIndex map = {0};
+    tree->table = table;
+    tree->parent = malloc((n + 1) * sizeof(int));
+    tree->child_start = calloc(n + 2, sizeof(int));
+    tree->children = malloc((n + 1) * sizeof(int));
+    bool ok = tree->parent && tree->child_start && tree->children && pid_index_build(&map, table);
+    if (ok) {
+        // Count each parent's children, turn the counts into offsets, then place
+        // the children; entries are visited in PID order, so each list is sorted.
+        for (int i = 0; i < n; i++) {
+            pid_t ppid = table->procs[i].ppid;
+            tree->parent[i] = (ppid > 0) ? pid_index_find(&map, ppid) : -1;
+            if (tree->parent[i] >= 0) tree->child_start[tree->parent[i] + 2]++;
+        }
+        for (int i = 2; i <= n + 1; i++) tree->child_start[i] += tree->child_start[i - 1];
+        for (int i = 0; i < n; i++) {
+            if (tree->parent[i] >= 0) tree->children[tree->child_start[tree->parent[i] + 1]++] = i;
+        }
+    } else {
+        print_shell_perror("procfs: malloc failed");
+        proc_tree_free(tree);
+    }
+    free(map.pids);
+    free(map.indexes);
+    return ok;
+}
+
+void proc_tree_free(ProcTree* tree) {
+    free(tree->parent);
+    free(tree->child_start);
+    free(tree->children);
+    tree->parent = tree->child_start = tree->children = NULL;
+}
+
+/**
+ * @brief Formats the children of 'node', 'indent' holding the branch lines drawn so far.
+ */
+static void format_children(const ProcTree* tree, int node, const char* prefix, StrBuf* indent, StrBuf* out) {
+    for (int c = tree->child_start[node]; c < tree->child_start[node + 1]; c++) {
+        const ProcInfo* child = &tree->table->procs[tree->children[c]];
+        bool last = c + 1 == tree->child_start[node + 1];
+        strbuf_appendf(out, "%s%s%s%d %s [%c]\n", prefix, indent->data ? indent->data : "",
+                       last ? "\u2514\u2500 " : "\u251c\u2500 ", child->pid, child->comm, child->state);
+        size_t len = indent->len;
+        strbuf_append_str(indent, last ? "   " : "\u2502  ");
+        format_children(tree, tree->children[c], prefix, indent, out);
+        indent->len = len;
+        indent->data[len] = '\0';
+    }
+}
+
+void proc_tree_format(const ProcTree* tree, int root, const char* prefix, StrBuf* out) {
+    const ProcInfo* proc = &tree->table->procs[root];
+    strbuf_appendf(out, "%s%d %s [%c]\n", prefix, proc->pid, proc->comm, proc->state);
+    StrBuf indent;
+    strbuf_init(&indent);
+    format_children(tree, root, prefix, &indent, out);
+    strbuf_free(&indent);
+}
+
+int procfs_signal(pid_t pid, unsigned long long start_time, int signal_number) {
+#ifdef SYS_pidfd_open
+    int pidfd = (int)syscall(SYS_pidfd_open, pid, 0);
+    if (pidfd >= 0) {
+        int error = 0;
+        ProcInfo now;
+        // Opened after the snapshot: the PID must still belong to the process we saw.
+        if (start_time && (!procfs_read_stat(pid, &now) || now.start_time != start_time)) {
+            error = ESRCH;
+        } else if (syscall(SYS_pidfd_send_signal, pidfd, signal_number, NULL, 0) < 0) {
+            error = errno;
+        }
+        close(pidfd);
+        return error;
+    }
+    if (errno != ENOSYS) return errno;
+#endif
+    return kill(pid, signal_number) < 0 ? errno : 0;
+}
@@ -0,0 +1,212 @@
+#include "core/redirect.h"
+#include "core/heredoc.h"
+#include "utils/error.h"
+#include "utils/fd.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define INITIAL_REDIRECTS_CAPACITY 4
+#define REDIRECT_FILE_MODE 0644
+#define SAVED_FD_MIN 10 ///< Saved copies go at or above this (and above any descriptor redirected)
+
+bool redirects_add(RedirectList* list, FdActionType type, int fd, int source, int flags, char* text) {
+    if (list->count >= list->capacity) {
+        int new_capacity = list->capacity ? list->capacity * 2 : INITIAL_REDIRECTS_CAPACITY;
+        FdAction* grown = realloc(list->actions, sizeof(FdAction) * new_capacity);
+        if (!grown) {
+            print_shell_perror("redirect: realloc for redirections failed");
+            free(text);
+            return false;
+        }
+        list->actions = grown;
+        list->capacity = new_capacity;
+    }
+    list->actions[list->count++] = (FdAction){type, fd, source, flags, text};
+    return true;
+}
+
+bool redirects_prepare(RedirectList* list) {
+    for (int i = 0; i < list->count; i++) {
+        FdAction* action = &list->actions[i];
+        if (action->type != FD_ACTION_DATA || action->source >= 0) continue;
+        action->source = heredoc_open(action->text, strlen(action->text));
+        if (action->source < 0) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Opens an OPEN action's file. Under noclobber ('>' with O_EXCL) an
+ *        existing file may only be written if it is not a regular file, such as /dev/null.
+ */
+static int open_target(const FdAction* action) {
+    int fd = open(action->text, action->flags, REDIRECT_FILE_MODE);
+    if (fd < 0 && errno == EEXIST && (action->flags & O_EXCL)) {
+        struct stat st;
+        if (stat(action->text, &st) == 0 && !S_ISREG(st.st_mode)) {
+            fd = open(action->text, action->flags & ~(O_EXCL | O_CREAT), REDIRECT_FILE_MODE);
+        } else {
+            errno = EEXIST;
+        }
+    }
+    return fd;
+}
+
+/**
+ * @brief The shell's own descriptor that an action would replace, close or
+ *        copy (see utils/fd.h), or -1 if it touches none. Such an action fails
+ *        with EBADF, as if the descriptor were not open, as in bash.
+ */
+static int internal_fd(const FdAction* action) {
+    if (fd_is_internal(action->fd)) return action->fd;
+    if (action->type == FD_ACTION_DUP && fd_is_internal(action->source)) return action->source;
+    return -1;
+}
+
+static bool apply_action(const FdAction* action) {
+    int internal = internal_fd(action);
+    if (internal >= 0) {
+        fprintf(stderr, _RED_ "Shell Error: " _RESET_ "%d: Bad file descriptor\n", internal);
+        return false;
+    }
+    switch (action->type) {
+    case FD_ACTION_OPEN: {
+        int fd = open_target(action);
+        if (fd < 0) {
+            if (errno == EEXIST) {
+                fprintf(stderr, _RED_ "Shell Error: " _RESET_ "%s: Cannot overwrite existing file (noclobber is set)\n", action->text);
+            } else {
+                print_shell_perror(action->text);
+            }
+            return false;
+        }
+        if (fd != action->fd) {
+            int result = dup2(fd, action->fd);
+            close(fd);
+            if (result < 0) {
+                print_shell_perror(action->text);
+                return false;
+            }
+        }
+        return true;
+    }
+    case FD_ACTION_DUP:
+    case FD_ACTION_DATA:
+        // dup2 onto itself does nothing, but still fails for a descriptor that is not open.
+        if (action->source < 0 || dup2(action->source, action->fd) < 0) {
+            fprintf(stderr, _RED_ "Shell Error: " _RESET_ "%d: Bad file descriptor\n", action->source);
+            return false;
+        }
+        return true;
+    case FD_ACTION_CLOSE:
+        close(action->fd);
+        return true;
+    }
+    return false;
+}
+
+bool redirects_apply(const RedirectList* list) {
+    for (int i = 0; i < list->count; i++) {
+        if (!apply_action(&list->actions[i])) return false;
+    }
+    return true;
+}
+
+bool redirects_apply_saved(const RedirectList* list, SavedFds* saved) {
+    memset(saved, 0, sizeof(*saved));
+    if (list->count == 0) return true;
+    saved->fds = malloc(sizeof(int) * list->count);
+    saved->saved = malloc(sizeof(int) * list->count);
+    if (!saved->fds || !saved->saved) {
+        print_shell_perror("redirect: malloc for saved descriptors failed");
+        free(saved->fds);
+        free(saved->saved);
+        memset(saved, 0, sizeof(*saved));
+        return false;
+    }
+
+    // Copies are placed above every descriptor the actions touch, so no action overwrites one.
+    int floor = SAVED_FD_MIN;
+    for (int i = 0; i < list->count; i++) {
+        const FdAction* action = &list->actions[i];
+        if (action->fd >= floor) floor = action->fd + 1;
+        if (action->source >= floor) floor = action->source + 1;
+    }
+    fflush(stdout);
+    fflush(stderr);
+    for (int i = 0; i < list->count; i++) {
+        int fd = list->actions[i].fd;
+        bool seen = false;
+        for (int k = 0; k < saved->count && !seen; k++) seen = (saved->fds[k] == fd);
+        if (seen || fd_is_internal(fd)) continue; // Never touched: its action fails
+        int copy = fcntl(fd, F_DUPFD_CLOEXEC, floor);
+        if (copy < 0 && errno != EBADF) {
+            print_shell_perror("redirect: saving a descriptor failed");
+            redirects_restore(saved);
+            return false;
+        }
+        saved->fds[saved->count] = fd;
+        saved->saved[saved->count++] = copy;
+    }
+    if (!redirects_apply(list)) {
+        redirects_restore(saved);
+        return false;
+    }
+    return true;
+}
+
+void redirects_restore(SavedFds* saved) {
+    fflush(stdout);
+    fflush(stderr);
+    for (int k = saved->count - 1; k >= 0; k--) {
+        if (saved->saved[k] >= 0) {
+            dup2(saved->saved[k], saved->fds[k]);
+            close(saved->saved[k]);
+        } else {
+            close(saved->fds[k]);
+        }
+    }
+    free(saved->fds);
+    free(saved->saved);
+    memset(saved, 0, sizeof(*saved));
+}
+
+int redirects_add_file_actions(const RedirectList* list, posix_spawn_file_actions_t* file_actions) {
+    for (int i = 0; i < list->count; i++) {
+        const FdAction* action = &list->actions[i];
+        int error = 0;
+        if (internal_fd(action) >= 0) return EBADF;
+        switch (action->type) {
+        case FD_ACTION_OPEN:
+            error = posix_spawn_file_actions_addopen(file_actions, action->fd, action->text,
+                                                     action->flags, REDIRECT_FILE_MODE);
+            break;
+        case FD_ACTION_DUP:
+        case FD_ACTION_DATA:
+            if (action->source < 0) return EBADF;
+            error = posix_spawn_file_actions_adddup2(file_actions, action->source, action->fd);
+            break;
+        case FD_ACTION_CLOSE:
+            error = posix_spawn_file_actions_addclose(file_actions, action->fd);
+            break;
+        }
+        if (error) return error;
+    }
+    return 0;
+}
+
+void redirects_clear(RedirectList* list) {
+    for (int i = 0; i < list->count; i++) {
+        FdAction* action = &list->actions[i];
+        if (action->type == FD_ACTION_DATA && action->source >= 0) close(action->source);
+        free(action->text);
+    }
+    free(list->actions);
+    memset(list, 0, sizeof(*list));
+}
@@ -1,5 +1,11 @@
 #include "core/shell_state.h"
+#include "core/aliases.h"
+#include "core/cgroup.h"
+#include "core/cwd.h"
+#include "core/dirdb.h"
+#include "core/parse_cache.h"
 #include "utils/error.h"
+#include "utils/trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,39 +13,102 @@
 #include <sys/utsname.h>
 #include <pwd.h>
 
+static char* default_positional[] = {"shellby", NULL};
+
+static void release_function(void* body) {
+    node_free(body);
+}
+
 bool shell_state_init(ShellState* state) {
-    if (getcwd(state->home_dir, sizeof(state->home_dir)) == NULL) {
-        print_shell_perror("Failed to get initial working directory");
+    // The inherited environment becomes the initial set of exported variables.
+    extern char** environ;
+    if (!vars_init(&state->vars, environ)) {
         return false;
     }
-
     state->prev_dir[0] = '\0';
+    state->cwd_fd = -1;
+    if (!cwd_init(state)) {
+        return false;
+    }
+    strcpy(state->home_dir, state->cwd);
+    state->positional = default_positional;
+    state->num_positional = 1;
+    strmap_init(&state->functions);
+    state->function_depth = 0;
+    state->loop_depth = 0;
+    state->flow = FLOW_NORMAL;
+    state->flow_count = 0;
+    state->interrupted = false;
+
+    state->dir_stack = NULL;
+    state->dir_stack_count = 0;
+    state->dir_stack_capacity = 0;
     state->history_queue = initQue();
     read_history_from_file(state->history_queue, state->home_dir);
 
+    // Without the directory database only 'warp -z' is lost, so failing to open it is not fatal.
+    char dirdb_path[MAX_PATH_LEN + sizeof(DIRDB_FILENAME) + 1];
+    snprintf(dirdb_path, sizeof(dirdb_path), "%s/%s", state->home_dir, DIRDB_FILENAME);
+    dirdb_open(dirdb_path);
+
     state->is_running = true;
-    state->num_bg_processes = 0;
+    state->jobs.count = 0;
+    state->substitutions.count = 0;
+    state->finished.count = 0;
     state->last_command_name[0] = '\0';
     state->time_taken_for_prompt = -1;
     state->foreground_pgid = -1;
-    
-    // Initialize background process arrays to be safe
-    for (int i = 0; i < MAX_BG_PROCS; i++) {
-        state->background_pids[i] = -1;
-        state->background_process_names[i][0] = '\0';
-    }
+    state->options.pipefail = false;
+    state->options.noclobber = false;
+    state->options.jobcapture = false;
+    state->last_exit_status = 0;
+    state->last_background_pid = 0;
+    memset(&state->job_placement, 0, sizeof(state->job_placement));
+    state->job_control = true;
+    state->interactive = true;
+    state->in_continuation = false;
 
     return true;
 }
 
 void shell_state_destroy(ShellState* state) {
+    for (int i = 0; i < state->jobs.count; i++) {
+        job_free(state->jobs.jobs[i]);
+    }
+    state->jobs.count = 0;
+    for (int i = 0; i < state->substitutions.count; i++) {
+        job_free(state->substitutions.jobs[i]);
+    }
+    state->substitutions.count = 0;
+    for (int i = 0; i < state->finished.count; i++) {
+        job_free(state->finished.jobs[i]);
+    }
+    state->finished.count = 0;
     write_history_to_file(state->history_queue, state->home_dir);
     destroyQue(state->history_queue);
     state->history_queue = NULL;
+    dirdb_close();
+    cwd_destroy(state);
+    for (int i = 0; i < state->dir_stack_count; i++) free(state->dir_stack[i]);
+    free(state->dir_stack);
+    state->dir_stack = NULL;
+    state->dir_stack_count = state->dir_stack_capacity = 0;
+    vars_destroy(&state->vars);
+    strmap_clear(&state->functions, release_function);
+    alias_clear();
+    parse_cache_clear();
+    cgroup_leave_leaf();
 }
 
 // This function is the former display_shell_prompt from prompt.c
 void display_shell_prompt(const ShellState* state) {
+    TRACE_BEGIN(prompt_start);
+    if (state->in_continuation) {
+        printf("> ");
+        fflush(stdout);
+        TRACE_END(TRACE_PROMPT, prompt_start);
+        return;
+    }
     struct utsname sys_info;
     if (uname(&sys_info) != 0) {
         strncpy(sys_info.nodename, "localhost", sizeof(sys_info.nodename) - 1);
@@ -52,11 +121,7 @@ void display_shell_prompt(const ShellState* state) {
         username = pw ? pw->pw_name : "user";
     }
 
-    char current_path[MAX_PATH_LEN];
-    if (getcwd(current_path, sizeof(current_path)) == NULL) {
-        strcpy(current_path, "?");
-    }
-
+    const char* current_path = state->cwd;
     char display_path[MAX_PATH_LEN];
     size_t home_dir_len = strlen(state->home_dir);
     if (strncmp(current_path, state->home_dir, home_dir_len) == 0 &&
@@ -75,4 +140,5 @@ void display_shell_prompt(const ShellState* state) {
     }
     printf(_GREEN_ "> " _RESET_);
     fflush(stdout);
+    TRACE_END(TRACE_PROMPT, prompt_start);
 }
\ No newline at end of file
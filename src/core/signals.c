@@ -1,59 +1,126 @@
+#define _GNU_SOURCE // For sigabbrev_np
 #include "core/signals.h"
 #include "core/shell_state.h"
+#include "utils/error.h"
+#include "utils/fd.h"
 
+#include <errno.h>
 #include <stdio.h>
 #include <signal.h>
+#include <strings.h>
 #include <unistd.h>
+#include <sys/signalfd.h>
 
-// A global pointer to the shell state, necessary for signal handlers
-// to access information about the current foreground process.
+// A global pointer to the shell state, needed to find the current foreground job.
 extern ShellState* g_shell_state;
 
-/**
- * @brief Handler for SIGINT (Ctrl+C).
- */
-static void sigint_handler(int signo) {
-    (void)signo; // Unused parameter
+static int signal_fd = -1;
+static sigset_t original_mask;
 
-    if (g_shell_state != NULL && g_shell_state->foreground_pgid > 0) {
-        // If a foreground process is running, send SIGINT to its entire process group.
-        kill(-g_shell_state->foreground_pgid, SIGINT);
+int setup_signal_handlers() {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTSTP);
+    sigaddset(&mask, SIGCHLD);
+    sigaddset(&mask, SIGWINCH);
+
+    // Block the signals first so none is delivered the old way in between.
+    if (sigprocmask(SIG_BLOCK, &mask, &original_mask) < 0) {
+        print_shell_perror("sigprocmask failed");
+        return -1;
+    }
+    signal_fd = fd_keep(signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC));
+    if (signal_fd < 0) {
+        print_shell_perror("signalfd failed");
+        sigprocmask(SIG_SETMASK, &original_mask, NULL);
+        return -1;
     }
-    // If no foreground process is running, the signal does nothing to the shell itself,
-    // but we print a newline to keep the terminal clean and redraw the prompt.
-    printf("\n");
-    display_shell_prompt(g_shell_state);
+
+    // Ignore signals that a shell should typically ignore for job control
+    signal(SIGTTIN, SIG_IGN);
+    signal(SIGTTOU, SIG_IGN);
+    // Builtins write from the shell itself: a closed pipe is a write error, not fatal.
+    signal(SIGPIPE, SIG_IGN);
+    return 0;
+}
+
+int signals_get_fd() {
+    return signal_fd;
 }
 
-/**
- * @brief Handler for SIGTSTP (Ctrl+Z).
- */
-static void sigtstp_handler(int signo) {
-    (void)signo; // Unused parameter
+int signals_dispatch() {
+    int events = 0;
+    struct signalfd_siginfo info;
+    pid_t fg_pgid = g_shell_state ? g_shell_state->foreground_pgid : -1;
 
-    if (g_shell_state != NULL && g_shell_state->foreground_pgid > 0) {
-        // If a foreground process is running, send SIGTSTP to its entire process group.
-        kill(-g_shell_state->foreground_pgid, SIGTSTP);
+    for (;;) {
+        ssize_t n = read(signal_fd, &info, sizeof(info));
+        if (n < 0 && errno == EINTR) continue;
+        if (n != (ssize_t)sizeof(info)) break; // EAGAIN: drained
+
+        switch (info.ssi_signo) {
+        case SIGINT:
+            // With a foreground job the signal is for its whole process group;
+            // otherwise the shell itself just abandons the line being edited.
+            if (fg_pgid > 0) kill(-fg_pgid, SIGINT);
+            else events |= SIGNAL_EVENT_INTERRUPT;
+            break;
+        case SIGTSTP:
+            // If no foreground process is running, this signal is ignored.
+            if (fg_pgid > 0) kill(-fg_pgid, SIGTSTP);
+            break;
+        case SIGCHLD:
+            events |= SIGNAL_EVENT_CHILD;
+            break;
+        case SIGWINCH:
+            events |= SIGNAL_EVENT_RESIZE;
+            break;
+        }
     }
-    // If no foreground process is running, this signal is ignored.
+    return events;
 }
 
-void setup_signal_handlers() {
-    struct sigaction sa_int, sa_tstp;
+bool signals_interrupt_pending() {
+    if (signal_fd < 0) return false;
+    sigset_t pending;
+    if (sigpending(&pending) < 0 || !sigismember(&pending, SIGINT)) return false;
+    return (signals_dispatch() & SIGNAL_EVENT_INTERRUPT) != 0;
+}
 
-    // Setup SIGINT handler
-    sa_int.sa_handler = sigint_handler;
-    sigemptyset(&sa_int.sa_mask);
-    sa_int.sa_flags = SA_RESTART; // Restart syscalls if interrupted by this signal
-    sigaction(SIGINT, &sa_int, NULL);
+void signals_child_defaults(sigset_t* defaults, sigset_t* mask) {
+    sigemptyset(defaults);
+    sigaddset(defaults, SIGINT);
+    sigaddset(defaults, SIGTSTP);
+    sigaddset(defaults, SIGTTIN);
+    sigaddset(defaults, SIGTTOU);
+    sigaddset(defaults, SIGPIPE);
+    if (signal_fd >= 0) {
+        *mask = original_mask;
+    } else {
+        sigprocmask(SIG_SETMASK, NULL, mask);
+    }
+}
 
-    // Setup SIGTSTP handler
-    sa_tstp.sa_handler = sigtstp_handler;
-    sigemptyset(&sa_tstp.sa_mask);
-    sa_tstp.sa_flags = SA_RESTART;
-    sigaction(SIGTSTP, &sa_tstp, NULL);
+int signals_from_name(const char* name) {
+    if (strncasecmp(name, "SIG", 3) == 0) name += 3;
+    for (int sig = 1; sig < NSIG; sig++) {
+        const char* abbrev = sigabbrev_np(sig);
+        if (abbrev && strcasecmp(name, abbrev) == 0) return sig;
+    }
+    return -1;
+}
 
-    // Ignore signals that a shell should typically ignore for job control
-    signal(SIGTTIN, SIG_IGN);
-    signal(SIGTTOU, SIG_IGN);
-}
\ No newline at end of file
+void signals_reset_for_child() {
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTSTP, SIG_DFL);
+    signal(SIGTTIN, SIG_DFL);
+    signal(SIGTTOU, SIG_DFL);
+    signal(SIGPIPE, SIG_DFL);
+    if (signal_fd >= 0) {
+        sigprocmask(SIG_SETMASK, &original_mask, NULL);
+        // A subshell waits for its own children with plain waitid.
+        fd_close(signal_fd);
+        signal_fd = -1;
+    }
+}
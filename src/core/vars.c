@@ -0,0 +1,246 @@
+#include "core/vars.h"
+#include "utils/error.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VARS_INITIAL_CAPACITY 128
+
+extern char** environ;
+
+/**
+ * @brief FNV-1a over the first 'len' bytes of 'name'.
+ */
+static uint32_t hash_name(const char* name, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Finds the slot for a name: the one holding it, or the empty slot where it would go.
+ */
+static Var* probe(const VarStore* store, const char* name, size_t len, uint32_t hash) {
+    size_t mask = store->capacity - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        Var* slot = &store->slots[i];
+        if (!slot->name) return slot;
+        if (slot->hash == hash && strncmp(slot->name, name, len) == 0 && slot->name[len] == '\0') return slot;
+    }
+}
+
+static bool grow(VarStore* store) {
+    size_t new_capacity = store->capacity ? store->capacity * 2 : VARS_INITIAL_CAPACITY;
+    Var* new_slots = calloc(new_capacity, sizeof(Var));
+    if (!new_slots) {
+        print_shell_perror("vars: calloc for table failed");
+        return false;
+    }
+    Var* old_slots = store->slots;
+    size_t old_capacity = store->capacity;
+    store->slots = new_slots;
+    store->capacity = new_capacity;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (!old_slots[i].name) continue;
+        *probe(store, old_slots[i].name, strlen(old_slots[i].name), old_slots[i].hash) = old_slots[i];
+    }
+    free(old_slots);
+    return true;
+}
+
+/**
+ * @brief Finds a name's slot, interning the name if it is new.
+ */
+static Var* intern(VarStore* store, const char* name, size_t len) {
+    // Keep the load factor under 3/4 so probe sequences stay short.
+    if ((store->used + 1) * 4 > store->capacity * 3 && !grow(store)) return NULL;
+    uint32_t hash = hash_name(name, len);
+    Var* slot = probe(store, name, len, hash);
+    if (slot->name) return slot;
+
+    char* copy = strndup(name, len);
+    if (!copy) {
+        print_shell_perror("vars: strdup for name failed");
+        return NULL;
+    }
+    slot->name = copy;
+    slot->hash = hash;
+    store->used++;
+    return slot;
+}
+
+/**
+ * @brief Rebuilds a variable's "NAME=value" entry after its value or export flag changed.
+ */
+static bool update_env_entry(VarStore* store, Var* var) {
+    bool had_entry = (var->env_entry != NULL);
+    free(var->env_entry);
+    var->env_entry = NULL;
+    if (var->exported && var->value) {
+        size_t name_len = strlen(var->name), value_len = strlen(var->value);
+        var->env_entry = malloc(name_len + value_len + 2);
+        if (!var->env_entry) {
+            print_shell_perror("vars: malloc for environment entry failed");
+            return false;
+        }
+        memcpy(var->env_entry, var->name, name_len);
+        var->env_entry[name_len] = '=';
+        memcpy(var->env_entry + name_len + 1, var->value, value_len + 1);
+    }
+    if (had_entry || var->env_entry) store->envp_dirty = true;
+    return true;
+}
+
+bool vars_init(VarStore* store, char** env) {
+    memset(store, 0, sizeof(*store));
+    store->original_environ = environ;
+    store->envp_dirty = true;
+    if (!grow(store)) return false;
+    for (char** entry = env; entry && *entry; entry++) {
+        if (!strchr(*entry, '=')) continue;
+        if (!vars_assign(store, *entry, true)) return false;
+    }
+    return true;
+}
+
+void vars_destroy(VarStore* store) {
+    if (store->envp && environ == store->envp) environ = store->original_environ;
+    for (size_t i = 0; i < store->capacity; i++) {
+        Var* var = &store->slots[i];
+        free((char*)var->name);
+        free(var->value);
+        free(var->env_entry);
+    }
+    free(store->slots);
+    free(store->envp);
+    memset(store, 0, sizeof(*store));
+}
+
+bool vars_valid_name(const char* name, size_t len) {
+    if (len == 0 || !(isalpha((unsigned char)name[0]) || name[0] == '_')) return false;
+    for (size_t i = 1; i < len; i++) {
+        if (!(isalnum((unsigned char)name[i]) || name[i] == '_')) return false;
+    }
+    return true;
+}
+
+const Var* vars_find(const VarStore* store, const char* name) {
+    size_t len = strlen(name);
+    const Var* slot = probe(store, name, len, hash_name(name, len));
+    return slot->name ? slot : NULL;
+}
+
+const char* vars_get(const VarStore* store, const char* name) {
+    const Var* var = vars_find(store, name);
+    return var ? var->value : NULL;
+}
+
+/**
+ * @brief Sets the variable named by the first 'name_len' bytes of 'name'.
+ */
+static bool set_value(VarStore* store, const char* name, size_t name_len, const char* value, bool export) {
+    Var* var = intern(store, name, name_len);
+    if (!var) return false;
+    char* copy = strdup(value);
+    if (!copy) {
+        print_shell_perror("vars: strdup for value failed");
+        return false;
+    }
+    free(var->value);
+    var->value = copy;
+    if (export) var->exported = true;
+    return update_env_entry(store, var);
+}
+
+bool vars_set(VarStore* store, const char* name, const char* value, bool export) {
+    return set_value(store, name, strlen(name), value, export);
+}
+
+bool vars_assign(VarStore* store, const char* assignment, bool export) {
+    const char* equals = strchr(assignment, '=');
+    if (!equals) return false;
+    return set_value(store, assignment, equals - assignment, equals + 1, export);
+}
+
+void vars_unset(VarStore* store, const char* name) {
+    Var* var = (Var*)vars_find(store, name);
+    if (!var) return;
+    free(var->value);
+    var->value = NULL;
+    var->exported = false;
+    update_env_entry(store, var);
+}
+
+bool vars_export(VarStore* store, const char* name, bool export) {
+    Var* var = intern(store, name, strlen(name));
+    if (!var) return false;
+    if (var->exported == export) return true;
+    var->exported = export;
+    return update_env_entry(store, var);
+}
+
+char** vars_envp(VarStore* store) {
+    if (!store->envp_dirty) return store->envp;
+
+    size_t count = 0;
+    for (size_t i = 0; i < store->capacity; i++) {
+        if (store->slots[i].env_entry) count++;
+    }
+    char** envp = malloc(sizeof(char*) * (count + 1));
+    if (!envp) {
+        print_shell_perror("vars: malloc for environment failed");
+        return NULL;
+    }
+    size_t n = 0, bytes = 0;
+    for (size_t i = 0; i < store->capacity; i++) {
+        char* entry = store->slots[i].env_entry;
+        if (!entry) continue;
+        envp[n++] = entry;
+        bytes += strlen(entry) + 1 + sizeof(char*);
+    }
+    envp[n] = NULL;
+
+    if (environ == store->envp) environ = envp;
+    free(store->envp);
+    store->envp = envp;
+    store->envp_count = n;
+    store->envp_bytes = bytes;
+    store->envp_dirty = false;
+    return envp;
+}
+
+void vars_apply_environ(VarStore* store) {
+    char** envp = vars_envp(store);
+    if (envp) environ = envp;
+}
+
+char** vars_layer_envp(const VarStore* store, char* const* assigns, int num_assigns) {
+    char** envp = malloc(sizeof(char*) * (store->envp_count + num_assigns + 1));
+    if (!envp) return NULL;
+    size_t n = 0;
+    for (int i = 0; i < num_assigns; i++) {
+        // 'B=1 B=2 cmd': the last assignment to a name wins, as in other shells.
+        size_t name_len = strcspn(assigns[i], "=");
+        bool reassigned = false;
+        for (int j = i + 1; j < num_assigns && !reassigned; j++) {
+            reassigned = strncmp(assigns[j], assigns[i], name_len + 1) == 0;
+        }
+        if (!reassigned) envp[n++] = assigns[i];
+    }
+    for (size_t i = 0; i < store->envp_count; i++) {
+        const char* entry = store->envp[i];
+        size_t name_len = strcspn(entry, "=");
+        bool overridden = false;
+        for (int j = 0; j < num_assigns && !overridden; j++) {
+            overridden = strncmp(assigns[j], entry, name_len) == 0 && assigns[j][name_len] == '=';
+        }
+        if (!overridden) envp[n++] = store->envp[i];
+    }
+    envp[n] = NULL;
+    return envp;
+}
@@ -0,0 +1,85 @@
+#include "core/watch.h"
+#include "core/event_loop.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+void watch_begin(WatchScreen* screen) {
+    memset(screen, 0, sizeof(*screen));
+    strbuf_init(&screen->out);
+    screen->redraw = isatty(STDOUT_FILENO);
+    if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &screen->saved) == 0) {
+        struct termios raw = screen->saved;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        screen->keys = tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0;
+    }
+    fflush(stdout); // Anything printed before must come out ahead of the first frame
+}
+
+bool watch_draw(WatchScreen* screen, const char* frame, size_t len) {
+    StrBuf* out = &screen->out;
+    strbuf_reset(out);
+    if (screen->redraw && screen->lines > 0) {
+        strbuf_appendf(out, "\033[%dA\r", screen->lines);
+    }
+    int lines = 0;
+    for (const char* p = frame; p < frame + len;) {
+        const char* eol = memchr(p, '\n', (size_t)(frame + len - p));
+        size_t part = eol ? (size_t)(eol - p) : (size_t)(frame + len - p);
+        strbuf_append(out, p, part);
+        if (!eol) break;
+        if (screen->redraw) strbuf_append_str(out, "\033[K"); // Clear what the old line had beyond this one
+        strbuf_putc(out, '\n');
+        lines++;
+        p = eol + 1;
+    }
+    if (screen->redraw) strbuf_append_str(out, "\033[J"); // And any lines below, if the frame shrank
+    screen->lines = lines;
+
+    for (size_t written = 0; written < out->len;) {
+        ssize_t n = write(STDOUT_FILENO, out->data + written, out->len - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return false;
+        written += (size_t)n;
+    }
+    return true;
+}
+
+static long long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+bool watch_sleep(WatchScreen* screen, double seconds) {
+    long long deadline = now_ms() + (long long)(seconds * 1000);
+    for (;;) {
+        long long remaining = deadline - now_ms();
+        if (remaining <= 0) return true;
+        if (signals_get_fd() < 0 && !screen->keys) {
+            // In a child, where Ctrl+C is delivered as usual and nothing else can wake us.
+            poll(NULL, 0, (int)remaining);
+            continue;
+        }
+        int events = event_loop_run_once(screen->keys ? STDIN_FILENO : -1, (int)remaining);
+        if (events & SIGNAL_EVENT_INTERRUPT) return false;
+        if (events & EVENT_FD_READY) {
+            char c;
+            ssize_t n = read(STDIN_FILENO, &c, 1);
+            if (n <= 0) screen->keys = false; // The terminal went away; keep going on the timer
+            else if (c == 'q' || c == 'x') return false;
+        }
+    }
+}
+
+void watch_end(WatchScreen* screen) {
+    if (screen->keys) tcsetattr(STDIN_FILENO, TCSANOW, &screen->saved);
+    screen->keys = false;
+    strbuf_free(&screen->out);
+}
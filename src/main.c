@@ -2,7 +2,11 @@
 #include "core/input.h"
 #include "core/executor.h"
 #include "utils/error.h"
+#include "utils/fd.h"
 #include "core/signals.h"
+#include "utils/strbuf.h"
+#include "utils/trace.h"
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -16,51 +20,127 @@ ShellState* g_shell_state = NULL;
  */
 static void cleanup_all_processes(ShellState* state) {
     printf("Killing all background jobs...\n");
-    for (int i = 0; i < state->num_bg_processes; i++) {
-        if (state->background_pids[i] > 0) {
-            kill(state->background_pids[i], SIGKILL);
-        }
+    for (int i = 0; i < state->jobs.count; i++) {
+        kill(-state->jobs.jobs[i]->pgid, SIGKILL);
     }
 }
 
-int main() {
-    ShellState state;
-    if (!shell_state_init(&state)) {
-        return EXIT_FAILURE;
-    }
+/**
+ * @brief Runs commands from a file (or a pipe) until it ends or 'exit' runs.
+ *
+ * Lines are accumulated until they form complete commands, so constructs may
+ * span lines just as they do at the "> " prompt.
+ */
+static void run_script(FILE* input, ShellState* state) {
+    PendingCommand pending;
+    pending_command_init(&pending);
+    char* line = NULL;
+    size_t capacity = 0;
+    ssize_t len;
 
-    g_shell_state = &state; // Set the global pointer for signal handlers
-    setup_signal_handlers();
+    while (state->is_running && (len = getline(&line, &capacity, input)) != -1) {
+        if (len > 0 && line[len - 1] == '\n') len--;
+        pending_command_add(&pending, line, (size_t)len, state);
+    }
+    if (state->is_running && pending.text.len > 0) {
+        print_shell_error("Syntax error: Unexpected end of file.");
+        state->last_exit_status = 2;
+    }
+    free(line);
+    pending_command_free(&pending);
+}
 
-    char input_line[MAX_INPUT_LEN];
+static void run_interactive(ShellState* state) {
+    // The line buffer grows as needed and is reused across iterations.
+    char* input_line = NULL;
+    size_t input_capacity = 0;
+    PendingCommand pending; // Lines of a command that is not finished yet
+    pending_command_init(&pending);
 
-    while (state.is_running) {
-        display_shell_prompt(&state);
+    while (state->is_running) {
+        if (!state->in_continuation) {
+            // Jobs that ended while a foreground command ran are reported before the prompt.
+            reap_background_jobs(state);
+        }
+        display_shell_prompt(state);
 
         // Reset per-command prompt info
-        state.last_command_name[0] = '\0';
-        state.time_taken_for_prompt = -1;
+        state->last_command_name[0] = '\0';
+        state->time_taken_for_prompt = -1;
 
-        if (get_line_with_history(input_line, sizeof(input_line), &state) == -1) {
+        long len = get_line_with_history(&input_line, &input_capacity, state);
+        if (len == LINE_INTERRUPTED) { // Ctrl+C at "> ": drop the unfinished command
+            pending_command_reset(&pending);
+            state->in_continuation = false;
+            continue;
+        }
+        if (len == -1) {
+            if (state->in_continuation) {
+                print_shell_error("Syntax error: Unexpected end of file.");
+                pending_command_reset(&pending);
+                state->in_continuation = false;
+                continue;
+            }
             printf("\n");
-            cleanup_all_processes(&state);
-            state.is_running = false;
+            cleanup_all_processes(state);
+            state->is_running = false;
             printf("Goodbye!\n");
             continue;
         }
 
-        if (strlen(input_line) == 0) {
+        if (input_line[0] == '\0' && !state->in_continuation) {
             continue;
         }
 
-        char mutable_input_line[MAX_INPUT_LEN];
-        strncpy(mutable_input_line, input_line, sizeof(mutable_input_line));
-        mutable_input_line[sizeof(mutable_input_line) - 1] = '\0';
+        state->in_continuation = !pending_command_add(&pending, input_line, (size_t)len, state);
+    }
 
-        // The executor now handles all processing for the input line
-        process_input_line(mutable_input_line, &state);
+    free(input_line);
+    pending_command_free(&pending);
+}
+
+int main(int argc, char* argv[]) {
+    // Tracing can be switched on from the environment so startup (history load) is captured too.
+    if (getenv("SHELLBY_TRACE") != NULL) {
+        trace_set_enabled(true);
+    }
+
+    // 'shellby script.sh', or commands piped in, run without prompts or history.
+    FILE* script = NULL;
+    if (argc > 1) {
+        // Kept out of the user's descriptors, and not inherited by the commands it runs.
+        int fd = open(argv[1], O_RDONLY | O_CLOEXEC);
+        script = (fd >= 0) ? fdopen(fd_keep(fd), "re") : NULL;
+        if (!script) {
+            print_shell_perror(argv[1]);
+            return 127;
+        }
+    } else if (!isatty(STDIN_FILENO)) {
+        script = stdin;
     }
 
+    ShellState state;
+    if (!shell_state_init(&state)) {
+        return EXIT_FAILURE;
+    }
+
+    g_shell_state = &state; // Set the global pointer for signal dispatch
+    setup_signal_handlers();
+
+    if (script) {
+        if (argc > 1) { // $0 is the script, $1... its arguments
+            state.positional = argv + 1;
+            state.num_positional = argc - 1;
+        }
+        state.interactive = false;
+        state.job_control = false; // No terminal to hand over
+        run_script(script, &state);
+        if (script != stdin) fclose(script);
+    } else {
+        run_interactive(&state);
+    }
+
+    int status = state.last_exit_status;
     shell_state_destroy(&state);
-    return EXIT_SUCCESS;
-}
\ No newline at end of file
+    return status;
+}
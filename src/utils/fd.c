@@ -0,0 +1,40 @@
+#include "utils/fd.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+
+#define FD_TRACKED 4096 ///< Descriptors numbered beyond this are not recorded
+#define WORD_BITS (sizeof(unsigned long) * CHAR_BIT)
+
+static unsigned long internal[FD_TRACKED / WORD_BITS];
+
+static void mark(int fd, bool on) {
+    if (fd < 0 || fd >= FD_TRACKED) return;
+    if (on) internal[fd / WORD_BITS] |= 1UL << (fd % WORD_BITS);
+    else internal[fd / WORD_BITS] &= ~(1UL << (fd % WORD_BITS));
+}
+
+int fd_keep(int fd) {
+    if (fd < 0) return -1;
+    if (fd < SHELL_FD_MIN) {
+        int moved = fcntl(fd, F_DUPFD_CLOEXEC, SHELL_FD_MIN);
+        if (moved >= 0) {
+            close(fd);
+            fd = moved;
+        }
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    mark(fd, true);
+    return fd;
+}
+
+void fd_close(int fd) {
+    if (fd < 0) return;
+    mark(fd, false);
+    close(fd);
+}
+
+bool fd_is_internal(int fd) {
+    return fd >= 0 && fd < FD_TRACKED && (internal[fd / WORD_BITS] >> (fd % WORD_BITS)) & 1UL;
+}
@@ -0,0 +1,183 @@
+#include "utils/html_text.h"
+#include "utils/colors.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { HT_HEADER, HT_TEXT, HT_TAG, HT_ENTITY };
+
+static const char HTTP_HEADER_END[] = "\r\n\r\n";
+static const char START_MARKER[] = "NAME\n";
+static const char NOT_FOUND_MARKER[] = "Search Again";
+
+/**
+ * @brief Advances a running match of 'pattern' by one character. For the
+ *        markers above a mismatch can only restart at the first character,
+ *        so falling back to 0 or 1 is exact.
+ */
+static size_t advance_match(const char* pattern, size_t matched, char c) {
+    if (pattern[matched] == c) return matched + 1;
+    return (c == pattern[0]) ? 1 : 0;
+}
+
+void html_text_init(HtmlText* h, bool skip_http_header) {
+    memset(h, 0, sizeof(*h));
+    h->state = skip_http_header ? HT_HEADER : HT_TEXT;
+}
+
+/**
+ * @brief Writes the escape codes for the current style. Called lazily before
+ *        the next visible character, so empty spans cost nothing.
+ */
+static void apply_style(HtmlText* h, FILE* out) {
+    h->style_dirty = false;
+    if (h->style_open) {
+        fputs(_RESET_, out);
+        h->style_open = false;
+    }
+    if (h->bold_depth > 0) {
+        fputs(_BOLD_, out);
+        h->style_open = true;
+    }
+    if (h->in_link) {
+        fputs(_BLUE_, out);
+        h->style_open = true;
+    }
+}
+
+static void emit_char(HtmlText* h, char c, FILE* out) {
+    if (h->started) {
+        if (h->style_dirty) apply_style(h, out);
+        fputc(c, out);
+        return;
+    }
+    // Before the page body: only look for the start and not-found markers.
+    h->not_found_match = advance_match(NOT_FOUND_MARKER, h->not_found_match, c);
+    if (NOT_FOUND_MARKER[h->not_found_match] == '\0') {
+        h->not_found = true;
+        h->not_found_match = 0;
+    }
+    h->start_match = advance_match(START_MARKER, h->start_match, c);
+    if (START_MARKER[h->start_match] == '\0') {
+        h->started = true;
+        fputs(START_MARKER, out);
+    }
+}
+
+static void handle_tag(HtmlText* h, FILE* out) {
+    const char* name = h->tag;
+    bool closing = (name[0] == '/');
+    if (closing) name++;
+
+    if (strcmp(name, "strong") == 0 || strcmp(name, "b") == 0) {
+        h->bold_depth += closing ? -1 : 1;
+        if (h->bold_depth < 0) h->bold_depth = 0;
+        h->style_dirty = true;
+    } else if (strcmp(name, "a") == 0) {
+        h->in_link = !closing;
+        h->style_dirty = true;
+    } else if (strcmp(name, "br") == 0) {
+        emit_char(h, '\n', out);
+    } else if (closing && strcmp(name, "pre") == 0 && h->started) {
+        h->finished = true;
+    }
+}
+
+/**
+ * @brief Emits a completed "&...;" reference (without the '&' and ';').
+ *        Unknown references are passed through unchanged.
+ */
+static void handle_entity(HtmlText* h, FILE* out) {
+    static const struct { const char* name; char c; } named[] = {
+        {"lt", '<'}, {"gt", '>'}, {"amp", '&'}, {"quot", '"'},
+        {"apos", '\''}, {"nbsp", ' '}, {"#39", '\''}, {"#160", ' '},
+    };
+    h->entity[h->entity_len] = '\0';
+    for (size_t i = 0; i < sizeof(named) / sizeof(named[0]); i++) {
+        if (strcmp(h->entity, named[i].name) == 0) {
+            emit_char(h, named[i].c, out);
+            return;
+        }
+    }
+    if (h->entity[0] == '#') {
+        long code = strtol(h->entity + 1, NULL, 10);
+        if (code > 0 && code < 128) {
+            emit_char(h, (char)code, out);
+            return;
+        }
+    }
+    emit_char(h, '&', out);
+    for (size_t i = 0; i < h->entity_len; i++) emit_char(h, h->entity[i], out);
+    emit_char(h, ';', out);
+}
+
+static void consume_char(HtmlText* h, char c, FILE* out) {
+    switch (h->state) {
+    case HT_HEADER:
+        h->header_match = advance_match(HTTP_HEADER_END, h->header_match, c);
+        if (HTTP_HEADER_END[h->header_match] == '\0') h->state = HT_TEXT;
+        return;
+
+    case HT_TEXT:
+        if (c == '<') {
+            h->state = HT_TAG;
+            h->tag_len = 0;
+            h->tag_name_done = false;
+            h->tag_quote = '\0';
+        } else if (c == '&') {
+            h->state = HT_ENTITY;
+            h->entity_len = 0;
+        } else if (c != '\r') {
+            emit_char(h, c, out);
+        }
+        return;
+
+    case HT_TAG:
+        if (h->tag_quote) {
+            if (c == h->tag_quote) h->tag_quote = '\0';
+        } else if (c == '>') {
+            h->tag[h->tag_len] = '\0';
+            h->state = HT_TEXT;
+            handle_tag(h, out);
+        } else if (c == '"' || c == '\'') {
+            h->tag_name_done = true;
+            h->tag_quote = c;
+        } else if (isspace((unsigned char)c) || (c == '/' && h->tag_len > 0)) {
+            h->tag_name_done = true;
+        } else if (!h->tag_name_done && h->tag_len < HTML_TAG_NAME_LEN - 1) {
+            h->tag[h->tag_len++] = (char)tolower((unsigned char)c);
+        }
+        return;
+
+    case HT_ENTITY:
+        if (c == ';') {
+            h->state = HT_TEXT;
+            handle_entity(h, out);
+        } else if ((isalnum((unsigned char)c) || c == '#') && h->entity_len < HTML_ENTITY_LEN - 1) {
+            h->entity[h->entity_len++] = c;
+        } else {
+            // Not a reference after all: emit it literally and reprocess 'c'.
+            h->state = HT_TEXT;
+            emit_char(h, '&', out);
+            for (size_t i = 0; i < h->entity_len; i++) emit_char(h, h->entity[i], out);
+            consume_char(h, c, out);
+        }
+        return;
+    }
+}
+
+bool html_text_feed(HtmlText* h, const char* data, size_t len, FILE* out) {
+    for (size_t i = 0; i < len && !h->finished; i++) {
+        consume_char(h, data[i], out);
+    }
+    return !h->finished;
+}
+
+void html_text_finish(HtmlText* h, FILE* out) {
+    if (h->style_open) {
+        fputs(_RESET_, out);
+        h->style_open = false;
+    }
+    fflush(out);
+}
@@ -1,7 +1,10 @@
 #include "utils/que.h"
-#include "core/shell_state.h" // For constants like MAX_INPUT_LEN, HISTORY_SIZE, etc.
+#include "core/shell_state.h" // For constants like MAX_PATH_LEN, HISTORY_SIZE, etc.
 #include "utils/error.h"      // For print_shell_perror
+#include "utils/strbuf.h"
+#include "utils/trace.h"
 
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -19,16 +22,9 @@ Que initQue() {
         free(Q);
         exit(EXIT_FAILURE); // Critical failure
     }
+    // Slots are allocated per entry, sized to the command they hold.
     for (int i = 0; i < Q->capacity; i++) {
-        Q->arr[i] = (Instruction)malloc(sizeof(char) * MAX_INPUT_LEN);
-        if (!Q->arr[i]) {
-            print_shell_perror("malloc for Que instruction string failed");
-            for (int j = 0; j < i; j++) free(Q->arr[j]);
-            free(Q->arr);
-            free(Q);
-            exit(EXIT_FAILURE); // Critical failure
-        }
-        Q->arr[i][0] = '\0'; // Initialize to empty string
+        Q->arr[i] = NULL;
     }
     Q->latest = -1;
     Q->numElems = 0;
@@ -42,19 +38,29 @@ bool isHistoryEmpty(Que Q) {
 
 void add_history_element(Que Q, Instruction e) {
     if (!Q || !e || strlen(e) == 0) return;
+    TRACE_BEGIN(add_start);
 
     // Avoid adding consecutive duplicates
     if (Q->numElems > 0 && strcmp(e, Q->arr[Q->latest]) == 0) {
+        TRACE_END(TRACE_HISTORY, add_start);
+        return;
+    }
+
+    Instruction copy = strdup(e);
+    if (!copy) {
+        print_shell_perror("strdup for history element failed");
+        TRACE_END(TRACE_HISTORY, add_start);
         return;
     }
 
     Q->latest = (Q->latest + 1) % Q->capacity;
-    strncpy(Q->arr[Q->latest], e, MAX_INPUT_LEN - 1);
-    Q->arr[Q->latest][MAX_INPUT_LEN - 1] = '\0'; // Ensure null termination
+    free(Q->arr[Q->latest]); // Overwrite the oldest entry once the queue is full
+    Q->arr[Q->latest] = copy;
 
     if (Q->numElems < Q->capacity) {
         Q->numElems++;
     }
+    TRACE_END(TRACE_HISTORY, add_start);
 }
 
 Instruction get_kth_history_element(Que Q, int k) {
@@ -70,20 +76,19 @@ Instruction get_kth_history_element(Que Q, int k) {
     // (latest - (k-1) + capacity) % capacity
     int target_index = (Q->latest - (k - 1) + Q->capacity) % Q->capacity;
 
-    Instruction ins_copy = (Instruction)malloc(sizeof(char) * MAX_INPUT_LEN);
+    Instruction ins_copy = strdup(Q->arr[target_index]);
     if (!ins_copy) {
-        print_shell_perror("malloc for history element copy failed");
+        print_shell_perror("strdup for history element copy failed");
         return NULL;
     }
-    strncpy(ins_copy, Q->arr[target_index], MAX_INPUT_LEN - 1);
-    ins_copy[MAX_INPUT_LEN - 1] = '\0';
     return ins_copy; // Caller must free this
 }
 
 void purge_history(Que Q) {
     if (!Q) return;
     for (int i = 0; i < Q->capacity; i++) {
-        Q->arr[i][0] = '\0';
+        free(Q->arr[i]);
+        Q->arr[i] = NULL;
     }
     Q->latest = -1;
     Q->numElems = 0;
@@ -104,8 +109,21 @@ void display_history(Que Q) {
     }
 }
 
+/**
+ * @brief The number of lines that follow a "#+N" line, which starts an entry
+ *        of N lines (a command with a here-document), or 0 for any other line.
+ */
+static int entry_lines(const char* line) {
+    if (line[0] != '#' || line[1] != '+' || !isdigit((unsigned char)line[2])) return 0;
+    for (const char* p = line + 2; *p; p++) {
+        if (!isdigit((unsigned char)*p)) return 0;
+    }
+    return atoi(line + 2);
+}
+
 void read_history_from_file(Que Q, const char* homeDir) {
     if (!Q || !homeDir) return;
+    TRACE_BEGIN(read_start);
     char path[MAX_PATH_LEN];
     snprintf(path, sizeof(path), "%s/%s", homeDir, HISTORY_FILENAME);
 
@@ -113,44 +131,68 @@ void read_history_from_file(Que Q, const char* homeDir) {
     if (!f) {
         // This is normal on first run or if file was deleted
         // perror("Could not open history file for reading"); 
+        TRACE_END(TRACE_HISTORY, read_start);
         return;
     }
 
-    char buff[MAX_INPUT_LEN];
-    while (fgets(buff, sizeof(buff), f) != NULL) {
-        size_t len = strlen(buff);
+    char* buff = NULL;
+    size_t buff_capacity = 0;
+    ssize_t len;
+    while ((len = getline(&buff, &buff_capacity, f)) != -1) {
         if (len > 0 && buff[len - 1] == '\n') {
             buff[len - 1] = '\0';
         }
-        if (strlen(buff) > 0) { // Don't add empty lines from file
+        int lines = entry_lines(buff);
+        if (lines > 0) {
+            StrBuf entry;
+            strbuf_init(&entry);
+            for (int i = 0; i < lines && (len = getline(&buff, &buff_capacity, f)) != -1; i++) {
+                if (len > 0 && buff[len - 1] == '\n') len--;
+                if (i > 0) strbuf_putc(&entry, '\n');
+                strbuf_append(&entry, buff, (size_t)len);
+            }
+            if (entry.data) add_history_element(Q, entry.data);
+            strbuf_free(&entry);
+        } else if (buff[0] != '\0') { // Don't add empty lines from file
             add_history_element(Q, buff); // add_history_element handles duplicates and capacity
         }
     }
+    free(buff);
     fclose(f);
+    TRACE_END(TRACE_HISTORY, read_start);
 }
 
 void write_history_to_file(Que Q, const char* homeDir) {
     if (!Q || !homeDir) return;
+    TRACE_BEGIN(write_start);
     char path[MAX_PATH_LEN];
     snprintf(path, sizeof(path), "%s/%s", homeDir, HISTORY_FILENAME);
 
     FILE* f = fopen(path, "w");
     if (!f) {
         print_shell_perror("Could not open history file for writing");
+        TRACE_END(TRACE_HISTORY, write_start);
         return;
     }
 
     if (Q->numElems == 0) {
         fclose(f);
+        TRACE_END(TRACE_HISTORY, write_start);
         return;
     }
 
     int current_idx = (Q->latest - Q->numElems + 1 + Q->capacity) % Q->capacity;
     for (int i = 0; i < Q->numElems; i++) {
-        fprintf(f, "%s\n", Q->arr[current_idx]);
+        // An entry of several lines is preceded by "#+N", N being how many.
+        const char* entry = Q->arr[current_idx];
+        int lines = 1;
+        for (const char* p = strchr(entry, '\n'); p; p = strchr(p + 1, '\n')) lines++;
+        if (lines > 1) fprintf(f, "#+%d\n", lines);
+        fprintf(f, "%s\n", entry);
         current_idx = (current_idx + 1) % Q->capacity;
     }
     fclose(f);
+    TRACE_END(TRACE_HISTORY, write_start);
 }
 
 void destroyQue(Que Q) {
@@ -178,12 +220,10 @@ Instruction get_kth_history_element_silent(Que Q, int k) {
     // k=1 is latest, k=2 is second latest, etc.
     int target_index = (Q->latest - (k - 1) + Q->capacity) % Q->capacity;
 
-    Instruction ins_copy = (Instruction)malloc(sizeof(char) * MAX_INPUT_LEN);
+    Instruction ins_copy = strdup(Q->arr[target_index]);
     if (!ins_copy) {
-        print_shell_perror("malloc for history element copy failed");
+        print_shell_perror("strdup for history element copy failed");
         return NULL;
     }
-    strncpy(ins_copy, Q->arr[target_index], MAX_INPUT_LEN - 1);
-    ins_copy[MAX_INPUT_LEN - 1] = '\0';
     return ins_copy; // Caller must free this
 }
\ No newline at end of file
@@ -0,0 +1,688 @@
+#include "utils/roff.h"
+#include "utils/colors.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#define ROFF_MAX_ARGS 16
+#define ROFF_MAX_SO_DEPTH 4
+#define ROFF_RS_STACK 16
+#define ROFF_SECTION_INDENT 7
+#define ROFF_SUBSECTION_INDENT 3
+
+typedef enum { FONT_R, FONT_B, FONT_I } RoffFont;
+
+/**
+ * @brief Formatter state. Text is collected a word at a time and filled into
+ *        'line', which is flushed to 'out' whenever it would exceed 'width'.
+ */
+typedef struct {
+    StrBuf* out;
+    int width;
+
+    int base_indent;  ///< 0 before the first .SH, then ROFF_SECTION_INDENT
+    int rs_indent;    ///< Extra indent from .RS blocks
+    int rs_stack[ROFF_RS_STACK];
+    int rs_depth;
+    int para_indent;  ///< Body indent of the current .TP/.IP paragraph
+
+    bool fill;
+    RoffFont font;
+    RoffFont prev_font;
+    RoffFont next_line_font; ///< Set by an argument-less .B/.I (FONT_R = none)
+
+    StrBuf line;      ///< Current output line, including escape codes
+    int line_col;     ///< Visible width of 'line'
+    bool line_started;
+    bool reopen_font; ///< A style was open when the last line was flushed
+    bool glue_next;   ///< Don't insert a space before the next word
+
+    StrBuf word;
+    int word_col;
+
+    bool tag_pending; ///< The next text line is a .TP tag
+    int tag_width;
+
+    bool last_blank;  ///< The last emitted line was blank (or nothing emitted yet)
+    char* url;        ///< Pending .UR/.MT target
+
+    bool skip_else;   ///< The last .ie condition was true: skip the next .el
+    int skip_braces;  ///< Depth of a skipped \{ ... \} conditional block
+    bool in_definition; ///< Inside .de/.ig, skipping to ".."
+} Roff;
+
+static const char* font_code(RoffFont font) {
+    switch (font) {
+        case FONT_B: return _BOLD_;
+        case FONT_I: return _UNDERLINE_;
+        default: return _RESET_;
+    }
+}
+
+static int indent_now(const Roff* r) {
+    return r->base_indent + r->rs_indent + r->para_indent;
+}
+
+/**
+ * @brief Counts the visible columns of a UTF-8 byte (continuation bytes count zero).
+ */
+static int visible_width(unsigned char c) {
+    return (c & 0xC0) == 0x80 ? 0 : 1;
+}
+
+static void set_font(Roff* r, RoffFont font) {
+    if (font == r->font) return;
+    r->prev_font = r->font;
+    r->font = font;
+    strbuf_append_str(&r->word, font_code(font));
+}
+
+static void start_line(Roff* r) {
+    if (r->line_started) return;
+    for (int i = 0; i < indent_now(r); i++) strbuf_putc(&r->line, ' ');
+    r->line_col = indent_now(r);
+    if (r->reopen_font && r->font != FONT_R) strbuf_append_str(&r->line, font_code(r->font));
+    r->reopen_font = false;
+    r->line_started = true;
+    r->glue_next = true;
+}
+
+static void flush_line(Roff* r) {
+    if (!r->line_started) return;
+    // Trim trailing spaces, then close any open style so it can't bleed into the next line.
+    while (r->line.len > 0 && r->line.data[r->line.len - 1] == ' ') r->line.len--;
+    r->line.data[r->line.len] = '\0';
+    strbuf_append(r->out, r->line.data, r->line.len);
+    if (r->font != FONT_R) strbuf_append_str(r->out, _RESET_);
+    r->reopen_font = r->font != FONT_R;
+    strbuf_putc(r->out, '\n');
+    strbuf_reset(&r->line);
+    r->line_started = false;
+    r->line_col = 0;
+    r->last_blank = false;
+}
+
+static void blank_line(Roff* r) {
+    flush_line(r);
+    if (!r->last_blank) {
+        strbuf_putc(r->out, '\n');
+        r->last_blank = true;
+    }
+}
+
+/**
+ * @brief Moves the pending word into the current line, wrapping first if needed.
+ */
+static void end_word(Roff* r) {
+    if (r->word.len == 0) return;
+    if (r->word_col == 0) {
+        // Only style codes. Inside a line they go straight in; otherwise they
+        // stay in the word and prefix the next visible text.
+        if (r->line_started) {
+            strbuf_append(&r->line, r->word.data, r->word.len);
+            strbuf_reset(&r->word);
+        }
+        return;
+    }
+    if (r->fill && r->line_started && !r->glue_next &&
+        r->line_col + 1 + r->word_col > r->width) {
+        flush_line(r);
+    }
+    start_line(r);
+    if (!r->glue_next) {
+        strbuf_putc(&r->line, ' ');
+        r->line_col++;
+    }
+    strbuf_append(&r->line, r->word.data, r->word.len);
+    r->line_col += r->word_col;
+    r->glue_next = false;
+    strbuf_reset(&r->word);
+    r->word_col = 0;
+}
+
+static void add_visible(Roff* r, const char* text) {
+    for (const char* p = text; *p; p++) {
+        strbuf_putc(&r->word, *p);
+        r->word_col += visible_width((unsigned char)*p);
+    }
+}
+
+/**
+ * @brief Maps a groff special character name (\(xx or \[name]) to plain text.
+ */
+static const char* special_char(const char* name) {
+    static const char* const table[][2] = {
+        {"em", "--"}, {"en", "-"}, {"hy", "-"}, {"mi", "-"}, {"bu", "*"}, {"co", "(C)"},
+        {"rg", "(R)"}, {"tm", "(TM)"}, {"aq", "'"}, {"dq", "\""}, {"lq", "\""}, {"rq", "\""},
+        {"oq", "'"}, {"cq", "'"}, {"ga", "`"}, {"ti", "~"}, {"ha", "^"}, {"rs", "\\"},
+        {"sl", "/"}, {"pl", "+"}, {"mu", "x"}, {"di", "/"}, {"eq", "="}, {">=", ">="},
+        {"<=", "<="}, {"!=", "!="}, {"->", "->"}, {"<-", "<-"}, {"de", "deg"}, {"or", "|"},
+        {"ba", "|"}, {"lh", "<="}, {"rh", "=>"}, {"Fo", "<<"}, {"Fc", ">>"}, {"fo", "<"},
+        {"fc", ">"}, {"sq", "[]"}, {"dg", "+"}, {"ps", "P"}, {"sc", "S"}, {"ct", "c"},
+        {"12", "1/2"}, {"14", "1/4"}, {"34", "3/4"}, {"R", "(R)"}, {"Tm", "(TM)"},
+    };
+    for (size_t i = 0; i < sizeof(table) / sizeof(table[0]); i++) {
+        if (strcmp(table[i][0], name) == 0) return table[i][1];
+    }
+    return "";
+}
+
+/**
+ * @brief Reads an escape name: "x", "(xx" or "[name]". Returns the position after it.
+ */
+static const char* read_escape_name(const char* p, char* name, size_t size) {
+    size_t n = 0;
+    if (*p == '(') {
+        p++;
+        while (*p && n < 2) name[n++] = *p++;
+    } else if (*p == '[') {
+        p++;
+        while (*p && *p != ']') {
+            if (n < size - 1) name[n++] = *p;
+            p++;
+        }
+        if (*p == ']') p++;
+    } else if (*p) {
+        name[n++] = *p++;
+    }
+    name[n] = '\0';
+    return p;
+}
+
+/**
+ * @brief Skips a delimited escape argument such as \h'...' or \w"...".
+ */
+static const char* skip_delimited(const char* p) {
+    char delim = *p;
+    if (!delim) return p;
+    p++;
+    while (*p && *p != delim) p++;
+    return *p ? p + 1 : p;
+}
+
+/**
+ * @brief Decodes escapes in 's' and adds the text to the current word.
+ * @param split_words Whether unescaped spaces separate words (fill mode).
+ * @return False if the text ended with \c (the next line continues this word).
+ */
+static bool add_text_raw(Roff* r, const char* s, bool split_words) {
+    for (const char* p = s; *p;) {
+        if (*p == '\\') {
+            p++;
+            char name[32];
+            switch (*p) {
+                case '\0':
+                    break; // Trailing backslash: line continuation
+                case 'f':
+                    p = read_escape_name(p + 1, name, sizeof(name));
+                    if (strcmp(name, "B") == 0 || strcmp(name, "3") == 0 || strcmp(name, "CB") == 0) set_font(r, FONT_B);
+                    else if (strcmp(name, "I") == 0 || strcmp(name, "2") == 0 || strcmp(name, "CI") == 0) set_font(r, FONT_I);
+                    else if (strcmp(name, "P") == 0) set_font(r, r->prev_font);
+                    else set_font(r, FONT_R);
+                    continue;
+                case '(':
+                case '[':
+                    p = read_escape_name(p, name, sizeof(name));
+                    add_visible(r, special_char(name));
+                    continue;
+                case '*':
+                    p = read_escape_name(p + 1, name, sizeof(name));
+                    add_visible(r, special_char(name));
+                    continue;
+                case 'n':
+                    p = read_escape_name(p + 1, name, sizeof(name)); // Number registers: drop
+                    continue;
+                case 's':
+                    p++;
+                    if (*p == '+' || *p == '-') p++;
+                    while (isdigit((unsigned char)*p)) p++;
+                    continue;
+                case 'h': case 'v': case 'w': case 'N': case 'o': case 'l': case 'L': case 'D': case 'X': case 'Z':
+                    p = skip_delimited(p + 1);
+                    continue;
+                case 'e': case '\\':
+                    add_visible(r, "\\");
+                    break;
+                case '-':
+                    add_visible(r, "-");
+                    break;
+                case ' ': case '~': case '0':
+                    add_visible(r, " "); // Unbreakable space
+                    break;
+                case '\'':
+                    add_visible(r, "'");
+                    break;
+                case '`':
+                    add_visible(r, "`");
+                    break;
+                case '.':
+                    add_visible(r, ".");
+                    break;
+                case '"':
+                    return true; // Comment to end of line
+                case 'c':
+                    return false; // Join with the next input line
+                case '{': case '}': case '&': case '|': case '^': case '%': case ':': case ')': case '/': case ',':
+                    break; // Zero-width
+                default:
+                    add_visible(r, (char[]){*p, '\0'});
+                    break;
+            }
+            if (*p) p++;
+        } else if (*p == ' ' && split_words) {
+            end_word(r);
+            while (*p == ' ') p++;
+        } else if (*p == '\t') {
+            end_word(r);
+            start_line(r);
+            int next_stop = indent_now(r) + ((r->line_col - indent_now(r)) / 8 + 1) * 8;
+            while (r->line_col < next_stop) {
+                strbuf_putc(&r->line, ' ');
+                r->line_col++;
+            }
+            r->glue_next = true;
+            p++;
+        } else {
+            char c[2] = {*p, '\0'};
+            add_visible(r, c);
+            p++;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Formats one line of text, decoding escapes and filling words.
+ */
+static void add_text(Roff* r, const char* s) {
+    if (add_text_raw(r, s, r->fill)) {
+        end_word(r);
+    }
+}
+
+/**
+ * @brief Splits macro arguments, honoring double quotes. Modifies 's' in place.
+ * @return The number of arguments stored in argv.
+ */
+static int split_args(char* s, char* argv[], int max_args) {
+    int argc = 0;
+    while (*s && argc < max_args) {
+        while (*s == ' ' || *s == '\t') s++;
+        if (!*s) break;
+        if (*s == '"') {
+            char* dst = ++s;
+            argv[argc++] = dst;
+            while (*s) {
+                if (*s == '"' && s[1] == '"') { *dst++ = '"'; s += 2; }
+                else if (*s == '"') { s++; break; }
+                else *dst++ = *s++;
+            }
+            char* after = s;
+            *dst = '\0';
+            s = after;
+        } else {
+            argv[argc++] = s;
+            while (*s && *s != ' ' && *s != '\t') {
+                if (*s == '\\' && s[1]) s++;
+                s++;
+            }
+            if (*s) *s++ = '\0';
+        }
+    }
+    return argc;
+}
+
+/**
+ * @brief Parses a roff scaled number ("4", "4n", "0.5i") into character columns.
+ */
+static int parse_indent(const char* arg, int fallback) {
+    if (!arg || !*arg) return fallback;
+    char* end;
+    double value = strtod(arg, &end);
+    if (end == arg) return fallback;
+    if (*end == 'i') value *= 10;
+    else if (*end == 'c') value *= 4;
+    return value < 0 ? 0 : (int)value;
+}
+
+/**
+ * @brief Renders 'text' in 'font', then returns to the previous font.
+ */
+static void add_text_in_font(Roff* r, const char* text, RoffFont font) {
+    RoffFont saved = r->font;
+    set_font(r, font);
+    add_text(r, text);
+    set_font(r, saved);
+    end_word(r);
+}
+
+/**
+ * @brief Handles .BR, .IR etc.: arguments alternate between two fonts with no spaces.
+ */
+static void add_alternating(Roff* r, char* argv[], int argc, RoffFont a, RoffFont b) {
+    RoffFont saved = r->font;
+    for (int i = 0; i < argc; i++) {
+        set_font(r, (i % 2 == 0) ? a : b);
+        // The pieces form one word; spaces inside a quoted argument don't split it.
+        add_text_raw(r, argv[i], false);
+    }
+    set_font(r, saved);
+    end_word(r);
+}
+
+static void begin_paragraph(Roff* r) {
+    blank_line(r);
+    r->para_indent = 0;
+    r->tag_pending = false;
+}
+
+static void begin_tagged_paragraph(Roff* r, int width) {
+    begin_paragraph(r);
+    r->tag_width = width;
+    r->tag_pending = true;
+}
+
+/**
+ * @brief Finishes a .TP/.IP tag: the body goes on the same line if the tag is short.
+ */
+static void finish_tag(Roff* r) {
+    end_word(r);
+    r->para_indent = r->tag_width;
+    if (r->line_started && r->line_col < indent_now(r) - 1) {
+        while (r->line_col < indent_now(r)) {
+            strbuf_putc(&r->line, ' ');
+            r->line_col++;
+        }
+        r->glue_next = true;
+    } else {
+        flush_line(r);
+    }
+    r->tag_pending = false;
+}
+
+static void section_heading(Roff* r, char* argv[], int argc, int indent) {
+    flush_line(r);
+    if (!r->last_blank && r->out->len > 0) blank_line(r);
+    r->rs_depth = 0;
+    r->rs_indent = 0;
+    r->para_indent = 0;
+    r->tag_pending = false;
+    r->base_indent = indent;
+    bool saved_fill = r->fill;
+    r->fill = true;
+    set_font(r, FONT_B);
+    for (int i = 0; i < argc; i++) add_text(r, argv[i]);
+    set_font(r, FONT_R);
+    end_word(r);
+    flush_line(r);
+    r->last_blank = true; // A paragraph break right after a heading adds no blank line
+    r->fill = saved_fill;
+    r->base_indent = ROFF_SECTION_INDENT;
+}
+
+static bool render_stream(Roff* r, const char* path, int depth);
+
+/**
+ * @brief Evaluates the condition of .if/.ie. Only nroff ('n') and its negation are understood.
+ * @param rest Set to the text after the condition.
+ */
+static bool eval_condition(char* s, char** rest) {
+    while (*s == ' ') s++;
+    bool negate = false;
+    if (*s == '!') { negate = true; s++; }
+    bool result = false;
+    if (*s == 'n') { result = true; s++; }
+    else if (*s == 't' || *s == 'o' || *s == 'e') { result = false; s++; }
+    else if (*s == '\'' || *s == '"') { s = (char*)skip_delimited(s); s = (char*)skip_delimited(s - 1); result = false; }
+    else { while (*s && *s != ' ') s++; result = false; }
+    while (*s == ' ') s++;
+    *rest = s;
+    return negate ? !result : result;
+}
+
+static void process_line(Roff* r, char* line, const char* path, int depth);
+
+/**
+ * @brief Runs or skips the body of a conditional, tracking \{ ... \} blocks.
+ */
+static void conditional_body(Roff* r, char* body, bool take, const char* path, int depth) {
+    bool opens_block = strncmp(body, "\\{", 2) == 0;
+    if (opens_block) {
+        body += 2;
+        while (*body == ' ') body++;
+    }
+    if (take) {
+        if (*body) process_line(r, body, path, depth);
+    } else if (opens_block && !strstr(body, "\\}")) {
+        r->skip_braces++;
+    }
+}
+
+static void request(Roff* r, char* line, const char* path, int depth) {
+    char* p = line + 1;
+    while (*p == ' ' || *p == '\t') p++;
+    char name[8] = {0};
+    int n = 0;
+    while (*p && *p != ' ' && *p != '\t' && n < (int)sizeof(name) - 1) name[n++] = *p++;
+    if (n == 0 || strncmp(name, "\\\"", 2) == 0) return; // Empty request or comment
+
+    if (strcmp(name, "if") == 0 || strcmp(name, "ie") == 0) {
+        char* rest;
+        bool take = eval_condition(p, &rest);
+        if (strcmp(name, "ie") == 0) r->skip_else = take;
+        conditional_body(r, rest, take, path, depth);
+        return;
+    }
+    if (strcmp(name, "el") == 0) {
+        while (*p == ' ') p++;
+        conditional_body(r, p, !r->skip_else, path, depth);
+        return;
+    }
+    if (strcmp(name, "de") == 0 || strcmp(name, "ig") == 0 || strcmp(name, "am") == 0) {
+        r->in_definition = true;
+        return;
+    }
+    if (strcmp(name, "so") == 0) {
+        char* argv[ROFF_MAX_ARGS];
+        if (split_args(p, argv, ROFF_MAX_ARGS) > 0 && depth < ROFF_MAX_SO_DEPTH) {
+            // .so paths are relative to the man tree root: <root>/manN/page.N
+            char root[4096];
+            snprintf(root, sizeof(root), "%s", path);
+            for (int up = 0; up < 2; up++) {
+                char* slash = strrchr(root, '/');
+                if (slash) *slash = '\0';
+            }
+            char target[8192];
+            snprintf(target, sizeof(target), "%s/%s", root, argv[0]);
+            if (!render_stream(r, target, depth + 1)) {
+                snprintf(target, sizeof(target), "%s/%s.gz", root, argv[0]);
+                render_stream(r, target, depth + 1);
+            }
+        }
+        return;
+    }
+
+    char* argv[ROFF_MAX_ARGS];
+    int argc = split_args(p, argv, ROFF_MAX_ARGS);
+
+    if (strcmp(name, "SH") == 0) {
+        section_heading(r, argv, argc, 0);
+    } else if (strcmp(name, "SS") == 0) {
+        section_heading(r, argv, argc, ROFF_SUBSECTION_INDENT);
+    } else if (strcmp(name, "PP") == 0 || strcmp(name, "P") == 0 || strcmp(name, "LP") == 0 ||
+               strcmp(name, "HP") == 0) {
+        begin_paragraph(r);
+    } else if (strcmp(name, "TP") == 0) {
+        begin_tagged_paragraph(r, parse_indent(argc > 0 ? argv[0] : NULL, ROFF_SECTION_INDENT));
+    } else if (strcmp(name, "TQ") == 0) {
+        flush_line(r);
+        r->para_indent = 0;
+        r->tag_pending = true;
+    } else if (strcmp(name, "IP") == 0) {
+        begin_tagged_paragraph(r, parse_indent(argc > 1 ? argv[1] : NULL, ROFF_SECTION_INDENT));
+        if (argc > 0 && argv[0][0]) {
+            add_text(r, argv[0]);
+            finish_tag(r);
+        } else {
+            r->tag_pending = false;
+            r->para_indent = r->tag_width;
+        }
+    } else if (strcmp(name, "RS") == 0) {
+        flush_line(r);
+        if (r->rs_depth < ROFF_RS_STACK) r->rs_stack[r->rs_depth++] = r->rs_indent;
+        r->rs_indent += parse_indent(argc > 0 ? argv[0] : NULL, r->para_indent ? r->para_indent : ROFF_SECTION_INDENT);
+        r->para_indent = 0;
+    } else if (strcmp(name, "RE") == 0) {
+        flush_line(r);
+        r->rs_indent = r->rs_depth > 0 ? r->rs_stack[--r->rs_depth] : 0;
+        r->para_indent = 0;
+    } else if (strcmp(name, "br") == 0) {
+        flush_line(r);
+    } else if (strcmp(name, "sp") == 0) {
+        blank_line(r);
+    } else if (strcmp(name, "nf") == 0 || strcmp(name, "EX") == 0) {
+        flush_line(r);
+        r->fill = false;
+    } else if (strcmp(name, "fi") == 0 || strcmp(name, "EE") == 0) {
+        flush_line(r);
+        r->fill = true;
+    } else if (strcmp(name, "ft") == 0) {
+        const char* f = argc > 0 ? argv[0] : "R";
+        set_font(r, (f[0] == 'B' || f[0] == '3') ? FONT_B : (f[0] == 'I' || f[0] == '2') ? FONT_I
+                   : (f[0] == 'P') ? r->prev_font : FONT_R);
+    } else if (strcmp(name, "B") == 0 || strcmp(name, "SB") == 0 || strcmp(name, "I") == 0) {
+        RoffFont font = name[0] == 'I' ? FONT_I : FONT_B;
+        if (argc == 0) {
+            r->next_line_font = font;
+        } else {
+            for (int i = 0; i < argc; i++) add_text_in_font(r, argv[i], font);
+        }
+    } else if (strcmp(name, "SM") == 0) {
+        for (int i = 0; i < argc; i++) add_text(r, argv[i]);
+    } else if (strcmp(name, "BR") == 0) { add_alternating(r, argv, argc, FONT_B, FONT_R);
+    } else if (strcmp(name, "RB") == 0) { add_alternating(r, argv, argc, FONT_R, FONT_B);
+    } else if (strcmp(name, "BI") == 0) { add_alternating(r, argv, argc, FONT_B, FONT_I);
+    } else if (strcmp(name, "IB") == 0) { add_alternating(r, argv, argc, FONT_I, FONT_B);
+    } else if (strcmp(name, "IR") == 0) { add_alternating(r, argv, argc, FONT_I, FONT_R);
+    } else if (strcmp(name, "RI") == 0) { add_alternating(r, argv, argc, FONT_R, FONT_I);
+    } else if (strcmp(name, "UR") == 0 || strcmp(name, "MT") == 0) {
+        free(r->url);
+        r->url = argc > 0 ? strdup(argv[0]) : NULL;
+    } else if (strcmp(name, "UE") == 0 || strcmp(name, "ME") == 0) {
+        if (r->url) {
+            add_visible(r, "<");
+            add_visible(r, r->url);
+            add_visible(r, ">");
+            if (argc > 0) add_text(r, argv[0]);
+            end_word(r);
+            free(r->url);
+            r->url = NULL;
+        }
+    } else if (strcmp(name, "SY") == 0) {
+        begin_paragraph(r);
+        if (argc > 0) add_text_in_font(r, argv[0], FONT_B);
+    } else if (strcmp(name, "OP") == 0) {
+        add_visible(r, "[");
+        if (argc > 0) add_text_in_font(r, argv[0], FONT_B);
+        if (argc > 1) add_text_in_font(r, argv[1], FONT_I);
+        add_visible(r, "]");
+        end_word(r);
+    } else if (strcmp(name, "YS") == 0) {
+        flush_line(r);
+    }
+    // Everything else (.TH, .PD, .ad, .na, .hy, .ne, .in, .ta, .ds, .nr, ...) has no visible effect here.
+}
+
+static void process_line(Roff* r, char* line, const char* path, int depth) {
+    if (r->in_definition) {
+        if (strncmp(line, "..", 2) == 0) r->in_definition = false;
+        return;
+    }
+    if (r->skip_braces > 0) {
+        for (const char* p = line; (p = strstr(p, "\\{")) != NULL; p += 2) r->skip_braces++;
+        for (const char* p = line; (p = strstr(p, "\\}")) != NULL; p += 2) r->skip_braces--;
+        if (r->skip_braces < 0) r->skip_braces = 0;
+        return;
+    }
+    if (line[0] == '.' || line[0] == '\'') {
+        request(r, line, path, depth);
+        // A tag given as a font macro (".TP" then ".B -a") ends with that macro.
+        if (r->tag_pending && r->line_started) finish_tag(r);
+        return;
+    }
+
+    // Plain text line
+    if (line[0] == '\0') {
+        blank_line(r);
+        return;
+    }
+    if (r->fill && (line[0] == ' ' || line[0] == '\t')) flush_line(r);
+
+    RoffFont line_font = r->next_line_font;
+    r->next_line_font = FONT_R;
+    if (line_font != FONT_R) {
+        add_text_in_font(r, line, line_font);
+    } else {
+        add_text(r, line);
+    }
+
+    if (r->tag_pending) {
+        finish_tag(r);
+    } else if (!r->fill) {
+        flush_line(r);
+    }
+}
+
+/**
+ * @brief Streams one file through zlib (transparent for uncompressed files).
+ */
+static bool render_stream(Roff* r, const char* path, int depth) {
+    gzFile gz = gzopen(path, "rb");
+    if (!gz) return false;
+
+    StrBuf line;
+    strbuf_init(&line);
+    char chunk[4096];
+    bool ok = true;
+    while (gzgets(gz, chunk, sizeof(chunk)) != NULL) {
+        size_t len = strlen(chunk);
+        strbuf_append(&line, chunk, len);
+        if (len == 0 || chunk[len - 1] != '\n') {
+            if (!gzeof(gz)) continue; // Line longer than the chunk: keep reading
+        } else {
+            line.data[--line.len] = '\0';
+        }
+        process_line(r, line.data, path, depth);
+        strbuf_reset(&line);
+    }
+    int err;
+    gzerror(gz, &err);
+    if (err != Z_OK && err != Z_STREAM_END) ok = false;
+    gzclose(gz);
+    strbuf_free(&line);
+    return ok;
+}
+
+bool roff_render_file(const char* path, int width, StrBuf* out) {
+    Roff r;
+    memset(&r, 0, sizeof(r));
+    r.out = out;
+    r.width = width;
+    r.fill = true;
+    r.font = r.prev_font = r.next_line_font = FONT_R;
+    r.last_blank = true;
+    strbuf_init(&r.line);
+    strbuf_init(&r.word);
+
+    bool ok = render_stream(&r, path, 0);
+    end_word(&r);
+    flush_line(&r);
+
+    strbuf_free(&r.line);
+    strbuf_free(&r.word);
+    free(r.url);
+    return ok;
+}
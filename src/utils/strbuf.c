@@ -0,0 +1,80 @@
+#include "utils/strbuf.h"
+#include "utils/error.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STRBUF_MIN_CAPACITY 64
+
+void strbuf_init(StrBuf* sb) {
+    sb->data = NULL;
+    sb->len = 0;
+    sb->cap = 0;
+}
+
+bool strbuf_reserve(StrBuf* sb, size_t extra) {
+    size_t needed = sb->len + extra + 1;
+    if (needed <= sb->cap) return true;
+    size_t new_cap = sb->cap ? sb->cap : STRBUF_MIN_CAPACITY;
+    while (new_cap < needed) new_cap *= 2;
+    char* grown = realloc(sb->data, new_cap);
+    if (!grown) {
+        print_shell_perror("strbuf: realloc failed");
+        return false;
+    }
+    if (!sb->data) grown[0] = '\0';
+    sb->data = grown;
+    sb->cap = new_cap;
+    return true;
+}
+
+bool strbuf_append(StrBuf* sb, const char* data, size_t len) {
+    if (!strbuf_reserve(sb, len)) return false;
+    memcpy(sb->data + sb->len, data, len);
+    sb->len += len;
+    sb->data[sb->len] = '\0';
+    return true;
+}
+
+bool strbuf_append_str(StrBuf* sb, const char* str) {
+    return strbuf_append(sb, str, strlen(str));
+}
+
+bool strbuf_putc(StrBuf* sb, char c) {
+    if (!strbuf_reserve(sb, 1)) return false;
+    sb->data[sb->len++] = c;
+    sb->data[sb->len] = '\0';
+    return true;
+}
+
+bool strbuf_appendf(StrBuf* sb, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int needed = vsnprintf(NULL, 0, fmt, args);
+    va_end(args);
+    if (needed < 0 || !strbuf_reserve(sb, (size_t)needed)) return false;
+
+    va_start(args, fmt);
+    vsnprintf(sb->data + sb->len, sb->cap - sb->len, fmt, args);
+    va_end(args);
+    sb->len += (size_t)needed;
+    return true;
+}
+
+void strbuf_reset(StrBuf* sb) {
+    sb->len = 0;
+    if (sb->data) sb->data[0] = '\0';
+}
+
+char* strbuf_detach(StrBuf* sb) {
+    char* result = sb->data ? sb->data : strdup("");
+    strbuf_init(sb);
+    return result;
+}
+
+void strbuf_free(StrBuf* sb) {
+    free(sb->data);
+    strbuf_init(sb);
+}
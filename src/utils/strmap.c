@@ -0,0 +1,113 @@
+#include "utils/strmap.h"
+#include "utils/error.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define STRMAP_INITIAL_CAPACITY 16
+
+/**
+ * @brief FNV-1a, as used for variable names.
+ */
+static uint32_t hash_key(const char* key) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char* p = (const unsigned char*)key; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief The slot holding 'key', or the empty slot where it would go.
+ */
+static StrMapEntry* probe(const StrMap* map, const char* key, uint32_t hash) {
+    size_t mask = map->capacity - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        StrMapEntry* slot = &map->slots[i];
+        if (!slot->key || (slot->hash == hash && strcmp(slot->key, key) == 0)) return slot;
+    }
+}
+
+static bool grow(StrMap* map) {
+    size_t new_capacity = map->capacity ? map->capacity * 2 : STRMAP_INITIAL_CAPACITY;
+    StrMapEntry* new_slots = calloc(new_capacity, sizeof(StrMapEntry));
+    if (!new_slots) {
+        print_shell_perror("strmap: calloc for table failed");
+        return false;
+    }
+    StrMapEntry* old_slots = map->slots;
+    size_t old_capacity = map->capacity;
+    map->slots = new_slots;
+    map->capacity = new_capacity;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_slots[i].key) *probe(map, old_slots[i].key, old_slots[i].hash) = old_slots[i];
+    }
+    free(old_slots);
+    return true;
+}
+
+void strmap_init(StrMap* map) {
+    memset(map, 0, sizeof(*map));
+}
+
+void* strmap_get(const StrMap* map, const char* key) {
+    if (map->count == 0) return NULL;
+    const StrMapEntry* slot = probe(map, key, hash_key(key));
+    return slot->key ? slot->value : NULL;
+}
+
+bool strmap_put(StrMap* map, const char* key, void* value, void** old_value) {
+    if (old_value) *old_value = NULL;
+    // Keep the load factor under 3/4 so probe sequences stay short.
+    if ((map->count + 1) * 4 > map->capacity * 3 && !grow(map)) return false;
+    uint32_t hash = hash_key(key);
+    StrMapEntry* slot = probe(map, key, hash);
+    if (slot->key) {
+        if (old_value) *old_value = slot->value;
+        slot->value = value;
+        return true;
+    }
+    char* copy = strdup(key);
+    if (!copy) {
+        print_shell_perror("strmap: strdup for key failed");
+        return false;
+    }
+    *slot = (StrMapEntry){copy, hash, value};
+    map->count++;
+    return true;
+}
+
+void* strmap_remove(StrMap* map, const char* key) {
+    if (map->count == 0) return NULL;
+    StrMapEntry* slot = probe(map, key, hash_key(key));
+    if (!slot->key) return NULL;
+    void* value = slot->value;
+    free(slot->key);
+    slot->key = NULL;
+    map->count--;
+
+    // Shift back any later entry of the run that the hole now separates from its home slot.
+    size_t mask = map->capacity - 1;
+    size_t hole = (size_t)(slot - map->slots);
+    for (size_t i = (hole + 1) & mask; map->slots[i].key; i = (i + 1) & mask) {
+        size_t home = map->slots[i].hash & mask;
+        // The entry may move into the hole unless its home lies cyclically in (hole, i].
+        bool stays = (hole <= i) ? (hole < home && home <= i) : (hole < home || home <= i);
+        if (stays) continue;
+        map->slots[hole] = map->slots[i];
+        map->slots[i].key = NULL;
+        hole = i;
+    }
+    return value;
+}
+
+void strmap_clear(StrMap* map, void (*free_value)(void*)) {
+    for (size_t i = 0; i < map->capacity; i++) {
+        if (!map->slots[i].key) continue;
+        if (free_value) free_value(map->slots[i].value);
+        free(map->slots[i].key);
+    }
+    free(map->slots);
+    memset(map, 0, sizeof(*map));
+}
@@ -0,0 +1,198 @@
+#define _GNU_SOURCE
+#include "utils/trace.h"
+#include "utils/error.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#define TRACE_RING_SIZE 4096 // Must be a power of two
+#define TRACE_HIST_BUCKETS 64 // One bucket per power of two nanoseconds
+#define TRACE_BAR_WIDTH 40
+
+typedef struct {
+    uint64_t start_ns;
+    uint64_t end_ns;
+    TracePhase phase;
+} TraceSpan;
+
+typedef struct {
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t min_ns;
+    uint64_t max_ns;
+    uint64_t buckets[TRACE_HIST_BUCKETS];
+} TraceHistogram;
+
+/**
+ * @brief Per-thread trace storage. Only the owning thread writes to it,
+ *        so recording needs neither locks nor atomics.
+ */
+typedef struct {
+    TraceSpan spans[TRACE_RING_SIZE];
+    uint64_t head; ///< Total spans ever recorded; head % size is the next slot.
+    TraceHistogram hist[TRACE_NUM_PHASES];
+} TraceBuffer;
+
+bool g_trace_enabled = false;
+
+static __thread TraceBuffer* t_buffer = NULL;
+
+static const char* const phase_names[TRACE_NUM_PHASES] = {
+    [TRACE_PROMPT] = "prompt",
+    [TRACE_INPUT] = "input",
+    [TRACE_PARSE] = "parse",
+    [TRACE_EXECUTE] = "execute",
+    [TRACE_FORK] = "fork",
+    [TRACE_EXEC] = "exec",
+    [TRACE_WAIT] = "wait",
+    [TRACE_HISTORY] = "history",
+};
+
+static TraceBuffer* get_buffer(void) {
+    if (!t_buffer) {
+        t_buffer = calloc(1, sizeof(TraceBuffer));
+    }
+    return t_buffer;
+}
+
+static int bucket_for(uint64_t ns) {
+    return ns == 0 ? 0 : 63 - __builtin_clzll(ns);
+}
+
+/**
+ * @brief Formats a nanosecond duration with a human-friendly unit.
+ */
+static void format_duration(uint64_t ns, char* buf, size_t size) {
+    if (ns < 1000) snprintf(buf, size, "%luns", (unsigned long)ns);
+    else if (ns < 1000000) snprintf(buf, size, "%.1fus", ns / 1e3);
+    else if (ns < 1000000000) snprintf(buf, size, "%.2fms", ns / 1e6);
+    else snprintf(buf, size, "%.2fs", ns / 1e9);
+}
+
+/**
+ * @brief Estimates a percentile from the log2 buckets (upper bucket bound).
+ */
+static uint64_t histogram_percentile(const TraceHistogram* h, double pct) {
+    uint64_t rank = (uint64_t)(h->count * pct);
+    if (rank >= h->count) rank = h->count - 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < TRACE_HIST_BUCKETS; b++) {
+        seen += h->buckets[b];
+        if (seen > rank) {
+            uint64_t upper = (b >= 63) ? UINT64_MAX : (1ULL << (b + 1));
+            return upper < h->max_ns ? upper : h->max_ns;
+        }
+    }
+    return h->max_ns;
+}
+
+uint64_t trace_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void trace_record(TracePhase phase, uint64_t start_ns, uint64_t end_ns) {
+    TraceBuffer* tb = get_buffer();
+    if (!tb || phase >= TRACE_NUM_PHASES) return;
+
+    TraceSpan* span = &tb->spans[tb->head & (TRACE_RING_SIZE - 1)];
+    span->start_ns = start_ns;
+    span->end_ns = end_ns;
+    span->phase = phase;
+    tb->head++;
+
+    uint64_t duration = end_ns > start_ns ? end_ns - start_ns : 0;
+    TraceHistogram* h = &tb->hist[phase];
+    if (h->count == 0 || duration < h->min_ns) h->min_ns = duration;
+    if (duration > h->max_ns) h->max_ns = duration;
+    h->count++;
+    h->total_ns += duration;
+    h->buckets[bucket_for(duration)]++;
+}
+
+const char* trace_phase_name(TracePhase phase) {
+    return phase < TRACE_NUM_PHASES ? phase_names[phase] : "unknown";
+}
+
+void trace_set_enabled(bool enabled) {
+    g_trace_enabled = enabled;
+}
+
+void trace_reset(void) {
+    if (t_buffer) memset(t_buffer, 0, sizeof(TraceBuffer));
+}
+
+void trace_print_histograms(FILE* out) {
+    TraceBuffer* tb = t_buffer;
+    fprintf(out, "Tracing is %s.\n", g_trace_enabled ? "on" : "off");
+    if (!tb || tb->head == 0) {
+        fprintf(out, "No spans recorded.\n");
+        return;
+    }
+
+    fprintf(out, _BLUE_ "%-8s %8s %10s %10s %10s %10s %10s %10s" _RESET_ "\n",
+            "phase", "count", "total", "mean", "min", "p50", "p99", "max");
+    for (int p = 0; p < TRACE_NUM_PHASES; p++) {
+        const TraceHistogram* h = &tb->hist[p];
+        if (h->count == 0) continue;
+        char total[16], mean[16], min[16], p50[16], p99[16], max[16];
+        format_duration(h->total_ns, total, sizeof(total));
+        format_duration(h->total_ns / h->count, mean, sizeof(mean));
+        format_duration(h->min_ns, min, sizeof(min));
+        format_duration(histogram_percentile(h, 0.50), p50, sizeof(p50));
+        format_duration(histogram_percentile(h, 0.99), p99, sizeof(p99));
+        format_duration(h->max_ns, max, sizeof(max));
+        fprintf(out, "%-8s %8lu %10s %10s %10s %10s %10s %10s\n", phase_names[p],
+                (unsigned long)h->count, total, mean, min, p50, p99, max);
+    }
+
+    for (int p = 0; p < TRACE_NUM_PHASES; p++) {
+        const TraceHistogram* h = &tb->hist[p];
+        if (h->count == 0) continue;
+
+        uint64_t peak = 0;
+        int first = bucket_for(h->min_ns), last = bucket_for(h->max_ns);
+        for (int b = first; b <= last; b++) {
+            if (h->buckets[b] > peak) peak = h->buckets[b];
+        }
+
+        fprintf(out, "\n" _GREEN_ "%s" _RESET_ "\n", phase_names[p]);
+        for (int b = first; b <= last; b++) {
+            char lo[16], hi[16];
+            format_duration(1ULL << b, lo, sizeof(lo));
+            format_duration(b >= 63 ? UINT64_MAX : 1ULL << (b + 1), hi, sizeof(hi));
+            int bar = (int)(h->buckets[b] * TRACE_BAR_WIDTH / peak);
+            fprintf(out, "  [%8s, %8s) %-*.*s %lu\n", lo, hi, TRACE_BAR_WIDTH, bar,
+                    "########################################", (unsigned long)h->buckets[b]);
+        }
+    }
+}
+
+int trace_export_chrome_json(const char* path) {
+    FILE* f = fopen(path, "w");
+    if (!f) return -1;
+
+    TraceBuffer* tb = t_buffer;
+    long pid = (long)getpid();
+    long tid = (long)syscall(SYS_gettid);
+
+    fprintf(f, "{\"traceEvents\":[");
+    if (tb) {
+        uint64_t count = tb->head < TRACE_RING_SIZE ? tb->head : TRACE_RING_SIZE;
+        uint64_t first = tb->head - count;
+        for (uint64_t i = 0; i < count; i++) {
+            const TraceSpan* s = &tb->spans[(first + i) & (TRACE_RING_SIZE - 1)];
+            fprintf(f, "%s\n{\"name\":\"%s\",\"cat\":\"shell\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%ld,\"tid\":%ld}",
+                    i == 0 ? "" : ",", trace_phase_name(s->phase),
+                    s->start_ns / 1e3, (s->end_ns - s->start_ns) / 1e3, pid, tid);
+        }
+    }
+    fprintf(f, "\n],\"displayTimeUnit\":\"ns\"}\n");
+
+    if (fclose(f) != 0) return -1;
+    return 0;
+}
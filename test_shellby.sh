@@ -0,0 +1,228 @@
+#!/bin/sh
+# Runs short scripts through ./shellby and compares what they print with what is expected.
+# Build first with 'make'. Exits with the number of failed checks.
+
+SHELLBY="$(pwd)/shellby"
+TEST_DIR="shellby_test_environment"
+failures=0
+
+if [ ! -x "$SHELLBY" ]; then
+    echo "shellby is not built; run 'make' first." >&2
+    exit 1
+fi
+rm -rf "$TEST_DIR"
+mkdir "$TEST_DIR" || exit 1
+
+# check <name> <expected output> <script>
+# The script runs in $TEST_DIR; job notices ("Shell: ...") are left out of its output.
+# A script still running after 20 seconds is stopped, and fails.
+check() {
+    actual=$(cd "$TEST_DIR" && printf '%s\n' "$3" | timeout 20 "$SHELLBY" 2>&1 | grep -v '^Shell: ')
+    if [ "$actual" = "$2" ]; then
+        echo "PASS: $1"
+    else
+        echo "FAIL: $1"
+        echo "  expected: $2"
+        echo "  actual:   $actual"
+        failures=$((failures + 1))
+    fi
+    rm -rf "$TEST_DIR" && mkdir "$TEST_DIR" # Also the history and directory database
+}
+
+# --- Lists and groups ---
+
+check "&& and ||" "a
+d
+status 1" \
+'true && echo a || echo b
+false && echo c || echo d
+false; echo "status $?"'
+
+check "group into a pipe" "2" \
+'{ echo one; echo two; } | wc -l'
+
+# --- Redirections ---
+
+check "> >> and <" "one
+two
+2" \
+'echo one > f
+echo two >> f
+cat f
+wc -l < f'
+
+check "noclobber" "one
+three
+four" \
+'echo one > f
+set -o noclobber
+echo two 2>/dev/null > f
+cat f
+echo three >| f
+cat f
+set +o noclobber
+echo four > f
+cat f'
+
+# The shell's own descriptors (10 and up) are not there for scripts to write to.
+check "redirect onto the shell's descriptor" "status 1" \
+'{ echo leaked >&10; } 2>/dev/null
+echo "status $?"'
+
+# --- Process substitution ---
+
+check "builtin into >(...)" "hello" \
+'echo hello > >(cat > out)
+sleep 0.3
+cat out'
+
+check "builtin reading <(...)" "from substitution" \
+'cat < <(echo from substitution)'
+
+check "builtin given <(...) as a file" "1 from substitution" \
+'cat -n <(echo from substitution) | tr -s " \t" " " | sed "s/^ //"'
+
+# A forked builtin stage must not hold another stage's substitution pipe: sort
+# sees EOF, and the writer sees EPIPE, as soon as the stage that owns it is done.
+check "forked builtin does not hold >(...) open" "hi" \
+'echo hi > >(sort > out) | { sleep 1; } &
+sleep 0.6
+cat out
+sleep 0.6'
+
+check "forked builtin does not hold <(...) open" "status 1" \
+'true < <(sh -c '\''trap "" PIPE; sleep 0.2; echo x 2>/dev/null; echo "status $?" > out'\'') | { sleep 1; } &
+sleep 0.6
+cat out
+sleep 0.6'
+
+# --- Compound commands and functions ---
+
+check "if, elif and else" "elif" \
+'if false; then echo if; elif true; then echo elif; else echo else; fi'
+
+check "for, continue and break" "1
+3" \
+'for i in 1 2 3 4 5; do
+    if [ $i -eq 2 ]; then continue; fi
+    if [ $i -eq 4 ]; then break; fi
+    echo $i
+done'
+
+check "while and until" "while done
+until done" \
+'while false; do echo never; done
+echo while done
+until true; do echo never; done
+echo until done'
+
+check "function with arguments and return" "args x y
+status 3" \
+'f() {
+    echo "args $1 $2"
+    return 3
+    echo unreachable
+}
+f x y
+echo "status $?"'
+
+check "return from inside a loop" "status 4" \
+'g() { for j in a b; do return 4; done; echo unreachable; }
+g
+echo "status $?"'
+
+# --- timeout and limit ---
+
+check "timeout" "status 124
+status 7" \
+'timeout 0.3 sleep 5
+echo "status $?"
+timeout 5 sh -c "exit 7"
+echo "status $?"'
+
+check "timeout -k" "status 137" \
+'timeout -k 0.2 0.2 sh -c "trap \"\" TERM; sleep 3" 2>/dev/null
+echo "status $?"'
+
+# Without cgroup v2 the command runs unlimited, with a warning: only its own output is compared.
+check "limit" "inside
+status 3" \
+'{ limit -p 64 sh -c "echo inside; exit 3"; echo "status $?"; } 2>/dev/null'
+
+# --- Prefix assignments ---
+
+check "assignment for one command" "x
+[]" \
+'V=x printenv V
+echo "[$V]"'
+
+# The last assignment to a name wins; the child used to get the first, and both were exported.
+check "repeated assignment, spawned" "2
+1" \
+'B=1 B=2 printenv B
+B=1 B=2 env | grep -c "^B="'
+
+check "repeated assignment, forked" "2" \
+'B=1 B=2 printenv B | cat'
+
+# --- Here-documents ---
+
+check "here-document" "one two" \
+'cat <<EOF
+one $(echo two)
+EOF'
+
+check "quoted delimiter, <<- and a blank line" 'x
+$y
+
+z' \
+'cat <<-"END"
+	x
+	$y
+
+	z
+	END'
+
+# Each line of a body used to make the whole text be parsed again: 20000 lines took minutes.
+big_heredoc=$(printf 'cat <<EOF | wc -l\n'; seq 1 20000; printf 'EOF\necho after\n')
+check "20000-line here-document" "20000
+after" "$big_heredoc"
+
+# History is only kept at a terminal: script(1) provides one for the first shell.
+# The entry used to be joined into "cat <<EOF; recorded body; EOF", whose body never ended.
+if command -v script > /dev/null; then
+    check "here-document recalled from history" "recorded body
+after" \
+"printf 'cat <<EOF\\nrecorded body\\nEOF\\nexit\\n' | script -qec $SHELLBY /dev/null > /dev/null
+printf 'pastevents execute 2; echo after\\nexit\\n' | $SHELLBY"
+fi
+
+check "pastevents execute after && || and {" "first
+first
+first" \
+"echo 'echo first' > .shellby_history.txt
+cat > recall.sh <<'EOF'
+true && pastevents execute 1
+false || pastevents execute 1
+{ pastevents execute 1; }
+EOF
+$SHELLBY recall.sh"
+
+# Quoted or escaped text used to be rewritten too: the first line printed "a; echo first".
+check "pastevents execute inside quotes" "a; pastevents execute 1
+b; pastevents execute 1
+c; pastevents execute 1
+d
+first" \
+"echo 'echo first' > .shellby_history.txt
+cat > recall.sh <<'EOF'
+echo 'a; pastevents execute 1'
+echo \"b; pastevents execute 1\"
+echo c\\; pastevents execute 1
+echo d; pastevents execute 1
+EOF
+$SHELLBY recall.sh"
+
+rm -rf "$TEST_DIR"
+echo "$failures failed"
+exit "$failures"